@@ -0,0 +1,636 @@
+// workbench_bench: headless throughput benchmark for the ingest pipeline.
+//
+// Feeds synthetic traffic, recorder captures or recorded relay streams through
+// HardwareServiceClient::injectRelayBytes -> DataRegistry::update -> observers and
+// reports frames/s, points/s, latency percentiles and heap allocations per frame.
+// Synthetic frames carry their ring slot in the timestamp, so observers can
+// measure injection-to-delivery latency even when the dispatcher drops frames.
+
+#include "argparse.hpp"
+#include "core/CaptureFile.h"
+#include "core/DataRegistry.h"
+#include "core/Types.h"
+#include "hardware/BinaryFrameCodec.h"
+#include "hardware/DataFrameSaxDecoder.h"
+#include "hardware/HardwareServiceClient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+std::atomic<std::uint64_t> gAllocations { 0 };
+
+void* CountedAlloc(std::size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* CountedAlignedAlloc(std::size_t size, std::align_val_t alignment)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    const std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+// Every heap allocation in the process is counted, including the registry's
+// dispatch workers, so "allocs/frame" is the whole pipeline's cost.
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAlignedAlloc(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Distinct synthetic messages per stream. A queued observer lags by at most its
+// mailbox capacity plus one batch, far less than this, so slots never alias.
+constexpr std::size_t kSyntheticRing = 128;
+
+std::int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Stream {
+    std::string label;
+    // One complete relay message per entry, framing included.
+    std::vector<std::string> messages;
+    bool binary { false };
+    // Synthetic streams stamp frame i with timestamp (i % ring) + 1 seconds.
+    bool synthetic { false };
+    std::vector<std::string> sourceIds;
+};
+
+struct Config {
+    std::size_t frames { 0 };
+    std::size_t warmupFrames { 0 };
+    std::size_t channels { 0 };
+    std::size_t samples { 0 };
+    bool binary { false };
+    bool queued { false };
+    int decodeWorkers { -1 };
+};
+
+void AppendDouble(std::string& out, double value)
+{
+    char buffer[32];
+    const int written = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    out.append(buffer, static_cast<std::size_t>(written));
+}
+
+// Relay-style `workbench.dataFrame` notification for the payload kinds the bench
+// generates, keeping `method` ahead of `params` like a real relay.
+std::string ToJsonMessage(const core::DataFrame& frame)
+{
+    std::string out = R"({"jsonrpc":"2.0","method":"workbench.dataFrame","params":{"frame":{"sourceId":")";
+    out += frame.sourceId;
+    out += R"(","timestamp":)";
+    AppendDouble(out, std::chrono::duration<double>(frame.timestamp.time_since_epoch()).count());
+    out += R"(,"points":[)";
+    bool firstPoint = true;
+    for (const auto& point : frame.points) {
+        out += firstPoint ? "" : ",";
+        firstPoint = false;
+        out += R"({"channelId":")" + point.channelId + R"(",)";
+        if (const auto* numeric = std::get_if<core::NumericSample>(&point.payload)) {
+            out += R"("numeric":{"value":)";
+            AppendDouble(out, numeric->value);
+            out += R"(,"unit":")" + numeric->unit + R"("}})";
+        } else if (const auto* waveform = std::get_if<core::WaveformSample>(&point.payload)) {
+            out += R"("waveform":{"sampleRate":)";
+            AppendDouble(out, waveform->sampleRateHz);
+            out += R"(,"samples":[)";
+            for (std::size_t i = 0; i < waveform->samples.size(); ++i) {
+                out += i == 0 ? "" : ",";
+                AppendDouble(out, waveform->samples[i]);
+            }
+            out += "]}}";
+        } else if (const auto* logic = std::get_if<core::LogicSample>(&point.payload)) {
+            out += R"("logic":{"channelCount":)" + std::to_string(logic->channelCount);
+            out += R"(,"periodNs":)" + std::to_string(logic->samplePeriod.count());
+            out += R"(,"words":[)";
+            for (std::size_t i = 0; i < logic->words.size(); ++i) {
+                out += i == 0 ? "" : ",";
+                out += std::to_string(logic->words[i]);
+            }
+            out += "]}}";
+        } else {
+            out += R"("numeric":{"value":0}})";
+        }
+    }
+    out += "]}}}\n";
+    return out;
+}
+
+core::DataPoint MakePoint(const std::string& kind, std::size_t channel, std::size_t frameIndex, const Config& config)
+{
+    core::DataPoint point;
+    point.channelId = "ch" + std::to_string(channel);
+    const double phase = static_cast<double>(frameIndex) * 0.1 + static_cast<double>(channel);
+    if (kind == "numeric") {
+        core::NumericSample sample;
+        sample.value = 5.0 + std::sin(phase);
+        sample.unit = "V";
+        point.payload = std::move(sample);
+    } else if (kind == "waveform") {
+        core::WaveformSample sample;
+        sample.sampleRateHz = 100000.0;
+        sample.samples.resize(config.samples);
+        for (std::size_t i = 0; i < config.samples; ++i) {
+            sample.samples[i] = std::sin(phase + static_cast<double>(i) * 0.05);
+        }
+        point.payload = std::move(sample);
+    } else {
+        // An 8-line bus counting up, one slice per sample period.
+        core::LogicSample sample;
+        sample.channelCount = 8;
+        sample.samplePeriod = std::chrono::nanoseconds(10);
+        sample.words.resize(config.samples);
+        for (std::size_t i = 0; i < config.samples; ++i) {
+            sample.words[i] = (frameIndex + i / 4) & 0xFF;
+        }
+        point.payload = std::move(sample);
+    }
+    return point;
+}
+
+Stream MakeSyntheticStream(const std::string& kind, const Config& config)
+{
+    Stream stream;
+    stream.label = kind;
+    stream.binary = config.binary;
+    stream.synthetic = true;
+    stream.sourceIds = { "bench." + kind };
+    stream.messages.reserve(kSyntheticRing);
+    for (std::size_t i = 0; i < kSyntheticRing; ++i) {
+        core::DataFrame frame;
+        frame.sourceId = stream.sourceIds.front();
+        frame.sourceName = frame.sourceId;
+        frame.timestamp = std::chrono::system_clock::time_point(std::chrono::seconds(static_cast<long long>(i + 1)));
+        for (std::size_t c = 0; c < config.channels; ++c) {
+            frame.points.push_back(MakePoint(kind, c, i, config));
+        }
+        std::string message;
+        if (config.binary) {
+            hardware::binary::EncodeDataFrame(frame, message);
+        } else {
+            message = ToJsonMessage(frame);
+        }
+        stream.messages.push_back(std::move(message));
+    }
+    return stream;
+}
+
+// A recorded protocol 1 stream: one relay JSON message per line, as read off the socket.
+Stream LoadReplayStream(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open replay file '" + path + "'");
+    }
+    Stream stream;
+    stream.label = "replay";
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            stream.messages.push_back(line + "\n");
+        }
+    }
+    if (stream.messages.empty()) {
+        throw std::runtime_error("replay file '" + path + "' holds no messages");
+    }
+    return stream;
+}
+
+// A recorder capture (.wbcap), re-encoded as protocol 2 relay frames so replays
+// exercise the same binary ingest path as a live relay. Only the first
+// `maxFrames` are loaded; runs cycle through them like any other stream.
+Stream LoadCaptureStream(const std::string& path, std::size_t maxFrames)
+{
+    core::CaptureReader reader;
+    if (!reader.open(path)) {
+        throw std::runtime_error("cannot open capture file '" + path + "'");
+    }
+    Stream stream;
+    stream.label = "capture";
+    stream.binary = true;
+    std::vector<core::DataFrame> frames;
+    for (std::size_t chunk = 0; chunk < reader.chunks().size() && stream.messages.size() < maxFrames; ++chunk) {
+        reader.readChunk(chunk, frames);
+        for (const auto& frame : frames) {
+            if (stream.messages.size() == maxFrames) {
+                break;
+            }
+            hardware::binary::EncodeDataFrame(frame, stream.messages.emplace_back());
+        }
+    }
+    if (stream.messages.empty()) {
+        throw std::runtime_error("capture file '" + path + "' holds no frames");
+    }
+    return stream;
+}
+
+bool IsCaptureFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(core::capture::kFileMagic)] {};
+    file.read(magic, sizeof(magic));
+    return file && std::equal(std::begin(magic), std::end(magic), std::begin(core::capture::kFileMagic));
+}
+
+// Decodes every message outside the pipeline to learn which sources the stream
+// feeds and how much data a pass carries.
+void ProbeStream(Stream& stream, std::uint64_t& points, std::uint64_t& samples)
+{
+    points = 0;
+    samples = 0;
+    hardware::DataFrameNotification notification;
+    core::DataFrame binaryFrame;
+    for (const auto& message : stream.messages) {
+        const core::DataFrame* frame = nullptr;
+        if (stream.binary) {
+            if (hardware::binary::DecodeDataFrame(std::string_view(message).substr(hardware::binary::kHeaderSize), binaryFrame)) {
+                frame = &binaryFrame;
+            }
+        } else {
+            const std::string_view line = std::string_view(message).substr(0, message.size() - 1);
+            if (hardware::DecodeDataFrameNotification(line, notification) == hardware::DecodeStatus::Decoded && notification.hasFrame) {
+                frame = &notification.frame;
+            }
+        }
+        if (!frame || frame->sourceId.empty()) {
+            continue;
+        }
+        if (std::find(stream.sourceIds.begin(), stream.sourceIds.end(), frame->sourceId) == stream.sourceIds.end()) {
+            stream.sourceIds.push_back(frame->sourceId);
+        }
+        points += frame->points.size();
+        for (const auto& point : frame->points) {
+            if (const auto* waveform = std::get_if<core::WaveformSample>(&point.payload)) {
+                samples += waveform->samples.size();
+            } else if (const auto* logic = std::get_if<core::LogicSample>(&point.payload)) {
+                samples += logic->sliceCount();
+            } else {
+                ++samples;
+            }
+        }
+    }
+}
+
+// Far outside the synthetic ring; marks the end of a phase for every observer.
+constexpr std::int64_t kSentinelSeconds = 1'000'000'000;
+
+std::int64_t StampSeconds(const core::DataFrame& frame)
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(frame.timestamp.time_since_epoch()).count();
+}
+
+struct Probe {
+    // Sized before the timed phase; appended from one thread at a time (the
+    // publisher for inline observers, the mailbox's worker for queued ones).
+    std::vector<std::int64_t> latencies;
+    std::atomic<std::uint64_t> deliveries { 0 };
+    std::atomic<int> sentinels { 0 };
+};
+
+struct Result {
+    double seconds { 0.0 };
+    std::uint64_t frames { 0 };
+    std::uint64_t deliveries { 0 };
+    std::uint64_t allocations { 0 };
+    std::vector<std::int64_t> latencies;
+    bool deliveryLatency { false };
+};
+
+class Harness {
+public:
+    Harness(const Stream& stream, std::size_t observers, const Config& config)
+        : stream_(stream)
+        , client_(registry_)
+        , sendNs_(kSyntheticRing)
+        , config_(config)
+    {
+        hardware::HardwareServiceClient::Options clientOptions;
+        clientOptions.decodeWorkers = config.decodeWorkers;
+        client_.configure(clientOptions);
+        core::ObserverOptions options;
+        options.delivery = config.queued ? core::ObserverDelivery::Queued : core::ObserverDelivery::Inline;
+        for (const auto& sourceId : stream.sourceIds) {
+            for (std::size_t n = 0; n < observers; ++n) {
+                auto probe = std::make_unique<Probe>();
+                probe->latencies.reserve(config.frames);
+                registry_.addObserver(sourceId, [this, probe = probe.get()](const core::DataFrame& frame) {
+                    observe(*probe, frame);
+                }, options);
+                probes_.push_back(std::move(probe));
+            }
+            core::DataFrame sentinel;
+            sentinel.sourceId = sourceId;
+            sentinel.sourceName = sourceId;
+            sentinel.timestamp = std::chrono::system_clock::time_point(std::chrono::seconds(kSentinelSeconds));
+            std::string message;
+            if (stream.binary) {
+                hardware::binary::EncodeDataFrame(sentinel, message);
+            } else {
+                message = ToJsonMessage(sentinel);
+            }
+            sentinels_.push_back(std::move(message));
+        }
+        // Latency is measured at the observers only when they can tell frames apart.
+        deliveryLatency_ = stream.synthetic && !probes_.empty();
+        injectLatencies_.reserve(config.frames);
+    }
+
+    Result run()
+    {
+        inject(config_.warmupFrames, false);
+        finishPhase();
+        for (auto& probe : probes_) {
+            probe->latencies.clear();
+            probe->deliveries.store(0);
+        }
+
+        Result result;
+        result.deliveryLatency = deliveryLatency_;
+        result.frames = config_.frames;
+        const std::uint64_t allocationsBefore = gAllocations.load();
+        const auto begin = Clock::now();
+        inject(config_.frames, true);
+        finishPhase();
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        result.allocations = gAllocations.load() - allocationsBefore;
+
+        for (auto& probe : probes_) {
+            result.deliveries += probe->deliveries.load();
+            result.latencies.insert(result.latencies.end(), probe->latencies.begin(), probe->latencies.end());
+        }
+        if (!deliveryLatency_) {
+            result.latencies = injectLatencies_;
+        }
+        return result;
+    }
+
+private:
+    void observe(Probe& probe, const core::DataFrame& frame)
+    {
+        const std::int64_t seconds = StampSeconds(frame);
+        if (seconds == kSentinelSeconds) {
+            probe.sentinels.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        probe.deliveries.fetch_add(1, std::memory_order_relaxed);
+        if (!deliveryLatency_ || seconds < 1 || seconds > static_cast<std::int64_t>(kSyntheticRing)) {
+            return;
+        }
+        const auto sent = sendNs_[static_cast<std::size_t>(seconds - 1)].load(std::memory_order_relaxed);
+        if (probe.latencies.size() < probe.latencies.capacity()) {
+            probe.latencies.push_back(NowNs() - sent);
+        }
+    }
+
+    void inject(std::size_t frames, bool record)
+    {
+        const auto& messages = stream_.messages;
+        for (std::size_t i = 0; i < frames; ++i) {
+            const auto& message = messages[i % messages.size()];
+            const std::int64_t sent = NowNs();
+            if (stream_.synthetic) {
+                sendNs_[i % kSyntheticRing].store(sent, std::memory_order_relaxed);
+            }
+            client_.injectRelayBytes(message, stream_.binary);
+            if (record && !deliveryLatency_) {
+                injectLatencies_.push_back(NowNs() - sent);
+            }
+        }
+    }
+
+    // The newest frame always reaches a queued observer, so once every observer has
+    // seen the sentinel nothing from the phase is still in flight.
+    void finishPhase()
+    {
+        ++phase_;
+        for (const auto& sentinel : sentinels_) {
+            client_.injectRelayBytes(sentinel, stream_.binary);
+        }
+        for (const auto& probe : probes_) {
+            while (probe->sentinels.load(std::memory_order_acquire) < phase_) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    const Stream& stream_;
+    core::DataRegistry registry_;
+    hardware::HardwareServiceClient client_;
+    std::vector<std::atomic<std::int64_t>> sendNs_;
+    std::vector<std::unique_ptr<Probe>> probes_;
+    std::vector<std::string> sentinels_;
+    std::vector<std::int64_t> injectLatencies_;
+    Config config_;
+    bool deliveryLatency_ { false };
+    int phase_ { 0 };
+};
+
+double PercentileUs(std::vector<std::int64_t>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(rank), values.end());
+    return static_cast<double>(values[rank]) / 1e3;
+}
+
+std::vector<std::size_t> ParseCounts(const std::string& text)
+{
+    std::vector<std::size_t> counts;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        try {
+            counts.push_back(static_cast<std::size_t>(std::stoul(item)));
+        } catch (...) {
+            throw std::invalid_argument("Observer counts must be a comma-separated list of integers");
+        }
+    }
+    if (counts.empty()) {
+        counts.push_back(0);
+    }
+    return counts;
+}
+
+void PrintHeader()
+{
+    std::printf("%-9s %5s %-7s %12s %12s %14s %10s %10s %-8s %12s %8s\n",
+        "stream", "obs", "deliver", "frames/s", "points/s", "samples/s", "p50 us", "p99 us", "latency", "allocs/frame", "dropped");
+}
+
+void PrintResult(const std::string& label, std::size_t observers, const Config& config, Result& result,
+    std::uint64_t pointsPerPass, std::uint64_t samplesPerPass, std::size_t messagesPerPass)
+{
+    const double frames = static_cast<double>(result.frames);
+    const double passes = frames / static_cast<double>(messagesPerPass);
+    const double framesPerSecond = frames / result.seconds;
+    const double pointsPerSecond = passes * static_cast<double>(pointsPerPass) / result.seconds;
+    const double samplesPerSecond = passes * static_cast<double>(samplesPerPass) / result.seconds;
+    const double p50 = PercentileUs(result.latencies, 0.50);
+    const double p99 = PercentileUs(result.latencies, 0.99);
+    const std::uint64_t expected = result.frames * observers;
+    const std::uint64_t dropped = expected > result.deliveries ? expected - result.deliveries : 0;
+    std::printf("%-9s %5zu %-7s %12.0f %12.0f %14.0f %10.2f %10.2f %-8s %12.2f %8llu\n",
+        label.c_str(), observers, config.queued ? "queued" : "inline", framesPerSecond, pointsPerSecond, samplesPerSecond,
+        p50, p99, result.deliveryLatency ? "deliver" : "inject", static_cast<double>(result.allocations) / frames,
+        static_cast<unsigned long long>(dropped));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser argumentParser("workbench_bench");
+    argumentParser.add_argument("--kind")
+        .help("Synthetic payload kind: numeric, waveform, logic or all")
+        .default_value(std::string("all"));
+    argumentParser.add_argument("--replay")
+        .help("Replay a recorder capture (.wbcap) or a relay stream (one JSON message per line) instead of synthetic frames")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--observers")
+        .help("Comma-separated observer counts per source to run, e.g. 0,1,8")
+        .default_value(std::string("0,1,8"));
+    argumentParser.add_argument("--frames")
+        .help("Frames injected per measured run")
+        .default_value(5000)
+        .scan<'i', int>();
+    argumentParser.add_argument("--warmup")
+        .help("Frames injected before measuring, so pools and buffers reach steady state")
+        .default_value(500)
+        .scan<'i', int>();
+    argumentParser.add_argument("--channels")
+        .help("Points per synthetic frame")
+        .default_value(4)
+        .scan<'i', int>();
+    argumentParser.add_argument("--samples")
+        .help("Samples per waveform point and slices per logic point")
+        .default_value(1000)
+        .scan<'i', int>();
+    argumentParser.add_argument("--binary")
+        .help("Encode synthetic frames with the protocol 2 binary framing")
+        .default_value(false)
+        .implicit_value(true);
+    argumentParser.add_argument("--queued")
+        .help("Deliver to observers through the dispatch pool instead of inline")
+        .default_value(false)
+        .implicit_value(true);
+    argumentParser.add_argument("--decode-workers")
+        .help("Decoder threads; -1 = one per spare core (at most 3), 0 = decode on the injecting thread")
+        .default_value(-1)
+        .scan<'i', int>();
+    try {
+        argumentParser.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    spdlog::set_level(spdlog::level::warn);
+
+    Config config;
+    config.frames = static_cast<std::size_t>(std::max(1, argumentParser.get<int>("--frames")));
+    config.warmupFrames = static_cast<std::size_t>(std::max(0, argumentParser.get<int>("--warmup")));
+    config.channels = static_cast<std::size_t>(std::max(1, argumentParser.get<int>("--channels")));
+    config.samples = static_cast<std::size_t>(std::max(1, argumentParser.get<int>("--samples")));
+    config.binary = argumentParser.get<bool>("--binary");
+    config.queued = argumentParser.get<bool>("--queued");
+    config.decodeWorkers = std::max(-1, argumentParser.get<int>("--decode-workers"));
+
+    std::vector<Stream> streams;
+    try {
+        const auto replay = argumentParser.get<std::string>("--replay");
+        if (!replay.empty() && IsCaptureFile(replay)) {
+            config.binary = true;
+            streams.push_back(LoadCaptureStream(replay, config.frames + config.warmupFrames));
+        } else if (!replay.empty()) {
+            if (config.binary) {
+                std::cerr << "--binary applies to synthetic streams and captures only; replaying as JSON" << std::endl;
+                config.binary = false;
+            }
+            streams.push_back(LoadReplayStream(replay));
+        } else {
+            const auto kind = argumentParser.get<std::string>("--kind");
+            for (const std::string candidate : { "numeric", "waveform", "logic" }) {
+                if (kind == "all" || kind == candidate) {
+                    streams.push_back(MakeSyntheticStream(candidate, config));
+                }
+            }
+            if (streams.empty()) {
+                throw std::invalid_argument("--kind must be numeric, waveform, logic or all");
+            }
+        }
+        const auto observerCounts = ParseCounts(argumentParser.get<std::string>("--observers"));
+
+        std::printf("%zu frames per run (+%zu warm-up), %zu points of %zu samples, %s framing\n",
+            config.frames, config.warmupFrames, config.channels, config.samples, config.binary ? "binary" : "JSON");
+        PrintHeader();
+        for (auto& stream : streams) {
+            std::uint64_t pointsPerPass = 0;
+            std::uint64_t samplesPerPass = 0;
+            ProbeStream(stream, pointsPerPass, samplesPerPass);
+            if (stream.sourceIds.empty()) {
+                throw std::runtime_error("stream '" + stream.label + "' holds no decodable data frames");
+            }
+            for (const auto observers : observerCounts) {
+                Harness harness(stream, observers, config);
+                auto result = harness.run();
+                PrintResult(stream.label, observers, config, result, pointsPerPass, samplesPerPass, stream.messages.size());
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "workbench_bench: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
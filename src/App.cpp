@@ -1,37 +1,117 @@
 #include "App.h"
 
+#include "core/Metrics.h"
+
 #include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <thread>
 #include <utility>
 
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/screen/color.hpp>
 #include <spdlog/spdlog.h>
 
+namespace {
+
+// Jobs posted to the UI thread, from the redraw scheduler or straight from modules.
+const core::metrics::Counter kUiPosts { "ui.posts" };
+
+// Set from the signal handler; lock-free, so safe to store there.
+std::atomic<bool> gStopRequested { false };
+
+void RequestStop(int)
+{
+    gStopRequested.store(true);
+}
+
+} // namespace
+
 App::App()
-    : hardwareService_ { dataRegistry_ }
-    , moduleContext_ { dataRegistry_, hardwareService_ }
+    : derivedChannels_ { dataRegistry_ }
+    , triggers_ { dataRegistry_ }
+    , hardwareService_ { dataRegistry_ }
+    , relayServer_ { dataRegistry_, hardwareService_ }
+    , moduleContext_ { dataRegistry_, hardwareService_, {}, &redrawScheduler_, &triggers_ }
     , pluginManager_(moduleContext_)
+    , moduleScheduler_(pluginManager_)
     , dashboard_(moduleContext_)
 {
 }
 
 void App::setHardwareMockEnabled(bool enabled)
 {
-    auto opts = hardware::HardwareServiceClient::Options();
-    opts.enableMock = enabled;
-    hardwareService_.configure(opts);
-
-    // If mock mode is requested, register the mock source metadata synchronously so
-    // UI code that queries the DataRegistry during bootstrap can discover it.
-    if (enabled) {
-        core::SourceMetadata meta;
-        meta.id = "mock.12v";
-        meta.name = "12V Supply";
-        meta.kind = core::DataKind::Numeric;
-        meta.unit = std::string("V");
-        dataRegistry_.registerSource(meta);
-        spdlog::info("Hardware mock enabled; registered mock source '{}'", meta.id);
+    // HardwareServiceClient::start() registers the mock sources before the modules
+    // bootstrap, so there is nothing to register here.
+    hardwareOptions_.enableMock = enabled;
+    hardwareService_.configure(hardwareOptions_);
+}
+
+void App::setRelayEndpoints(std::vector<hardware::RelayEndpoint> endpoints)
+{
+    hardwareOptions_.endpoints = std::move(endpoints);
+    hardwareService_.configure(hardwareOptions_);
+}
+
+void App::setRelaySharedMemory(bool enabled)
+{
+    hardwareOptions_.sharedMemory = enabled;
+    hardwareService_.configure(hardwareOptions_);
+}
+
+void App::setLayoutFile(std::string path)
+{
+    layoutFile_ = std::move(path);
+}
+
+void App::setMaxFps(int fps)
+{
+    redrawScheduler_.setMaxFps(fps);
+}
+
+void App::setTickRate(int hz)
+{
+    moduleScheduler_.setTickRate(hz);
+}
+
+bool App::setReplayFiles(const std::vector<std::string>& paths, core::ReplayOptions options)
+{
+    replays_.clear();
+    bool ok = true;
+    std::int64_t originNs = 0;
+    for (const auto& path : paths) {
+        auto replay = std::make_unique<core::CaptureReplay>(dataRegistry_);
+        if (!replay->open(path, options)) {
+            ok = false;
+            continue;
+        }
+        originNs = replays_.empty() ? replay->firstTimestampNs() : std::min(originNs, replay->firstTimestampNs());
+        replays_.push_back(std::move(replay));
+    }
+    for (auto& replay : replays_) {
+        replay->setOrigin(originNs);
     }
+    return ok;
+}
+
+bool App::setDerivedChannels(std::vector<core::DerivedChannelSpec> specs)
+{
+    derivedChannels_.clear();
+    bool ok = true;
+    for (auto& spec : specs) {
+        ok = derivedChannels_.add(std::move(spec)) && ok;
+    }
+    return ok;
+}
+
+bool App::setTriggers(std::vector<core::TriggerSpec> specs)
+{
+    triggers_.clear();
+    bool ok = true;
+    for (auto& spec : specs) {
+        ok = triggers_.add(std::move(spec)) && ok;
+    }
+    return ok;
 }
 
 void App::registerModule(core::ModulePtr module)
@@ -45,6 +125,9 @@ int App::run()
     spdlog::info("Starting hardware service");
     hardwareService_.start();
     bootstrapModules();
+    for (auto& replay : replays_) {
+        replay->start();
+    }
 
     auto component = dashboard_.build();
     if (component) {
@@ -52,15 +135,28 @@ int App::run()
         auto screen = ftxui::ScreenInteractive::Fullscreen();
         // Provide modules with a centralized post-redraw callback that posts to the active screen.
         moduleContext_.postRedraw = [&screen](std::function<void()> job) {
+            kUiPosts.add();
             screen.Post([job = std::move(job), &screen]() mutable {
                 if (job)
                     job();
                 screen.RequestAnimationFrame();
             });
         };
+        redrawScheduler_.start(moduleContext_.postRedraw);
+        // Started once postRedraw is set: ticks may use it from the scheduler thread.
+        moduleScheduler_.start();
         screen.Loop(component);
+        moduleScheduler_.stop();
+        redrawScheduler_.stop();
+        moduleContext_.postRedraw = nullptr;
+        if (!layoutFile_.empty()) {
+            dashboard_.saveLayout(layoutFile_);
+        }
     }
 
+    for (auto& replay : replays_) {
+        replay->stop();
+    }
     spdlog::info("Shutting down modules and hardware service");
     pluginManager_.shutdownModules();
     hardwareService_.stop();
@@ -68,6 +164,45 @@ int App::run()
     return 0;
 }
 
+int App::serve(const std::string& socketPath)
+{
+    spdlog::info("Starting hardware service");
+    hardwareService_.start();
+    // No windows without a terminal: modules still declare their sources and tick.
+    pluginManager_.initializeModules();
+    for (auto& replay : replays_) {
+        replay->start();
+    }
+
+    int status = 0;
+    hardware::RelayServer::Options serverOptions;
+    serverOptions.socketPath = socketPath;
+    if (relayServer_.start(serverOptions)) {
+        moduleScheduler_.start();
+        gStopRequested.store(false);
+        const auto previousInt = std::signal(SIGINT, RequestStop);
+        const auto previousTerm = std::signal(SIGTERM, RequestStop);
+        while (!gStopRequested.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        std::signal(SIGINT, previousInt);
+        std::signal(SIGTERM, previousTerm);
+        spdlog::info("Headless server stopping ({} clients connected)", relayServer_.clientCount());
+        moduleScheduler_.stop();
+        relayServer_.stop();
+    } else {
+        status = 1;
+    }
+
+    for (auto& replay : replays_) {
+        replay->stop();
+    }
+    spdlog::info("Shutting down modules and hardware service");
+    pluginManager_.shutdownModules();
+    hardwareService_.stop();
+    return status;
+}
+
 core::DataRegistry& App::dataRegistry()
 {
     return dataRegistry_;
@@ -93,7 +228,11 @@ void App::bootstrapModules()
     }
 
     dashboard_.setAvailableWindows(registeredWindows_);
-    openDefaultWindows();
+    // The relay handshake is still under way; restored windows pick their sources up
+    // as the relays announce them.
+    if (layoutFile_.empty() || !dashboard_.restoreLayout(layoutFile_)) {
+        openDefaultWindows();
+    }
     modulesBootstrapped_ = true;
 }
 
@@ -1,14 +1,19 @@
 #pragma once
 
-#pragma once
-
+#include "core/CaptureReplay.h"
 #include "core/DataRegistry.h"
+#include "core/DerivedChannels.h"
 #include "core/Module.h"
 #include "core/ModuleContext.h"
+#include "core/ModuleScheduler.h"
 #include "core/PluginManager.h"
+#include "core/TriggerEngine.h"
 #include "hardware/HardwareServiceClient.h"
+#include "hardware/RelayServer.h"
 #include "ui/Dashboard.h"
+#include "ui/RedrawScheduler.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,7 +23,30 @@ public:
 
     void registerModule(core::ModulePtr module);
     void setHardwareMockEnabled(bool enabled);
+    // Relays to ingest from; empty keeps the default socket.
+    void setRelayEndpoints(std::vector<hardware::RelayEndpoint> endpoints);
+    // Asks relays on this host for shared-memory rings for waveform and logic sources.
+    void setRelaySharedMemory(bool enabled);
+    // Where the window layout is restored from at startup and saved to on exit; empty
+    // always opens the default windows and saves nothing.
+    void setLayoutFile(std::string path);
+    void setMaxFps(int fps);
+    void setTickRate(int hz);
+    // Publishes each capture file as a live source while the app runs. Files share
+    // one origin (the earliest first frame), so captures recorded together replay
+    // in step. Returns false if any file cannot be opened.
+    bool setReplayFiles(const std::vector<std::string>& paths, core::ReplayOptions options);
+    // Registers computed sources, evaluated as their inputs arrive. Returns false if
+    // any is rejected; the others are still added.
+    bool setDerivedChannels(std::vector<core::DerivedChannelSpec> specs);
+    // Arms triggers on incoming samples. Returns false if any is rejected; the others
+    // are still armed.
+    bool setTriggers(std::vector<core::TriggerSpec> specs);
     int run();
+    // Headless mode: ingests and runs the modules without a terminal, serving the
+    // registry on `socketPath` to dashboards started with `--relay`, until SIGINT or
+    // SIGTERM. Returns non-zero if the socket cannot be served.
+    int serve(const std::string& socketPath);
 
     core::DataRegistry& dataRegistry();
     hardware::HardwareServiceClient& hardwareService();
@@ -28,11 +56,20 @@ private:
     void openDefaultWindows();
 
     core::DataRegistry dataRegistry_;
+    core::DerivedChannels derivedChannels_;
+    core::TriggerEngine triggers_;
     hardware::HardwareServiceClient hardwareService_;
+    hardware::HardwareServiceClient::Options hardwareOptions_;
+    hardware::RelayServer relayServer_;
+    ui::RedrawScheduler redrawScheduler_;
     core::ModuleContext moduleContext_;
     core::PluginManager pluginManager_;
+    // Ticks modules off the UI thread while the screen loop runs.
+    core::ModuleScheduler moduleScheduler_;
     ui::Dashboard dashboard_;
     std::vector<ui::WindowSpec> registeredWindows_;
+    std::string layoutFile_;
+    std::vector<std::unique_ptr<core::CaptureReplay>> replays_;
     bool modulesBootstrapped_ { false };
     // Central redraw notifier: posts UI rebuilds from other threads.
     std::function<void()> postRedrawCallback_;
@@ -0,0 +1,931 @@
+#include "CaptureFile.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace core {
+
+namespace capture {
+
+namespace {
+
+template <typename T>
+T ToLittleEndian(T value)
+{
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+        if constexpr (std::is_floating_point_v<T>) {
+            using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+            return std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+        } else {
+            return std::byteswap(value);
+        }
+    }
+    return value;
+}
+
+template <typename T>
+void Append(std::string& out, T value)
+{
+    value = ToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void AppendArray(std::string& out, const std::vector<T>& values)
+{
+    if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+        out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    } else {
+        for (const auto value : values) {
+            Append(out, value);
+        }
+    }
+}
+
+void Pad(std::string& out)
+{
+    out.resize(PadTo8(out.size()), '\0');
+}
+
+void AppendHeader(std::string& out, const FileHeader& header)
+{
+    out.append(header.magic, sizeof(header.magic));
+    Append(out, header.version);
+    Append(out, header.metadataBytes);
+}
+
+void AppendHeader(std::string& out, const ChunkHeader& header)
+{
+    Append(out, header.magic);
+    Append(out, header.columnCount);
+    Append(out, header.frameCount);
+    Append(out, header.reserved);
+    Append(out, header.payloadBytes);
+    Append(out, header.firstTimestampNs);
+    Append(out, header.lastTimestampNs);
+}
+
+void AppendHeader(std::string& out, const ColumnHeader& header)
+{
+    Append(out, static_cast<std::uint8_t>(header.kind));
+    Append(out, header.reserved);
+    Append(out, header.channelIdBytes);
+    Append(out, header.unitBytes);
+    Append(out, header.reserved2);
+    Append(out, header.rows);
+    Append(out, header.reserved3);
+}
+
+void AppendHeader(std::string& out, const ChunkIndexEntry& entry)
+{
+    Append(out, entry.offset);
+    Append(out, entry.bytes);
+    Append(out, entry.firstTimestampNs);
+    Append(out, entry.lastTimestampNs);
+    Append(out, entry.frameCount);
+    Append(out, entry.reserved);
+}
+
+void AppendHeader(std::string& out, const FileTrailer& trailer)
+{
+    Append(out, trailer.indexOffset);
+    Append(out, trailer.chunkCount);
+    out.append(trailer.magic, sizeof(trailer.magic));
+}
+
+// Bounds-checked little-endian reader over part of a mapped file. Any read past
+// the end clears ok() and yields zeroes from then on.
+class Cursor {
+public:
+    Cursor(const std::uint8_t* data, std::size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] std::size_t offset() const { return offset_; }
+
+    template <typename T>
+    T read()
+    {
+        T value {};
+        if (need(1, sizeof(T))) {
+            std::memcpy(&value, data_ + offset_, sizeof(T));
+            offset_ += sizeof(T);
+        }
+        return ToLittleEndian(value);
+    }
+
+    template <typename T>
+    void readArray(std::size_t count, std::vector<T>& out)
+    {
+        out.clear();
+        if (!need(count, sizeof(T))) {
+            return;
+        }
+        out.resize(count);
+        std::memcpy(out.data(), data_ + offset_, count * sizeof(T));
+        offset_ += count * sizeof(T);
+        if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+            for (auto& value : out) {
+                value = ToLittleEndian(value);
+            }
+        }
+    }
+
+    std::string_view bytes(std::size_t count)
+    {
+        if (!need(count, 1)) {
+            return {};
+        }
+        const std::string_view view(reinterpret_cast<const char*>(data_ + offset_), count);
+        offset_ += count;
+        return view;
+    }
+
+    void align()
+    {
+        const std::size_t aligned = PadTo8(offset_);
+        if (need(aligned - offset_, 1)) {
+            offset_ = aligned;
+        }
+    }
+
+private:
+    bool need(std::size_t count, std::size_t width)
+    {
+        if (ok_ && count > (size_ - offset_) / width) {
+            ok_ = false;
+        }
+        return ok_;
+    }
+
+    const std::uint8_t* data_;
+    std::size_t size_;
+    std::size_t offset_ { 0 };
+    bool ok_ { true };
+};
+
+ChunkHeader ReadChunkHeader(Cursor& cursor)
+{
+    ChunkHeader header {};
+    header.magic = cursor.read<std::uint32_t>();
+    header.columnCount = cursor.read<std::uint32_t>();
+    header.frameCount = cursor.read<std::uint32_t>();
+    header.reserved = cursor.read<std::uint32_t>();
+    header.payloadBytes = cursor.read<std::uint64_t>();
+    header.firstTimestampNs = cursor.read<std::int64_t>();
+    header.lastTimestampNs = cursor.read<std::int64_t>();
+    return header;
+}
+
+// `ends` of a variable-length column must be cumulative; whether the elements
+// they describe fit in the chunk is left to the cursor.
+bool ValidEnds(const std::vector<std::uint64_t>& ends)
+{
+    return std::is_sorted(ends.begin(), ends.end());
+}
+
+ColumnKind KindOf(const DataPayload& payload)
+{
+    if (std::holds_alternative<NumericSample>(payload)) {
+        return ColumnKind::Numeric;
+    }
+    if (std::holds_alternative<WaveformSample>(payload)) {
+        return ColumnKind::Waveform;
+    }
+    if (std::holds_alternative<SerialSample>(payload)) {
+        return ColumnKind::Serial;
+    }
+    if (std::holds_alternative<LogicSample>(payload)) {
+        return ColumnKind::Logic;
+    }
+    return ColumnKind::Gpio;
+}
+
+std::string_view UnitOf(const DataPayload& payload)
+{
+    if (const auto* numeric = std::get_if<NumericSample>(&payload)) {
+        return numeric->unit;
+    }
+    return {};
+}
+
+} // namespace
+
+std::int64_t ToNanoseconds(std::chrono::system_clock::time_point timestamp)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+}
+
+ChunkBuilder::Column& ChunkBuilder::column(std::size_t hint, ColumnKind kind, const std::string& channelId, std::string_view unit)
+{
+    // Sources usually send the same channels in the same order, so the column at
+    // the point's position nearly always matches.
+    auto matches = [&](const Column& c) {
+        return c.kind == kind && c.channelId == channelId && c.unit == unit;
+    };
+    if (hint < columns.size() && matches(columns[hint])) {
+        return columns[hint];
+    }
+    for (auto& c : columns) {
+        if (matches(c)) {
+            return c;
+        }
+    }
+    auto& created = columns.emplace_back();
+    created.kind = kind;
+    created.channelId = channelId;
+    created.unit = unit;
+    payloadEstimate += sizeof(ColumnHeader) + PadTo8(channelId.size() + unit.size());
+    return created;
+}
+
+bool ChunkBuilder::add(const DataFrame& frame)
+{
+    const auto frameIndex = static_cast<std::uint32_t>(timestampsNs.size());
+    bool recorded = false;
+    std::size_t position = 0;
+    for (const auto& point : frame.points) {
+        const auto& payload = point.payload;
+        if (std::holds_alternative<std::monostate>(payload)) {
+            continue;
+        }
+        auto& c = column(position++, KindOf(payload), point.channelId, UnitOf(payload));
+        c.frameIndex.push_back(frameIndex);
+        payloadEstimate += sizeof(std::uint32_t);
+        recorded = true;
+
+        if (const auto* numeric = std::get_if<NumericSample>(&payload)) {
+            c.values.push_back(numeric->value);
+            payloadEstimate += sizeof(double);
+        } else if (const auto* waveform = std::get_if<WaveformSample>(&payload)) {
+            c.values.push_back(waveform->sampleRateHz);
+            c.samples.insert(c.samples.end(), waveform->samples.begin(), waveform->samples.end());
+            c.ends.push_back(c.samples.size());
+            payloadEstimate += 2 * sizeof(double) + waveform->samples.size() * sizeof(double);
+        } else if (const auto* serial = std::get_if<SerialSample>(&payload)) {
+            c.bytes += serial->text;
+            c.ends.push_back(c.bytes.size());
+            payloadEstimate += sizeof(std::uint64_t) + serial->text.size();
+        } else if (const auto* logic = std::get_if<LogicSample>(&payload)) {
+            c.channelCounts.push_back(logic->channelCount);
+            c.periodsNs.push_back(logic->samplePeriod.count());
+            c.words.insert(c.words.end(), logic->words.begin(), logic->words.end());
+            c.ends.push_back(c.words.size());
+            payloadEstimate += 4 * sizeof(std::uint64_t) + logic->words.size() * sizeof(std::uint64_t);
+        } else if (const auto* gpio = std::get_if<GpioState>(&payload)) {
+            c.channelCounts.push_back(gpio->pins.count);
+            c.periodsNs.push_back(0);
+            c.words.insert(c.words.end(), gpio->pins.words.begin(), gpio->pins.words.end());
+            c.ends.push_back(c.words.size());
+            payloadEstimate += 4 * sizeof(std::uint64_t) + gpio->pins.words.size() * sizeof(std::uint64_t);
+        }
+    }
+    if (!recorded) {
+        return false;
+    }
+    timestampsNs.push_back(ToNanoseconds(frame.timestamp));
+    payloadEstimate += sizeof(std::int64_t);
+    return true;
+}
+
+void ChunkBuilder::encode(std::string& out) const
+{
+    const std::size_t start = out.size();
+    ChunkHeader header {};
+    header.magic = kChunkMagic;
+    header.columnCount = static_cast<std::uint32_t>(columns.size());
+    header.frameCount = static_cast<std::uint32_t>(timestampsNs.size());
+    header.firstTimestampNs = timestampsNs.empty() ? 0 : timestampsNs.front();
+    header.lastTimestampNs = timestampsNs.empty() ? 0 : timestampsNs.back();
+    AppendHeader(out, header);
+    AppendArray(out, timestampsNs);
+
+    for (const auto& c : columns) {
+        ColumnHeader columnHeader {};
+        columnHeader.kind = c.kind;
+        columnHeader.channelIdBytes = static_cast<std::uint16_t>(std::min<std::size_t>(c.channelId.size(), 0xFFFF));
+        columnHeader.unitBytes = static_cast<std::uint16_t>(std::min<std::size_t>(c.unit.size(), 0xFFFF));
+        columnHeader.rows = static_cast<std::uint32_t>(c.frameIndex.size());
+        AppendHeader(out, columnHeader);
+        out.append(c.channelId.data(), columnHeader.channelIdBytes);
+        out.append(c.unit.data(), columnHeader.unitBytes);
+        Pad(out);
+        AppendArray(out, c.frameIndex);
+        Pad(out);
+        switch (c.kind) {
+        case ColumnKind::Numeric:
+            AppendArray(out, c.values);
+            break;
+        case ColumnKind::Waveform:
+            AppendArray(out, c.values);
+            AppendArray(out, c.ends);
+            AppendArray(out, c.samples);
+            break;
+        case ColumnKind::Serial:
+            AppendArray(out, c.ends);
+            out += c.bytes;
+            Pad(out);
+            break;
+        case ColumnKind::Logic:
+        case ColumnKind::Gpio:
+            AppendArray(out, c.channelCounts);
+            Pad(out);
+            AppendArray(out, c.periodsNs);
+            AppendArray(out, c.ends);
+            AppendArray(out, c.words);
+            break;
+        }
+    }
+
+    // Patch the payload size into the header now that the columns are laid out.
+    const auto payloadBytes = ToLittleEndian(static_cast<std::uint64_t>(out.size() - start - sizeof(ChunkHeader)));
+    std::memcpy(out.data() + start + offsetof(ChunkHeader, payloadBytes), &payloadBytes, sizeof(payloadBytes));
+}
+
+} // namespace capture
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const std::string& path)
+{
+    close();
+    path_ = path;
+
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        spdlog::error("CaptureReader: cannot open '{}': {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        spdlog::error("CaptureReader: '{}' is empty or unreadable", path);
+        ::close(fd);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        spdlog::error("CaptureReader: cannot map '{}': {}", path, std::strerror(errno));
+        return false;
+    }
+    // Replays read front to back; let the kernel read ahead.
+    ::madvise(mapping, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const std::uint8_t*>(mapping);
+    size_ = static_cast<std::size_t>(info.st_size);
+#else
+    std::ifstream file(path, std::ios::binary);
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (buffer_.empty()) {
+        spdlog::error("CaptureReader: cannot read '{}'", path);
+        return false;
+    }
+    data_ = reinterpret_cast<const std::uint8_t*>(buffer_.data());
+    size_ = buffer_.size();
+#endif
+
+    capture::Cursor cursor(data_, size_);
+    const auto magic = cursor.bytes(sizeof(capture::kFileMagic));
+    const auto version = cursor.read<std::uint32_t>();
+    const auto metadataBytes = cursor.read<std::uint32_t>();
+    if (!cursor.ok() || magic != std::string_view(capture::kFileMagic, sizeof(capture::kFileMagic))) {
+        spdlog::error("CaptureReader: '{}' is not a capture file", path);
+        close();
+        return false;
+    }
+    if (version != capture::kVersion) {
+        spdlog::error("CaptureReader: '{}' has unsupported version {}", path, version);
+        close();
+        return false;
+    }
+
+    metadata_.kind = static_cast<DataKind>(cursor.read<std::uint8_t>());
+    const bool hasUnit = cursor.read<std::uint8_t>() != 0;
+    cursor.read<std::uint16_t>();
+    std::string* fields[] = { &metadata_.id, &metadata_.name, &metadata_.description };
+    for (auto* field : fields) {
+        *field = std::string(cursor.bytes(cursor.read<std::uint16_t>()));
+    }
+    const std::string unit(cursor.bytes(cursor.read<std::uint16_t>()));
+    if (hasUnit) {
+        metadata_.unit = unit;
+    }
+    firstChunkOffset_ = sizeof(capture::FileHeader) + std::size_t { metadataBytes };
+    if (!cursor.ok() || cursor.offset() > firstChunkOffset_ || firstChunkOffset_ > size_ || metadata_.id.empty()) {
+        spdlog::error("CaptureReader: '{}' has a damaged header", path);
+        close();
+        return false;
+    }
+
+    if (!readIndex()) {
+        scanChunks();
+        spdlog::warn("CaptureReader: '{}' has no chunk index (not closed cleanly?); recovered {} chunks", path, index_.size());
+    }
+    for (const auto& entry : index_) {
+        frameCount_ += entry.frameCount;
+    }
+    spdlog::info("CaptureReader: opened '{}' ({} frames in {} chunks)", path, frameCount_, index_.size());
+    return true;
+}
+
+void CaptureReader::close()
+{
+#ifndef _WIN32
+    if (data_) {
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+#else
+    buffer_.clear();
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    firstChunkOffset_ = 0;
+    metadata_ = {};
+    index_.clear();
+    frameCount_ = 0;
+}
+
+bool CaptureReader::readIndex()
+{
+    if (size_ < firstChunkOffset_ + sizeof(capture::FileTrailer)) {
+        return false;
+    }
+    const std::size_t trailerOffset = size_ - sizeof(capture::FileTrailer);
+    capture::Cursor trailer(data_ + trailerOffset, sizeof(capture::FileTrailer));
+    const auto indexOffset = trailer.read<std::uint64_t>();
+    const auto chunkCount = trailer.read<std::uint64_t>();
+    if (trailer.bytes(sizeof(capture::kIndexMagic)) != std::string_view(capture::kIndexMagic, sizeof(capture::kIndexMagic))) {
+        return false;
+    }
+    if (indexOffset < firstChunkOffset_ || indexOffset > trailerOffset
+        || (trailerOffset - indexOffset) / sizeof(capture::ChunkIndexEntry) != chunkCount
+        || (trailerOffset - indexOffset) % sizeof(capture::ChunkIndexEntry) != 0) {
+        return false;
+    }
+
+    capture::Cursor cursor(data_ + indexOffset, trailerOffset - indexOffset);
+    std::uint64_t expectedOffset = firstChunkOffset_;
+    index_.reserve(chunkCount);
+    for (std::uint64_t i = 0; i < chunkCount; ++i) {
+        capture::ChunkIndexEntry entry {};
+        entry.offset = cursor.read<std::uint64_t>();
+        entry.bytes = cursor.read<std::uint64_t>();
+        entry.firstTimestampNs = cursor.read<std::int64_t>();
+        entry.lastTimestampNs = cursor.read<std::int64_t>();
+        entry.frameCount = cursor.read<std::uint32_t>();
+        entry.reserved = cursor.read<std::uint32_t>();
+        // Chunks are contiguous, so a sane index tiles the file up to itself.
+        if (entry.offset != expectedOffset || entry.bytes > indexOffset - entry.offset) {
+            index_.clear();
+            return false;
+        }
+        expectedOffset = entry.offset + entry.bytes;
+        index_.push_back(entry);
+    }
+    return expectedOffset == indexOffset;
+}
+
+void CaptureReader::scanChunks()
+{
+    index_.clear();
+    std::size_t offset = firstChunkOffset_;
+    while (size_ - offset >= sizeof(capture::ChunkHeader)) {
+        capture::Cursor cursor(data_ + offset, size_ - offset);
+        const auto header = capture::ReadChunkHeader(cursor);
+        // Stops at the first chunk that was cut short or never written.
+        if (header.magic != capture::kChunkMagic || header.payloadBytes > size_ - offset - sizeof(capture::ChunkHeader)) {
+            break;
+        }
+        capture::ChunkIndexEntry entry {};
+        entry.offset = offset;
+        entry.bytes = sizeof(capture::ChunkHeader) + header.payloadBytes;
+        entry.firstTimestampNs = header.firstTimestampNs;
+        entry.lastTimestampNs = header.lastTimestampNs;
+        entry.frameCount = header.frameCount;
+        index_.push_back(entry);
+        offset += entry.bytes;
+    }
+}
+
+std::int64_t CaptureReader::firstTimestampNs() const
+{
+    return index_.empty() ? 0 : index_.front().firstTimestampNs;
+}
+
+std::int64_t CaptureReader::lastTimestampNs() const
+{
+    return index_.empty() ? 0 : index_.back().lastTimestampNs;
+}
+
+std::size_t CaptureReader::findChunk(std::int64_t timestampNs) const
+{
+    if (index_.empty()) {
+        return 0;
+    }
+    const auto it = std::lower_bound(index_.begin(), index_.end(), timestampNs,
+        [](const capture::ChunkIndexEntry& entry, std::int64_t ns) { return entry.lastTimestampNs < ns; });
+    return std::min<std::size_t>(static_cast<std::size_t>(it - index_.begin()), index_.size() - 1);
+}
+
+bool CaptureReader::readChunk(std::size_t index, std::vector<DataFrame>& frames) const
+{
+    if (index >= index_.size()) {
+        frames.clear();
+        return false;
+    }
+    const auto& entry = index_[index];
+    capture::Cursor cursor(data_ + entry.offset, entry.bytes);
+    const auto header = capture::ReadChunkHeader(cursor);
+    auto fail = [&]() {
+        spdlog::warn("CaptureReader: chunk {} of '{}' is malformed", index, path_);
+        frames.clear();
+        return false;
+    };
+    if (header.magic != capture::kChunkMagic || header.payloadBytes + sizeof(capture::ChunkHeader) != entry.bytes) {
+        return fail();
+    }
+
+    std::vector<std::int64_t> timestamps;
+    cursor.readArray(header.frameCount, timestamps);
+    if (!cursor.ok()) {
+        return fail();
+    }
+    frames.resize(header.frameCount);
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        auto& frame = frames[i];
+        frame.sourceId = metadata_.id;
+        frame.sourceName = metadata_.name;
+        frame.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamps[i])));
+        frame.points.clear();
+    }
+
+    std::vector<std::uint32_t> frameIndex;
+    std::vector<double> values;
+    std::vector<std::uint64_t> ends;
+    std::vector<std::uint32_t> channelCounts;
+    std::vector<std::int64_t> periods;
+    for (std::uint32_t c = 0; c < header.columnCount; ++c) {
+        const auto kind = static_cast<capture::ColumnKind>(cursor.read<std::uint8_t>());
+        cursor.read<std::uint8_t>();
+        const auto idBytes = cursor.read<std::uint16_t>();
+        const auto unitBytes = cursor.read<std::uint16_t>();
+        cursor.read<std::uint16_t>();
+        const auto rows = cursor.read<std::uint32_t>();
+        cursor.read<std::uint32_t>();
+        const std::string channelId(cursor.bytes(idBytes));
+        const std::string unit(cursor.bytes(unitBytes));
+        cursor.align();
+        cursor.readArray(rows, frameIndex);
+        cursor.align();
+        if (!cursor.ok() || std::any_of(frameIndex.begin(), frameIndex.end(), [&](std::uint32_t i) { return i >= frames.size(); })) {
+            return fail();
+        }
+
+        // Points are appended in column order, which is the order the recorder first
+        // saw each channel.
+        auto addPoint = [&](std::size_t row) -> DataPoint& {
+            auto& frame = frames[frameIndex[row]];
+            auto& point = frame.points.emplace_back();
+            point.channelId = channelId;
+            return point;
+        };
+        switch (kind) {
+        case capture::ColumnKind::Numeric:
+            cursor.readArray(rows, values);
+            if (!cursor.ok()) {
+                return fail();
+            }
+            for (std::size_t r = 0; r < rows; ++r) {
+                auto& point = addPoint(r);
+                point.payload = NumericSample { values[r], unit, frames[frameIndex[r]].timestamp };
+            }
+            break;
+        case capture::ColumnKind::Waveform: {
+            cursor.readArray(rows, values);
+            cursor.readArray(rows, ends);
+            if (!cursor.ok() || !capture::ValidEnds(ends)) {
+                return fail();
+            }
+            std::vector<double> samples;
+            cursor.readArray(ends.empty() ? 0 : ends.back(), samples);
+            if (!cursor.ok()) {
+                return fail();
+            }
+            for (std::size_t r = 0; r < rows; ++r) {
+                const std::uint64_t begin = r == 0 ? 0 : ends[r - 1];
+                WaveformSample sample;
+                sample.samples.assign(samples.begin() + static_cast<std::ptrdiff_t>(begin), samples.begin() + static_cast<std::ptrdiff_t>(ends[r]));
+                sample.sampleRateHz = values[r];
+                sample.timestamp = frames[frameIndex[r]].timestamp;
+                addPoint(r).payload = std::move(sample);
+            }
+            break;
+        }
+        case capture::ColumnKind::Serial: {
+            cursor.readArray(rows, ends);
+            if (!cursor.ok() || !capture::ValidEnds(ends)) {
+                return fail();
+            }
+            const auto text = cursor.bytes(ends.empty() ? 0 : ends.back());
+            cursor.align();
+            if (!cursor.ok()) {
+                return fail();
+            }
+            for (std::size_t r = 0; r < rows; ++r) {
+                const std::uint64_t begin = r == 0 ? 0 : ends[r - 1];
+                addPoint(r).payload = SerialSample { std::string(text.substr(begin, ends[r] - begin)), frames[frameIndex[r]].timestamp };
+            }
+            break;
+        }
+        case capture::ColumnKind::Logic:
+        case capture::ColumnKind::Gpio: {
+            cursor.readArray(rows, channelCounts);
+            cursor.align();
+            cursor.readArray(rows, periods);
+            cursor.readArray(rows, ends);
+            if (!cursor.ok() || !capture::ValidEnds(ends)) {
+                return fail();
+            }
+            std::vector<std::uint64_t> words;
+            cursor.readArray(ends.empty() ? 0 : ends.back(), words);
+            if (!cursor.ok()) {
+                return fail();
+            }
+            for (std::size_t r = 0; r < rows; ++r) {
+                const auto first = words.begin() + static_cast<std::ptrdiff_t>(r == 0 ? 0 : ends[r - 1]);
+                const auto last = words.begin() + static_cast<std::ptrdiff_t>(ends[r]);
+                if (kind == capture::ColumnKind::Logic) {
+                    LogicSample sample;
+                    sample.channelCount = channelCounts[r];
+                    sample.words.assign(first, last);
+                    sample.samplePeriod = std::chrono::nanoseconds(periods[r]);
+                    sample.timestamp = frames[frameIndex[r]].timestamp;
+                    addPoint(r).payload = std::move(sample);
+                } else {
+                    GpioState state;
+                    state.pins.count = channelCounts[r];
+                    state.pins.words.assign(first, last);
+                    state.timestamp = frames[frameIndex[r]].timestamp;
+                    addPoint(r).payload = std::move(state);
+                }
+            }
+            break;
+        }
+        default:
+            return fail();
+        }
+    }
+    return true;
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path, const SourceMetadata& metadata, CaptureOptions options)
+{
+    close();
+
+    std::error_code ec;
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        spdlog::error("CaptureWriter: cannot create '{}'", path);
+        return false;
+    }
+
+    path_ = path;
+    options_ = options;
+    options_.chunkFrames = std::max<std::size_t>(options_.chunkFrames, 1);
+    options_.maxPendingChunks = std::max<std::size_t>(options_.maxPendingChunks, 1);
+    fileOffset_ = 0;
+    index_.clear();
+    current_ = {};
+    stats_ = {};
+
+    std::string meta;
+    capture::Append(meta, static_cast<std::uint8_t>(metadata.kind));
+    capture::Append(meta, static_cast<std::uint8_t>(metadata.unit.has_value()));
+    capture::Append(meta, std::uint16_t { 0 });
+    for (const std::string_view text : { std::string_view(metadata.id), std::string_view(metadata.name),
+             std::string_view(metadata.description), std::string_view(metadata.unit.value_or("")) }) {
+        const auto length = static_cast<std::uint16_t>(std::min<std::size_t>(text.size(), 0xFFFF));
+        capture::Append(meta, length);
+        meta.append(text.data(), length);
+    }
+    capture::Pad(meta);
+
+    capture::FileHeader header {};
+    std::memcpy(header.magic, capture::kFileMagic, sizeof(header.magic));
+    header.version = capture::kVersion;
+    header.metadataBytes = static_cast<std::uint32_t>(meta.size());
+    std::string prefix;
+    capture::AppendHeader(prefix, header);
+    prefix += meta;
+    if (!writeBytes(prefix)) {
+        file_.close();
+        return false;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        open_ = true;
+        stopping_ = false;
+    }
+    writer_ = std::thread(&CaptureWriter::run, this);
+    spdlog::info("CaptureWriter: recording '{}' to '{}'", metadata.id, path);
+    return true;
+}
+
+void CaptureWriter::append(const DataFrame& frame)
+{
+    std::lock_guard appendLock(appendMutex_);
+    {
+        std::lock_guard lock(mutex_);
+        if (!open_ || stopping_ || stats_.failed) {
+            return;
+        }
+    }
+    const bool first = current_.empty();
+    if (!current_.add(frame)) {
+        return;
+    }
+    if (first) {
+        currentStarted_ = std::chrono::steady_clock::now();
+    }
+    if (current_.timestampsNs.size() >= options_.chunkFrames || current_.payloadEstimate >= options_.chunkBytes) {
+        sealLocked();
+    }
+}
+
+void CaptureWriter::sealLocked()
+{
+    if (current_.empty()) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        if (pending_.size() >= options_.maxPendingChunks) {
+            // The disk is behind; losing a chunk beats blocking ingest.
+            stats_.droppedFrames += current_.timestampsNs.size();
+            current_ = {};
+            return;
+        }
+        pending_.push_back(std::move(current_));
+    }
+    current_ = {};
+    cv_.notify_one();
+}
+
+void CaptureWriter::sealStale()
+{
+    std::lock_guard appendLock(appendMutex_);
+    if (!isOpen() || current_.empty()) {
+        return;
+    }
+    if (std::chrono::steady_clock::now() - currentStarted_ >= options_.chunkAge) {
+        sealLocked();
+    }
+}
+
+void CaptureWriter::close()
+{
+    {
+        std::lock_guard appendLock(appendMutex_);
+        if (!isOpen()) {
+            return;
+        }
+        sealLocked();
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    std::string tail;
+    const std::uint64_t indexOffset = fileOffset_;
+    for (const auto& entry : index_) {
+        capture::AppendHeader(tail, entry);
+    }
+    capture::FileTrailer trailer {};
+    trailer.indexOffset = indexOffset;
+    trailer.chunkCount = index_.size();
+    std::memcpy(trailer.magic, capture::kIndexMagic, sizeof(trailer.magic));
+    capture::AppendHeader(tail, trailer);
+    writeBytes(tail);
+    file_.close();
+
+    std::lock_guard lock(mutex_);
+    open_ = false;
+    spdlog::info("CaptureWriter: closed '{}' ({} frames in {} chunks, {} bytes, {} frames dropped)", path_, stats_.frames,
+        stats_.chunks, stats_.bytes, stats_.droppedFrames);
+}
+
+bool CaptureWriter::isOpen() const
+{
+    std::lock_guard lock(mutex_);
+    return open_ && !stopping_;
+}
+
+CaptureWriter::Stats CaptureWriter::stats() const
+{
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void CaptureWriter::run()
+{
+    std::string buffer;
+    std::unique_lock lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;
+        }
+        auto chunk = std::move(pending_.front());
+        pending_.pop_front();
+        if (stats_.failed) {
+            stats_.droppedFrames += chunk.timestampsNs.size();
+            continue;
+        }
+        lock.unlock();
+
+        buffer.clear();
+        chunk.encode(buffer);
+        capture::ChunkIndexEntry entry {};
+        entry.offset = fileOffset_;
+        entry.bytes = buffer.size();
+        entry.firstTimestampNs = chunk.timestampsNs.front();
+        entry.lastTimestampNs = chunk.timestampsNs.back();
+        entry.frameCount = static_cast<std::uint32_t>(chunk.timestampsNs.size());
+        const bool ok = writeBytes(buffer);
+        if (ok) {
+            // Complete chunks reach the OS as they are sealed, so a crash loses at
+            // most the chunks still in memory.
+            file_.flush();
+            index_.push_back(entry);
+        }
+
+        lock.lock();
+        if (ok) {
+            stats_.frames += entry.frameCount;
+            ++stats_.chunks;
+            stats_.bytes = fileOffset_;
+        } else {
+            stats_.droppedFrames += entry.frameCount;
+            stats_.failed = true;
+            spdlog::error("CaptureWriter: stopped recording '{}' after a failed write", path_);
+        }
+    }
+}
+
+bool CaptureWriter::writeBytes(const std::string& bytes)
+{
+    file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file_) {
+        spdlog::error("CaptureWriter: write to '{}' failed", path_);
+        file_.clear();
+        // Part of it may have landed; the index must point past whatever did.
+        const auto position = file_.tellp();
+        if (position >= 0) {
+            fileOffset_ = static_cast<std::uint64_t>(position);
+        }
+        return false;
+    }
+    fileOffset_ += bytes.size();
+    return true;
+}
+
+} // namespace core
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "Types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace core {
+
+/**
+ * Capture files (`.wbcap`) hold one source's frames, append-only and columnar.
+ *
+ * Everything is little-endian and every section starts on an 8-byte boundary, so
+ * a mapped file can be read in place:
+ *
+ *   FileHeader, source metadata
+ *   chunk*        ChunkHeader, i64 frame timestamps (ns since epoch), columns
+ *   index         ChunkIndexEntry per chunk
+ *   FileTrailer   where the index starts
+ *
+ * A column holds one (channel, payload kind, unit) over the chunk's frames: the
+ * index of the frame each row belongs to, then packed values (see
+ * `hardware/README.md` for the per-kind layout). The index and trailer are written
+ * on close; a file cut short by a crash is still readable by hopping from chunk
+ * header to chunk header.
+ */
+namespace capture {
+
+constexpr char kFileMagic[8] = { 'W', 'B', 'C', 'A', 'P', 'T', 'R', '1' };
+constexpr char kIndexMagic[8] = { 'W', 'B', 'I', 'N', 'D', 'E', 'X', '1' };
+constexpr std::uint32_t kChunkMagic = 0x4B4E4843; // "CHNK"
+constexpr std::uint32_t kVersion = 1;
+
+// Same numbering as the binary relay payload tags.
+enum class ColumnKind : std::uint8_t {
+    Numeric = 1,
+    Waveform = 2,
+    Serial = 3,
+    Logic = 4,
+    Gpio = 5,
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    // Bytes of source metadata that follow, padding included.
+    std::uint32_t metadataBytes;
+};
+static_assert(sizeof(FileHeader) == 16);
+
+struct ChunkHeader {
+    std::uint32_t magic;
+    std::uint32_t columnCount;
+    std::uint32_t frameCount;
+    std::uint32_t reserved;
+    // Bytes after this header up to the next chunk.
+    std::uint64_t payloadBytes;
+    std::int64_t firstTimestampNs;
+    std::int64_t lastTimestampNs;
+};
+static_assert(sizeof(ChunkHeader) == 40);
+
+struct ColumnHeader {
+    ColumnKind kind;
+    std::uint8_t reserved;
+    std::uint16_t channelIdBytes;
+    std::uint16_t unitBytes;
+    std::uint16_t reserved2;
+    std::uint32_t rows;
+    std::uint32_t reserved3;
+};
+static_assert(sizeof(ColumnHeader) == 16);
+
+struct ChunkIndexEntry {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+    std::int64_t firstTimestampNs;
+    std::int64_t lastTimestampNs;
+    std::uint32_t frameCount;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(ChunkIndexEntry) == 40);
+
+struct FileTrailer {
+    std::uint64_t indexOffset;
+    std::uint64_t chunkCount;
+    char magic[8];
+};
+static_assert(sizeof(FileTrailer) == 24);
+
+constexpr std::size_t PadTo8(std::size_t bytes)
+{
+    return (bytes + 7) & ~std::size_t{7};
+}
+
+// One chunk's frames in columnar form, filled on the recording thread and encoded
+// on the writer thread.
+struct ChunkBuilder {
+    struct Column {
+        ColumnKind kind{ColumnKind::Numeric};
+        std::string channelId;
+        std::string unit;
+        std::vector<std::uint32_t> frameIndex;
+        // Numeric values, or waveform sample rates.
+        std::vector<double> values;
+        // Cumulative element counts per row for variable-length payloads.
+        std::vector<std::uint64_t> ends;
+        std::vector<double> samples;
+        std::vector<std::uint64_t> words;
+        std::vector<std::uint32_t> channelCounts;
+        std::vector<std::int64_t> periodsNs;
+        std::string bytes;
+    };
+
+    std::vector<std::int64_t> timestampsNs;
+    std::vector<Column> columns;
+    std::size_t payloadEstimate{0};
+
+    [[nodiscard]] bool empty() const { return timestampsNs.empty(); }
+    // Adds `frame` as the next row; returns false for frames with nothing recordable.
+    bool add(const DataFrame& frame);
+    // Appends the encoded chunk, header included, to `out`.
+    void encode(std::string& out) const;
+
+private:
+    Column& column(std::size_t hint, ColumnKind kind, const std::string& channelId, std::string_view unit);
+};
+
+std::int64_t ToNanoseconds(std::chrono::system_clock::time_point timestamp);
+
+}  // namespace capture
+
+struct CaptureOptions {
+    // A chunk is sealed when it holds this many frames or this many payload bytes.
+    std::size_t chunkFrames{4096};
+    std::size_t chunkBytes{std::size_t{4} << 20};
+    // ...or, through sealStale(), once its first frame is this old, so a slow source
+    // does not sit in memory for an hour before reaching the disk.
+    std::chrono::milliseconds chunkAge{std::chrono::seconds(10)};
+    // Sealed chunks waiting for the disk; beyond this, new chunks are dropped.
+    std::size_t maxPendingChunks{16};
+};
+
+/**
+ * @brief Read-only view of a capture file, memory-mapped.
+ *
+ * `open()` reads only the header, metadata and chunk index (or, for a file that
+ * was never closed, walks the chunk headers), so opening and seeking cost the
+ * same however long the capture is. Chunks are decoded on demand straight from
+ * the mapping. Every offset and length is bounds-checked; a damaged chunk fails
+ * to decode instead of reading past the file.
+ */
+class CaptureReader {
+public:
+    CaptureReader() = default;
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    // Maps `path`; returns false and logs when it is not a readable capture file.
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return data_ != nullptr; }
+    [[nodiscard]] const std::string& path() const { return path_; }
+    [[nodiscard]] const SourceMetadata& metadata() const { return metadata_; }
+    [[nodiscard]] const std::vector<capture::ChunkIndexEntry>& chunks() const { return index_; }
+    [[nodiscard]] std::uint64_t frameCount() const { return frameCount_; }
+    [[nodiscard]] std::int64_t firstTimestampNs() const;
+    [[nodiscard]] std::int64_t lastTimestampNs() const;
+
+    // Index of the first chunk that ends at or after `timestampNs`, clamped to the
+    // last chunk. A binary search over the index; no chunk is touched.
+    [[nodiscard]] std::size_t findChunk(std::int64_t timestampNs) const;
+    // Decodes chunk `index` into `frames`, one per recorded frame, reusing the
+    // vector's frames. Returns false (and leaves `frames` empty) when the chunk is malformed.
+    bool readChunk(std::size_t index, std::vector<DataFrame>& frames) const;
+
+private:
+    bool readIndex();
+    void scanChunks();
+
+    std::string path_;
+    const std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    std::size_t firstChunkOffset_{0};
+    SourceMetadata metadata_;
+    std::vector<capture::ChunkIndexEntry> index_;
+    std::uint64_t frameCount_{0};
+#ifdef _WIN32
+    // No mmap here; the file is read into memory instead.
+    std::vector<char> buffer_;
+#endif
+};
+
+/**
+ * @brief Appends one source's frames to a capture file from a background thread.
+ *
+ * `append()` only copies the frame into the open chunk's columns, so it is safe
+ * to call from an ingest observer. Sealed chunks are encoded and written by the
+ * writer thread; if the disk falls behind by more than `maxPendingChunks`, whole
+ * chunks are dropped and counted instead of stalling the caller. The first failed
+ * write stops the recording; the file is closed with an index of the chunks before it.
+ */
+class CaptureWriter {
+public:
+    struct Stats {
+        std::uint64_t frames{0};
+        std::uint64_t chunks{0};
+        std::uint64_t bytes{0};
+        std::uint64_t droppedFrames{0};
+        bool failed{false};
+    };
+
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Creates (truncating) `path`; returns false and logs when it cannot be written.
+    bool open(const std::string& path, const SourceMetadata& metadata, CaptureOptions options = {});
+    void append(const DataFrame& frame);
+    // Seals the open chunk if it is older than `chunkAge`; call periodically.
+    void sealStale();
+    // Seals the open chunk, drains the writer and writes the chunk index.
+    void close();
+
+    [[nodiscard]] bool isOpen() const;
+    [[nodiscard]] const std::string& path() const { return path_; }
+    [[nodiscard]] Stats stats() const;
+
+private:
+    void sealLocked();
+    void run();
+    bool writeBytes(const std::string& bytes);
+
+    std::string path_;
+    CaptureOptions options_;
+    std::ofstream file_;
+    std::uint64_t fileOffset_{0};
+    std::vector<capture::ChunkIndexEntry> index_;
+
+    // Guards the open chunk; held only while a frame is copied in.
+    std::mutex appendMutex_;
+    capture::ChunkBuilder current_;
+    std::chrono::steady_clock::time_point currentStarted_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<capture::ChunkBuilder> pending_;
+    std::thread writer_;
+    bool open_{false};
+    bool stopping_{false};
+    Stats stats_;
+};
+
+}  // namespace core
@@ -0,0 +1,249 @@
+#include "CaptureReplay.h"
+
+#include "DataRegistry.h"
+#include "Metrics.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+namespace core {
+
+namespace {
+
+const metrics::Counter kFramesReplayed{"replay.frames"};
+
+void ShiftTimestamps(DataFrame& frame, std::chrono::nanoseconds shift)
+{
+    const auto by = std::chrono::duration_cast<std::chrono::system_clock::duration>(shift);
+    frame.timestamp += by;
+    for (auto& point : frame.points) {
+        std::visit(
+            [by](auto& payload) {
+                if constexpr (requires { payload.timestamp; }) {
+                    payload.timestamp += by;
+                }
+            },
+            point.payload);
+    }
+}
+
+} // namespace
+
+CaptureReplay::CaptureReplay(DataRegistry& registry)
+    : registry_(registry)
+{
+}
+
+CaptureReplay::~CaptureReplay()
+{
+    stop();
+}
+
+bool CaptureReplay::open(const std::string& path, ReplayOptions options)
+{
+    stop();
+    if (!reader_.open(path)) {
+        return false;
+    }
+    if (reader_.frameCount() == 0) {
+        spdlog::warn("CaptureReplay: '{}' holds no frames", path);
+    }
+    options_ = options;
+    originNs_ = reader_.firstTimestampNs();
+    shiftNs_ = 0;
+    lastPublishedNs_.reset();
+    {
+        std::lock_guard lock(mutex_);
+        speed_ = std::max(options.speed, 0.0);
+        positionNs_ = originNs_;
+        published_ = 0;
+    }
+    registry_.registerSource(reader_.metadata());
+    return true;
+}
+
+void CaptureReplay::setOrigin(std::int64_t originNs)
+{
+    std::lock_guard lock(mutex_);
+    originNs_ = originNs;
+    positionNs_ = originNs;
+}
+
+void CaptureReplay::start()
+{
+    std::lock_guard lock(mutex_);
+    if (!reader_.isOpen() || running_) {
+        return;
+    }
+    running_ = true;
+    finished_ = false;
+    seekNs_ = originNs_ + options_.start.count();
+    thread_ = std::thread(&CaptureReplay::run, this);
+    spdlog::info("CaptureReplay: replaying '{}' as '{}' at {}", reader_.path(), reader_.metadata().id,
+        speed_ > 0.0 ? std::to_string(speed_) + "x" : std::string("max speed"));
+}
+
+void CaptureReplay::stop()
+{
+    {
+        std::lock_guard lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void CaptureReplay::seek(std::chrono::nanoseconds position)
+{
+    {
+        std::lock_guard lock(mutex_);
+        seekNs_ = originNs_ + position.count();
+        finished_ = false;
+    }
+    cv_.notify_all();
+}
+
+void CaptureReplay::setSpeed(double speed)
+{
+    {
+        std::lock_guard lock(mutex_);
+        // Re-anchor so the change applies from the current position onward.
+        anchorNs_ = positionNs_;
+        anchorWall_ = std::chrono::steady_clock::now();
+        speed_ = std::max(speed, 0.0);
+    }
+    cv_.notify_all();
+}
+
+std::chrono::nanoseconds CaptureReplay::position() const
+{
+    std::lock_guard lock(mutex_);
+    return std::chrono::nanoseconds(positionNs_ - originNs_);
+}
+
+std::chrono::nanoseconds CaptureReplay::duration() const
+{
+    return std::chrono::nanoseconds(reader_.lastTimestampNs() - originNs_);
+}
+
+double CaptureReplay::speed() const
+{
+    std::lock_guard lock(mutex_);
+    return speed_;
+}
+
+bool CaptureReplay::finished() const
+{
+    std::lock_guard lock(mutex_);
+    return finished_;
+}
+
+std::uint64_t CaptureReplay::framesPublished() const
+{
+    std::lock_guard lock(mutex_);
+    return published_;
+}
+
+void CaptureReplay::load(std::int64_t targetNs)
+{
+    chunk_ = reader_.findChunk(targetNs);
+    reader_.readChunk(chunk_, frames_);
+    const auto it = std::lower_bound(frames_.begin(), frames_.end(), targetNs,
+        [](const DataFrame& frame, std::int64_t ns) { return capture::ToNanoseconds(frame.timestamp) < ns; });
+    next_ = static_cast<std::size_t>(it - frames_.begin());
+}
+
+std::int64_t CaptureReplay::frameIntervalNs() const
+{
+    const auto frames = reader_.frameCount();
+    if (frames < 2) {
+        return kSingleFrameIntervalNs;
+    }
+    const auto span = reader_.lastTimestampNs() - reader_.firstTimestampNs();
+    return std::max<std::int64_t>(span / static_cast<std::int64_t>(frames - 1), 1);
+}
+
+void CaptureReplay::rebase(std::int64_t targetNs)
+{
+    if (!lastPublishedNs_ || targetNs + shiftNs_ > *lastPublishedNs_) {
+        return;
+    }
+    // Leave one average frame interval between the passes, as if the capture ran on.
+    shiftNs_ = *lastPublishedNs_ + frameIntervalNs() - targetNs;
+}
+
+void CaptureReplay::run()
+{
+    std::unique_lock lock(mutex_);
+    bool looped = false;
+    while (running_) {
+        if (seekNs_) {
+            const auto target = *seekNs_;
+            seekNs_.reset();
+            lock.unlock();
+            load(target);
+            rebase(target);
+            lock.lock();
+            // A new pass starts one frame interval after the last frame, in wall time
+            // as well as in the shifted timestamps.
+            anchorNs_ = std::exchange(looped, false) ? target - frameIntervalNs() : target;
+            anchorWall_ = std::chrono::steady_clock::now();
+            positionNs_ = target;
+            continue;
+        }
+
+        if (next_ >= frames_.size()) {
+            if (chunk_ + 1 < reader_.chunks().size()) {
+                // A malformed chunk decodes to nothing and is skipped here.
+                lock.unlock();
+                reader_.readChunk(++chunk_, frames_);
+                next_ = 0;
+                lock.lock();
+                continue;
+            }
+            if (options_.loop && reader_.frameCount() > 0) {
+                seekNs_ = reader_.firstTimestampNs();
+                looped = true;
+                continue;
+            }
+            if (!finished_) {
+                finished_ = true;
+                spdlog::info("CaptureReplay: finished '{}' ({} frames published)", reader_.path(), published_);
+            }
+            cv_.wait(lock, [this] { return !running_ || seekNs_.has_value(); });
+            continue;
+        }
+
+        const auto frameNs = capture::ToNanoseconds(frames_[next_].timestamp);
+        if (speed_ > 0.0) {
+            const auto due = anchorWall_
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::nano>(static_cast<double>(frameNs - anchorNs_) / speed_));
+            if (std::chrono::steady_clock::now() < due) {
+                // Woken early by seek, setSpeed or stop; everything is re-evaluated.
+                cv_.wait_until(lock, due);
+                continue;
+            }
+        }
+        positionNs_ = frameNs;
+        lock.unlock();
+        auto& frame = frames_[next_];
+        if (shiftNs_ != 0) {
+            ShiftTimestamps(frame, std::chrono::nanoseconds(shiftNs_));
+        }
+        lastPublishedNs_ = frameNs + shiftNs_;
+        // The frame comes back holding recycled storage, which the next chunk reuses.
+        registry_.update(std::move(frame));
+        kFramesReplayed.add();
+        ++next_;
+        lock.lock();
+        ++published_;
+    }
+}
+
+} // namespace core
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CaptureFile.h"
+#include "Types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace core {
+
+class DataRegistry;
+
+struct ReplayOptions {
+    // Capture seconds per wall second; 0 publishes as fast as the registry accepts.
+    double speed{1.0};
+    // Start again from the beginning after the last frame.
+    bool loop{false};
+    // Where to start, relative to the origin.
+    std::chrono::nanoseconds start{0};
+};
+
+/**
+ * @brief Publishes a capture file as a live source, paced to its timestamps.
+ *
+ * The file is memory-mapped through `CaptureReader` and decoded a chunk at a time
+ * on the replay thread, which hands each frame to `DataRegistry::update(DataFrame&&)`
+ * when it falls due. Seeking finds the chunk through the index, so it costs the
+ * same anywhere in the file. Loops and backward seeks shift the published timestamps
+ * forward so the source's history never runs backwards; `position()` stays in capture
+ * time. Control methods are safe to call from any thread.
+ */
+class CaptureReplay {
+public:
+    explicit CaptureReplay(DataRegistry& registry);
+    ~CaptureReplay();
+
+    CaptureReplay(const CaptureReplay&) = delete;
+    CaptureReplay& operator=(const CaptureReplay&) = delete;
+
+    // Maps `path` and registers its source with the registry.
+    bool open(const std::string& path, ReplayOptions options = {});
+    // Capture time (ns since epoch) that position 0 refers to; defaults to the file's
+    // first frame. Files recorded together share one origin to stay in step. Call
+    // before start().
+    void setOrigin(std::int64_t originNs);
+    void start();
+    void stop();
+
+    // Jumps to `position` past the origin; playback continues from there.
+    void seek(std::chrono::nanoseconds position);
+    void setSpeed(double speed);
+
+    [[nodiscard]] const SourceMetadata& metadata() const { return reader_.metadata(); }
+    [[nodiscard]] std::int64_t firstTimestampNs() const { return reader_.firstTimestampNs(); }
+    [[nodiscard]] std::chrono::nanoseconds position() const;
+    [[nodiscard]] std::chrono::nanoseconds duration() const;
+    [[nodiscard]] double speed() const;
+    [[nodiscard]] bool finished() const;
+    [[nodiscard]] std::uint64_t framesPublished() const;
+
+private:
+    static constexpr std::int64_t kSingleFrameIntervalNs = 1'000'000'000;
+
+    void run();
+    // Loads the chunk holding `targetNs` and skips to its first frame at or after it.
+    void load(std::int64_t targetNs);
+    // Average spacing of the capture's frames; a one-frame capture repeats once a second.
+    [[nodiscard]] std::int64_t frameIntervalNs() const;
+    // Raises shiftNs_ so that replaying from `targetNs` never publishes a timestamp at
+    // or before the last one; history, triggers and the graph caches expect them rising.
+    void rebase(std::int64_t targetNs);
+
+    DataRegistry& registry_;
+    CaptureReader reader_;
+    ReplayOptions options_;
+    std::int64_t originNs_{0};
+
+    // Replay thread only.
+    std::vector<DataFrame> frames_;
+    std::size_t chunk_{0};
+    std::size_t next_{0};
+    // Added to capture time on publish; grows on every loop and backward seek.
+    std::int64_t shiftNs_{0};
+    std::optional<std::int64_t> lastPublishedNs_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool running_{false};
+    bool finished_{false};
+    std::optional<std::int64_t> seekNs_;
+    double speed_{1.0};
+    // Pacing: capture time anchorNs_ is due at wall time anchorWall_.
+    std::int64_t anchorNs_{0};
+    std::chrono::steady_clock::time_point anchorWall_;
+    std::int64_t positionNs_{0};
+    std::uint64_t published_{0};
+};
+
+}  // namespace core
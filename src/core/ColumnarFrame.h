@@ -0,0 +1,94 @@
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace core {
+
+/**
+ * @brief Column-oriented frame for high-rate numeric and waveform sources.
+ *
+ * Every point is one entry in the parallel point columns; channel ids and units
+ * are interned `Symbol`s from `DataRegistry::intern()`, and all waveform samples
+ * of the frame live back to back in `samples`. A producer keeps one of these,
+ * calls `clear()` and refills it, so steady-state publishing does not allocate.
+ * Serial, logic and GPIO data keep using `DataFrame`.
+ */
+struct ColumnarFrame {
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    enum class PointKind : std::uint8_t {
+        Numeric,
+        Waveform
+    };
+
+    struct WaveformSpan {
+        std::uint32_t offset{0};
+        std::uint32_t count{0};
+        double sampleRateHz{0.0};
+    };
+
+    std::string sourceId;
+    std::string sourceName;
+    TimePoint timestamp;
+
+    // Point columns, one entry per point.
+    std::vector<Symbol> channels;
+    std::vector<PointKind> kinds;
+    std::vector<Symbol> units;
+    std::vector<double> values;       // numeric value; 0 for waveforms
+    std::vector<TimePoint> timestamps;
+    std::vector<WaveformSpan> waveforms;  // empty span for numerics
+
+    std::vector<double> samples;
+
+    [[nodiscard]] std::size_t size() const { return channels.size(); }
+    [[nodiscard]] bool empty() const { return channels.empty(); }
+
+    // Drops the points but keeps every column's capacity.
+    void clear()
+    {
+        channels.clear();
+        kinds.clear();
+        units.clear();
+        values.clear();
+        timestamps.clear();
+        waveforms.clear();
+        samples.clear();
+    }
+
+    void addNumeric(Symbol channel, double value, Symbol unit, TimePoint at)
+    {
+        channels.push_back(channel);
+        kinds.push_back(PointKind::Numeric);
+        units.push_back(unit);
+        values.push_back(value);
+        timestamps.push_back(at);
+        waveforms.push_back({});
+    }
+
+    void addWaveform(Symbol channel, std::span<const double> data, double sampleRateHz, TimePoint at)
+    {
+        channels.push_back(channel);
+        kinds.push_back(PointKind::Waveform);
+        units.push_back(kEmptySymbol);
+        values.push_back(0.0);
+        timestamps.push_back(at);
+        waveforms.push_back({static_cast<std::uint32_t>(samples.size()), static_cast<std::uint32_t>(data.size()), sampleRateHz});
+        samples.insert(samples.end(), data.begin(), data.end());
+    }
+
+    [[nodiscard]] std::span<const double> waveformSamples(std::size_t point) const
+    {
+        const auto& span = waveforms[point];
+        return {samples.data() + span.offset, span.count};
+    }
+};
+
+}  // namespace core
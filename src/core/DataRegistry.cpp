@@ -1,101 +1,468 @@
 #include "DataRegistry.h"
+#include "Metrics.h"
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
 
 namespace core {
 
+namespace {
+
+const metrics::Counter kUpdates { "registry.updates" };
+// Publish and history append, excluding observer fan-out.
+const metrics::Histogram kUpdateTime { "registry.update" };
+// Inline observer callbacks plus posts to queued mailboxes.
+const metrics::Histogram kFanoutTime { "registry.fanout" };
+
+} // namespace
+
+std::shared_ptr<DataFrame> DataRegistry::SourceSlot::acquireFrame()
+{
+    // A pooled frame whose only owner is the pool is neither the published frame
+    // nor held by any reader, so it can be overwritten in place. Only publishers
+    // (holding publishMutex) get here, and new readers can only reach the frame
+    // currently stored in `latest`.
+    for (auto& frame : framePool) {
+        if (frame.use_count() == 1) {
+            // Pair with the release in the last reader's reference drop.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return frame;
+        }
+    }
+    auto frame = std::make_shared<DataFrame>();
+    if (framePool.size() < kMaxPooledFrames) {
+        framePool.push_back(frame);
+    }
+    return frame;
+}
+
 void DataRegistry::registerSource(SourceMetadata metadata)
 {
-    std::unique_lock lock(mutex_);
-    metadata_[metadata.id] = std::move(metadata);
+    catalog_.upsert(std::move(metadata));
 }
 
 void DataRegistry::unregisterSource(const std::string& sourceId)
 {
-    std::unique_lock lock(mutex_);
-    metadata_.erase(sourceId);
-    latestFrames_.erase(sourceId);
-    observers_.erase(sourceId);
+    catalog_.remove(sourceId);
+
+    std::lock_guard writeLock(slotWriteMutex_);
+    auto current = slots_.load(std::memory_order_acquire);
+    if (current->find(sourceId) == current->end()) {
+        return;
+    }
+    auto next = std::make_shared<SlotMap>(*current);
+    next->erase(sourceId);
+    slots_.store(std::move(next), std::memory_order_release);
 }
 
 bool DataRegistry::isRegistered(const std::string& sourceId) const
 {
-    std::shared_lock lock(mutex_);
-    return metadata_.find(sourceId) != metadata_.end();
+    return catalog_.contains(sourceId);
 }
 
 std::optional<SourceMetadata> DataRegistry::metadata(const std::string& sourceId) const
 {
-    std::shared_lock lock(mutex_);
-    if (auto it = metadata_.find(sourceId); it != metadata_.end()) {
-        return it->second;
+    if (auto entry = catalog_.find(sourceId)) {
+        return *entry;
     }
     return std::nullopt;
 }
 
 std::vector<SourceMetadata> DataRegistry::listSources() const
 {
-    std::shared_lock lock(mutex_);
+    const auto entries = catalog_.query();
     std::vector<SourceMetadata> result;
-    result.reserve(metadata_.size());
-    for (const auto& [_, meta] : metadata_) {
-        result.push_back(meta);
+    result.reserve(entries.size());
+    for (const auto& entry : entries) {
+        result.push_back(*entry);
     }
     return result;
 }
 
 void DataRegistry::update(const DataFrame& frame)
 {
-    std::vector<Observer> callbacks;
+    auto slot = ensureSlot(frame.sourceId);
+
+    std::shared_ptr<const DataFrame> published;
     {
-        std::unique_lock lock(mutex_);
-        latestFrames_[frame.sourceId] = frame;
-        if (auto it = observers_.find(frame.sourceId); it != observers_.end()) {
-            callbacks.reserve(it->second.size());
-            for (const auto& entry : it->second) {
-                callbacks.push_back(entry.callback);
-            }
-        }
+        metrics::ScopedTimer timer(kUpdateTime);
+        std::lock_guard publishLock(slot->publishMutex);
+        auto target = slot->acquireFrame();
+        // Copy-assignment reuses the retired frame's point, string and sample storage.
+        *target = frame;
+        published = target;
+        slot->latest.store(published, std::memory_order_release);
+        appendHistory(*slot, frame);
+    }
+
+    notifyObservers(*slot, published);
+}
+
+void DataRegistry::update(DataFrame&& frame)
+{
+    auto slot = ensureSlot(frame.sourceId);
+
+    std::shared_ptr<const DataFrame> published;
+    {
+        metrics::ScopedTimer timer(kUpdateTime);
+        std::lock_guard publishLock(slot->publishMutex);
+        auto target = slot->acquireFrame();
+        // The target is unreachable by readers, so handing its buffers to the caller is safe.
+        std::swap(*target, frame);
+        published = target;
+        slot->latest.store(published, std::memory_order_release);
+        appendHistory(*slot, *published);
+    }
+
+    notifyObservers(*slot, published);
+}
+
+void DataRegistry::update(const ColumnarFrame& frame)
+{
+    auto slot = ensureSlot(frame.sourceId);
+
+    std::shared_ptr<const DataFrame> published;
+    {
+        metrics::ScopedTimer timer(kUpdateTime);
+        std::lock_guard publishLock(slot->publishMutex);
+        auto target = slot->acquireFrame();
+        materialize(frame, *target);
+        published = target;
+        slot->latest.store(published, std::memory_order_release);
+        appendHistory(*slot, frame);
+    }
+
+    notifyObservers(*slot, published);
+}
+
+void DataRegistry::notifyObservers(const SourceSlot& slot, const std::shared_ptr<const DataFrame>& frame)
+{
+    kUpdates.add();
+    // Observers run against an immutable snapshot, so they may add or remove
+    // observers (including themselves) without deadlocking.
+    const auto observers = slot.observers.load(std::memory_order_acquire);
+    if (!observers || observers->empty()) {
+        return;
     }
-    spdlog::trace("DataRegistry: update for source '{}' with {} points", frame.sourceId, frame.points.size());
-    for (const auto& cb : callbacks) {
-        if (cb) {
-            cb(frame);
+    metrics::ScopedTimer timer(kFanoutTime);
+    for (const auto& entry : *observers) {
+        if (entry.mailbox) {
+            // Queued observers share the published snapshot; it stays out of the
+            // frame pool until every mailbox holding it has been drained.
+            dispatcher_.post(entry.mailbox, frame);
+        } else if (entry.callback) {
+            entry.callback(*frame);
         }
     }
 }
 
 std::optional<DataFrame> DataRegistry::latest(const std::string& sourceId) const
 {
-    std::shared_lock lock(mutex_);
-    if (auto it = latestFrames_.find(sourceId); it != latestFrames_.end()) {
-        return it->second;
+    if (auto frame = latestShared(sourceId)) {
+        return *frame;
     }
     return std::nullopt;
 }
 
-int DataRegistry::addObserver(const std::string& sourceId, Observer observer)
+std::shared_ptr<const DataFrame> DataRegistry::latestShared(const std::string& sourceId) const
+{
+    if (auto slot = findSlot(sourceId)) {
+        return slot->latest.load(std::memory_order_acquire);
+    }
+    return nullptr;
+}
+
+Symbol DataRegistry::intern(std::string_view text)
+{
+    return symbols_.intern(text);
+}
+
+const std::string& DataRegistry::symbolName(Symbol symbol) const
 {
-    std::unique_lock lock(mutex_);
+    return symbols_.name(symbol);
+}
+
+int DataRegistry::addObserver(const std::string& sourceId, Observer observer, ObserverOptions options)
+{
+    auto slot = ensureSlot(sourceId);
     const int token = nextObserverId_++;
-    observers_[sourceId].push_back(ObserverEntry { token, std::move(observer) });
+    ObserverEntry entry { token, nullptr, nullptr };
+    if (options.delivery == ObserverDelivery::Queued) {
+        entry.mailbox = dispatcher_.createMailbox(std::move(observer), options);
+    } else {
+        entry.callback = std::move(observer);
+    }
+
+    std::lock_guard writeLock(slotWriteMutex_);
+    auto current = slot->observers.load(std::memory_order_acquire);
+    auto next = current ? std::make_shared<ObserverList>(*current) : std::make_shared<ObserverList>();
+    next->push_back(std::move(entry));
+    slot->observers.store(std::move(next), std::memory_order_release);
     return token;
 }
 
 void DataRegistry::removeObserver(const std::string& sourceId, int token)
 {
-    std::unique_lock lock(mutex_);
-    if (auto it = observers_.find(sourceId); it != observers_.end()) {
-        auto& entries = it->second;
-        entries.erase(std::remove_if(entries.begin(), entries.end(), [token](const ObserverEntry& entry) {
-            return entry.id == token;
-        }),
-            entries.end());
-        if (entries.empty()) {
-            observers_.erase(it);
+    auto slot = findSlot(sourceId);
+    if (!slot) {
+        return;
+    }
+
+    std::lock_guard writeLock(slotWriteMutex_);
+    auto current = slot->observers.load(std::memory_order_acquire);
+    if (!current) {
+        return;
+    }
+    auto next = std::make_shared<ObserverList>(*current);
+    const auto removed = std::remove_if(next->begin(), next->end(), [token](const ObserverEntry& entry) {
+        return entry.id == token;
+    });
+    for (auto it = removed; it != next->end(); ++it) {
+        if (it->mailbox) {
+            dispatcher_.close(it->mailbox);
+        }
+    }
+    next->erase(removed, next->end());
+    if (next->empty()) {
+        slot->observers.store(nullptr, std::memory_order_release);
+    } else {
+        slot->observers.store(std::move(next), std::memory_order_release);
+    }
+}
+
+void DataRegistry::setHistoryCapacity(std::size_t samplesPerChannel)
+{
+    // Existing rings keep their size; only channels created afterwards pick it up.
+    historyCapacity_.store(std::max<std::size_t>(samplesPerChannel, 1));
+}
+
+std::size_t DataRegistry::historyCapacity() const
+{
+    return historyCapacity_.load();
+}
+
+std::vector<std::string> DataRegistry::historyChannels(const std::string& sourceId) const
+{
+    std::vector<std::string> result;
+    if (auto slot = findSlot(sourceId)) {
+        std::shared_lock lock(slot->historyMutex);
+        result.reserve(slot->histories.size());
+        for (const auto& [channelId, _] : slot->histories) {
+            result.push_back(channelId);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool DataRegistry::readHistory(const std::string& sourceId,
+    const std::string& channelId,
+    std::size_t maxSamples,
+    HistoryWindow& out) const
+{
+    auto history = findHistory(sourceId, channelId);
+    if (!history) {
+        out.clear();
+        return false;
+    }
+    std::lock_guard lock(history->mutex);
+    history->ring.copyLatest(maxSamples, out);
+    return true;
+}
+
+bool DataRegistry::readHistorySince(const std::string& sourceId,
+    const std::string& channelId,
+    std::chrono::system_clock::time_point since,
+    HistoryWindow& out) const
+{
+    auto history = findHistory(sourceId, channelId);
+    if (!history) {
+        out.clear();
+        return false;
+    }
+    std::lock_guard lock(history->mutex);
+    history->ring.copySince(since, out);
+    return true;
+}
+
+bool DataRegistry::readHistoryRecent(const std::string& sourceId,
+    const std::string& channelId,
+    std::chrono::nanoseconds span,
+    std::size_t maxSamples,
+    HistoryWindow& out) const
+{
+    auto history = findHistory(sourceId, channelId);
+    if (!history) {
+        out.clear();
+        return false;
+    }
+    std::lock_guard lock(history->mutex);
+    history->ring.copyRecent(span, maxSamples, out);
+    return true;
+}
+
+std::uint64_t DataRegistry::historySequence(const std::string& sourceId, const std::string& channelId) const
+{
+    auto history = findHistory(sourceId, channelId);
+    if (!history) {
+        return 0;
+    }
+    std::lock_guard lock(history->mutex);
+    return history->ring.sequence();
+}
+
+DataRegistry::SourceSlotPtr DataRegistry::findSlot(const std::string& sourceId) const
+{
+    const auto slots = slots_.load(std::memory_order_acquire);
+    if (auto it = slots->find(sourceId); it != slots->end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+DataRegistry::SourceSlotPtr DataRegistry::ensureSlot(const std::string& sourceId)
+{
+    if (auto existing = findSlot(sourceId)) {
+        return existing;
+    }
+
+    std::lock_guard writeLock(slotWriteMutex_);
+    auto current = slots_.load(std::memory_order_acquire);
+    if (auto it = current->find(sourceId); it != current->end()) {
+        return it->second;
+    }
+    auto slot = std::make_shared<SourceSlot>();
+    auto next = std::make_shared<SlotMap>(*current);
+    next->emplace(sourceId, slot);
+    slots_.store(std::move(next), std::memory_order_release);
+    return slot;
+}
+
+void DataRegistry::appendHistory(SourceSlot& slot, const DataFrame& frame)
+{
+    for (const auto& point : frame.points) {
+        if (const auto* numeric = std::get_if<NumericSample>(&point.payload)) {
+            auto history = ensureHistory(slot, point.channelId);
+            std::lock_guard lock(history->mutex);
+            history->ring.push(numeric->timestamp, numeric->value);
+        } else if (const auto* waveform = std::get_if<WaveformSample>(&point.payload)) {
+            if (waveform->samples.empty()) {
+                continue;
+            }
+            auto history = ensureHistory(slot, point.channelId);
+            pushWaveform(*history, waveform->samples, waveform->sampleRateHz, waveform->timestamp);
+        }
+    }
+}
+
+void DataRegistry::appendHistory(SourceSlot& slot, const ColumnarFrame& frame)
+{
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        if (frame.kinds[i] == ColumnarFrame::PointKind::Numeric) {
+            auto history = ensureHistory(slot, frame.channels[i]);
+            std::lock_guard lock(history->mutex);
+            history->ring.push(frame.timestamps[i], frame.values[i]);
+        } else if (frame.waveforms[i].count > 0) {
+            auto history = ensureHistory(slot, frame.channels[i]);
+            pushWaveform(*history, frame.waveformSamples(i), frame.waveforms[i].sampleRateHz, frame.timestamps[i]);
         }
     }
 }
 
+void DataRegistry::pushWaveform(ChannelHistory& history,
+    std::span<const double> samples,
+    double sampleRateHz,
+    std::chrono::system_clock::time_point timestamp)
+{
+    // Spread waveform samples backwards from the frame timestamp so the last
+    // sample lands on it; without a sample rate they share the timestamp.
+    std::chrono::system_clock::duration step {};
+    if (sampleRateHz > 0.0) {
+        step = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double>(1.0 / sampleRateHz));
+    }
+    const auto count = static_cast<std::int64_t>(samples.size());
+    auto at = timestamp - step * (count - 1);
+    std::lock_guard lock(history.mutex);
+    for (double value : samples) {
+        history.ring.push(at, value);
+        at += step;
+    }
+}
+
+void DataRegistry::materialize(const ColumnarFrame& frame, DataFrame& out) const
+{
+    // Assigning into the recycled frame reuses its strings and sample vectors, and
+    // symbol names resolve without locking, so this stays allocation-free once warm.
+    out.sourceId = frame.sourceId;
+    out.sourceName = frame.sourceName.empty() ? frame.sourceId : frame.sourceName;
+    out.timestamp = frame.timestamp;
+    out.points.resize(frame.size());
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        auto& point = out.points[i];
+        point.channelId = symbols_.name(frame.channels[i]);
+        if (frame.kinds[i] == ColumnarFrame::PointKind::Numeric) {
+            auto* sample = std::get_if<NumericSample>(&point.payload);
+            if (!sample) {
+                sample = &point.payload.emplace<NumericSample>();
+            }
+            sample->value = frame.values[i];
+            sample->unit = symbols_.name(frame.units[i]);
+            sample->timestamp = frame.timestamps[i];
+        } else {
+            auto* sample = std::get_if<WaveformSample>(&point.payload);
+            if (!sample) {
+                sample = &point.payload.emplace<WaveformSample>();
+            }
+            const auto samples = frame.waveformSamples(i);
+            sample->samples.assign(samples.begin(), samples.end());
+            sample->sampleRateHz = frame.waveforms[i].sampleRateHz;
+            sample->timestamp = frame.timestamps[i];
+        }
+    }
+}
+
+DataRegistry::ChannelHistoryPtr DataRegistry::findHistory(const std::string& sourceId, const std::string& channelId) const
+{
+    auto slot = findSlot(sourceId);
+    if (!slot) {
+        return nullptr;
+    }
+    std::shared_lock lock(slot->historyMutex);
+    if (auto it = slot->histories.find(channelId); it != slot->histories.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+DataRegistry::ChannelHistoryPtr DataRegistry::ensureHistory(SourceSlot& slot, const std::string& channelId)
+{
+    {
+        std::shared_lock lock(slot.historyMutex);
+        if (auto it = slot.histories.find(channelId); it != slot.histories.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock lock(slot.historyMutex);
+    auto& history = slot.histories[channelId];
+    if (!history) {
+        history = std::make_shared<ChannelHistory>(historyCapacity_.load());
+    }
+    return history;
+}
+
+DataRegistry::ChannelHistoryPtr DataRegistry::ensureHistory(SourceSlot& slot, Symbol channel)
+{
+    // Only publishers (holding publishMutex) touch historyBySymbol.
+    if (channel < slot.historyBySymbol.size() && slot.historyBySymbol[channel]) {
+        return slot.historyBySymbol[channel];
+    }
+    auto history = ensureHistory(slot, symbols_.name(channel));
+    if (channel >= slot.historyBySymbol.size()) {
+        slot.historyBySymbol.resize(channel + 1);
+    }
+    slot.historyBySymbol[channel] = history;
+    return history;
+}
+
 } // namespace core
@@ -1,12 +1,21 @@
 #pragma once
 
+#include "ColumnarFrame.h"
+#include "HistoryBuffer.h"
+#include "ObserverDispatcher.h"
+#include "SourceCatalog.h"
+#include "SymbolTable.h"
 #include "Types.h"
 
 #include <atomic>
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <shared_mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <mutex>
@@ -22,25 +31,125 @@ public:
 
     [[nodiscard]] bool isRegistered(const std::string& sourceId) const;
     [[nodiscard]] std::optional<SourceMetadata> metadata(const std::string& sourceId) const;
+    // Copies every description; menus and other large listings should query the
+    // catalog instead and follow its change notifications.
     [[nodiscard]] std::vector<SourceMetadata> listSources() const;
+    // Registered sources, indexed by id prefix and kind.
+    [[nodiscard]] SourceCatalog& catalog() { return catalog_; }
+    [[nodiscard]] const SourceCatalog& catalog() const { return catalog_; }
 
+    // Publishing is single-producer per source: concurrent updates to the same source
+    // are serialised, but readers never wait on a publisher. The latest frame and the
+    // observer list are immutable snapshots swapped in atomically, and steady-state
+    // publishing reuses retired frame buffers instead of allocating.
     void update(const DataFrame& frame);
+    // Move-based publish: `frame` is swapped with a recycled pooled frame instead of
+    // copied, and comes back holding that frame's (stale) storage for the caller to
+    // refill. Ingest loops keep one frame and pass it here on every message.
+    void update(DataFrame&& frame);
+    // Columnar fast path: history is appended straight from the columns, and the
+    // `DataFrame` handed to observers and `latest()` is materialised into a pooled
+    // frame, so existing observers keep working without per-point allocations.
+    void update(const ColumnarFrame& frame);
     [[nodiscard]] std::optional<DataFrame> latest(const std::string& sourceId) const;
+    // Zero-copy variant of latest(); the returned frame is never mutated.
+    [[nodiscard]] std::shared_ptr<const DataFrame> latestShared(const std::string& sourceId) const;
 
-    int addObserver(const std::string& sourceId, Observer observer);
+    // Channel ids and units shared by every source; symbols never change meaning.
+    Symbol intern(std::string_view text);
+    [[nodiscard]] const std::string& symbolName(Symbol symbol) const;
+
+    // Inline observers run on the publisher's thread. Queued observers get a bounded
+    // mailbox drained by the registry's dispatch workers, so a slow consumer costs
+    // dropped or conflated frames instead of stalling ingest.
+    int addObserver(const std::string& sourceId, Observer observer, ObserverOptions options = {});
     void removeObserver(const std::string& sourceId, int token);
 
+    // Shared per-(source, channel) sample history. Numeric points push one sample,
+    // waveform points push every sample; all windows read the same ring.
+    void setHistoryCapacity(std::size_t samplesPerChannel);
+    [[nodiscard]] std::size_t historyCapacity() const;
+    [[nodiscard]] std::vector<std::string> historyChannels(const std::string& sourceId) const;
+    bool readHistory(const std::string& sourceId, const std::string& channelId, std::size_t maxSamples, HistoryWindow& out) const;
+    bool readHistorySince(const std::string& sourceId,
+        const std::string& channelId,
+        std::chrono::system_clock::time_point since,
+        HistoryWindow& out) const;
+    // Bounded warm-start read: the newest samples spanning at most `span` (measured
+    // from the newest sample) and at most `maxSamples`, in one copy under the ring lock.
+    bool readHistoryRecent(const std::string& sourceId,
+        const std::string& channelId,
+        std::chrono::nanoseconds span,
+        std::size_t maxSamples,
+        HistoryWindow& out) const;
+    [[nodiscard]] std::uint64_t historySequence(const std::string& sourceId, const std::string& channelId) const;
+
+    static constexpr std::size_t kDefaultHistoryCapacity = 4096;
+
 private:
     struct ObserverEntry {
         int id;
         Observer callback;
+        // Set for queued observers; `callback` then lives in the mailbox.
+        ObserverDispatcher::MailboxPtr mailbox;
     };
+    using ObserverList = std::vector<ObserverEntry>;
+
+    struct ChannelHistory {
+        explicit ChannelHistory(std::size_t capacity) : ring(capacity) {}
+        mutable std::mutex mutex;
+        SampleRing ring;
+    };
+    using ChannelHistoryPtr = std::shared_ptr<ChannelHistory>;
+
+    // Everything published for one source. Slots are created on first use and
+    // looked up through an RCU-style snapshot of the slot map.
+    struct SourceSlot {
+        // Serialises publishers of this source; readers never take it.
+        std::mutex publishMutex;
+        std::atomic<std::shared_ptr<const DataFrame>> latest;
+        std::atomic<std::shared_ptr<const ObserverList>> observers;
+        // Frames handed out through `latest`, recycled once no reader holds them.
+        std::vector<std::shared_ptr<DataFrame>> framePool;
+
+        mutable std::shared_mutex historyMutex;
+        std::unordered_map<std::string, ChannelHistoryPtr> histories;
+        // Symbol-indexed shortcut into `histories` for columnar publishers (publishMutex).
+        std::vector<ChannelHistoryPtr> historyBySymbol;
+
+        std::shared_ptr<DataFrame> acquireFrame();
+    };
+    using SourceSlotPtr = std::shared_ptr<SourceSlot>;
+    using SlotMap = std::unordered_map<std::string, SourceSlotPtr>;
+
+    static constexpr std::size_t kMaxPooledFrames = 4;
+
+    [[nodiscard]] SourceSlotPtr findSlot(const std::string& sourceId) const;
+    SourceSlotPtr ensureSlot(const std::string& sourceId);
+
+    void notifyObservers(const SourceSlot& slot, const std::shared_ptr<const DataFrame>& frame);
+    void materialize(const ColumnarFrame& frame, DataFrame& out) const;
+    void appendHistory(SourceSlot& slot, const DataFrame& frame);
+    void appendHistory(SourceSlot& slot, const ColumnarFrame& frame);
+    static void pushWaveform(ChannelHistory& history,
+        std::span<const double> samples,
+        double sampleRateHz,
+        std::chrono::system_clock::time_point timestamp);
+    [[nodiscard]] ChannelHistoryPtr findHistory(const std::string& sourceId, const std::string& channelId) const;
+    ChannelHistoryPtr ensureHistory(SourceSlot& slot, const std::string& channelId);
+    ChannelHistoryPtr ensureHistory(SourceSlot& slot, Symbol channel);
+
+    SourceCatalog catalog_;
 
-    mutable std::shared_mutex mutex_;
-    std::unordered_map<std::string, SourceMetadata> metadata_;
-    std::unordered_map<std::string, DataFrame> latestFrames_;
-    std::unordered_map<std::string, std::vector<ObserverEntry>> observers_;
+    // Structural changes (new slots, observer add/remove) copy and swap under this
+    // mutex; the hot path only loads the current snapshot.
+    std::mutex slotWriteMutex_;
+    std::atomic<std::shared_ptr<const SlotMap>> slots_{std::make_shared<const SlotMap>()};
     std::atomic<int> nextObserverId_{1};
+    SymbolTable symbols_;
+    // Declared last so workers stop before the state their callbacks may touch.
+    ObserverDispatcher dispatcher_;
+    std::atomic<std::size_t> historyCapacity_{kDefaultHistoryCapacity};
 };
 
 }  // namespace core
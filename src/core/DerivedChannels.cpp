@@ -0,0 +1,457 @@
+#include "DerivedChannels.h"
+
+#include "DataRegistry.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <set>
+#include <span>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace core {
+
+namespace {
+
+// Evaluating one derived channel, including publishing its frame.
+const metrics::Histogram kEvalTime { "derived.eval" };
+const metrics::Counter kEvaluations { "derived.evaluations" };
+
+// A routed point of the frame being dispatched.
+struct Hit {
+    std::uint32_t channel;
+    std::uint32_t input;
+    const DataPoint* point;
+};
+
+// Publishing a derived frame re-enters dispatch() for the channels it feeds, so
+// each nesting level keeps its own scratch (a deque, so levels never move).
+thread_local std::deque<std::vector<Hit>> tHits;
+thread_local std::size_t tDepth = 0;
+
+struct DepthGuard {
+    DepthGuard() { ++tDepth; }
+    ~DepthGuard() { --tDepth; }
+};
+
+std::string_view Trim(std::string_view text)
+{
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+} // namespace
+
+bool ParseDerivedChannelSpec(std::string_view text, DerivedChannelSpec& out, std::string& error)
+{
+    const auto equals = text.find('=');
+    if (equals == std::string_view::npos) {
+        error = "expected id[unit]=expression";
+        return false;
+    }
+    auto target = Trim(text.substr(0, equals));
+    const auto expression = Trim(text.substr(equals + 1));
+
+    DerivedChannelSpec spec;
+    if (target.ends_with(']')) {
+        const auto open = target.rfind('[');
+        if (open == std::string_view::npos) {
+            error = "unbalanced ']' in '" + std::string(target) + "'";
+            return false;
+        }
+        spec.unit = std::string(Trim(target.substr(open + 1, target.size() - open - 2)));
+        target = Trim(target.substr(0, open));
+    }
+    if (target.empty()) {
+        error = "missing source id before '='";
+        return false;
+    }
+    spec.sourceId = std::string(target);
+    spec.expression = std::string(expression);
+
+    ExpressionProgram program;
+    if (!ExpressionProgram::Compile(spec.expression, program, error)) {
+        error = spec.sourceId + ": " + error;
+        return false;
+    }
+    out = std::move(spec);
+    return true;
+}
+
+struct DerivedChannels::Channel {
+    // Last delivery of one program input.
+    struct Input {
+        bool seen{false};
+        // Set by a new waveform block, cleared once it has been evaluated.
+        bool fresh{false};
+        bool waveform{false};
+        double value{0.0};
+        std::vector<double> samples;
+        double sampleRateHz{0.0};
+        std::chrono::system_clock::time_point timestamp;
+    };
+
+    Channel(DataRegistry& registry, DerivedChannelSpec specIn, ExpressionProgram programIn, DataKind kind)
+        : registry(registry)
+        , spec(std::move(specIn))
+        , program(std::move(programIn))
+        , evaluator(program)
+        , inputs(program.inputs().size())
+        , operands(program.inputs().size())
+        , kind(kind)
+    {
+    }
+
+    [[nodiscard]] SourceMetadata metadata() const
+    {
+        SourceMetadata meta;
+        meta.id = spec.sourceId;
+        meta.name = spec.name;
+        meta.kind = kind;
+        meta.description = "= " + spec.expression;
+        if (!spec.unit.empty()) {
+            meta.unit = spec.unit;
+        }
+        return meta;
+    }
+
+    // Numeric inputs start from the newest sample in their history, so a slow input
+    // does not hold the channel back until it next publishes. Waveforms wait for a
+    // new block either way.
+    void seed()
+    {
+        const auto& refs = program.inputs();
+        HistoryWindow last;
+        for (std::size_t i = 0; i < refs.size(); ++i) {
+            const auto meta = registry.metadata(refs[i].sourceId);
+            if (meta && meta->kind == DataKind::Waveform) {
+                continue;
+            }
+            if (registry.readHistory(refs[i].sourceId, refs[i].channelId, 1, last) && !last.empty()) {
+                inputs[i].seen = true;
+                inputs[i].value = last.values.back();
+                inputs[i].timestamp = last.timestamps.back();
+            }
+        }
+    }
+
+    void ingest(std::span<const Hit> hits, const DataFrame& frame)
+    {
+        std::lock_guard lock(mutex);
+        if (!active) {
+            return;
+        }
+        for (const auto& hit : hits) {
+            latch(inputs[hit.input], *hit.point, frame.timestamp);
+        }
+        const bool ready = std::all_of(inputs.begin(), inputs.end(), [](const Input& input) {
+            return input.seen && (!input.waveform || input.fresh);
+        });
+        if (ready) {
+            publish();
+        }
+    }
+
+    static void latch(Input& input, const DataPoint& point, std::chrono::system_clock::time_point frameTime)
+    {
+        if (const auto* numeric = std::get_if<NumericSample>(&point.payload)) {
+            input.waveform = false;
+            input.value = numeric->value;
+            input.timestamp = numeric->timestamp.time_since_epoch().count() != 0 ? numeric->timestamp : frameTime;
+        } else if (const auto* waveform = std::get_if<WaveformSample>(&point.payload)) {
+            if (waveform->samples.empty()) {
+                return;
+            }
+            input.waveform = true;
+            input.samples.assign(waveform->samples.begin(), waveform->samples.end());
+            input.sampleRateHz = waveform->sampleRateHz;
+            input.timestamp = waveform->timestamp.time_since_epoch().count() != 0 ? waveform->timestamp : frameTime;
+        } else {
+            // Serial, logic and GPIO payloads have no arithmetic value.
+            return;
+        }
+        input.seen = true;
+        input.fresh = true;
+    }
+
+    void publish()
+    {
+        metrics::ScopedTimer timer(kEvalTime);
+        kEvaluations.add();
+
+        // The first waveform sets the block's rate and start; the shortest bounds it.
+        const Input* clock = nullptr;
+        std::size_t length = 1;
+        auto newest = inputs.front().timestamp;
+        for (const auto& input : inputs) {
+            newest = std::max(newest, input.timestamp);
+            if (input.waveform) {
+                length = clock ? std::min(length, input.samples.size()) : input.samples.size();
+                clock = clock ? clock : &input;
+            }
+        }
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            auto& input = inputs[i];
+            operands[i] = input.waveform ? std::span<const double>(input.samples.data(), length) : std::span<const double>(&input.value, 1);
+            input.fresh = false;
+        }
+
+        const DataKind produced = clock ? DataKind::Waveform : DataKind::Numeric;
+        if (produced != kind) {
+            kind = produced;
+            registry.registerSource(metadata());
+        }
+
+        // `output` is whichever pooled frame the last update() handed back; refill it.
+        output.sourceId = spec.sourceId;
+        output.sourceName = spec.name;
+        output.timestamp = clock ? clock->timestamp : newest;
+        output.points.resize(1);
+        auto& point = output.points.front();
+        point.channelId = spec.channelId;
+        if (clock) {
+            auto* sample = std::get_if<WaveformSample>(&point.payload);
+            if (!sample) {
+                sample = &point.payload.emplace<WaveformSample>();
+            }
+            sample->samples.resize(length);
+            evaluator.evaluate(operands, length, sample->samples);
+            sample->sampleRateHz = clock->sampleRateHz;
+            sample->timestamp = clock->timestamp;
+        } else {
+            auto* sample = std::get_if<NumericSample>(&point.payload);
+            if (!sample) {
+                sample = &point.payload.emplace<NumericSample>();
+            }
+            evaluator.evaluate(operands, 1, std::span<double>(&sample->value, 1));
+            sample->unit = spec.unit;
+            sample->timestamp = newest;
+        }
+        // Still under the channel's lock, so its frames are published in order. Any
+        // channel reading this one is downstream of it, so the locks nest acyclically.
+        registry.update(std::move(output));
+    }
+
+    DataRegistry& registry;
+    const DerivedChannelSpec spec;
+    const ExpressionProgram program;
+
+    std::mutex mutex;
+    // Cleared under `mutex` by remove(), for frames already being dispatched.
+    bool active{true};
+    ExpressionEvaluator evaluator;
+    std::vector<Input> inputs;
+    std::vector<std::span<const double>> operands;
+    DataKind kind;
+    DataFrame output;
+};
+
+DerivedChannels::DerivedChannels(DataRegistry& registry)
+    : registry_(registry)
+{
+}
+
+DerivedChannels::~DerivedChannels()
+{
+    clear();
+}
+
+bool DerivedChannels::add(DerivedChannelSpec spec)
+{
+    if (spec.sourceId.empty()) {
+        spdlog::error("Derived source needs an id");
+        return false;
+    }
+    if (spec.name.empty()) {
+        spec.name = spec.sourceId;
+    }
+    ExpressionProgram program;
+    std::string error;
+    if (!ExpressionProgram::Compile(spec.expression, program, error)) {
+        spdlog::error("Derived source '{}': {}", spec.sourceId, error);
+        return false;
+    }
+    if (program.inputs().empty()) {
+        spdlog::error("Derived source '{}': the expression reads no channels", spec.sourceId);
+        return false;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (channels_.contains(spec.sourceId) || registry_.isRegistered(spec.sourceId)) {
+        spdlog::error("Derived source '{}': the id is already in use", spec.sourceId);
+        return false;
+    }
+    std::set<std::string> inputSources;
+    DataKind kind = DataKind::Numeric;
+    for (const auto& input : program.inputs()) {
+        if (dependsOn(input.sourceId, spec.sourceId)) {
+            spdlog::error("Derived source '{}': it would be computed from itself through '{}'", spec.sourceId, input.sourceId);
+            return false;
+        }
+        // A guess until the first frame is computed; the catalog is told if it changes.
+        if (const auto meta = registry_.metadata(input.sourceId); meta && meta->kind == DataKind::Waveform) {
+            kind = DataKind::Waveform;
+        }
+        inputSources.insert(input.sourceId);
+    }
+
+    auto channel = std::make_shared<Channel>(registry_, std::move(spec), std::move(program), kind);
+    channel->seed();
+    registry_.registerSource(channel->metadata());
+    spdlog::info("Derived source '{}' = {}", channel->spec.sourceId, channel->spec.expression);
+    channels_.emplace(channel->spec.sourceId, std::move(channel));
+    for (const auto& sourceId : inputSources) {
+        rebuildRoutes(sourceId);
+    }
+    return true;
+}
+
+bool DerivedChannels::remove(const std::string& sourceId)
+{
+    std::lock_guard lock(mutex_);
+    auto it = channels_.find(sourceId);
+    if (it == channels_.end()) {
+        return false;
+    }
+    const auto channel = std::move(it->second);
+    channels_.erase(it);
+    {
+        std::lock_guard channelLock(channel->mutex);
+        channel->active = false;
+    }
+    std::set<std::string> inputSources;
+    for (const auto& input : channel->program.inputs()) {
+        inputSources.insert(input.sourceId);
+    }
+    for (const auto& inputSourceId : inputSources) {
+        rebuildRoutes(inputSourceId);
+    }
+    registry_.unregisterSource(sourceId);
+    return true;
+}
+
+void DerivedChannels::clear()
+{
+    std::vector<std::string> ids;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& [id, channel] : channels_) {
+            ids.push_back(id);
+        }
+    }
+    for (const auto& id : ids) {
+        remove(id);
+    }
+}
+
+std::vector<DerivedChannelSpec> DerivedChannels::specs() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<DerivedChannelSpec> result;
+    result.reserve(channels_.size());
+    for (const auto& [id, channel] : channels_) {
+        result.push_back(channel->spec);
+    }
+    return result;
+}
+
+void DerivedChannels::dispatch(const Routes& routes, const DataFrame& frame)
+{
+    if (tDepth == tHits.size()) {
+        tHits.emplace_back();
+    }
+    auto& hits = tHits[tDepth];
+    hits.clear();
+    for (const auto& point : frame.points) {
+        const auto it = routes.byChannelId.find(point.channelId);
+        if (it == routes.byChannelId.end()) {
+            continue;
+        }
+        for (const auto& route : it->second) {
+            hits.push_back(Hit { route.channel, route.input, &point });
+        }
+    }
+    if (hits.empty()) {
+        return;
+    }
+    // Group by channel; within one, frame order, so a repeated channel id's last point wins.
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        return a.channel != b.channel ? a.channel < b.channel : a.point < b.point;
+    });
+
+    DepthGuard depth;
+    for (std::size_t begin = 0; begin < hits.size();) {
+        std::size_t end = begin + 1;
+        while (end < hits.size() && hits[end].channel == hits[begin].channel) {
+            ++end;
+        }
+        routes.channels[hits[begin].channel]->ingest(std::span<const Hit>(hits.data() + begin, end - begin), frame);
+        begin = end;
+    }
+}
+
+// Caller holds mutex_.
+void DerivedChannels::rebuildRoutes(const std::string& inputSourceId)
+{
+    auto routes = std::make_shared<Routes>();
+    for (const auto& [id, channel] : channels_) {
+        const auto& inputs = channel->program.inputs();
+        const auto index = static_cast<std::uint32_t>(routes->channels.size());
+        bool used = false;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            if (inputs[i].sourceId == inputSourceId) {
+                routes->byChannelId[inputs[i].channelId].push_back(Route { index, static_cast<std::uint32_t>(i) });
+                used = true;
+            }
+        }
+        if (used) {
+            routes->channels.push_back(channel);
+        }
+    }
+
+    auto it = bindings_.find(inputSourceId);
+    if (routes->channels.empty()) {
+        if (it != bindings_.end()) {
+            registry_.removeObserver(inputSourceId, it->second->token);
+            bindings_.erase(it);
+        }
+        return;
+    }
+    if (it != bindings_.end()) {
+        it->second->routes.store(std::move(routes), std::memory_order_release);
+        return;
+    }
+    auto binding = std::make_shared<Binding>();
+    binding->routes.store(std::move(routes), std::memory_order_release);
+    binding->token = registry_.addObserver(inputSourceId, [binding](const DataFrame& frame) {
+        const auto routes = binding->routes.load(std::memory_order_acquire);
+        dispatch(*routes, frame);
+    });
+    bindings_.emplace(inputSourceId, std::move(binding));
+}
+
+// Caller holds mutex_.
+bool DerivedChannels::dependsOn(const std::string& sourceId, const std::string& targetId) const
+{
+    if (sourceId == targetId) {
+        return true;
+    }
+    const auto it = channels_.find(sourceId);
+    if (it == channels_.end()) {
+        return false;
+    }
+    return std::any_of(it->second->program.inputs().begin(), it->second->program.inputs().end(), [&](const ChannelRef& input) {
+        return dependsOn(input.sourceId, targetId);
+    });
+}
+
+} // namespace core
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Expression.h"
+#include "Types.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+
+class DataRegistry;
+
+// A computed source: `expression` over other channels, published as channel
+// `channelId` of source `sourceId`.
+struct DerivedChannelSpec {
+    std::string sourceId;
+    // Defaults to sourceId.
+    std::string name;
+    std::string channelId{"value"};
+    std::string unit;
+    std::string expression;
+};
+
+// Parses the command-line form "id[unit]=expression", e.g.
+// "derived.power[W]={psu/voltage} * {psu/current}".
+bool ParseDerivedChannelSpec(std::string_view text, DerivedChannelSpec& out, std::string& error);
+
+/**
+ * @brief Registers computed sources and evaluates them as their inputs arrive.
+ *
+ * Each expression is compiled once. The engine holds one inline registry observer
+ * per input source, routing a frame's points by channel id to the derived channels
+ * that read them, so a frame only evaluates the channels it feeds, and each of those
+ * once however many of its inputs the frame carries. Evaluation runs on the thread
+ * that published the input, in batches across waveform blocks.
+ *
+ * Numeric inputs hold their last value. An output becomes a waveform when any input
+ * is one; it is then computed once every waveform input has delivered a new block,
+ * over the shortest of them, at the first waveform's rate and timestamp. Derived
+ * sources may feed each other, but not in a cycle.
+ */
+class DerivedChannels {
+public:
+    explicit DerivedChannels(DataRegistry& registry);
+    ~DerivedChannels();
+
+    DerivedChannels(const DerivedChannels&) = delete;
+    DerivedChannels& operator=(const DerivedChannels&) = delete;
+
+    // Compiles and registers `spec`; false (logged) if it does not compile, its id is
+    // taken, or it would feed itself.
+    bool add(DerivedChannelSpec spec);
+    bool remove(const std::string& sourceId);
+    void clear();
+
+    [[nodiscard]] std::vector<DerivedChannelSpec> specs() const;
+
+private:
+    struct Channel;
+    // Where one channel id of an input source goes: channel, and input of its program.
+    struct Route {
+        std::uint32_t channel;
+        std::uint32_t input;
+    };
+    // Immutable; swapped whole when channels come and go.
+    struct Routes {
+        std::vector<std::shared_ptr<Channel>> channels;
+        std::unordered_map<std::string, std::vector<Route>> byChannelId;
+    };
+    // One observed input source.
+    struct Binding {
+        std::atomic<std::shared_ptr<const Routes>> routes;
+        int token{0};
+    };
+
+    static void dispatch(const Routes& routes, const DataFrame& frame);
+    void rebuildRoutes(const std::string& inputSourceId);
+    // Whether `sourceId` is `targetId` or is computed from it, directly or not.
+    [[nodiscard]] bool dependsOn(const std::string& sourceId, const std::string& targetId) const;
+
+    DataRegistry& registry_;
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Channel>> channels_;
+    std::map<std::string, std::shared_ptr<Binding>> bindings_;
+};
+
+}  // namespace core
@@ -0,0 +1,152 @@
+#include "Downsample.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace core {
+
+namespace {
+
+void ScalarMinMax(const double* data, std::size_t count, double& low, double& high)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        low = std::min(low, data[i]);
+        high = std::max(high, data[i]);
+    }
+}
+
+} // namespace
+
+void MinMax(std::span<const double> values, double& low, double& high)
+{
+    if (values.empty()) {
+        return;
+    }
+    const double* data = values.data();
+    const std::size_t count = values.size();
+    double mn = data[0];
+    double mx = data[0];
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    if (count >= 8) {
+        // Two accumulators per bound hide the min/max latency.
+        __m256d min0 = _mm256_loadu_pd(data);
+        __m256d max0 = min0;
+        __m256d min1 = _mm256_loadu_pd(data + 4);
+        __m256d max1 = min1;
+        for (i = 8; i + 8 <= count; i += 8) {
+            const __m256d a = _mm256_loadu_pd(data + i);
+            const __m256d b = _mm256_loadu_pd(data + i + 4);
+            min0 = _mm256_min_pd(min0, a);
+            max0 = _mm256_max_pd(max0, a);
+            min1 = _mm256_min_pd(min1, b);
+            max1 = _mm256_max_pd(max1, b);
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_min_pd(min0, min1));
+        mn = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm256_store_pd(lanes, _mm256_max_pd(max0, max1));
+        mx = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (count >= 4) {
+        float64x2_t min0 = vld1q_f64(data);
+        float64x2_t max0 = min0;
+        float64x2_t min1 = vld1q_f64(data + 2);
+        float64x2_t max1 = min1;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const float64x2_t a = vld1q_f64(data + i);
+            const float64x2_t b = vld1q_f64(data + i + 2);
+            min0 = vminq_f64(min0, a);
+            max0 = vmaxq_f64(max0, a);
+            min1 = vminq_f64(min1, b);
+            max1 = vmaxq_f64(max1, b);
+        }
+        mn = vminvq_f64(vminq_f64(min0, min1));
+        mx = vmaxvq_f64(vmaxq_f64(max0, max1));
+    }
+#endif
+
+    ScalarMinMax(data + i, count - i, mn, mx);
+    low = std::min(low, mn);
+    high = std::max(high, mx);
+}
+
+void BuildEnvelope(std::span<const double> values, std::size_t columns, Envelope& out)
+{
+    out.firsts.resize(columns);
+    out.mins.resize(columns);
+    out.maxs.resize(columns);
+    out.lasts.resize(columns);
+    out.low = 0.0;
+    out.high = 0.0;
+    if (columns == 0) {
+        return;
+    }
+    if (values.empty()) {
+        std::fill(out.firsts.begin(), out.firsts.end(), 0.0);
+        std::fill(out.mins.begin(), out.mins.end(), 0.0);
+        std::fill(out.maxs.begin(), out.maxs.end(), 0.0);
+        std::fill(out.lasts.begin(), out.lasts.end(), 0.0);
+        return;
+    }
+
+    const std::size_t count = values.size();
+    double low = values[0];
+    double high = values[0];
+
+    if (count <= columns) {
+        // Sparse: interpolate between neighbouring samples like a plain line plot.
+        const double span = static_cast<double>(count - 1);
+        const double denominator = static_cast<double>(std::max<std::size_t>(1, columns - 1));
+        for (std::size_t x = 0; x < columns; ++x) {
+            const double position = span * (static_cast<double>(x) / denominator);
+            const auto i0 = std::min(static_cast<std::size_t>(std::floor(position)), count - 1);
+            const auto i1 = std::min(i0 + 1, count - 1);
+            const double t = position - static_cast<double>(i0);
+            const double value = values[i0] + (values[i1] - values[i0]) * t;
+            out.firsts[x] = out.mins[x] = out.maxs[x] = out.lasts[x] = value;
+        }
+        MinMax(values, low, high);
+    } else {
+        // M4: every sample lands in exactly one bucket, so no spike is skipped.
+        for (std::size_t x = 0; x < columns; ++x) {
+            const std::size_t begin = x * count / columns;
+            const std::size_t end = (x + 1) * count / columns;
+            const auto bucket = values.subspan(begin, end - begin);
+            double mn = bucket.front();
+            double mx = bucket.front();
+            MinMax(bucket, mn, mx);
+            out.firsts[x] = bucket.front();
+            out.mins[x] = mn;
+            out.maxs[x] = mx;
+            out.lasts[x] = bucket.back();
+            low = std::min(low, mn);
+            high = std::max(high, mx);
+        }
+    }
+    out.low = low;
+    out.high = high;
+}
+
+bool EnvelopeCache::update(std::span<const double> values, std::uint64_t sequence, std::size_t columns)
+{
+    if (valid_ && sequence == sequence_ && values.size() == count_ && columns == columns_) {
+        return false;
+    }
+    BuildEnvelope(values, columns, envelope_);
+    sequence_ = sequence;
+    count_ = values.size();
+    columns_ = columns;
+    valid_ = true;
+    return true;
+}
+
+} // namespace core
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace core {
+
+/**
+ * @brief Per-column M4 summary of a sample series (first, min, max, last).
+ *
+ * Built by `BuildEnvelope()`; `low`/`high` are the extremes over every column, so
+ * renderers can scale without rescanning the samples.
+ */
+struct Envelope {
+    std::vector<double> firsts;
+    std::vector<double> mins;
+    std::vector<double> maxs;
+    std::vector<double> lasts;
+    double low{0.0};
+    double high{0.0};
+
+    [[nodiscard]] std::size_t size() const { return mins.size(); }
+    [[nodiscard]] bool empty() const { return mins.empty(); }
+
+    void clear()
+    {
+        firsts.clear();
+        mins.clear();
+        maxs.clear();
+        lasts.clear();
+        low = 0.0;
+        high = 0.0;
+    }
+};
+
+// Vectorised (AVX2 / AArch64 NEON when the build targets them) min/max of a block.
+// Leaves `low`/`high` untouched for an empty block.
+void MinMax(std::span<const double> values, double& low, double& high);
+
+// Reduces `values` to `columns` M4 buckets, reusing `out`'s storage. With fewer
+// samples than columns each column takes the linearly interpolated value instead,
+// so sparse histories still draw a continuous line.
+void BuildEnvelope(std::span<const double> values, std::size_t columns, Envelope& out);
+
+/**
+ * @brief Recomputes an envelope only when its input changed.
+ *
+ * Keyed by the history ring sequence (bumped on every push), the sample count and
+ * the column count, so repaints without new data cost nothing.
+ */
+class EnvelopeCache {
+public:
+    // Returns true when the envelope was rebuilt.
+    bool update(std::span<const double> values, std::uint64_t sequence, std::size_t columns);
+    void invalidate() { valid_ = false; }
+
+    [[nodiscard]] const Envelope& envelope() const { return envelope_; }
+
+private:
+    Envelope envelope_;
+    std::uint64_t sequence_{0};
+    std::size_t count_{0};
+    std::size_t columns_{0};
+    bool valid_{false};
+};
+
+}  // namespace core
@@ -0,0 +1,710 @@
+#include "Expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace core {
+
+namespace {
+
+// Deep enough for any hand-written expression, shallow enough for the parser's stack.
+constexpr std::size_t kMaxNesting = 64;
+constexpr std::uint32_t kMaxAverageWindow = 1u << 20;
+
+template <ExpressionOp Op>
+double Apply(double a, double b)
+{
+    if constexpr (Op == ExpressionOp::Add) {
+        return a + b;
+    } else if constexpr (Op == ExpressionOp::Subtract) {
+        return a - b;
+    } else if constexpr (Op == ExpressionOp::Multiply) {
+        return a * b;
+    } else if constexpr (Op == ExpressionOp::Divide) {
+        return a / b;
+    } else if constexpr (Op == ExpressionOp::Min) {
+        return b < a ? b : a;
+    } else {
+        return b > a ? b : a;
+    }
+}
+
+template <ExpressionOp Op>
+double Apply(double a)
+{
+    if constexpr (Op == ExpressionOp::Negate) {
+        return -a;
+    } else if constexpr (Op == ExpressionOp::Abs) {
+        return std::fabs(a);
+    } else {
+        return std::sqrt(a);
+    }
+}
+
+// One vector register of doubles, or a plain double when the build has no SIMD
+// target; the kernels below are written once against these helpers.
+#if defined(__AVX2__)
+using Lanes = __m256d;
+constexpr std::size_t kLaneCount = 4;
+
+Lanes LoadLanes(const double* data) { return _mm256_loadu_pd(data); }
+void StoreLanes(double* data, Lanes value) { _mm256_storeu_pd(data, value); }
+Lanes SplatLanes(double value) { return _mm256_set1_pd(value); }
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a, Lanes b)
+{
+    if constexpr (Op == ExpressionOp::Add) {
+        return _mm256_add_pd(a, b);
+    } else if constexpr (Op == ExpressionOp::Subtract) {
+        return _mm256_sub_pd(a, b);
+    } else if constexpr (Op == ExpressionOp::Multiply) {
+        return _mm256_mul_pd(a, b);
+    } else if constexpr (Op == ExpressionOp::Divide) {
+        return _mm256_div_pd(a, b);
+    } else if constexpr (Op == ExpressionOp::Min) {
+        return _mm256_min_pd(a, b);
+    } else {
+        return _mm256_max_pd(a, b);
+    }
+}
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a)
+{
+    if constexpr (Op == ExpressionOp::Negate) {
+        return _mm256_xor_pd(a, _mm256_set1_pd(-0.0));
+    } else if constexpr (Op == ExpressionOp::Abs) {
+        return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+    } else {
+        return _mm256_sqrt_pd(a);
+    }
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+using Lanes = float64x2_t;
+constexpr std::size_t kLaneCount = 2;
+
+Lanes LoadLanes(const double* data) { return vld1q_f64(data); }
+void StoreLanes(double* data, Lanes value) { vst1q_f64(data, value); }
+Lanes SplatLanes(double value) { return vdupq_n_f64(value); }
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a, Lanes b)
+{
+    if constexpr (Op == ExpressionOp::Add) {
+        return vaddq_f64(a, b);
+    } else if constexpr (Op == ExpressionOp::Subtract) {
+        return vsubq_f64(a, b);
+    } else if constexpr (Op == ExpressionOp::Multiply) {
+        return vmulq_f64(a, b);
+    } else if constexpr (Op == ExpressionOp::Divide) {
+        return vdivq_f64(a, b);
+    } else if constexpr (Op == ExpressionOp::Min) {
+        return vminq_f64(a, b);
+    } else {
+        return vmaxq_f64(a, b);
+    }
+}
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a)
+{
+    if constexpr (Op == ExpressionOp::Negate) {
+        return vnegq_f64(a);
+    } else if constexpr (Op == ExpressionOp::Abs) {
+        return vabsq_f64(a);
+    } else {
+        return vsqrtq_f64(a);
+    }
+}
+#else
+using Lanes = double;
+constexpr std::size_t kLaneCount = 1;
+
+Lanes LoadLanes(const double* data) { return *data; }
+void StoreLanes(double* data, Lanes value) { *data = value; }
+Lanes SplatLanes(double value) { return value; }
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a, Lanes b)
+{
+    return Apply<Op>(a, b);
+}
+
+template <ExpressionOp Op>
+Lanes ApplyLanes(Lanes a)
+{
+    return Apply<Op>(a);
+}
+#endif
+
+// `a` or `b` may be a single value broadcast across the batch.
+template <ExpressionOp Op, bool BroadcastA, bool BroadcastB>
+void BinaryKernel(const double* a, const double* b, double* out, std::size_t count)
+{
+    std::size_t i = 0;
+    if (count >= kLaneCount) {
+        const Lanes splatA = SplatLanes(*a);
+        const Lanes splatB = SplatLanes(*b);
+        for (; i + kLaneCount <= count; i += kLaneCount) {
+            const Lanes x = BroadcastA ? splatA : LoadLanes(a + i);
+            const Lanes y = BroadcastB ? splatB : LoadLanes(b + i);
+            StoreLanes(out + i, ApplyLanes<Op>(x, y));
+        }
+    }
+    for (; i < count; ++i) {
+        out[i] = Apply<Op>(BroadcastA ? *a : a[i], BroadcastB ? *b : b[i]);
+    }
+}
+
+template <ExpressionOp Op>
+void UnaryKernel(const double* a, double* out, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + kLaneCount <= count; i += kLaneCount) {
+        StoreLanes(out + i, ApplyLanes<Op>(LoadLanes(a + i)));
+    }
+    for (; i < count; ++i) {
+        out[i] = Apply<Op>(a[i]);
+    }
+}
+
+template <ExpressionOp Op>
+void Binary(const double* a, bool scalarA, const double* b, bool scalarB, double* out, std::size_t count)
+{
+    if (scalarA) {
+        BinaryKernel<Op, true, false>(a, b, out, count);
+    } else if (scalarB) {
+        BinaryKernel<Op, false, true>(a, b, out, count);
+    } else {
+        BinaryKernel<Op, false, false>(a, b, out, count);
+    }
+}
+
+void BinaryBatch(ExpressionOp op, const double* a, bool scalarA, const double* b, bool scalarB, double* out, std::size_t count)
+{
+    switch (op) {
+    case ExpressionOp::Add:
+        Binary<ExpressionOp::Add>(a, scalarA, b, scalarB, out, count);
+        break;
+    case ExpressionOp::Subtract:
+        Binary<ExpressionOp::Subtract>(a, scalarA, b, scalarB, out, count);
+        break;
+    case ExpressionOp::Multiply:
+        Binary<ExpressionOp::Multiply>(a, scalarA, b, scalarB, out, count);
+        break;
+    case ExpressionOp::Divide:
+        Binary<ExpressionOp::Divide>(a, scalarA, b, scalarB, out, count);
+        break;
+    case ExpressionOp::Min:
+        Binary<ExpressionOp::Min>(a, scalarA, b, scalarB, out, count);
+        break;
+    default:
+        Binary<ExpressionOp::Max>(a, scalarA, b, scalarB, out, count);
+        break;
+    }
+}
+
+void UnaryBatch(ExpressionOp op, const double* a, double* out, std::size_t count)
+{
+    switch (op) {
+    case ExpressionOp::Negate:
+        UnaryKernel<ExpressionOp::Negate>(a, out, count);
+        break;
+    case ExpressionOp::Abs:
+        UnaryKernel<ExpressionOp::Abs>(a, out, count);
+        break;
+    default:
+        UnaryKernel<ExpressionOp::Sqrt>(a, out, count);
+        break;
+    }
+}
+
+double ApplyScalar(ExpressionOp op, double a, double b)
+{
+    switch (op) {
+    case ExpressionOp::Add:
+        return Apply<ExpressionOp::Add>(a, b);
+    case ExpressionOp::Subtract:
+        return Apply<ExpressionOp::Subtract>(a, b);
+    case ExpressionOp::Multiply:
+        return Apply<ExpressionOp::Multiply>(a, b);
+    case ExpressionOp::Divide:
+        return Apply<ExpressionOp::Divide>(a, b);
+    case ExpressionOp::Min:
+        return Apply<ExpressionOp::Min>(a, b);
+    default:
+        return Apply<ExpressionOp::Max>(a, b);
+    }
+}
+
+double ApplyScalar(ExpressionOp op, double a)
+{
+    switch (op) {
+    case ExpressionOp::Negate:
+        return Apply<ExpressionOp::Negate>(a);
+    case ExpressionOp::Abs:
+        return Apply<ExpressionOp::Abs>(a);
+    default:
+        return Apply<ExpressionOp::Sqrt>(a);
+    }
+}
+
+bool IsBinary(ExpressionOp op)
+{
+    switch (op) {
+    case ExpressionOp::Add:
+    case ExpressionOp::Subtract:
+    case ExpressionOp::Multiply:
+    case ExpressionOp::Divide:
+    case ExpressionOp::Min:
+    case ExpressionOp::Max:
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct Function {
+    std::string_view name;
+    ExpressionOp op;
+    std::size_t arity;
+};
+
+constexpr Function kFunctions[] = {
+    { "abs", ExpressionOp::Abs, 1 },
+    { "sqrt", ExpressionOp::Sqrt, 1 },
+    { "min", ExpressionOp::Min, 2 },
+    { "max", ExpressionOp::Max, 2 },
+    { "avg", ExpressionOp::Average, 2 },
+    { "delta", ExpressionOp::Delta, 1 },
+};
+
+} // namespace
+
+// Recursive descent straight to postfix code, folding constants as it goes.
+class ExpressionCompiler {
+public:
+    ExpressionCompiler(std::string_view text, ExpressionProgram& out)
+        : text_(text)
+        , out_(out)
+    {
+    }
+
+    bool run(std::string& error)
+    {
+        out_ = {};
+        out_.text_ = std::string(text_);
+        skipSpace();
+        if (!expression()) {
+            error = std::move(error_);
+            return false;
+        }
+        if (pos_ != text_.size()) {
+            fail("unexpected '" + std::string(1, text_[pos_]) + "'");
+            error = std::move(error_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool expression()
+    {
+        if (++nesting_ > kMaxNesting) {
+            return fail("expression is nested too deeply");
+        }
+        if (!term()) {
+            return false;
+        }
+        while (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+            const auto op = text_[pos_] == '+' ? ExpressionOp::Add : ExpressionOp::Subtract;
+            advance();
+            if (!term()) {
+                return false;
+            }
+            emit(op);
+        }
+        --nesting_;
+        return true;
+    }
+
+    bool term()
+    {
+        if (!unary()) {
+            return false;
+        }
+        while (pos_ < text_.size() && (text_[pos_] == '*' || text_[pos_] == '/')) {
+            const auto op = text_[pos_] == '*' ? ExpressionOp::Multiply : ExpressionOp::Divide;
+            advance();
+            if (!unary()) {
+                return false;
+            }
+            emit(op);
+        }
+        return true;
+    }
+
+    bool unary()
+    {
+        if (pos_ < text_.size() && (text_[pos_] == '-' || text_[pos_] == '+')) {
+            const bool negate = text_[pos_] == '-';
+            advance();
+            if (++nesting_ > kMaxNesting) {
+                return fail("expression is nested too deeply");
+            }
+            if (!unary()) {
+                return false;
+            }
+            --nesting_;
+            if (negate) {
+                emit(ExpressionOp::Negate);
+            }
+            return true;
+        }
+        return primary();
+    }
+
+    bool primary()
+    {
+        if (pos_ >= text_.size()) {
+            return fail("expected a value");
+        }
+        const char c = text_[pos_];
+        if (c == '(') {
+            advance();
+            if (!expression()) {
+                return false;
+            }
+            return expect(')');
+        }
+        if (c == '{') {
+            return reference();
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            return number();
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            return call();
+        }
+        return fail("unexpected '" + std::string(1, c) + "'");
+    }
+
+    bool number()
+    {
+        double value = 0.0;
+        const auto* begin = text_.data() + pos_;
+        const auto [end, ec] = std::from_chars(begin, text_.data() + text_.size(), value);
+        if (ec != std::errc()) {
+            return fail("malformed number");
+        }
+        pos_ += static_cast<std::size_t>(end - begin);
+        skipSpace();
+        push({ ExpressionOp::Constant, 0, value });
+        return true;
+    }
+
+    bool reference()
+    {
+        const std::size_t start = pos_;
+        const auto close = text_.find('}', pos_);
+        if (close == std::string_view::npos) {
+            return fail("unterminated '{'");
+        }
+        const auto body = text_.substr(pos_ + 1, close - pos_ - 1);
+        const auto slash = body.rfind('/');
+        if (slash == std::string_view::npos || slash == 0 || slash + 1 == body.size()) {
+            return fail("expected {source/channel}", start);
+        }
+        ChannelRef ref { std::string(body.substr(0, slash)), std::string(body.substr(slash + 1)) };
+        pos_ = close + 1;
+        skipSpace();
+
+        const auto existing = std::find(out_.inputs_.begin(), out_.inputs_.end(), ref);
+        const auto index = static_cast<std::uint32_t>(existing - out_.inputs_.begin());
+        if (existing == out_.inputs_.end()) {
+            out_.inputs_.push_back(std::move(ref));
+        }
+        push({ ExpressionOp::Input, index, 0.0 });
+        return true;
+    }
+
+    bool call()
+    {
+        const std::size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+            ++pos_;
+        }
+        const auto name = text_.substr(start, pos_ - start);
+        const auto* function = std::find_if(std::begin(kFunctions), std::end(kFunctions), [&](const Function& entry) {
+            return entry.name == name;
+        });
+        if (function == std::end(kFunctions)) {
+            return fail("unknown function '" + std::string(name) + "'", start);
+        }
+        skipSpace();
+        if (!expect('(')) {
+            return false;
+        }
+        for (std::size_t arg = 0; arg < function->arity; ++arg) {
+            if (arg > 0 && !expect(',')) {
+                return false;
+            }
+            if (!expression()) {
+                return false;
+            }
+        }
+        if (!expect(')')) {
+            return false;
+        }
+
+        if (function->op == ExpressionOp::Average) {
+            // The window is fixed: it sizes the ring the evaluator keeps.
+            const auto& last = out_.code_.back();
+            const double window = last.constant;
+            if (last.op != ExpressionOp::Constant || window < 1.0 || window > kMaxAverageWindow || window != std::floor(window)) {
+                return fail("avg() needs a whole number of samples between 1 and " + std::to_string(kMaxAverageWindow), start);
+            }
+            pop(1);
+            push({ ExpressionOp::Average, static_cast<std::uint32_t>(window), 0.0 }, 0);
+            out_.stateful_ = true;
+            return true;
+        }
+        if (function->op == ExpressionOp::Delta) {
+            push({ ExpressionOp::Delta, 0, 0.0 }, 0);
+            out_.stateful_ = true;
+            return true;
+        }
+        emit(function->op);
+        return true;
+    }
+
+    // Emits a pure operator, or folds it when its operands are all constants.
+    void emit(ExpressionOp op)
+    {
+        const std::size_t arity = IsBinary(op) ? 2 : 1;
+        const auto& code = out_.code_;
+        const bool constant = code.size() >= arity
+            && std::all_of(code.end() - static_cast<std::ptrdiff_t>(arity), code.end(), [](const ExpressionInstruction& instruction) {
+                   return instruction.op == ExpressionOp::Constant;
+               });
+        if (!constant) {
+            push({ op, 0, 0.0 }, 1 - static_cast<int>(arity));
+            return;
+        }
+        double value = 0.0;
+        if (arity == 2) {
+            value = ApplyScalar(op, code[code.size() - 2].constant, code.back().constant);
+        } else {
+            value = ApplyScalar(op, code.back().constant);
+        }
+        pop(arity);
+        push({ ExpressionOp::Constant, 0, value });
+    }
+
+    void push(ExpressionInstruction instruction, int stackEffect = 1)
+    {
+        out_.code_.push_back(instruction);
+        depth_ = static_cast<std::size_t>(static_cast<int>(depth_) + stackEffect);
+        out_.stackDepth_ = std::max(out_.stackDepth_, depth_);
+    }
+
+    // Drops the last `count` constants.
+    void pop(std::size_t count)
+    {
+        out_.code_.resize(out_.code_.size() - count);
+        depth_ -= count;
+    }
+
+    bool expect(char c)
+    {
+        if (pos_ >= text_.size() || text_[pos_] != c) {
+            return fail(std::string("expected '") + c + "'");
+        }
+        advance();
+        return true;
+    }
+
+    void advance()
+    {
+        ++pos_;
+        skipSpace();
+    }
+
+    void skipSpace()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool fail(std::string message)
+    {
+        return fail(std::move(message), pos_);
+    }
+
+    bool fail(std::string message, std::size_t column)
+    {
+        if (error_.empty()) {
+            error_ = "column " + std::to_string(column + 1) + ": " + message;
+        }
+        return false;
+    }
+
+    std::string_view text_;
+    ExpressionProgram& out_;
+    std::size_t pos_{0};
+    std::size_t depth_{0};
+    std::size_t nesting_{0};
+    std::string error_;
+};
+
+bool ExpressionProgram::Compile(std::string_view text, ExpressionProgram& out, std::string& error)
+{
+    return ExpressionCompiler(text, out).run(error);
+}
+
+ExpressionEvaluator::ExpressionEvaluator(const ExpressionProgram& program)
+    : program_(program)
+    , scratch_(program.stackDepth() * kBatch)
+    , stack_(program.stackDepth())
+{
+    const auto& code = program.code();
+    if (program.stateful()) {
+        windows_.resize(code.size());
+        previous_.resize(code.size());
+        held_.resize(code.size());
+        for (std::size_t i = 0; i < code.size(); ++i) {
+            if (code[i].op == ExpressionOp::Average) {
+                windows_[i].ring.assign(code[i].operand, 0.0);
+            }
+        }
+    }
+}
+
+void ExpressionEvaluator::evaluate(std::span<const std::span<const double>> inputs, std::size_t length, std::span<double> out)
+{
+    const auto& code = program_.code();
+    for (std::size_t start = 0; start < length; start += kBatch) {
+        const std::size_t count = std::min(kBatch, length - start);
+        std::size_t depth = 0;
+        for (std::size_t i = 0; i < code.size(); ++i) {
+            const auto& instruction = code[i];
+            switch (instruction.op) {
+            case ExpressionOp::Constant:
+                stack_[depth++] = Slot { nullptr, true, instruction.constant };
+                break;
+            case ExpressionOp::Input: {
+                const auto input = inputs[instruction.operand];
+                if (input.size() == 1 || length == 1) {
+                    stack_[depth++] = Slot { nullptr, true, input.front() };
+                } else {
+                    stack_[depth++] = Slot { input.data() + start, false, 0.0 };
+                }
+                break;
+            }
+            case ExpressionOp::Average:
+            case ExpressionOp::Delta: {
+                auto& operand = stack_[depth - 1];
+                const bool averaging = instruction.op == ExpressionOp::Average;
+                if (operand.scalar) {
+                    // One value per call, so only the first batch advances the history.
+                    if (start == 0) {
+                        held_[i] = averaging ? average(windows_[i], operand.value) : delta(previous_[i], operand.value);
+                    }
+                    operand.value = held_[i];
+                    break;
+                }
+                double* target = scratch_.data() + (depth - 1) * kBatch;
+                for (std::size_t k = 0; k < count; ++k) {
+                    target[k] = averaging ? average(windows_[i], operand.data[k]) : delta(previous_[i], operand.data[k]);
+                }
+                operand = Slot { target, false, 0.0 };
+                break;
+            }
+            default:
+                if (IsBinary(instruction.op)) {
+                    const auto rhs = stack_[--depth];
+                    auto& lhs = stack_[depth - 1];
+                    if (lhs.scalar && rhs.scalar) {
+                        lhs.value = ApplyScalar(instruction.op, lhs.value, rhs.value);
+                        break;
+                    }
+                    double* target = scratch_.data() + (depth - 1) * kBatch;
+                    BinaryBatch(instruction.op,
+                        lhs.scalar ? &lhs.value : lhs.data, lhs.scalar,
+                        rhs.scalar ? &rhs.value : rhs.data, rhs.scalar,
+                        target, count);
+                    lhs = Slot { target, false, 0.0 };
+                } else {
+                    auto& operand = stack_[depth - 1];
+                    if (operand.scalar) {
+                        operand.value = ApplyScalar(instruction.op, operand.value);
+                        break;
+                    }
+                    double* target = scratch_.data() + (depth - 1) * kBatch;
+                    UnaryBatch(instruction.op, operand.data, target, count);
+                    operand = Slot { target, false, 0.0 };
+                }
+                break;
+            }
+        }
+        const auto& result = stack_[0];
+        if (result.scalar) {
+            std::fill_n(out.data() + start, count, result.value);
+        } else {
+            std::copy_n(result.data, count, out.data() + start);
+        }
+    }
+}
+
+void ExpressionEvaluator::reset()
+{
+    for (auto& window : windows_) {
+        std::fill(window.ring.begin(), window.ring.end(), 0.0);
+        window.head = 0;
+        window.count = 0;
+        window.sum = 0.0;
+    }
+    std::fill(previous_.begin(), previous_.end(), Previous {});
+}
+
+double ExpressionEvaluator::average(Window& window, double value)
+{
+    const std::size_t size = window.ring.size();
+    if (window.count == size) {
+        window.sum -= window.ring[window.head];
+    } else {
+        ++window.count;
+    }
+    window.ring[window.head] = value;
+    window.sum += value;
+    if (++window.head == size) {
+        window.head = 0;
+        // Resum once per lap so rounding in the running sum cannot accumulate.
+        if (window.count == size) {
+            window.sum = std::accumulate(window.ring.begin(), window.ring.end(), 0.0);
+        }
+    }
+    return window.sum / static_cast<double>(window.count);
+}
+
+double ExpressionEvaluator::delta(Previous& previous, double value)
+{
+    const double change = previous.valid ? value - previous.value : 0.0;
+    previous.value = value;
+    previous.valid = true;
+    return change;
+}
+
+} // namespace core
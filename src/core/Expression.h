@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core {
+
+// One channel of one source, as referenced by `{source/channel}` in an expression.
+struct ChannelRef {
+    std::string sourceId;
+    std::string channelId;
+
+    bool operator==(const ChannelRef&) const = default;
+};
+
+enum class ExpressionOp : std::uint8_t {
+    Constant,
+    Input,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    Abs,
+    Sqrt,
+    Min,
+    Max,
+    // Stateful: mean of the last `operand` samples, and the change since the previous one.
+    Average,
+    Delta
+};
+
+struct ExpressionInstruction {
+    ExpressionOp op{ExpressionOp::Constant};
+    // Input index for Input, window length for Average.
+    std::uint32_t operand{0};
+    double constant{0.0};
+};
+
+/**
+ * @brief An arithmetic expression over channels, compiled once to postfix code.
+ *
+ * Grammar: `+ - * /`, unary minus, parentheses, numbers, `{source/channel}`
+ * references (split at the last `/`) and the functions `abs`, `sqrt`, `min`,
+ * `max`, `avg(x, n)` (mean of the last n samples) and `delta(x)` (change since the
+ * previous sample). Sub-expressions without references are folded at compile time
+ * and each distinct reference becomes one input.
+ */
+class ExpressionProgram {
+public:
+    // False, with `error` naming the column, when `text` does not parse.
+    static bool Compile(std::string_view text, ExpressionProgram& out, std::string& error);
+
+    [[nodiscard]] const std::string& text() const { return text_; }
+    [[nodiscard]] const std::vector<ChannelRef>& inputs() const { return inputs_; }
+    [[nodiscard]] const std::vector<ExpressionInstruction>& code() const { return code_; }
+    // Deepest the operand stack gets while evaluating.
+    [[nodiscard]] std::size_t stackDepth() const { return stackDepth_; }
+    [[nodiscard]] bool stateful() const { return stateful_; }
+
+private:
+    friend class ExpressionCompiler;
+
+    std::string text_;
+    std::vector<ChannelRef> inputs_;
+    std::vector<ExpressionInstruction> code_;
+    std::size_t stackDepth_{0};
+    bool stateful_{false};
+};
+
+/**
+ * @brief Runs an ExpressionProgram over blocks of samples.
+ *
+ * Each instruction is applied to a whole batch of lanes before the next one, with
+ * AVX2 or AArch64 NEON kernels when the build targets them, so interpreting the
+ * program costs a few dispatches per batch rather than per sample. Inputs of one
+ * value (numeric channels) are broadcast against waveform blocks. Stateful
+ * functions keep their history between calls: per sample for block operands, per
+ * call for single values. Not thread-safe; one evaluator per output.
+ */
+class ExpressionEvaluator {
+public:
+    explicit ExpressionEvaluator(const ExpressionProgram& program);
+
+    // `inputs` follows program.inputs(); each holds one value or at least `length`.
+    // Writes `length` results to `out`, which must be at least that long.
+    void evaluate(std::span<const std::span<const double>> inputs, std::size_t length, std::span<double> out);
+    // Forgets the history of stateful functions.
+    void reset();
+
+    // Lanes per batch; keeps the scratch stack in L1.
+    static constexpr std::size_t kBatch = 512;
+
+private:
+    struct Slot {
+        const double* data{nullptr};
+        bool scalar{true};
+        double value{0.0};
+    };
+    struct Window {
+        std::vector<double> ring;
+        std::size_t head{0};
+        std::size_t count{0};
+        double sum{0.0};
+    };
+    struct Previous {
+        double value{0.0};
+        bool valid{false};
+    };
+
+    double average(Window& window, double value);
+    double delta(Previous& previous, double value);
+
+    const ExpressionProgram& program_;
+    std::vector<double> scratch_;
+    std::vector<Slot> stack_;
+    // Indexed by instruction; only the stateful instructions use theirs.
+    std::vector<Window> windows_;
+    std::vector<Previous> previous_;
+    std::vector<double> held_;
+};
+
+}  // namespace core
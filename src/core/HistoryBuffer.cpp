@@ -0,0 +1,100 @@
+#include "HistoryBuffer.h"
+
+#include <algorithm>
+
+namespace core {
+
+SampleRing::SampleRing(std::size_t capacity)
+    : timestamps_(std::max<std::size_t>(capacity, 1))
+    , values_(std::max<std::size_t>(capacity, 1))
+{
+}
+
+void SampleRing::push(TimePoint timestamp, double value)
+{
+    timestamps_[head_] = timestamp;
+    values_[head_] = value;
+    head_ = (head_ + 1) % values_.size();
+    if (size_ < values_.size()) {
+        ++size_;
+    }
+    ++sequence_;
+}
+
+void SampleRing::clear()
+{
+    head_ = 0;
+    size_ = 0;
+}
+
+std::size_t SampleRing::physicalIndex(std::size_t logicalIndex) const
+{
+    // Logical index 0 is the oldest retained sample.
+    const std::size_t cap = values_.size();
+    return (head_ + cap - size_ + logicalIndex) % cap;
+}
+
+void SampleRing::copyRange(std::size_t firstLogical, std::size_t count, HistoryWindow& out) const
+{
+    out.timestamps.resize(count);
+    out.values.resize(count);
+    out.endSequence = sequence_;
+    if (count == 0) {
+        return;
+    }
+
+    // The requested range is at most two contiguous runs in the backing arrays.
+    const std::size_t cap = values_.size();
+    const std::size_t start = physicalIndex(firstLogical);
+    const std::size_t firstRun = std::min(count, cap - start);
+    std::copy_n(timestamps_.begin() + static_cast<std::ptrdiff_t>(start), firstRun, out.timestamps.begin());
+    std::copy_n(values_.begin() + static_cast<std::ptrdiff_t>(start), firstRun, out.values.begin());
+    const std::size_t secondRun = count - firstRun;
+    if (secondRun > 0) {
+        std::copy_n(timestamps_.begin(), secondRun, out.timestamps.begin() + static_cast<std::ptrdiff_t>(firstRun));
+        std::copy_n(values_.begin(), secondRun, out.values.begin() + static_cast<std::ptrdiff_t>(firstRun));
+    }
+}
+
+void SampleRing::copyLatest(std::size_t count, HistoryWindow& out) const
+{
+    const std::size_t n = std::min(count, size_);
+    copyRange(size_ - n, n, out);
+}
+
+std::size_t SampleRing::lowerBound(TimePoint since) const
+{
+    // Timestamps are pushed in arrival order, so a binary search over logical
+    // indices finds the first sample at or after `since`.
+    std::size_t lo = 0;
+    std::size_t hi = size_;
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (timestamps_[physicalIndex(mid)] < since) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void SampleRing::copySince(TimePoint since, HistoryWindow& out) const
+{
+    const std::size_t first = lowerBound(since);
+    copyRange(first, size_ - first, out);
+}
+
+void SampleRing::copyRecent(std::chrono::nanoseconds span, std::size_t maxCount, HistoryWindow& out) const
+{
+    if (size_ == 0) {
+        copyRange(0, 0, out);
+        return;
+    }
+    const TimePoint newest = timestamps_[physicalIndex(size_ - 1)];
+    const std::size_t first = lowerBound(newest - std::chrono::duration_cast<TimePoint::duration>(span));
+    const std::size_t n = std::min(size_ - first, maxCount);
+    copyRange(size_ - n, n, out);
+}
+
+} // namespace core
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+
+/**
+ * @brief Result buffer for windowed history reads.
+ *
+ * Callers keep one of these around and pass it to `DataRegistry::readHistory*`
+ * so repeated reads reuse the same storage. Samples are ordered oldest first.
+ */
+struct HistoryWindow {
+    std::vector<std::chrono::system_clock::time_point> timestamps;
+    std::vector<double> values;
+    // Total number of samples ever pushed to the ring at the time of the read.
+    std::uint64_t endSequence{0};
+
+    [[nodiscard]] std::size_t size() const { return values.size(); }
+    [[nodiscard]] bool empty() const { return values.empty(); }
+
+    void clear()
+    {
+        timestamps.clear();
+        values.clear();
+        endSequence = 0;
+    }
+};
+
+/**
+ * @brief Fixed-capacity ring of timestamped samples for one channel.
+ *
+ * Pushing is O(1) and never allocates once constructed; the oldest sample is
+ * overwritten when the ring is full. Not thread-safe on its own; the registry
+ * guards each ring with its own mutex.
+ */
+class SampleRing {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    explicit SampleRing(std::size_t capacity);
+
+    void push(TimePoint timestamp, double value);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] std::size_t capacity() const { return values_.size(); }
+    [[nodiscard]] std::uint64_t sequence() const { return sequence_; }
+
+    // Copies at most `count` of the newest samples into `out` (replacing its contents).
+    void copyLatest(std::size_t count, HistoryWindow& out) const;
+    // Copies every retained sample with a timestamp >= `since` into `out`.
+    void copySince(TimePoint since, HistoryWindow& out) const;
+    // Copies the newest samples no more than `span` older than the newest one, at
+    // most `maxCount` of them. Measured from the newest sample rather than the
+    // clock, so paused and replayed sources read the same as live ones.
+    void copyRecent(std::chrono::nanoseconds span, std::size_t maxCount, HistoryWindow& out) const;
+
+private:
+    // Logical index of the first retained sample at or after `since`.
+    [[nodiscard]] std::size_t lowerBound(TimePoint since) const;
+    [[nodiscard]] std::size_t physicalIndex(std::size_t logicalIndex) const;
+    void copyRange(std::size_t firstLogical, std::size_t count, HistoryWindow& out) const;
+
+    std::vector<TimePoint> timestamps_;
+    std::vector<double> values_;
+    std::size_t head_{0};  // next write position
+    std::size_t size_{0};
+    std::uint64_t sequence_{0};
+};
+
+}  // namespace core
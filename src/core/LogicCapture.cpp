@@ -0,0 +1,216 @@
+#include "LogicCapture.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace core {
+
+namespace {
+
+// Bits of channel word `word` that correspond to real channels.
+std::uint64_t ChannelMask(std::uint32_t channelCount, std::size_t word)
+{
+    const std::size_t remaining = channelCount - std::min<std::size_t>(channelCount, word * 64);
+    return remaining >= 64 ? ~std::uint64_t { 0 } : (std::uint64_t { 1 } << remaining) - 1;
+}
+
+} // namespace
+
+void NormalizeLogicSample(LogicSample& sample)
+{
+    const std::size_t stride = sample.wordsPerSlice();
+    if (stride == 0) {
+        sample.words.clear();
+        return;
+    }
+    sample.words.resize(sample.words.size() / stride * stride);
+    const std::uint64_t mask = ChannelMask(sample.channelCount, stride - 1);
+    if (mask == ~std::uint64_t { 0 }) {
+        return;
+    }
+    for (std::size_t i = stride - 1; i < sample.words.size(); i += stride) {
+        sample.words[i] &= mask;
+    }
+}
+
+void LogicSliceFromGpio(const GpioState& state, LogicSample& out)
+{
+    out.channelCount = state.pins.count;
+    out.words.assign(state.pins.words.begin(), state.pins.words.end());
+    out.samplePeriod = std::chrono::nanoseconds { 0 };
+    out.timestamp = state.timestamp;
+}
+
+LogicCapture::LogicCapture(std::uint64_t maxSlices)
+    : maxSlices_(std::max<std::uint64_t>(maxSlices, 1))
+{
+}
+
+void LogicCapture::append(const LogicSample& sample)
+{
+    if (sample.channelCount == 0) {
+        return;
+    }
+    if (sample.channelCount != channelCount_) {
+        clear();
+        channelCount_ = sample.channelCount;
+        stride_ = sample.wordsPerSlice();
+    }
+    if (sample.samplePeriod.count() > 0) {
+        samplePeriod_ = sample.samplePeriod;
+    }
+
+    const std::size_t slices = sample.sliceCount();
+    const std::uint64_t* data = sample.words.data();
+    if (stride_ == 1) {
+        // Single-word slices: a run starts wherever the word differs from the last.
+        for (std::size_t s = 0; s < slices; ++s, ++end_) {
+            if (runCount() == 0 || data[s] != words_.back()) {
+                pushRun(data + s);
+            }
+        }
+    } else {
+        for (std::size_t s = 0; s < slices; ++s, ++end_) {
+            const std::uint64_t* slice = data + s * stride_;
+            if (runCount() == 0 || !std::equal(slice, slice + stride_, words_.end() - static_cast<std::ptrdiff_t>(stride_))) {
+                pushRun(slice);
+            }
+        }
+    }
+    trim();
+}
+
+void LogicCapture::clear()
+{
+    starts_.clear();
+    words_.clear();
+    head_ = 0;
+    first_ = 0;
+    end_ = 0;
+}
+
+bool LogicCapture::level(std::uint64_t slice, std::size_t channel) const
+{
+    if (empty() || channel >= channelCount_) {
+        return false;
+    }
+    return (runWords(runAt(slice))[channel / 64] >> (channel % 64)) & 1u;
+}
+
+std::uint64_t LogicCapture::nextEdge(std::uint64_t slice, std::size_t word, std::uint64_t mask) const
+{
+    if (empty() || word >= stride_) {
+        return end_;
+    }
+    mask &= ChannelMask(channelCount_, word);
+    const std::size_t run = runAt(slice);
+    if (stride_ == 1 && mask == ChannelMask(channelCount_, 0)) {
+        // Every run boundary is an edge on some channel.
+        return run + 1 < starts_.size() ? starts_[run + 1] : end_;
+    }
+    for (std::size_t r = run + 1; r < starts_.size(); ++r) {
+        if (toggled(r, word) & mask) {
+            return starts_[r];
+        }
+    }
+    return end_;
+}
+
+std::uint64_t LogicCapture::previousEdge(std::uint64_t slice, std::size_t word, std::uint64_t mask) const
+{
+    if (empty() || word >= stride_) {
+        return first_;
+    }
+    mask &= ChannelMask(channelCount_, word);
+    for (std::size_t r = runAt(slice); r > head_; --r) {
+        if (toggled(r, word) & mask) {
+            return starts_[r];
+        }
+    }
+    return first_;
+}
+
+std::uint64_t LogicCapture::countEdges(std::uint64_t begin, std::uint64_t end) const
+{
+    if (empty()) {
+        return 0;
+    }
+    std::uint64_t edges = 0;
+    for (std::size_t r = runAt(begin) + 1; r < starts_.size() && starts_[r] < end; ++r) {
+        for (std::size_t w = 0; w < stride_; ++w) {
+            edges += static_cast<std::uint64_t>(std::popcount(toggled(r, w)));
+        }
+    }
+    return edges;
+}
+
+void LogicCapture::summarize(std::uint64_t begin, std::uint64_t end, std::size_t columns, std::size_t word, std::vector<Column>& out) const
+{
+    out.assign(columns, Column {});
+    if (empty() || word >= stride_ || end <= begin || columns == 0) {
+        return;
+    }
+    const std::uint64_t all = ChannelMask(channelCount_, word);
+    const std::uint64_t span = end - begin;
+    for (std::size_t x = 0; x < columns; ++x) {
+        const std::uint64_t from = begin + span * x / columns;
+        // Zoomed in past one slice per column, neighbouring columns share a slice.
+        const std::uint64_t to = std::max(from + 1, begin + span * (x + 1) / columns);
+        if (from >= end_) {
+            break;
+        }
+        const std::size_t run = runAt(from);
+        auto& column = out[x];
+        column.levels = runWords(run)[word];
+        for (std::size_t r = run + 1; r < starts_.size() && starts_[r] < to; ++r) {
+            column.toggles |= toggled(r, word);
+            if (column.toggles == all) {
+                break;
+            }
+        }
+    }
+}
+
+std::size_t LogicCapture::runAt(std::uint64_t slice) const
+{
+    const auto first = starts_.begin() + static_cast<std::ptrdiff_t>(head_);
+    const auto it = std::upper_bound(first, starts_.end(), slice);
+    if (it == first) {
+        return head_;
+    }
+    return static_cast<std::size_t>(it - starts_.begin()) - 1;
+}
+
+std::uint64_t LogicCapture::toggled(std::size_t run, std::size_t word) const
+{
+    // The run before head_ may already be gone, so the first live run has no edge.
+    if (run <= head_) {
+        return 0;
+    }
+    return runWords(run)[word] ^ runWords(run - 1)[word];
+}
+
+void LogicCapture::pushRun(const std::uint64_t* words)
+{
+    starts_.push_back(end_);
+    words_.insert(words_.end(), words, words + stride_);
+}
+
+void LogicCapture::trim()
+{
+    if (end_ - first_ <= maxSlices_) {
+        return;
+    }
+    first_ = end_ - maxSlices_;
+    while (head_ + 1 < starts_.size() && starts_[head_ + 1] <= first_) {
+        ++head_;
+    }
+    // Compact once the dead prefix dominates, so trimming stays amortised O(1).
+    if (head_ >= 1024 && head_ * 2 >= starts_.size()) {
+        starts_.erase(starts_.begin(), starts_.begin() + static_cast<std::ptrdiff_t>(head_));
+        words_.erase(words_.begin(), words_.begin() + static_cast<std::ptrdiff_t>(head_ * stride_));
+        head_ = 0;
+    }
+}
+
+} // namespace core
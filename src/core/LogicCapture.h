@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+
+// Drops a trailing partial slice and clears the bits above `channelCount`, so
+// consumers can compare and XOR whole words.
+void NormalizeLogicSample(LogicSample& sample);
+
+// Copies GPIO pin states into a single-slice logic sample, reusing `out`'s storage.
+void LogicSliceFromGpio(const GpioState& state, LogicSample& out);
+
+/**
+ * @brief Run-length compressed logic capture with word-parallel edge search.
+ *
+ * Consecutive identical slices collapse into one run, so idle lines cost nothing
+ * and captures of slow or bursty signals stay small however many samples they
+ * span. Every run boundary is an edge on at least one channel; which channels
+ * toggled is the XOR of neighbouring runs, 64 channels per word. Slices are
+ * addressed by absolute index; once more than `maxSlices` have been appended the
+ * oldest are discarded.
+ */
+class LogicCapture {
+public:
+    static constexpr std::uint64_t kDefaultMaxSlices = std::uint64_t{1} << 22;
+
+    // Levels of one 64-channel word over a span of slices.
+    struct Column {
+        std::uint64_t levels{0};   // levels at the start of the span
+        std::uint64_t toggles{0};  // channels that changed at least once inside it
+    };
+
+    explicit LogicCapture(std::uint64_t maxSlices = kDefaultMaxSlices);
+
+    // Appends every slice of `sample`. A change of channel count restarts the capture.
+    void append(const LogicSample& sample);
+    void clear();
+
+    [[nodiscard]] std::uint32_t channelCount() const { return channelCount_; }
+    [[nodiscard]] std::chrono::nanoseconds samplePeriod() const { return samplePeriod_; }
+    [[nodiscard]] std::uint64_t firstSlice() const { return first_; }
+    [[nodiscard]] std::uint64_t endSlice() const { return end_; }
+    [[nodiscard]] std::uint64_t sliceCount() const { return end_ - first_; }
+    [[nodiscard]] std::size_t runCount() const { return starts_.size() - head_; }
+    [[nodiscard]] bool empty() const { return end_ == first_; }
+
+    [[nodiscard]] bool level(std::uint64_t slice, std::size_t channel) const;
+
+    // First slice after `slice` at which any channel in `mask` (one word, channels
+    // 64 * word .. 64 * word + 63) changes level; endSlice() when there is none.
+    [[nodiscard]] std::uint64_t nextEdge(std::uint64_t slice, std::size_t word = 0, std::uint64_t mask = ~std::uint64_t{0}) const;
+    // Last slice at or before `slice` at which a channel in `mask` changed level;
+    // firstSlice() when there is none.
+    [[nodiscard]] std::uint64_t previousEdge(std::uint64_t slice, std::size_t word = 0, std::uint64_t mask = ~std::uint64_t{0}) const;
+
+    // Total level changes over every channel in (begin, end), by popcount.
+    [[nodiscard]] std::uint64_t countEdges(std::uint64_t begin, std::uint64_t end) const;
+
+    // Splits [begin, end) into `columns` equal spans and summarises channel word
+    // `word` over each, reusing `out`'s storage. Cost is proportional to the runs
+    // in view, stopping early once every channel in a column has toggled.
+    void summarize(std::uint64_t begin, std::uint64_t end, std::size_t columns, std::size_t word, std::vector<Column>& out) const;
+
+private:
+    // Index into starts_ of the run containing `slice` (clamped to the live range).
+    [[nodiscard]] std::size_t runAt(std::uint64_t slice) const;
+    [[nodiscard]] const std::uint64_t* runWords(std::size_t run) const { return words_.data() + run * stride_; }
+    [[nodiscard]] std::uint64_t toggled(std::size_t run, std::size_t word) const;
+    void pushRun(const std::uint64_t* words);
+    void trim();
+
+    std::uint64_t maxSlices_;
+    std::uint32_t channelCount_{0};
+    std::size_t stride_{0};
+    std::chrono::nanoseconds samplePeriod_{};
+
+    // Run i covers [starts_[i], starts_[i + 1]) with levels runWords(i). Runs before
+    // head_ have been trimmed and are compacted away lazily.
+    std::vector<std::uint64_t> starts_;
+    std::vector<std::uint64_t> words_;
+    std::size_t head_{0};
+    std::uint64_t first_{0};
+    std::uint64_t end_{0};
+};
+
+}  // namespace core
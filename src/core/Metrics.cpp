@@ -0,0 +1,338 @@
+#include "Metrics.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace core::metrics {
+
+namespace {
+
+struct HistogramCells {
+    std::array<std::atomic<std::uint64_t>, kHistogramBuckets> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> max{0};
+};
+
+// One thread's cells. Only the owning thread writes; Collect() reads concurrently,
+// which is why the cells are atomics even though no update needs a RMW.
+struct ThreadCells {
+    std::array<std::atomic<std::uint64_t>, kMaxCounters> counters{};
+    // Allocated on the thread's first record of each histogram.
+    std::array<std::atomic<HistogramCells*>, kMaxHistograms> histograms{};
+
+    ~ThreadCells()
+    {
+        for (auto& cells : histograms) {
+            delete cells.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+void Bump(std::atomic<std::uint64_t>& cell, std::uint64_t amount)
+{
+    cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct GaugeCells {
+    std::atomic<std::int64_t> value{0};
+    std::atomic<std::int64_t> max{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> counterNames;
+    std::vector<std::string> histogramNames;
+    std::vector<std::string> gaugeNames;
+    std::unordered_map<std::string, std::uint32_t> counterIndex;
+    std::unordered_map<std::string, std::uint32_t> histogramIndex;
+    std::unordered_map<std::string, std::uint32_t> gaugeIndex;
+    // Shared by every thread; see Gauge.
+    std::array<GaugeCells, kMaxGauges> gauges;
+    std::vector<ThreadCells*> threads;
+    // Totals of threads that have exited.
+    ThreadCells retired;
+
+    std::uint32_t intern(std::string_view name, std::vector<std::string>& names,
+        std::unordered_map<std::string, std::uint32_t>& index, std::size_t capacity)
+    {
+        std::lock_guard lock(mutex);
+        std::string key(name);
+        if (auto it = index.find(key); it != index.end()) {
+            return it->second;
+        }
+        if (names.size() + 1 < capacity) {
+            names.push_back(key);
+            index.emplace(std::move(key), static_cast<std::uint32_t>(names.size() - 1));
+            return static_cast<std::uint32_t>(names.size() - 1);
+        }
+        // The last slot is shared by every name that did not fit.
+        if (names.size() + 1 == capacity) {
+            spdlog::warn("Metrics: capacity of {} reached; '{}' and later metrics are counted as 'other'", capacity, key);
+            names.push_back("other");
+        }
+        index.emplace(std::move(key), static_cast<std::uint32_t>(capacity - 1));
+        return static_cast<std::uint32_t>(capacity - 1);
+    }
+};
+
+// Never destroyed: threads may record while static destructors run.
+Registry& GetRegistry()
+{
+    static auto* registry = new Registry();
+    return *registry;
+}
+
+void Fold(const ThreadCells& from, ThreadCells& into)
+{
+    for (std::size_t i = 0; i < kMaxCounters; ++i) {
+        Bump(into.counters[i], from.counters[i].load(std::memory_order_relaxed));
+    }
+    for (std::size_t i = 0; i < kMaxHistograms; ++i) {
+        const auto* source = from.histograms[i].load(std::memory_order_acquire);
+        if (!source) {
+            continue;
+        }
+        auto* target = into.histograms[i].load(std::memory_order_relaxed);
+        if (!target) {
+            target = new HistogramCells();
+            into.histograms[i].store(target, std::memory_order_release);
+        }
+        for (std::size_t b = 0; b < kHistogramBuckets; ++b) {
+            Bump(target->buckets[b], source->buckets[b].load(std::memory_order_relaxed));
+        }
+        Bump(target->count, source->count.load(std::memory_order_relaxed));
+        Bump(target->sum, source->sum.load(std::memory_order_relaxed));
+        target->max.store(std::max(target->max.load(std::memory_order_relaxed), source->max.load(std::memory_order_relaxed)),
+            std::memory_order_relaxed);
+    }
+}
+
+// Registers the calling thread's cells on first use and retires them at thread exit.
+class ThreadSlot {
+public:
+    ThreadSlot()
+        : cells_(std::make_unique<ThreadCells>())
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.threads.push_back(cells_.get());
+    }
+
+    ~ThreadSlot()
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        Fold(*cells_, registry.retired);
+        registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), cells_.get()), registry.threads.end());
+    }
+
+    ThreadCells& cells() { return *cells_; }
+
+private:
+    std::unique_ptr<ThreadCells> cells_;
+};
+
+ThreadCells& LocalCells()
+{
+    thread_local ThreadSlot slot;
+    return slot.cells();
+}
+
+std::size_t BucketFor(std::uint64_t ns)
+{
+    return std::min<std::size_t>(static_cast<std::size_t>(std::bit_width(ns)), kHistogramBuckets - 1);
+}
+
+void Accumulate(const ThreadCells& cells, Snapshot& out)
+{
+    for (std::size_t i = 0; i < out.counters.size(); ++i) {
+        out.counters[i].total += cells.counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < out.histograms.size(); ++i) {
+        const auto* source = cells.histograms[i].load(std::memory_order_acquire);
+        if (!source) {
+            continue;
+        }
+        auto& target = out.histograms[i];
+        for (std::size_t b = 0; b < kHistogramBuckets; ++b) {
+            target.buckets[b] += source->buckets[b].load(std::memory_order_relaxed);
+        }
+        target.count += source->count.load(std::memory_order_relaxed);
+        target.sumNs += source->sum.load(std::memory_order_relaxed);
+        target.maxNs = std::max(target.maxNs, source->max.load(std::memory_order_relaxed));
+    }
+}
+
+std::string FormatNs(double ns)
+{
+    char buffer[32];
+    if (ns >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+    } else if (ns >= 1e3) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f us", ns / 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.0f ns", ns);
+    }
+    return buffer;
+}
+
+} // namespace
+
+Counter::Counter(std::string_view name)
+{
+    auto& registry = GetRegistry();
+    index_ = registry.intern(name, registry.counterNames, registry.counterIndex, kMaxCounters);
+}
+
+void Counter::add(std::uint64_t amount) const
+{
+    Bump(LocalCells().counters[index_], amount);
+}
+
+Histogram::Histogram(std::string_view name)
+{
+    auto& registry = GetRegistry();
+    index_ = registry.intern(name, registry.histogramNames, registry.histogramIndex, kMaxHistograms);
+}
+
+void Histogram::record(std::chrono::nanoseconds duration) const
+{
+    auto& slot = LocalCells().histograms[index_];
+    auto* cells = slot.load(std::memory_order_relaxed);
+    if (!cells) {
+        cells = new HistogramCells();
+        slot.store(cells, std::memory_order_release);
+    }
+    const auto ns = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 0));
+    Bump(cells->buckets[BucketFor(ns)], 1);
+    Bump(cells->count, 1);
+    Bump(cells->sum, ns);
+    if (ns > cells->max.load(std::memory_order_relaxed)) {
+        cells->max.store(ns, std::memory_order_relaxed);
+    }
+}
+
+Gauge::Gauge(std::string_view name)
+{
+    auto& registry = GetRegistry();
+    index_ = registry.intern(name, registry.gaugeNames, registry.gaugeIndex, kMaxGauges);
+}
+
+void Gauge::set(std::int64_t value) const
+{
+    auto& cells = GetRegistry().gauges[index_];
+    cells.value.store(value, std::memory_order_relaxed);
+    // Not a RMW: racing setters can lose a peak, which is fine for a high-water mark.
+    if (value > cells.max.load(std::memory_order_relaxed)) {
+        cells.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+double HistogramSnapshot::meanNs() const
+{
+    return count == 0 ? 0.0 : static_cast<double>(sumNs) / static_cast<double>(count);
+}
+
+double HistogramSnapshot::percentileNs(double fraction) const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < kHistogramBuckets; ++b) {
+        seen += buckets[b];
+        if (seen >= std::max<std::uint64_t>(rank, 1)) {
+            if (b == 0) {
+                return 0.0;
+            }
+            // Geometric midpoint of [2^(b-1), 2^b).
+            const double estimate = std::ldexp(std::sqrt(2.0), static_cast<int>(b) - 1);
+            return std::min(estimate, static_cast<double>(maxNs));
+        }
+    }
+    return static_cast<double>(maxNs);
+}
+
+Snapshot Collect()
+{
+    auto& registry = GetRegistry();
+    Snapshot snapshot;
+    std::lock_guard lock(registry.mutex);
+    snapshot.taken = std::chrono::steady_clock::now();
+    snapshot.counters.resize(registry.counterNames.size());
+    for (std::size_t i = 0; i < snapshot.counters.size(); ++i) {
+        snapshot.counters[i].name = registry.counterNames[i];
+    }
+    snapshot.histograms.resize(registry.histogramNames.size());
+    for (std::size_t i = 0; i < snapshot.histograms.size(); ++i) {
+        snapshot.histograms[i].name = registry.histogramNames[i];
+    }
+    snapshot.gauges.resize(registry.gaugeNames.size());
+    for (std::size_t i = 0; i < snapshot.gauges.size(); ++i) {
+        snapshot.gauges[i].name = registry.gaugeNames[i];
+        snapshot.gauges[i].value = registry.gauges[i].value.load(std::memory_order_relaxed);
+        snapshot.gauges[i].max = registry.gauges[i].max.load(std::memory_order_relaxed);
+    }
+    Accumulate(registry.retired, snapshot);
+    for (const auto* cells : registry.threads) {
+        Accumulate(*cells, snapshot);
+    }
+    return snapshot;
+}
+
+HistogramSnapshot Since(const HistogramSnapshot& current, const HistogramSnapshot& earlier)
+{
+    HistogramSnapshot delta = current;
+    delta.count -= std::min(delta.count, earlier.count);
+    delta.sumNs -= std::min(delta.sumNs, earlier.sumNs);
+    for (std::size_t b = 0; b < kHistogramBuckets; ++b) {
+        delta.buckets[b] -= std::min(delta.buckets[b], earlier.buckets[b]);
+    }
+    return delta;
+}
+
+void LogSnapshot(const Snapshot& current, const Snapshot* previous)
+{
+    const double seconds = previous ? std::chrono::duration<double>(current.taken - previous->taken).count() : 0.0;
+    for (std::size_t i = 0; i < current.counters.size(); ++i) {
+        const auto& counter = current.counters[i];
+        if (counter.total == 0) {
+            continue;
+        }
+        if (previous && i < previous->counters.size() && seconds > 0.0) {
+            const double rate = static_cast<double>(counter.total - previous->counters[i].total) / seconds;
+            spdlog::info("Metrics: {} = {} ({:.1f}/s)", counter.name, counter.total, rate);
+        } else {
+            spdlog::info("Metrics: {} = {}", counter.name, counter.total);
+        }
+    }
+    for (std::size_t i = 0; i < current.histograms.size(); ++i) {
+        const auto histogram = previous && i < previous->histograms.size()
+            ? Since(current.histograms[i], previous->histograms[i])
+            : current.histograms[i];
+        if (histogram.count == 0) {
+            continue;
+        }
+        spdlog::info("Metrics: {} n={} mean {} p50 {} p99 {} max {}", histogram.name, histogram.count,
+            FormatNs(histogram.meanNs()), FormatNs(histogram.percentileNs(0.50)), FormatNs(histogram.percentileNs(0.99)),
+            FormatNs(static_cast<double>(histogram.maxNs)));
+    }
+    for (const auto& gauge : current.gauges) {
+        if (gauge.max == 0) {
+            continue;
+        }
+        spdlog::info("Metrics: {} = {} (max {})", gauge.name, gauge.value, gauge.max);
+    }
+}
+
+} // namespace core::metrics
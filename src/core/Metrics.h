@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::metrics {
+
+/**
+ * @brief Process-wide hot-path counters and latency histograms.
+ *
+ * Metrics are named once and then recorded through small handles. Each thread
+ * writes only to its own cells (a relaxed load and store, no read-modify-write,
+ * no lock), and `Collect()` sums every thread's cells when someone asks, so an
+ * unread metric costs little more than the clock reads around it. Cells of
+ * exited threads are folded into a shared total. Gauges are the exception: a
+ * level such as a queue depth has one current value, so it is a single shared
+ * cell. Registering an existing name returns the same metric; names beyond the
+ * fixed capacity share an "other" slot.
+ */
+constexpr std::size_t kMaxCounters = 128;
+constexpr std::size_t kMaxHistograms = 256;
+constexpr std::size_t kMaxGauges = 64;
+// Power-of-two nanosecond buckets: bucket b holds [2^(b-1), 2^b).
+constexpr std::size_t kHistogramBuckets = 64;
+
+class Counter {
+public:
+    explicit Counter(std::string_view name);
+    void add(std::uint64_t amount = 1) const;
+
+private:
+    std::uint32_t index_;
+};
+
+class Histogram {
+public:
+    explicit Histogram(std::string_view name);
+    void record(std::chrono::nanoseconds duration) const;
+
+private:
+    std::uint32_t index_;
+};
+
+// Current level of something, plus the highest level seen since start.
+class Gauge {
+public:
+    explicit Gauge(std::string_view name);
+    void set(std::int64_t value) const;
+
+private:
+    std::uint32_t index_;
+};
+
+// Records the lifetime of the scope into `histogram`.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const Histogram& histogram)
+        : histogram_(histogram)
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedTimer()
+    {
+        histogram_.record(std::chrono::steady_clock::now() - start_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+struct CounterSnapshot {
+    std::string name;
+    std::uint64_t total{0};
+};
+
+struct HistogramSnapshot {
+    std::string name;
+    std::uint64_t count{0};
+    std::uint64_t sumNs{0};
+    std::uint64_t maxNs{0};
+    std::array<std::uint64_t, kHistogramBuckets> buckets{};
+
+    [[nodiscard]] double meanNs() const;
+    // Estimated from the buckets (geometric bucket midpoint, capped at maxNs).
+    [[nodiscard]] double percentileNs(double fraction) const;
+};
+
+struct GaugeSnapshot {
+    std::string name;
+    std::int64_t value{0};
+    std::int64_t max{0};
+};
+
+struct Snapshot {
+    std::chrono::steady_clock::time_point taken;
+    std::vector<CounterSnapshot> counters;
+    std::vector<HistogramSnapshot> histograms;
+    std::vector<GaugeSnapshot> gauges;
+};
+
+// Sums every thread's cells. Metrics are listed in registration order.
+Snapshot Collect();
+
+// Writes one info line per metric that has recorded anything; with `previous`,
+// counters also show their rate and histograms cover only the interval since.
+void LogSnapshot(const Snapshot& current, const Snapshot* previous = nullptr);
+
+// Difference of two histograms of the same metric (current minus earlier); the
+// maximum is the current one, since maxima cannot be subtracted.
+HistogramSnapshot Since(const HistogramSnapshot& current, const HistogramSnapshot& earlier);
+
+}  // namespace core::metrics
@@ -27,10 +27,17 @@ public:
     virtual std::vector<SourceMetadata> declareSources() = 0;
     virtual std::vector<ui::WindowSpec> createDefaultWindows(ModuleContext& context) = 0;
 
+    // Called from the module scheduler thread, never the UI thread; `delta` is the
+    // time since this module's previous tick.
     virtual void tick(ModuleContext& context, std::chrono::milliseconds delta) {
         (void)context;
         (void)delta;
     }
+
+    // Preferred spacing between ticks; zero ticks at the scheduler's base rate.
+    virtual std::chrono::milliseconds tickInterval() const {
+        return std::chrono::milliseconds{0};
+    }
 };
 
 using ModulePtr = std::unique_ptr<Module>;
@@ -2,12 +2,17 @@
 #include <functional>
 namespace core {
 class DataRegistry;
+class TriggerEngine;
 }
 
 namespace hardware {
 class HardwareServiceClient;
 }
 
+namespace ui {
+class RedrawScheduler;
+}
+
 namespace core {
 
 struct ModuleContext {
@@ -16,6 +21,11 @@ struct ModuleContext {
     // Optional: modules can call this to request a UI job to run on the UI thread.
     // The callback accepts a job lambda which will be posted to the FTXUI screen.
     std::function<void(std::function<void()>)> postRedraw;
+    // Coalesces per-window rebuild requests to the display frame rate; prefer this
+    // over postRedraw for anything triggered by incoming data.
+    ui::RedrawScheduler* redrawScheduler{nullptr};
+    // Optional: where trigger firings and their history snapshots are announced.
+    TriggerEngine* triggers{nullptr};
 };
 
 } // namespace core
@@ -0,0 +1,238 @@
+#include "ModuleScheduler.h"
+
+#include "PluginManager.h"
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+
+namespace core {
+
+namespace {
+
+ModuleScheduler::Clock::duration PeriodForHz(int hz)
+{
+    const int clamped = std::clamp(hz, 1, ModuleScheduler::kMaxTickRateHz);
+    return std::chrono::duration_cast<ModuleScheduler::Clock::duration>(std::chrono::duration<double>(1.0 / clamped));
+}
+
+double Microseconds(ModuleScheduler::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+double Milliseconds(ModuleScheduler::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+ModuleScheduler::ModuleScheduler(PluginManager& plugins, int tickRateHz)
+    : plugins_(plugins)
+    , tickRateHz_(std::clamp(tickRateHz, 1, kMaxTickRateHz))
+    , basePeriod_(PeriodForHz(tickRateHz))
+{
+}
+
+ModuleScheduler::~ModuleScheduler()
+{
+    stop();
+}
+
+void ModuleScheduler::setTickRate(int hz)
+{
+    {
+        std::lock_guard lock(mutex_);
+        tickRateHz_ = std::clamp(hz, 1, kMaxTickRateHz);
+        basePeriod_ = PeriodForHz(tickRateHz_);
+        applyIntervalsLocked();
+    }
+    cv_.notify_one();
+}
+
+int ModuleScheduler::tickRate() const
+{
+    std::lock_guard lock(mutex_);
+    return tickRateHz_;
+}
+
+void ModuleScheduler::setModuleRate(const std::string& moduleId, int hz)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (hz <= 0) {
+            overrides_.erase(moduleId);
+        } else {
+            overrides_[moduleId] = PeriodForHz(hz);
+        }
+        applyIntervalsLocked();
+    }
+    cv_.notify_one();
+}
+
+void ModuleScheduler::start()
+{
+    std::lock_guard lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    // Deadlines restart from now rather than replaying the time spent stopped.
+    haveRevision_ = false;
+    thread_ = std::thread(&ModuleScheduler::run, this);
+    spdlog::debug("ModuleScheduler: started with a {} Hz base tick rate", tickRateHz_);
+}
+
+void ModuleScheduler::stop()
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard lock(mutex_);
+    for (const auto& entry : entries_) {
+        const auto& s = entry.stats;
+        if (s.ticks == 0) {
+            continue;
+        }
+        spdlog::info("ModuleScheduler: '{}' ticked {} times every {:.1f} ms; cost mean {:.1f} us, max {:.1f} us; {} overruns",
+            s.moduleId, s.ticks, Milliseconds(s.interval), Microseconds(s.meanCost()), Microseconds(s.maxCost), s.overruns);
+    }
+}
+
+std::vector<ModuleScheduler::TickStats> ModuleScheduler::stats() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<TickStats> snapshot;
+    snapshot.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        snapshot.push_back(entry.stats);
+    }
+    return snapshot;
+}
+
+void ModuleScheduler::run()
+{
+    std::unique_lock lock(mutex_);
+    while (running_) {
+        auto now = Clock::now();
+        const auto revision = plugins_.revision();
+        if (!haveRevision_ || revision != revision_) {
+            refreshLocked(now);
+            revision_ = revision;
+            haveRevision_ = true;
+        }
+
+        for (std::size_t i = 0; i < entries_.size() && running_; ++i) {
+            if (entries_[i].due <= now) {
+                tickEntry(i, now, lock);
+                now = Clock::now();
+            }
+        }
+        if (!running_) {
+            break;
+        }
+
+        auto next = now + basePeriod_;
+        for (const auto& entry : entries_) {
+            next = std::min(next, entry.due);
+        }
+        // Rate changes and stop() notify, so the next deadline is recomputed early.
+        cv_.wait_until(lock, next);
+    }
+}
+
+void ModuleScheduler::refreshLocked(Clock::time_point now)
+{
+    const auto modules = plugins_.modules();
+    // Modules are only ever appended, so existing entries keep their statistics.
+    if (modules.size() < entries_.size()) {
+        entries_.clear();
+    }
+    for (auto& entry : entries_) {
+        entry.last = now;
+        entry.due = now;
+    }
+    for (std::size_t i = entries_.size(); i < modules.size(); ++i) {
+        Entry entry;
+        entry.stats.moduleId = modules[i]->id();
+        entry.preferred = std::max(Clock::duration{}, Clock::duration{modules[i]->tickInterval()});
+        entry.last = now;
+        entry.due = now;
+        entries_.push_back(std::move(entry));
+    }
+    applyIntervalsLocked();
+}
+
+void ModuleScheduler::applyIntervalsLocked()
+{
+    for (auto& entry : entries_) {
+        Clock::duration interval = basePeriod_;
+        if (auto it = overrides_.find(entry.stats.moduleId); it != overrides_.end()) {
+            interval = it->second;
+        } else if (entry.preferred > Clock::duration{}) {
+            interval = entry.preferred;
+        }
+        if (interval != entry.stats.interval) {
+            entry.stats.interval = interval;
+            entry.due = std::min(entry.due, entry.last + interval);
+        }
+    }
+}
+
+void ModuleScheduler::tickEntry(std::size_t index, Clock::time_point now, std::unique_lock<std::mutex>& lock)
+{
+    auto& entry = entries_[index];
+    const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.last);
+    // Only whole milliseconds are handed out; the remainder carries into the next tick.
+    entry.last += delta;
+    // Only this thread resizes entries_ or renames an entry, so the id is safe to
+    // read unlocked.
+    const std::string& moduleId = entry.stats.moduleId;
+
+    // Ticks run unlocked so stats() and rate changes never wait on a slow module.
+    lock.unlock();
+    bool ticked = false;
+    const auto begin = Clock::now();
+    try {
+        ticked = plugins_.tickModule(index, delta);
+    } catch (const std::exception& ex) {
+        ticked = true;
+        spdlog::error("ModuleScheduler: module '{}' tick threw: {}", moduleId, ex.what());
+    }
+    const auto end = Clock::now();
+    lock.lock();
+
+    auto& current = entries_[index];
+    current.due += current.stats.interval;
+    if (current.due <= end) {
+        ++current.stats.overruns;
+        current.due = end + current.stats.interval;
+    }
+    if (!ticked) {
+        return;
+    }
+
+    auto& s = current.stats;
+    const auto cost = end - begin;
+    ++s.ticks;
+    s.lastCost = cost;
+    s.maxCost = std::max(s.maxCost, cost);
+    s.totalCost += cost;
+    if (cost > s.interval && !current.warned) {
+        current.warned = true;
+        spdlog::warn("ModuleScheduler: module '{}' tick took {:.1f} ms, longer than its {:.1f} ms interval",
+            s.moduleId, Milliseconds(cost), Milliseconds(s.interval));
+    }
+}
+
+} // namespace core
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+
+class PluginManager;
+
+/**
+ * @brief Drives `Module::tick` from a dedicated thread at a fixed cadence.
+ *
+ * Each module ticks on its own interval: a rate set with `setModuleRate`, else
+ * the module's `tickInterval()`, else the scheduler's base rate. Deadlines advance
+ * by whole intervals so a module keeps its average rate; one that falls more than
+ * an interval behind skips the missed ticks instead of bursting to catch up, and
+ * the miss is counted as an overrun. Modules share the one thread, so a slow tick
+ * delays the others; every tick is timed so the culprit can be found from
+ * `stats()` or the summary logged on `stop()`.
+ */
+class ModuleScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kDefaultTickRateHz = 50;
+    static constexpr int kMaxTickRateHz = 1000;
+
+    struct TickStats {
+        std::string moduleId;
+        Clock::duration interval{};
+        std::uint64_t ticks{0};
+        std::uint64_t overruns{0};
+        Clock::duration lastCost{};
+        Clock::duration maxCost{};
+        Clock::duration totalCost{};
+
+        [[nodiscard]] Clock::duration meanCost() const
+        {
+            return ticks == 0 ? Clock::duration{} : totalCost / static_cast<Clock::rep>(ticks);
+        }
+    };
+
+    explicit ModuleScheduler(PluginManager& plugins, int tickRateHz = kDefaultTickRateHz);
+    ~ModuleScheduler();
+
+    ModuleScheduler(const ModuleScheduler&) = delete;
+    ModuleScheduler& operator=(const ModuleScheduler&) = delete;
+
+    void setTickRate(int hz);
+    [[nodiscard]] int tickRate() const;
+    // Overrides a module's own interval; `hz <= 0` restores it.
+    void setModuleRate(const std::string& moduleId, int hz);
+
+    void start();
+    void stop();
+
+    [[nodiscard]] std::vector<TickStats> stats() const;
+
+private:
+    struct Entry {
+        TickStats stats;
+        Clock::duration preferred{};  // module's tickInterval(), zero for the base rate
+        Clock::time_point due{};
+        Clock::time_point last{};
+        bool warned{false};
+    };
+
+    void run();
+    // Matches entries_ to the plugin manager's module list after it changes.
+    void refreshLocked(Clock::time_point now);
+    void applyIntervalsLocked();
+    void tickEntry(std::size_t index, Clock::time_point now, std::unique_lock<std::mutex>& lock);
+
+    PluginManager& plugins_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool running_{false};
+    int tickRateHz_;
+    Clock::duration basePeriod_;
+    std::unordered_map<std::string, Clock::duration> overrides_;
+    std::vector<Entry> entries_;
+    std::uint64_t revision_{0};
+    bool haveRevision_{false};
+};
+
+}  // namespace core
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace core {
+
+/**
+ * @brief Bounded lock-free queue for any number of producers and consumers.
+ *
+ * Dmitry Vyukov's array queue: every cell carries a sequence number that says
+ * whether it is ready to be written or read at a given position, so a push or pop
+ * is one CAS on its cursor plus a release store to the cell, and producers and
+ * consumers never touch the same cursor. Capacity is rounded up to a power of two.
+ * Neither operation blocks; callers that need to wait pair the queue with a
+ * semaphore or similar.
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(std::size_t capacity)
+        : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+        , cells_(std::make_unique<Cell[]>(mask_ + 1))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // False when the queue is full.
+    bool tryPush(T value)
+    {
+        std::size_t position = enqueue_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &cells_[position & mask_];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (diff == 0) {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // False when the queue is empty.
+    bool tryPop(T& out)
+    {
+        std::size_t position = dequeue_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &cells_[position & mask_];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+            if (diff == 0) {
+                if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->value);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return mask_ + 1; }
+
+    // Approximate while pushes or pops are in progress.
+    [[nodiscard]] std::size_t size() const
+    {
+        const std::size_t tail = dequeue_.load(std::memory_order_relaxed);
+        const std::size_t head = enqueue_.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    // Keeps the two cursors off each other's cache line.
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLine) std::atomic<std::size_t> enqueue_{0};
+    alignas(kCacheLine) std::atomic<std::size_t> dequeue_{0};
+};
+
+}  // namespace core
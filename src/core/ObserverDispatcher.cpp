@@ -0,0 +1,171 @@
+#include "ObserverDispatcher.h"
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace core {
+
+struct ObserverDispatcher::Mailbox {
+    Callback callback;
+    BackpressurePolicy policy{BackpressurePolicy::ConflateLatest};
+
+    std::mutex mutex;
+    // Fixed ring of undelivered frames; sized once so posting never allocates.
+    std::vector<FramePtr> ring;
+    std::size_t head{0};
+    std::size_t count{0};
+    // True while the mailbox sits in ready_ or is being drained by a worker.
+    bool scheduled{false};
+    bool closed{false};
+};
+
+ObserverDispatcher::ObserverDispatcher(std::size_t workers)
+    : workerCount_(std::max<std::size_t>(workers, 1))
+{
+}
+
+ObserverDispatcher::~ObserverDispatcher()
+{
+    stop();
+}
+
+ObserverDispatcher::MailboxPtr ObserverDispatcher::createMailbox(Callback callback, const ObserverOptions& options)
+{
+    auto mailbox = std::make_shared<Mailbox>();
+    mailbox->callback = std::move(callback);
+    mailbox->policy = options.policy;
+    const std::size_t capacity = options.policy == BackpressurePolicy::ConflateLatest ? 1 : std::max<std::size_t>(options.queueCapacity, 1);
+    mailbox->ring.resize(capacity);
+
+    std::lock_guard lock(mutex_);
+    ensureWorkersLocked();
+    return mailbox;
+}
+
+void ObserverDispatcher::post(const MailboxPtr& mailbox, FramePtr frame)
+{
+    bool needsSchedule = false;
+    {
+        std::lock_guard lock(mailbox->mutex);
+        if (mailbox->closed) {
+            return;
+        }
+        const std::size_t capacity = mailbox->ring.size();
+        if (mailbox->count == capacity) {
+            // Full: overwrite the oldest slot. For ConflateLatest (capacity 1) this
+            // replaces the pending frame with the newer one.
+            mailbox->ring[mailbox->head] = std::move(frame);
+            mailbox->head = (mailbox->head + 1) % capacity;
+            droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            mailbox->ring[(mailbox->head + mailbox->count) % capacity] = std::move(frame);
+            ++mailbox->count;
+        }
+        if (!mailbox->scheduled) {
+            mailbox->scheduled = true;
+            needsSchedule = true;
+        }
+    }
+    if (needsSchedule) {
+        schedule(mailbox);
+    }
+}
+
+void ObserverDispatcher::close(const MailboxPtr& mailbox)
+{
+    std::lock_guard lock(mailbox->mutex);
+    mailbox->closed = true;
+    for (auto& frame : mailbox->ring) {
+        frame.reset();
+    }
+    mailbox->count = 0;
+}
+
+void ObserverDispatcher::stop()
+{
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+        workers.swap(workers_);
+    }
+    cv_.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    std::lock_guard lock(mutex_);
+    ready_.clear();
+}
+
+void ObserverDispatcher::ensureWorkersLocked()
+{
+    if (!workers_.empty() || stopping_) {
+        return;
+    }
+    workers_.reserve(workerCount_);
+    for (std::size_t i = 0; i < workerCount_; ++i) {
+        workers_.emplace_back(&ObserverDispatcher::workerLoop, this);
+    }
+    spdlog::debug("ObserverDispatcher: started {} dispatch workers", workerCount_);
+}
+
+void ObserverDispatcher::schedule(MailboxPtr mailbox)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        ready_.push_back(std::move(mailbox));
+    }
+    cv_.notify_one();
+}
+
+void ObserverDispatcher::workerLoop()
+{
+    while (true) {
+        MailboxPtr mailbox;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !ready_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            mailbox = std::move(ready_.front());
+            ready_.pop_front();
+        }
+        drain(mailbox);
+    }
+}
+
+void ObserverDispatcher::drain(const MailboxPtr& mailbox)
+{
+    for (std::size_t delivered = 0;; ++delivered) {
+        FramePtr frame;
+        {
+            std::lock_guard lock(mailbox->mutex);
+            if (mailbox->closed || mailbox->count == 0) {
+                mailbox->scheduled = false;
+                return;
+            }
+            if (delivered == kMaxBatch) {
+                break; // still scheduled; requeue behind other observers
+            }
+            frame = std::move(mailbox->ring[mailbox->head]);
+            mailbox->head = (mailbox->head + 1) % mailbox->ring.size();
+            --mailbox->count;
+        }
+        try {
+            mailbox->callback(*frame);
+        } catch (const std::exception& ex) {
+            spdlog::error("ObserverDispatcher: observer threw: {}", ex.what());
+        }
+    }
+    schedule(mailbox);
+}
+
+} // namespace core
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+
+enum class ObserverDelivery {
+    // Called on the publisher's thread before update() returns.
+    Inline,
+    // Queued to a bounded per-observer mailbox and called on a dispatch worker.
+    Queued
+};
+
+enum class BackpressurePolicy {
+    // Keep the newest `queueCapacity` frames; older undelivered frames are dropped.
+    DropOldest,
+    // Keep only the newest undelivered frame.
+    ConflateLatest
+};
+
+struct ObserverOptions {
+    ObserverDelivery delivery{ObserverDelivery::Inline};
+    BackpressurePolicy policy{BackpressurePolicy::ConflateLatest};
+    std::size_t queueCapacity{16};
+};
+
+/**
+ * @brief Worker pool that delivers frames to queued observers.
+ *
+ * Each queued observer owns a fixed-size mailbox. Posting never blocks on the
+ * consumer: a full mailbox applies its backpressure policy instead. A mailbox is
+ * drained by one worker at a time, so an observer sees its frames in order and is
+ * never called concurrently with itself.
+ */
+class ObserverDispatcher {
+public:
+    using FramePtr = std::shared_ptr<const DataFrame>;
+    using Callback = std::function<void(const DataFrame&)>;
+
+    struct Mailbox;
+    using MailboxPtr = std::shared_ptr<Mailbox>;
+
+    static constexpr std::size_t kDefaultWorkers = 2;
+
+    explicit ObserverDispatcher(std::size_t workers = kDefaultWorkers);
+    ~ObserverDispatcher();
+
+    ObserverDispatcher(const ObserverDispatcher&) = delete;
+    ObserverDispatcher& operator=(const ObserverDispatcher&) = delete;
+
+    // Workers start with the first mailbox.
+    MailboxPtr createMailbox(Callback callback, const ObserverOptions& options);
+    void post(const MailboxPtr& mailbox, FramePtr frame);
+    // Drops pending frames; a callback that is already running finishes first.
+    void close(const MailboxPtr& mailbox);
+    void stop();
+
+    [[nodiscard]] std::uint64_t droppedFrames() const { return droppedFrames_.load(std::memory_order_relaxed); }
+
+private:
+    // Frames delivered per turn before a busy mailbox yields its worker to others.
+    static constexpr std::size_t kMaxBatch = 16;
+
+    void ensureWorkersLocked();
+    void workerLoop();
+    void drain(const MailboxPtr& mailbox);
+    void schedule(MailboxPtr mailbox);
+
+    std::size_t workerCount_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<MailboxPtr> ready_;
+    std::vector<std::thread> workers_;
+    bool stopping_{false};
+    std::atomic<std::uint64_t> droppedFrames_{0};
+};
+
+}  // namespace core
@@ -3,10 +3,53 @@
 #include "DataRegistry.h"
 #include <spdlog/spdlog.h>
 
+#include <exception>
+#include <thread>
 #include <utility>
 
 namespace core {
 
+namespace {
+
+// A thread costs about 20 us to start and join, which a trivial hook never wins back;
+// below this many modules the hooks just run in order.
+constexpr std::size_t kMinConcurrentModules = 4;
+
+// Runs `hook` for every module at once, one thread each, and waits for all of them.
+// The first exception a hook throws is rethrown here once the others are done.
+template <typename Hook>
+void ForEachConcurrently(std::vector<ModulePtr>& modules, Hook hook)
+{
+    if (modules.size() < kMinConcurrentModules) {
+        for (auto& module : modules) {
+            hook(*module);
+        }
+        return;
+    }
+    std::vector<std::exception_ptr> errors(modules.size());
+    std::vector<std::thread> threads;
+    threads.reserve(modules.size());
+    for (std::size_t i = 0; i < modules.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            try {
+                hook(*modules[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+} // namespace
+
 PluginManager::PluginManager(ModuleContext& context)
     : context_(context)
 {
@@ -23,9 +66,14 @@ void PluginManager::registerModule(ModulePtr module)
         return;
     }
 
+    std::lock_guard lock(mutex_);
     const std::string moduleId = module->id();
+    if (!moduleSources_.try_emplace(moduleId).second) {
+        // Sources and removal are tracked by id, so a second module under it would be unreachable.
+        spdlog::warn("Ignoring module '{}': a module with that id is already registered", moduleId);
+        return;
+    }
     auto* modulePtr = module.get();
-    moduleSources_.try_emplace(moduleId);
     modules_.push_back(std::move(module));
 
     spdlog::debug("Registered module '{}'", modulePtr->id());
@@ -40,14 +88,18 @@ void PluginManager::registerModule(ModulePtr module)
         }
         modulePtr->initialize(context_);
     }
+    ++revision_;
 }
 
 void PluginManager::initializeModules()
 {
+    std::lock_guard lock(mutex_);
     if (initialized_) {
         return;
     }
 
+    // Every module's sources are registered before any module initializes. Declaring
+    // only lists metadata, so it stays on this thread; initialize() may block on I/O.
     for (auto& module : modules_) {
         auto& ids = moduleSources_[module->id()];
         ids.clear();
@@ -56,17 +108,18 @@ void PluginManager::initializeModules()
             context_.dataRegistry.registerSource(std::move(meta));
         }
     }
-
-    for (auto& module : modules_) {
-        module->initialize(context_);
-        spdlog::info("Initialized module '{}'", module->id());
-    }
+    ForEachConcurrently(modules_, [this](Module& module) {
+        module.initialize(context_);
+        spdlog::info("Initialized module '{}'", module.id());
+    });
 
     initialized_ = true;
+    ++revision_;
 }
 
 void PluginManager::shutdownModules()
 {
+    std::lock_guard lock(mutex_);
     if (!initialized_) {
         return;
     }
@@ -84,10 +137,12 @@ void PluginManager::shutdownModules()
     }
 
     initialized_ = false;
+    ++revision_;
 }
 
 void PluginManager::tickModules(std::chrono::milliseconds delta)
 {
+    std::lock_guard lock(mutex_);
     if (!initialized_) {
         return;
     }
@@ -97,9 +152,38 @@ void PluginManager::tickModules(std::chrono::milliseconds delta)
     }
 }
 
-const std::vector<ModulePtr>& PluginManager::modules() const
+bool PluginManager::tickModule(std::size_t index, std::chrono::milliseconds delta)
+{
+    std::lock_guard lock(mutex_);
+    if (!initialized_ || index >= modules_.size()) {
+        return false;
+    }
+
+    modules_[index]->tick(context_, delta);
+    return true;
+}
+
+std::vector<Module*> PluginManager::modules() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<Module*> snapshot;
+    snapshot.reserve(modules_.size());
+    for (const auto& module : modules_) {
+        snapshot.push_back(module.get());
+    }
+    return snapshot;
+}
+
+bool PluginManager::initialized() const
+{
+    std::lock_guard lock(mutex_);
+    return initialized_;
+}
+
+std::uint64_t PluginManager::revision() const
 {
-    return modules_;
+    std::lock_guard lock(mutex_);
+    return revision_;
 }
 
 } // namespace core
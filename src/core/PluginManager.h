@@ -3,12 +3,28 @@
 #include "Module.h"
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace core {
 
+/**
+ * @brief Owns module instances and drives their lifecycle hooks.
+ *
+ * Every member is thread-safe: the UI thread registers and shuts modules down
+ * while the module scheduler ticks them. Hooks run under the manager's lock, so
+ * shutdown waits for an in-flight tick and a module is never ticked after it has
+ * shut down. Modules must not call back into the manager from their hooks.
+ *
+ * `initializeModules()` runs the modules' `declareSources()` hooks concurrently,
+ * then their `initialize()` hooks, one thread per module, so a slow module does
+ * not hold up the rest; those two hooks must not touch other modules' state.
+ * Shutdown stays sequential, in reverse registration order.
+ */
 class PluginManager {
 public:
     explicit PluginManager(ModuleContext& context);
@@ -19,14 +35,24 @@ public:
     void initializeModules();
     void shutdownModules();
     void tickModules(std::chrono::milliseconds delta);
+    // Ticks the module at `index` in modules() order (modules are never reordered);
+    // returns false when there is no such module or modules are not initialized.
+    bool tickModule(std::size_t index, std::chrono::milliseconds delta);
 
-    [[nodiscard]] const std::vector<ModulePtr>& modules() const;
+    // Snapshot of the registered modules, in registration order. The pointers stay
+    // valid for the manager's lifetime.
+    [[nodiscard]] std::vector<Module*> modules() const;
+    [[nodiscard]] bool initialized() const;
+    // Bumped whenever the module list or its initialized state changes.
+    [[nodiscard]] std::uint64_t revision() const;
 
 private:
+    mutable std::mutex mutex_;
     ModuleContext& context_;
     std::vector<ModulePtr> modules_;
     std::unordered_map<std::string, std::vector<std::string>> moduleSources_;
     bool initialized_{false};
+    std::uint64_t revision_{0};
 };
 
 }  // namespace core
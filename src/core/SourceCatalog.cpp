@@ -0,0 +1,172 @@
+#include "SourceCatalog.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+namespace core {
+
+namespace {
+
+std::size_t KindIndex(DataKind kind)
+{
+    return static_cast<std::size_t>(kind);
+}
+
+} // namespace
+
+bool SourceQuery::matches(const SourceMetadata& metadata) const
+{
+    if (!kinds.empty() && std::find(kinds.begin(), kinds.end(), metadata.kind) == kinds.end()) {
+        return false;
+    }
+    return std::string_view(metadata.id).starts_with(idPrefix);
+}
+
+bool SourceCatalog::upsert(SourceMetadata metadata)
+{
+    std::lock_guard writeLock(writeMutex_);
+    auto entry = std::make_shared<const SourceMetadata>(std::move(metadata));
+    SourceEventType type = SourceEventType::Added;
+    std::uint64_t version = 0;
+    {
+        std::unique_lock lock(mutex_);
+        auto it = byId_.find(entry->id);
+        if (it != byId_.end()) {
+            if (*it->second == *entry) {
+                return false;
+            }
+            type = SourceEventType::Updated;
+            byKind_[KindIndex(it->second->kind)].erase(entry->id);
+            it->second = entry;
+        } else {
+            byId_.emplace(entry->id, entry);
+        }
+        byKind_[KindIndex(entry->kind)].insert_or_assign(entry->id, entry);
+        version = version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+    notify(type, std::move(entry), version);
+    return true;
+}
+
+bool SourceCatalog::remove(const std::string& sourceId)
+{
+    std::lock_guard writeLock(writeMutex_);
+    Entry removed;
+    std::uint64_t version = 0;
+    {
+        std::unique_lock lock(mutex_);
+        auto it = byId_.find(sourceId);
+        if (it == byId_.end()) {
+            return false;
+        }
+        removed = std::move(it->second);
+        byId_.erase(it);
+        byKind_[KindIndex(removed->kind)].erase(sourceId);
+        version = version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+    notify(SourceEventType::Removed, std::move(removed), version);
+    return true;
+}
+
+SourceCatalog::Entry SourceCatalog::find(const std::string& sourceId) const
+{
+    std::shared_lock lock(mutex_);
+    if (auto it = byId_.find(sourceId); it != byId_.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+bool SourceCatalog::contains(const std::string& sourceId) const
+{
+    std::shared_lock lock(mutex_);
+    return byId_.find(sourceId) != byId_.end();
+}
+
+template <typename Visitor>
+void SourceCatalog::visit(const SourceQuery& query, Visitor&& visitor) const
+{
+    // One kind has its own index; several are filtered out of the id index.
+    const Index& index = query.kinds.size() == 1 ? byKind_[KindIndex(query.kinds.front())] : byId_;
+    for (auto it = index.lower_bound(query.idPrefix); it != index.end(); ++it) {
+        if (!std::string_view(it->first).starts_with(query.idPrefix)) {
+            break;
+        }
+        if (query.kinds.size() > 1 && !query.matches(*it->second)) {
+            continue;
+        }
+        if (!visitor(it->second)) {
+            break;
+        }
+    }
+}
+
+std::vector<SourceCatalog::Entry> SourceCatalog::query(const SourceQuery& query) const
+{
+    std::vector<Entry> result;
+    std::size_t skip = query.offset;
+    std::shared_lock lock(mutex_);
+    visit(query, [&](const Entry& entry) {
+        if (skip > 0) {
+            --skip;
+            return true;
+        }
+        result.push_back(entry);
+        return query.limit == 0 || result.size() < query.limit;
+    });
+    return result;
+}
+
+std::size_t SourceCatalog::count(const SourceQuery& query) const
+{
+    std::shared_lock lock(mutex_);
+    if (query.idPrefix.empty() && query.kinds.size() <= 1) {
+        return query.kinds.empty() ? byId_.size() : byKind_[KindIndex(query.kinds.front())].size();
+    }
+    std::size_t matching = 0;
+    visit(query, [&](const Entry&) {
+        ++matching;
+        return true;
+    });
+    return matching;
+}
+
+std::size_t SourceCatalog::size() const
+{
+    std::shared_lock lock(mutex_);
+    return byId_.size();
+}
+
+int SourceCatalog::addObserver(Observer observer)
+{
+    std::lock_guard lock(observerMutex_);
+    const int id = nextObserverId_++;
+    auto next = std::make_shared<ObserverList>(*observers_.load(std::memory_order_acquire));
+    next->push_back(ObserverEntry { id, std::move(observer) });
+    observers_.store(std::move(next), std::memory_order_release);
+    return id;
+}
+
+void SourceCatalog::removeObserver(int token)
+{
+    std::lock_guard lock(observerMutex_);
+    auto next = std::make_shared<ObserverList>(*observers_.load(std::memory_order_acquire));
+    std::erase_if(*next, [token](const ObserverEntry& entry) { return entry.id == token; });
+    observers_.store(std::move(next), std::memory_order_release);
+}
+
+void SourceCatalog::notify(SourceEventType type, Entry source, std::uint64_t version)
+{
+    // A snapshot: observers can add or remove observers (but not sources) meanwhile.
+    const auto observers = observers_.load(std::memory_order_acquire);
+    if (observers->empty()) {
+        return;
+    }
+    const SourceEvent event { type, std::move(source), version };
+    for (const auto& observer : *observers) {
+        observer.callback(event);
+    }
+}
+
+} // namespace core
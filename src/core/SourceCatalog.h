@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace core {
+
+// Selects catalog entries. Results are ordered by source id, so `offset` and
+// `limit` page through a stable list.
+struct SourceQuery {
+    // Empty matches every kind.
+    std::vector<DataKind> kinds;
+    // Matches ids starting with this, e.g. a relay's "scope:" namespace.
+    std::string idPrefix;
+    std::size_t offset{0};
+    // 0 returns everything after `offset`.
+    std::size_t limit{0};
+
+    [[nodiscard]] bool matches(const SourceMetadata& metadata) const;
+};
+
+enum class SourceEventType {
+    Added,
+    Updated,
+    Removed
+};
+
+struct SourceEvent {
+    SourceEventType type{SourceEventType::Added};
+    // The new metadata, or for Removed the last one registered.
+    std::shared_ptr<const SourceMetadata> source;
+    // Catalog version after the change.
+    std::uint64_t version{0};
+};
+
+/**
+ * @brief Indexed, versioned set of source descriptions.
+ *
+ * Entries are immutable and shared, so queries hand out pointers instead of
+ * copying strings. A sorted id index serves prefix ranges and a per-kind index
+ * serves kind filters without scanning other kinds. Every change bumps
+ * `version()` and is reported to observers, in order, on the thread that made it;
+ * observers must not modify the catalog. Re-registering identical metadata is
+ * not a change.
+ */
+class SourceCatalog {
+public:
+    using Entry = std::shared_ptr<const SourceMetadata>;
+    using Observer = std::function<void(const SourceEvent&)>;
+
+    // Adds or replaces; false when the catalog already held exactly this.
+    bool upsert(SourceMetadata metadata);
+    bool remove(const std::string& sourceId);
+
+    [[nodiscard]] Entry find(const std::string& sourceId) const;
+    [[nodiscard]] bool contains(const std::string& sourceId) const;
+    [[nodiscard]] std::vector<Entry> query(const SourceQuery& query = {}) const;
+    // Matching entries, ignoring `offset` and `limit`.
+    [[nodiscard]] std::size_t count(const SourceQuery& query = {}) const;
+    [[nodiscard]] std::size_t size() const;
+    // Lock-free; compare against a remembered value to see whether anything changed.
+    [[nodiscard]] std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // Observers removed while a change is being reported may still see that change.
+    int addObserver(Observer observer);
+    void removeObserver(int token);
+
+private:
+    struct ObserverEntry {
+        int id;
+        Observer callback;
+    };
+    using ObserverList = std::vector<ObserverEntry>;
+    using Index = std::map<std::string, Entry, std::less<>>;
+
+    static constexpr std::size_t kKindCount = static_cast<std::size_t>(DataKind::Custom) + 1;
+
+    // Walks the entries matching `query` in id order until `visitor` returns false.
+    template <typename Visitor>
+    void visit(const SourceQuery& query, Visitor&& visitor) const;
+    void notify(SourceEventType type, Entry source, std::uint64_t version);
+
+    // Serialises changes and their notifications, so observers see them in order.
+    std::mutex writeMutex_;
+    mutable std::shared_mutex mutex_;
+    Index byId_;
+    std::array<Index, kKindCount> byKind_;
+    std::atomic<std::uint64_t> version_{0};
+
+    std::mutex observerMutex_;
+    std::atomic<std::shared_ptr<const ObserverList>> observers_{std::make_shared<const ObserverList>()};
+    int nextObserverId_{1};
+};
+
+}  // namespace core
@@ -0,0 +1,309 @@
+#include "Statistics.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace core {
+
+namespace {
+
+struct SumMinMax {
+    double sum{0.0};
+    double min{0.0};
+    double max{0.0};
+};
+
+SumMinMax FirstPass(const double* data, std::size_t count)
+{
+    SumMinMax result { 0.0, data[0], data[0] };
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    if (count >= 4) {
+        __m256d sum = _mm256_setzero_pd();
+        __m256d mn = _mm256_loadu_pd(data);
+        __m256d mx = mn;
+        for (; i + 4 <= count; i += 4) {
+            const __m256d v = _mm256_loadu_pd(data + i);
+            sum = _mm256_add_pd(sum, v);
+            mn = _mm256_min_pd(mn, v);
+            mx = _mm256_max_pd(mx, v);
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, sum);
+        result.sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm256_store_pd(lanes, mn);
+        result.min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm256_store_pd(lanes, mx);
+        result.max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (count >= 2) {
+        float64x2_t sum = vdupq_n_f64(0.0);
+        float64x2_t mn = vld1q_f64(data);
+        float64x2_t mx = mn;
+        for (; i + 2 <= count; i += 2) {
+            const float64x2_t v = vld1q_f64(data + i);
+            sum = vaddq_f64(sum, v);
+            mn = vminq_f64(mn, v);
+            mx = vmaxq_f64(mx, v);
+        }
+        result.sum = vaddvq_f64(sum);
+        result.min = vminvq_f64(mn);
+        result.max = vmaxvq_f64(mx);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        result.sum += data[i];
+        result.min = std::min(result.min, data[i]);
+        result.max = std::max(result.max, data[i]);
+    }
+    return result;
+}
+
+double SquaredDeviations(const double* data, std::size_t count, double mean)
+{
+    double total = 0.0;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    if (count >= 4) {
+        const __m256d centre = _mm256_set1_pd(mean);
+        __m256d acc = _mm256_setzero_pd();
+        for (; i + 4 <= count; i += 4) {
+            const __m256d d = _mm256_sub_pd(_mm256_loadu_pd(data + i), centre);
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(d, d));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (count >= 2) {
+        const float64x2_t centre = vdupq_n_f64(mean);
+        float64x2_t acc = vdupq_n_f64(0.0);
+        for (; i + 2 <= count; i += 2) {
+            const float64x2_t d = vsubq_f64(vld1q_f64(data + i), centre);
+            acc = vfmaq_f64(acc, d, d);
+        }
+        total = vaddvq_f64(acc);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const double d = data[i] - mean;
+        total += d * d;
+    }
+    return total;
+}
+
+} // namespace
+
+BlockStats ComputeBlockStats(std::span<const double> values)
+{
+    BlockStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+    const auto first = FirstPass(values.data(), values.size());
+    stats.count = values.size();
+    stats.mean = first.sum / static_cast<double>(stats.count);
+    stats.min = first.min;
+    stats.max = first.max;
+    // Deviations from the block mean keep the variance stable for offset signals.
+    stats.m2 = SquaredDeviations(values.data(), values.size(), stats.mean);
+    return stats;
+}
+
+void RunningStats::push(double value)
+{
+    if (stats_.count == 0) {
+        stats_.min = value;
+        stats_.max = value;
+    } else {
+        stats_.min = std::min(stats_.min, value);
+        stats_.max = std::max(stats_.max, value);
+    }
+    ++stats_.count;
+    const double delta = value - stats_.mean;
+    stats_.mean += delta / static_cast<double>(stats_.count);
+    stats_.m2 += delta * (value - stats_.mean);
+}
+
+void RunningStats::merge(const BlockStats& block)
+{
+    if (block.empty()) {
+        return;
+    }
+    if (stats_.count == 0) {
+        stats_ = block;
+        return;
+    }
+    const double countA = static_cast<double>(stats_.count);
+    const double countB = static_cast<double>(block.count);
+    const double total = countA + countB;
+    const double delta = block.mean - stats_.mean;
+    stats_.mean += delta * countB / total;
+    stats_.m2 += block.m2 + delta * delta * countA * countB / total;
+    stats_.count += block.count;
+    stats_.min = std::min(stats_.min, block.min);
+    stats_.max = std::max(stats_.max, block.max);
+}
+
+RollingStats::Ring::Ring(std::size_t capacity)
+    : entries_(std::max<std::size_t>(capacity, 1))
+{
+}
+
+void RollingStats::Ring::pushBack(const Entry& entry)
+{
+    entries_[(head_ + size_) % entries_.size()] = entry;
+    ++size_;
+}
+
+void RollingStats::Ring::popFront()
+{
+    head_ = (head_ + 1) % entries_.size();
+    --size_;
+}
+
+void RollingStats::Ring::clear()
+{
+    head_ = 0;
+    size_ = 0;
+}
+
+RollingStats::RollingStats(std::size_t window)
+    : window_(window)
+    , values_(window)
+    , mins_(window)
+    , maxs_(window)
+{
+}
+
+void RollingStats::push(double value)
+{
+    if (window_ == 0) {
+        return;
+    }
+    const std::uint64_t index = next_++;
+    auto& slot = values_[index % window_];
+    if (index >= window_) {
+        sum_ -= slot;
+        sumSquares_ -= slot * slot;
+    }
+    slot = value;
+    if (next_ % window_ == 0) {
+        // The ring holds exactly the window now; start the sums afresh from it.
+        sum_ = 0.0;
+        sumSquares_ = 0.0;
+        for (double v : values_) {
+            sum_ += v;
+            sumSquares_ += v * v;
+        }
+    } else {
+        sum_ += value;
+        sumSquares_ += value * value;
+    }
+    // Expire entries that slid out of the window.
+    if (mins_.size() > 0 && mins_.front().index + window_ <= index) {
+        mins_.popFront();
+    }
+    if (maxs_.size() > 0 && maxs_.front().index + window_ <= index) {
+        maxs_.popFront();
+    }
+    // Entries dominated by the new value can never be the answer again.
+    while (mins_.size() > 0 && mins_.back().value >= value) {
+        mins_.popBack();
+    }
+    while (maxs_.size() > 0 && maxs_.back().value <= value) {
+        maxs_.popBack();
+    }
+    mins_.pushBack({ index, value });
+    maxs_.pushBack({ index, value });
+}
+
+void RollingStats::clear()
+{
+    next_ = 0;
+    sum_ = 0.0;
+    sumSquares_ = 0.0;
+    mins_.clear();
+    maxs_.clear();
+}
+
+ChannelStatistics::ChannelStatistics(std::size_t rollingWindow)
+    : rolling_(rollingWindow)
+{
+}
+
+void ChannelStatistics::addSample(double value)
+{
+    current_ = value;
+    hasCurrent_ = true;
+    extend(value, value);
+    running_.push(value);
+    rolling_.push(value);
+}
+
+void ChannelStatistics::addBlock(std::span<const double> values)
+{
+    if (values.empty()) {
+        return;
+    }
+    lastBlock_ = ComputeBlockStats(values);
+    current_ = values.back();
+    hasCurrent_ = true;
+    extend(lastBlock_.min, lastBlock_.max);
+    running_.merge(lastBlock_);
+    // Only the tail can still be inside the rolling window.
+    const std::size_t tail = std::min(values.size(), rolling_.window());
+    for (double value : values.last(tail)) {
+        rolling_.push(value);
+    }
+}
+
+void ChannelStatistics::resetMin()
+{
+    hasMin_ = hasCurrent_;
+    if (hasCurrent_) {
+        min_ = current_;
+    }
+}
+
+void ChannelStatistics::resetMax()
+{
+    hasMax_ = hasCurrent_;
+    if (hasCurrent_) {
+        max_ = current_;
+    }
+}
+
+void ChannelStatistics::reset()
+{
+    resetMin();
+    resetMax();
+    running_.reset();
+    lastBlock_ = {};
+    rolling_.clear();
+}
+
+void ChannelStatistics::extend(double low, double high)
+{
+    if (!hasMin_ || low < min_) {
+        min_ = low;
+        hasMin_ = true;
+    }
+    if (!hasMax_ || high > max_) {
+        max_ = high;
+        hasMax_ = true;
+    }
+}
+
+} // namespace core
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace core {
+
+// Summary of one block of samples (e.g. a waveform frame).
+struct BlockStats {
+    std::size_t count{0};
+    double mean{0.0};
+    // Sum of squared deviations from the mean.
+    double m2{0.0};
+    double min{0.0};
+    double max{0.0};
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] double variance() const { return count > 0 ? m2 / static_cast<double>(count) : 0.0; }
+    [[nodiscard]] double stddev() const { return std::sqrt(variance()); }
+    [[nodiscard]] double rms() const { return std::sqrt(variance() + mean * mean); }
+    [[nodiscard]] double peakToPeak() const { return max - min; }
+};
+
+// Two-pass (sum/min/max, then squared deviations) block kernel, vectorised with
+// AVX2 or AArch64 NEON when the build targets them.
+BlockStats ComputeBlockStats(std::span<const double> values);
+
+/**
+ * @brief Welford accumulator over every sample since the last reset.
+ *
+ * Single samples use Welford's update; whole blocks are folded in with Chan's
+ * parallel combination, so block and sample inputs can be mixed freely.
+ */
+class RunningStats {
+public:
+    void push(double value);
+    void merge(const BlockStats& block);
+    void reset() { stats_ = {}; }
+
+    [[nodiscard]] const BlockStats& stats() const { return stats_; }
+
+private:
+    BlockStats stats_;
+};
+
+/**
+ * @brief Min, max, mean and RMS over the last `window` samples, O(1) amortised per push.
+ *
+ * Min/max come from monotonic deques and mean/RMS from running sums over a ring of
+ * the window's values, all in fixed storage so pushing never allocates. The sums are
+ * recomputed from the ring once per window to keep rounding from accumulating. A
+ * window of 0 tracks nothing.
+ */
+class RollingStats {
+public:
+    explicit RollingStats(std::size_t window);
+
+    void push(double value);
+    void clear();
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    // Samples currently inside the window.
+    [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(std::min<std::uint64_t>(next_, window_)); }
+    [[nodiscard]] double min() const { return mins_.front().value; }
+    [[nodiscard]] double max() const { return maxs_.front().value; }
+    [[nodiscard]] double mean() const { return sum_ / static_cast<double>(size()); }
+    [[nodiscard]] double rms() const { return std::sqrt(std::max(sumSquares_ / static_cast<double>(size()), 0.0)); }
+    [[nodiscard]] double stddev() const { return std::sqrt(std::max(sumSquares_ / static_cast<double>(size()) - mean() * mean(), 0.0)); }
+    [[nodiscard]] double peakToPeak() const { return max() - min(); }
+    [[nodiscard]] std::size_t window() const { return window_; }
+
+private:
+    struct Entry {
+        std::uint64_t index{0};
+        double value{0.0};
+    };
+
+    // Fixed-capacity double-ended ring.
+    class Ring {
+    public:
+        explicit Ring(std::size_t capacity);
+
+        void pushBack(const Entry& entry);
+        void popBack() { --size_; }
+        void popFront();
+        void clear();
+
+        [[nodiscard]] std::size_t size() const { return size_; }
+        [[nodiscard]] const Entry& front() const { return entries_[head_]; }
+        [[nodiscard]] const Entry& back() const { return entries_[(head_ + size_ - 1) % entries_.size()]; }
+
+    private:
+        std::vector<Entry> entries_;
+        std::size_t head_{0};
+        std::size_t size_{0};
+    };
+
+    std::size_t window_;
+    std::uint64_t next_{0};
+    // Sample i lives at values_[i % window_] while it is inside the window.
+    std::vector<double> values_;
+    double sum_{0.0};
+    double sumSquares_{0.0};
+    Ring mins_;
+    Ring maxs_;
+};
+
+/**
+ * @brief Everything the data windows show for one channel.
+ *
+ * `min()`/`max()` follow the relay's `workbench.resetMetric` semantics: resetting
+ * one restarts it from the current value without touching the other. Running
+ * statistics cover every sample since `reset()`, `lastBlock()` describes the most
+ * recent waveform frame, and `rolling()` gives min, max, mean and RMS over the last
+ * `rollingWindow` samples. Consumers that only show the extremes pass a window of 0
+ * and skip the per-sample rolling update.
+ */
+class ChannelStatistics {
+public:
+    static constexpr std::size_t kDefaultRollingWindow = 1024;
+
+    explicit ChannelStatistics(std::size_t rollingWindow = kDefaultRollingWindow);
+
+    void addSample(double value);
+    void addBlock(std::span<const double> values);
+
+    void resetMin();
+    void resetMax();
+    void reset();
+
+    [[nodiscard]] bool hasCurrent() const { return hasCurrent_; }
+    [[nodiscard]] bool hasMin() const { return hasMin_; }
+    [[nodiscard]] bool hasMax() const { return hasMax_; }
+    [[nodiscard]] double current() const { return current_; }
+    [[nodiscard]] double min() const { return min_; }
+    [[nodiscard]] double max() const { return max_; }
+
+    [[nodiscard]] const BlockStats& running() const { return running_.stats(); }
+    [[nodiscard]] const BlockStats& lastBlock() const { return lastBlock_; }
+    [[nodiscard]] const RollingStats& rolling() const { return rolling_; }
+
+private:
+    void extend(double low, double high);
+
+    double current_{0.0};
+    double min_{0.0};
+    double max_{0.0};
+    bool hasCurrent_{false};
+    bool hasMin_{false};
+    bool hasMax_{false};
+
+    RunningStats running_;
+    BlockStats lastBlock_;
+    RollingStats rolling_;
+};
+
+}  // namespace core
@@ -0,0 +1,66 @@
+#include "SymbolTable.h"
+#include <spdlog/spdlog.h>
+
+namespace core {
+
+SymbolTable::SymbolTable()
+{
+    intern({});
+}
+
+SymbolTable::~SymbolTable()
+{
+    for (auto& chunk : chunks_) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+Symbol SymbolTable::intern(std::string_view text)
+{
+    Symbol existing = kEmptySymbol;
+    if (find(text, existing)) {
+        return existing;
+    }
+
+    std::unique_lock lock(mutex_);
+    if (auto it = index_.find(text); it != index_.end()) {
+        return it->second;
+    }
+    const std::size_t next = size_.load(std::memory_order_relaxed);
+    const std::size_t chunkIndex = next / kChunkSize;
+    if (chunkIndex >= kMaxChunks) {
+        spdlog::warn("SymbolTable: table full, '{}' maps to the empty symbol", text);
+        return kEmptySymbol;
+    }
+    std::string* chunk = chunks_[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new std::string[kChunkSize];
+        chunks_[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    chunk[next % kChunkSize].assign(text);
+    const auto symbol = static_cast<Symbol>(next);
+    index_.emplace(std::string(text), symbol);
+    // Publishing the new size makes the name visible to lock-free readers.
+    size_.store(next + 1, std::memory_order_release);
+    return symbol;
+}
+
+bool SymbolTable::find(std::string_view text, Symbol& out) const
+{
+    std::shared_lock lock(mutex_);
+    if (auto it = index_.find(text); it != index_.end()) {
+        out = it->second;
+        return true;
+    }
+    return false;
+}
+
+const std::string& SymbolTable::name(Symbol symbol) const
+{
+    if (symbol >= size_.load(std::memory_order_acquire)) {
+        symbol = kEmptySymbol;
+    }
+    return chunks_[symbol / kChunkSize].load(std::memory_order_acquire)[symbol % kChunkSize];
+}
+
+} // namespace core
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace core {
+
+// Interned channel/unit identifier. 0 is always the empty string.
+using Symbol = std::uint32_t;
+constexpr Symbol kEmptySymbol = 0;
+
+/**
+ * @brief Append-only string interning table.
+ *
+ * `intern()` takes a lock only to look up or add a string; `name()` is lock-free
+ * and returns a reference that stays valid for the table's lifetime, so hot
+ * paths can carry 4-byte symbols instead of owning `std::string`s.
+ */
+class SymbolTable {
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view text);
+    // Returns false (and leaves `out` alone) when `text` was never interned.
+    bool find(std::string_view text, Symbol& out) const;
+    // Unknown symbols resolve to the empty string.
+    [[nodiscard]] const std::string& name(Symbol symbol) const;
+    [[nodiscard]] std::size_t size() const { return size_.load(std::memory_order_acquire); }
+
+    static constexpr std::size_t kChunkSize = 1024;
+    static constexpr std::size_t kMaxChunks = 1024;
+
+private:
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    // Fixed chunk directory so published names never move and readers need no lock.
+    std::array<std::atomic<std::string*>, kMaxChunks> chunks_{};
+    std::atomic<std::size_t> size_{0};
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Symbol, Hash, std::equal_to<>> index_;
+};
+
+}  // namespace core
@@ -0,0 +1,641 @@
+#include "TriggerEngine.h"
+
+#include "DataRegistry.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
+namespace core {
+
+namespace {
+
+// Checking one frame against the triggers on its channels, on the publishing thread.
+const metrics::Histogram kCheckTime { "trigger.check" };
+// From the sample being checked to the worker handling the firing.
+const metrics::Histogram kLatency { "trigger.latency" };
+const metrics::Counter kFired { "trigger.fired" };
+// Firings lost because the worker fell kEventQueueCapacity behind.
+const metrics::Counter kDropped { "trigger.dropped" };
+
+// A TriggerSpec reduced to what the per-sample step needs, plus its state.
+struct Detector {
+    TriggerCondition condition{TriggerCondition::Rising};
+    double level{0.0};
+    // Where the detector arms again: `level` moved back by the hysteresis.
+    double rearm{0.0};
+    std::uint64_t mask{0};
+    std::uint64_t pattern{0};
+    std::int64_t holdoffNs{0};
+
+    bool armed{false};
+    bool hasPrevious{false};
+    double previous{0.0};
+    std::int64_t previousNs{0};
+    std::int64_t quietUntilNs{std::numeric_limits<std::int64_t>::min()};
+};
+
+Detector CompileDetector(const TriggerSpec& spec)
+{
+    Detector detector;
+    detector.condition = spec.condition;
+    detector.level = spec.level;
+    detector.mask = spec.mask;
+    detector.pattern = spec.pattern;
+    detector.holdoffNs = spec.holdoff.count();
+    switch (spec.condition) {
+    case TriggerCondition::Rising:
+    case TriggerCondition::Above:
+    case TriggerCondition::RateAbove:
+        detector.rearm = spec.level - spec.hysteresis;
+        break;
+    case TriggerCondition::Falling:
+    case TriggerCondition::Below:
+        detector.rearm = spec.level + spec.hysteresis;
+        break;
+    case TriggerCondition::Pattern:
+        break;
+    }
+    // Crossings need to see the far side first; alarms fire on a value already past.
+    detector.armed = spec.condition == TriggerCondition::Above || spec.condition == TriggerCondition::Below
+        || spec.condition == TriggerCondition::RateAbove;
+    return detector;
+}
+
+template <TriggerCondition C>
+bool Step(Detector& d, double value)
+{
+    if constexpr (C == TriggerCondition::Rising || C == TriggerCondition::Above) {
+        if (C == TriggerCondition::Rising ? value < d.rearm : value <= d.rearm) {
+            d.armed = true;
+            return false;
+        }
+        if (d.armed && (C == TriggerCondition::Rising ? value >= d.level : value > d.level)) {
+            d.armed = false;
+            return true;
+        }
+        return false;
+    } else {
+        if (C == TriggerCondition::Falling ? value > d.rearm : value >= d.rearm) {
+            d.armed = true;
+            return false;
+        }
+        if (d.armed && (C == TriggerCondition::Falling ? value <= d.level : value < d.level)) {
+            d.armed = false;
+            return true;
+        }
+        return false;
+    }
+}
+
+// Applies the holdoff; true when a detection at `ns` really fires.
+bool Fires(Detector& d, std::int64_t ns)
+{
+    if (d.holdoffNs == 0) {
+        return true;
+    }
+    if (ns < d.quietUntilNs) {
+        return false;
+    }
+    d.quietUntilNs = ns + d.holdoffNs;
+    return true;
+}
+
+template <TriggerCondition C, typename Emit>
+void ScanLevels(Detector& d, std::span<const double> values, std::int64_t startNs, double periodNs, Emit& emit)
+{
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (Step<C>(d, values[i])) {
+            const auto ns = startNs + static_cast<std::int64_t>(static_cast<double>(i) * periodNs);
+            if (Fires(d, ns)) {
+                emit(ns, values[i], i);
+            }
+        }
+    }
+}
+
+template <typename Emit>
+void ScanRate(Detector& d, std::span<const double> values, std::int64_t startNs, double periodNs, Emit& emit)
+{
+    if (periodNs <= 0.0) {
+        return;
+    }
+    const double perSecond = 1e9 / periodNs;
+    std::size_t i = 0;
+    if (!d.hasPrevious && !values.empty()) {
+        d.previous = values.front();
+        d.hasPrevious = true;
+        i = 1;
+    }
+    for (; i < values.size(); ++i) {
+        const double rate = std::fabs(values[i] - d.previous) * perSecond;
+        d.previous = values[i];
+        if (Step<TriggerCondition::Above>(d, rate)) {
+            const auto ns = startNs + static_cast<std::int64_t>(static_cast<double>(i) * periodNs);
+            if (Fires(d, ns)) {
+                emit(ns, rate, i);
+            }
+        }
+    }
+    d.previousNs = startNs + static_cast<std::int64_t>(static_cast<double>(values.size()) * periodNs);
+}
+
+// One block of evenly spaced samples; a numeric point is a block of one.
+template <typename Emit>
+void ScanBlock(Detector& d, std::span<const double> values, std::int64_t startNs, double periodNs, Emit& emit)
+{
+    switch (d.condition) {
+    case TriggerCondition::Rising:
+        ScanLevels<TriggerCondition::Rising>(d, values, startNs, periodNs, emit);
+        break;
+    case TriggerCondition::Falling:
+        ScanLevels<TriggerCondition::Falling>(d, values, startNs, periodNs, emit);
+        break;
+    case TriggerCondition::Above:
+        ScanLevels<TriggerCondition::Above>(d, values, startNs, periodNs, emit);
+        break;
+    case TriggerCondition::Below:
+        ScanLevels<TriggerCondition::Below>(d, values, startNs, periodNs, emit);
+        break;
+    case TriggerCondition::RateAbove:
+        ScanRate(d, values, startNs, periodNs, emit);
+        break;
+    case TriggerCondition::Pattern:
+        break;
+    }
+}
+
+// Slices `stride` words apart; only the first word of each (lines 0-63) is compared.
+template <typename Emit>
+void ScanPattern(Detector& d, const std::uint64_t* words, std::size_t slices, std::size_t stride, std::int64_t startNs, std::int64_t periodNs, Emit& emit)
+{
+    for (std::size_t s = 0; s < slices; ++s) {
+        const std::uint64_t lines = words[s * stride] & d.mask;
+        if (lines != d.pattern) {
+            d.armed = true;
+            continue;
+        }
+        if (!d.armed) {
+            continue;
+        }
+        d.armed = false;
+        const auto ns = startNs + static_cast<std::int64_t>(s) * periodNs;
+        if (Fires(d, ns)) {
+            emit(ns, static_cast<double>(lines), s);
+        }
+    }
+}
+
+std::int64_t Nanos(std::chrono::system_clock::time_point time, std::int64_t fallback)
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return ns != 0 ? ns : fallback;
+}
+
+template <typename Emit>
+void CheckPoint(Detector& d, const DataPoint& point, std::int64_t frameNs, Emit& emit)
+{
+    const bool pattern = d.condition == TriggerCondition::Pattern;
+    if (const auto* numeric = std::get_if<NumericSample>(&point.payload); numeric && !pattern) {
+        const auto ns = Nanos(numeric->timestamp, frameNs);
+        if (d.condition != TriggerCondition::RateAbove) {
+            ScanBlock(d, std::span<const double>(&numeric->value, 1), ns, 0.0, emit);
+            return;
+        }
+        // Irregular samples: the rate is taken over the time since the previous one.
+        if (d.hasPrevious && ns > d.previousNs) {
+            const double rate = std::fabs(numeric->value - d.previous) * 1e9 / static_cast<double>(ns - d.previousNs);
+            if (Step<TriggerCondition::Above>(d, rate) && Fires(d, ns)) {
+                emit(ns, rate, 0);
+            }
+        }
+        d.previous = numeric->value;
+        d.previousNs = ns;
+        d.hasPrevious = true;
+    } else if (const auto* waveform = std::get_if<WaveformSample>(&point.payload); waveform && !pattern) {
+        const double periodNs = waveform->sampleRateHz > 0.0 ? 1e9 / waveform->sampleRateHz : 0.0;
+        ScanBlock(d, waveform->samples, Nanos(waveform->timestamp, frameNs), periodNs, emit);
+    } else if (const auto* logic = std::get_if<LogicSample>(&point.payload); logic && pattern) {
+        ScanPattern(d, logic->words.data(), logic->sliceCount(), logic->wordsPerSlice(), Nanos(logic->timestamp, frameNs), logic->samplePeriod.count(), emit);
+    } else if (const auto* gpio = std::get_if<GpioState>(&point.payload); gpio && pattern && !gpio->pins.words.empty()) {
+        ScanPattern(d, gpio->pins.words.data(), 1, 1, Nanos(gpio->timestamp, frameNs), 0, emit);
+    }
+}
+
+bool ParseNumber(std::string_view token, double& out)
+{
+    const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), out);
+    return ec == std::errc() && end == token.data() + token.size();
+}
+
+const char* ConditionName(TriggerCondition condition)
+{
+    switch (condition) {
+    case TriggerCondition::Rising:
+        return "rises";
+    case TriggerCondition::Falling:
+        return "falls";
+    case TriggerCondition::Above:
+        return "above";
+    case TriggerCondition::Below:
+        return "below";
+    case TriggerCondition::RateAbove:
+        return "rate";
+    case TriggerCondition::Pattern:
+        return "pattern";
+    }
+    return "?";
+}
+
+std::string DescribeCondition(const TriggerSpec& spec)
+{
+    if (spec.condition == TriggerCondition::Pattern) {
+        return fmt::format("pattern {:#x} under mask {:#x}", spec.pattern, spec.mask);
+    }
+    return fmt::format("{} {}", ConditionName(spec.condition), spec.level);
+}
+
+// Drops the newest `count` samples.
+void DropNewest(HistoryWindow& window, std::size_t count)
+{
+    count = std::min(count, window.size());
+    window.values.resize(window.size() - count);
+    window.timestamps.resize(window.values.size());
+    window.endSequence -= count;
+}
+
+} // namespace
+
+bool ParseTriggerSpec(std::string_view text, TriggerSpec& out, std::string& error)
+{
+    const auto open = text.find('{');
+    const auto close = text.find('}', open == std::string_view::npos ? 0 : open);
+    if (open == std::string_view::npos || close == std::string_view::npos) {
+        error = "expected name: {source/channel} condition level";
+        return false;
+    }
+    TriggerSpec spec;
+    auto name = text.substr(0, open);
+    while (!name.empty() && std::isspace(static_cast<unsigned char>(name.back()))) {
+        name.remove_suffix(1);
+    }
+    if (!name.ends_with(':')) {
+        error = "expected 'name:' before the channel";
+        return false;
+    }
+    name.remove_suffix(1);
+    while (!name.empty() && std::isspace(static_cast<unsigned char>(name.front()))) {
+        name.remove_prefix(1);
+    }
+    spec.name = std::string(name);
+
+    const auto reference = text.substr(open + 1, close - open - 1);
+    const auto slash = reference.rfind('/');
+    if (spec.name.empty() || slash == std::string_view::npos || slash == 0 || slash + 1 == reference.size()) {
+        error = "expected name: {source/channel}";
+        return false;
+    }
+    spec.channel = ChannelRef { std::string(reference.substr(0, slash)), std::string(reference.substr(slash + 1)) };
+
+    std::istringstream words { std::string(text.substr(close + 1)) };
+    std::vector<std::string> tokens;
+    for (std::string token; words >> token;) {
+        tokens.push_back(std::move(token));
+    }
+    if (tokens.size() < 2) {
+        error = "expected a condition and its level after the channel";
+        return false;
+    }
+
+    const auto& condition = tokens[0];
+    if (condition == "pattern") {
+        spec.condition = TriggerCondition::Pattern;
+        if (tokens[1].empty() || tokens[1].size() > 64) {
+            error = "a pattern has 1 to 64 lines";
+            return false;
+        }
+        for (const char bit : tokens[1]) {
+            if (bit != '0' && bit != '1' && bit != 'x' && bit != 'X') {
+                error = "pattern lines are 0, 1 or x";
+                return false;
+            }
+            spec.mask = (spec.mask << 1) | (bit == 'x' || bit == 'X' ? 0u : 1u);
+            spec.pattern = (spec.pattern << 1) | (bit == '1' ? 1u : 0u);
+        }
+    } else {
+        constexpr TriggerCondition kLevelConditions[] = {
+            TriggerCondition::Rising, TriggerCondition::Falling, TriggerCondition::Above, TriggerCondition::Below, TriggerCondition::RateAbove
+        };
+        const auto* match = std::find_if(std::begin(kLevelConditions), std::end(kLevelConditions), [&](TriggerCondition candidate) {
+            return condition == ConditionName(candidate);
+        });
+        if (match == std::end(kLevelConditions)) {
+            error = "unknown condition '" + condition + "'; expected rises, falls, above, below, rate or pattern";
+            return false;
+        }
+        spec.condition = *match;
+        if (!ParseNumber(tokens[1], spec.level)) {
+            error = "malformed level '" + tokens[1] + "'";
+            return false;
+        }
+    }
+
+    for (std::size_t i = 2; i < tokens.size(); ++i) {
+        const auto& option = tokens[i];
+        if (option == "freeze") {
+            spec.freeze = true;
+        } else if (option == "snapshot") {
+            spec.snapshot = true;
+        } else if ((option == "hysteresis" || option == "holdoff") && i + 1 < tokens.size()) {
+            double value = 0.0;
+            if (!ParseNumber(tokens[++i], value) || value < 0.0) {
+                error = option + " needs a non-negative number";
+                return false;
+            }
+            if (option == "hysteresis") {
+                spec.hysteresis = value;
+            } else {
+                spec.holdoff = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>(value));
+            }
+        } else {
+            error = "unexpected '" + option + "'";
+            return false;
+        }
+    }
+    out = std::move(spec);
+    return true;
+}
+
+struct TriggerEngine::Trigger {
+    std::shared_ptr<const TriggerSpec> spec;
+    // Only touched under the owning binding's mutex.
+    Detector detector;
+    // Cleared by remove(), for frames and firings already in flight.
+    std::atomic<bool> active{true};
+};
+
+TriggerEngine::TriggerEngine(DataRegistry& registry)
+    : registry_(registry)
+    , outbox_(std::make_shared<Outbox>(kEventQueueCapacity))
+{
+    worker_ = std::thread(&TriggerEngine::run, this);
+}
+
+TriggerEngine::~TriggerEngine()
+{
+    clear();
+    outbox_->stopping.store(true);
+    outbox_->ready.release();
+    worker_.join();
+}
+
+bool TriggerEngine::add(TriggerSpec spec)
+{
+    const auto reject = [&](const char* reason) {
+        spdlog::error("Trigger '{}': {}", spec.name, reason);
+        return false;
+    };
+    if (spec.name.empty()) {
+        return reject("needs a name");
+    }
+    if (spec.channel.sourceId.empty() || spec.channel.channelId.empty()) {
+        return reject("needs a source and channel");
+    }
+    if (spec.hysteresis < 0.0 || spec.holdoff.count() < 0) {
+        return reject("hysteresis and holdoff must not be negative");
+    }
+    if (spec.condition == TriggerCondition::Pattern && (spec.mask == 0 || (spec.pattern & ~spec.mask) != 0)) {
+        return reject("the pattern must cover at least one line and only masked ones");
+    }
+    if (spec.condition == TriggerCondition::RateAbove && spec.level < 0.0) {
+        return reject("a rate limit must not be negative");
+    }
+
+    std::lock_guard lock(mutex_);
+    if (triggers_.contains(spec.name)) {
+        return reject("the name is already in use");
+    }
+    auto trigger = std::make_shared<Trigger>();
+    trigger->detector = CompileDetector(spec);
+    trigger->spec = std::make_shared<const TriggerSpec>(std::move(spec));
+    const auto& added = *trigger->spec;
+    spdlog::info("Trigger '{}' on {}/{}: {}", added.name, added.channel.sourceId, added.channel.channelId, DescribeCondition(added));
+    const auto sourceId = added.channel.sourceId;
+    triggers_.emplace(added.name, std::move(trigger));
+    rebuildRoutes(sourceId);
+    return true;
+}
+
+bool TriggerEngine::remove(const std::string& name)
+{
+    std::lock_guard lock(mutex_);
+    auto it = triggers_.find(name);
+    if (it == triggers_.end()) {
+        return false;
+    }
+    const auto trigger = std::move(it->second);
+    triggers_.erase(it);
+    trigger->active.store(false);
+    rebuildRoutes(trigger->spec->channel.sourceId);
+    return true;
+}
+
+void TriggerEngine::clear()
+{
+    std::lock_guard lock(mutex_);
+    for (auto& [name, trigger] : triggers_) {
+        trigger->active.store(false);
+    }
+    triggers_.clear();
+    for (auto& [sourceId, binding] : bindings_) {
+        registry_.removeObserver(sourceId, binding->token);
+    }
+    bindings_.clear();
+}
+
+std::vector<TriggerSpec> TriggerEngine::specs() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<TriggerSpec> result;
+    result.reserve(triggers_.size());
+    for (const auto& [name, trigger] : triggers_) {
+        result.push_back(*trigger->spec);
+    }
+    return result;
+}
+
+std::vector<TriggerEvent> TriggerEngine::recent() const
+{
+    std::lock_guard lock(mutex_);
+    return { recent_.begin(), recent_.end() };
+}
+
+int TriggerEngine::addListener(Listener listener)
+{
+    std::lock_guard lock(listenerMutex_);
+    const int id = nextListenerId_++;
+    auto next = std::make_shared<ListenerList>(*listeners_.load(std::memory_order_acquire));
+    next->push_back(ListenerEntry { id, std::move(listener) });
+    listeners_.store(std::move(next), std::memory_order_release);
+    return id;
+}
+
+void TriggerEngine::removeListener(int token)
+{
+    std::lock_guard lock(listenerMutex_);
+    auto next = std::make_shared<ListenerList>(*listeners_.load(std::memory_order_acquire));
+    std::erase_if(*next, [token](const ListenerEntry& entry) { return entry.id == token; });
+    listeners_.store(std::move(next), std::memory_order_release);
+}
+
+void TriggerEngine::check(DataRegistry& registry, Outbox& outbox, const Routes& routes, const DataFrame& frame)
+{
+    metrics::ScopedTimer timer(kCheckTime);
+    const auto detected = std::chrono::steady_clock::now();
+    const auto frameNs = Nanos(frame.timestamp, 0);
+    for (const auto& point : frame.points) {
+        const auto it = routes.find(point.channelId);
+        if (it == routes.end()) {
+            continue;
+        }
+        for (const auto& trigger : it->second) {
+            if (!trigger->active.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            // `index` is the firing sample's position in the point's block.
+            auto emit = [&](std::int64_t ns, double value, std::size_t index) {
+                kFired.add();
+                const auto& spec = *trigger->spec;
+                Pending pending { trigger, ns, value, 0, detected };
+                if (spec.freeze || spec.snapshot) {
+                    // The whole block is in the ring by now; step back over the samples
+                    // that came after the firing one.
+                    const auto* waveform = std::get_if<WaveformSample>(&point.payload);
+                    const std::uint64_t later = waveform ? waveform->samples.size() - 1 - index : 0;
+                    const auto end = registry.historySequence(spec.channel.sourceId, spec.channel.channelId);
+                    pending.sequence = end - std::min(end, later);
+                }
+                if (!outbox.queue.tryPush(std::move(pending))) {
+                    kDropped.add();
+                    return;
+                }
+                outbox.ready.release();
+            };
+            CheckPoint(trigger->detector, point, frameNs, emit);
+        }
+    }
+}
+
+// Caller holds mutex_.
+void TriggerEngine::rebuildRoutes(const std::string& sourceId)
+{
+    auto routes = std::make_shared<Routes>();
+    for (const auto& [name, trigger] : triggers_) {
+        if (trigger->spec->channel.sourceId == sourceId) {
+            (*routes)[trigger->spec->channel.channelId].push_back(trigger);
+        }
+    }
+
+    auto it = bindings_.find(sourceId);
+    if (routes->empty()) {
+        if (it != bindings_.end()) {
+            registry_.removeObserver(sourceId, it->second->token);
+            bindings_.erase(it);
+        }
+        return;
+    }
+    if (it != bindings_.end()) {
+        it->second->routes.store(std::move(routes), std::memory_order_release);
+        return;
+    }
+    auto binding = std::make_shared<Binding>();
+    binding->routes.store(std::move(routes), std::memory_order_release);
+    binding->token = registry_.addObserver(sourceId, [binding, outbox = outbox_, registry = &registry_](const DataFrame& frame) {
+        std::lock_guard lock(binding->mutex);
+        check(*registry, *outbox, *binding->routes.load(std::memory_order_acquire), frame);
+    });
+    bindings_.emplace(sourceId, std::move(binding));
+}
+
+void TriggerEngine::run()
+{
+    for (;;) {
+        outbox_->ready.acquire();
+        Pending pending;
+        // With several publishing threads, the firing this count stands for can sit
+        // behind a cell another publisher has claimed but not yet filled. Wait for it
+        // rather than dropping the count, which would strand the firing in the queue.
+        while (!outbox_->queue.tryPop(pending)) {
+            if (outbox_->stopping.load()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        handle(pending);
+    }
+}
+
+void TriggerEngine::handle(Pending& pending)
+{
+    if (!pending.trigger->active.load()) {
+        return;
+    }
+    const auto& spec = pending.trigger->spec;
+    TriggerEvent event;
+    event.trigger = spec;
+    event.time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(pending.timeNs)));
+    event.value = pending.value;
+    if (spec->freeze || spec->snapshot) {
+        event.snapshot = capture(pending);
+    }
+    kLatency.record(std::chrono::steady_clock::now() - pending.detected);
+    spdlog::warn("Trigger '{}' fired: {}/{} {} (value {})", spec->name, spec->channel.sourceId, spec->channel.channelId, DescribeCondition(*spec), event.value);
+
+    {
+        std::lock_guard lock(mutex_);
+        recent_.push_back(event);
+        if (recent_.size() > kRecentEvents) {
+            recent_.pop_front();
+        }
+    }
+    const auto listeners = listeners_.load(std::memory_order_acquire);
+    for (const auto& listener : *listeners) {
+        listener.callback(event);
+    }
+}
+
+// The ring may have moved on since the firing; newer samples are cut off again, on
+// the trigger channel by ring position and on the others by time.
+std::shared_ptr<const TriggerSnapshot> TriggerEngine::capture(const Pending& pending) const
+{
+    const auto& channel = pending.trigger->spec->channel;
+    auto snapshot = std::make_shared<TriggerSnapshot>();
+    snapshot->sourceId = channel.sourceId;
+    const auto capacity = registry_.historyCapacity();
+
+    auto& primary = snapshot->channels[channel.channelId];
+    registry_.readHistory(channel.sourceId, channel.channelId, capacity, primary);
+    DropNewest(primary, static_cast<std::size_t>(primary.endSequence - std::min(primary.endSequence, pending.sequence)));
+    const auto cutoff = primary.empty()
+        ? std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(pending.timeNs)))
+        : primary.timestamps.back();
+
+    for (const auto& channelId : registry_.historyChannels(channel.sourceId)) {
+        if (channelId == channel.channelId) {
+            continue;
+        }
+        auto& window = snapshot->channels[channelId];
+        registry_.readHistory(channel.sourceId, channelId, capacity, window);
+        const auto after = std::upper_bound(window.timestamps.begin(), window.timestamps.end(), cutoff);
+        DropNewest(window, static_cast<std::size_t>(window.timestamps.end() - after));
+    }
+    return snapshot;
+}
+
+} // namespace core
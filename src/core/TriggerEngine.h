@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Expression.h"
+#include "HistoryBuffer.h"
+#include "MpmcQueue.h"
+#include "Types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+class DataRegistry;
+
+enum class TriggerCondition {
+    // Crosses `level` upwards / downwards; re-arms once `hysteresis` back across it.
+    Rising,
+    Falling,
+    // Alarm style: fires on entering the region, including when the first sample is
+    // already in it, and re-arms once `hysteresis` back out.
+    Above,
+    Below,
+    // |d value / dt| in units per second exceeds `level`.
+    RateAbove,
+    // Logic or GPIO lines under `mask` take the values in `pattern`.
+    Pattern
+};
+
+struct TriggerSpec {
+    std::string name;
+    ChannelRef channel;
+    TriggerCondition condition{TriggerCondition::Rising};
+    double level{0.0};
+    double hysteresis{0.0};
+    // Pattern: lines 0-63, line i being bit i.
+    std::uint64_t mask{0};
+    std::uint64_t pattern{0};
+    // Crossings within this long after a firing (in sample time) are ignored; 0 = none.
+    std::chrono::nanoseconds holdoff{0};
+    // Hold Graphing windows on the source at the history as of the firing.
+    bool freeze{false};
+    // Keep a copy of the source's history as of the firing.
+    bool snapshot{false};
+};
+
+// Parses the command-line form
+// "name: {source/channel} rises|falls|above|below|rate LEVEL [hysteresis H]
+// [holdoff MS] [freeze] [snapshot]", or "... pattern BITS" with BITS written as
+// 0/1/x from the highest line down to line 0.
+bool ParseTriggerSpec(std::string_view text, TriggerSpec& out, std::string& error);
+
+// A source's history, cut off at the sample that fired a trigger.
+struct TriggerSnapshot {
+    std::string sourceId;
+    std::map<std::string, HistoryWindow> channels;
+};
+
+struct TriggerEvent {
+    std::shared_ptr<const TriggerSpec> trigger;
+    // Time of the sample that fired, and its value (the lines under the mask for Pattern).
+    std::chrono::system_clock::time_point time;
+    double value{0.0};
+    // Set when the trigger freezes or snapshots.
+    std::shared_ptr<const TriggerSnapshot> snapshot;
+};
+
+/**
+ * @brief Threshold, rate and logic-pattern triggers checked as samples arrive.
+ *
+ * Each trigger is compiled into a detector for one channel: a small state machine
+ * whose step costs O(1) per sample (per slice for logic), with the condition
+ * resolved once per block rather than per sample. One inline registry observer per
+ * source routes a frame's points by channel id to their detectors, so checks run on
+ * the publishing thread straight after `DataRegistry::update`. Firing only queues
+ * the event; logging, history snapshots and listeners run on the engine's worker.
+ */
+class TriggerEngine {
+public:
+    using Listener = std::function<void(const TriggerEvent&)>;
+
+    static constexpr std::size_t kEventQueueCapacity = 256;
+    static constexpr std::size_t kRecentEvents = 32;
+
+    explicit TriggerEngine(DataRegistry& registry);
+    ~TriggerEngine();
+
+    TriggerEngine(const TriggerEngine&) = delete;
+    TriggerEngine& operator=(const TriggerEngine&) = delete;
+
+    // False (logged) when the name is taken or the spec is inconsistent.
+    bool add(TriggerSpec spec);
+    bool remove(const std::string& name);
+    void clear();
+
+    [[nodiscard]] std::vector<TriggerSpec> specs() const;
+    // Newest last.
+    [[nodiscard]] std::vector<TriggerEvent> recent() const;
+
+    // Called on the worker thread, in firing order. Listeners must not block for long.
+    int addListener(Listener listener);
+    void removeListener(int token);
+
+private:
+    struct Trigger;
+    // Fired on the hot path, handled by the worker.
+    struct Pending {
+        std::shared_ptr<const Trigger> trigger;
+        std::int64_t timeNs{0};
+        double value{0.0};
+        // Ring position of the trigger channel just after the firing sample.
+        std::uint64_t sequence{0};
+        std::chrono::steady_clock::time_point detected;
+    };
+    // Shared with the observers, which may outlive the engine briefly.
+    struct Outbox {
+        explicit Outbox(std::size_t capacity) : queue(capacity) {}
+        MpmcQueue<Pending> queue;
+        std::counting_semaphore<> ready{0};
+        std::atomic<bool> stopping{false};
+    };
+    // Immutable; swapped whole when triggers come and go.
+    using Routes = std::unordered_map<std::string, std::vector<std::shared_ptr<Trigger>>>;
+    // One observed source. `mutex` keeps its detectors single-threaded.
+    struct Binding {
+        std::mutex mutex;
+        std::atomic<std::shared_ptr<const Routes>> routes;
+        int token{0};
+    };
+    struct ListenerEntry {
+        int id;
+        Listener callback;
+    };
+    using ListenerList = std::vector<ListenerEntry>;
+
+    static void check(DataRegistry& registry, Outbox& outbox, const Routes& routes, const DataFrame& frame);
+    void rebuildRoutes(const std::string& sourceId);
+    void run();
+    void handle(Pending& pending);
+    [[nodiscard]] std::shared_ptr<const TriggerSnapshot> capture(const Pending& pending) const;
+
+    DataRegistry& registry_;
+    std::shared_ptr<Outbox> outbox_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Trigger>> triggers_;
+    std::map<std::string, std::shared_ptr<Binding>> bindings_;
+    std::deque<TriggerEvent> recent_;
+
+    std::mutex listenerMutex_;
+    std::atomic<std::shared_ptr<const ListenerList>> listeners_{std::make_shared<const ListenerList>()};
+    int nextListenerId_{1};
+
+    std::thread worker_;
+};
+
+}  // namespace core
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -35,14 +36,71 @@ struct SerialSample {
     std::chrono::system_clock::time_point timestamp;
 };
 
+// Bit-packed line states: line i is bit (i % 64) of words[i / 64]; unused high
+// bits of the last word stay zero so whole words can be compared and XORed.
+struct PackedBits {
+    std::vector<std::uint64_t> words;
+    std::uint32_t count{0};
+
+    static constexpr std::size_t WordsFor(std::size_t bits) { return (bits + 63) / 64; }
+
+    [[nodiscard]] std::size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] bool test(std::size_t i) const { return (words[i / 64] >> (i % 64)) & 1u; }
+
+    void set(std::size_t i, bool value)
+    {
+        const std::uint64_t mask = std::uint64_t{1} << (i % 64);
+        words[i / 64] = value ? (words[i / 64] | mask) : (words[i / 64] & ~mask);
+    }
+
+    void push_back(bool value)
+    {
+        if (count % 64 == 0) {
+            words.push_back(0);
+        }
+        if (value) {
+            words.back() |= std::uint64_t{1} << (count % 64);
+        }
+        ++count;
+    }
+
+    // Resizes to `bits` lines, all low.
+    void reset(std::size_t bits)
+    {
+        count = static_cast<std::uint32_t>(bits);
+        words.assign(WordsFor(bits), 0);
+    }
+
+    void clear()
+    {
+        words.clear();
+        count = 0;
+    }
+
+    bool operator==(const PackedBits&) const = default;
+};
+
+// One or more consecutive time slices of `channelCount` logic lines, `samplePeriod`
+// apart, starting at `timestamp`. Slice s occupies words
+// [s * wordsPerSlice(), (s + 1) * wordsPerSlice()) laid out like `PackedBits`.
 struct LogicSample {
-    std::vector<bool> channels;
+    std::uint32_t channelCount{0};
+    std::vector<std::uint64_t> words;
     std::chrono::nanoseconds samplePeriod{};
     std::chrono::system_clock::time_point timestamp;
+
+    [[nodiscard]] std::size_t wordsPerSlice() const { return PackedBits::WordsFor(channelCount); }
+    [[nodiscard]] std::size_t sliceCount() const { return channelCount == 0 ? 0 : words.size() / wordsPerSlice(); }
+
+    [[nodiscard]] bool level(std::size_t slice, std::size_t channel) const
+    {
+        return (words[slice * wordsPerSlice() + channel / 64] >> (channel % 64)) & 1u;
+    }
 };
 
 struct GpioState {
-    std::vector<bool> pins;
+    PackedBits pins;
     std::chrono::system_clock::time_point timestamp;
 };
 
@@ -66,6 +124,8 @@ struct SourceMetadata {
     DataKind kind{DataKind::Custom};
     std::string description;
     std::optional<std::string> unit;
+
+    bool operator==(const SourceMetadata&) const = default;
 };
 
 }  // namespace core
@@ -0,0 +1,21 @@
+#include "flags.h"
+
+// Defaults; main() overwrites them from the command line. They live outside
+// main.cpp so tools linking the workbench library (e.g. workbench_bench) get them.
+bool flags::enableHardwareMock = false;
+int flags::logLevel = 2;
+int flags::maxFps = 30;
+int flags::tickRate = 50;
+int flags::metricsLogInterval = 0;
+std::string flags::relayEndpoints;
+bool flags::relaySharedMemory = false;
+std::string flags::captureDir = "captures";
+std::string flags::recordSources;
+std::string flags::replayFiles;
+double flags::replaySpeed = 1.0;
+bool flags::replayLoop = false;
+double flags::replayStart = 0.0;
+std::string flags::derivedChannels;
+std::string flags::triggers;
+std::string flags::layoutFile = "workbench-layout.json";
+std::string flags::serveSocket;
@@ -1,6 +1,23 @@
 #pragma once
 
+#include <string>
+
 namespace flags {
 extern bool enableHardwareMock;
 extern int logLevel; // 0=error, 1=warning, 2=info, 3=debug, 4=trace
+extern int maxFps; // upper bound on UI rebuilds per second
+extern int tickRate; // base rate of module ticks, in Hz
+extern int metricsLogInterval; // seconds between metric dumps to the log; 0 = off
+extern std::string relayEndpoints; // comma-separated [name=]socket-path relays to ingest from
+extern bool relaySharedMemory; // take bulk sources from same-host relays through shared memory
+extern std::string captureDir; // where the recorder writes capture files
+extern std::string recordSources; // comma-separated source ids recorded from startup
+extern std::string replayFiles; // comma-separated capture files published as live sources
+extern double replaySpeed; // replay rate relative to real time; 0 = as fast as possible
+extern bool replayLoop;
+extern double replayStart; // seconds into the replay to start from
+extern std::string derivedChannels; // semicolon-separated id[unit]=expression computed sources
+extern std::string triggers; // semicolon-separated "name: {source/channel} condition level" triggers
+extern std::string layoutFile; // window layout restored at startup and saved on exit; empty = off
+extern std::string serveSocket; // headless mode: serve the registry on this socket instead of drawing
 } // namespace flags
\ No newline at end of file
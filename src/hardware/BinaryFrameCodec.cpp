@@ -0,0 +1,400 @@
+#include "hardware/BinaryFrameCodec.h"
+
+#include "core/LogicCapture.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+namespace hardware::binary {
+
+namespace {
+
+template <typename T>
+T FromLittleEndian(T value)
+{
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+        if constexpr (std::is_floating_point_v<T>) {
+            using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+            return std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+        } else {
+            return std::byteswap(value);
+        }
+    }
+    return value;
+}
+
+template <typename T>
+T ToLittleEndian(T value)
+{
+    return FromLittleEndian(value);
+}
+
+// Bounds-checked little-endian reader over a payload view.
+class Reader {
+public:
+    explicit Reader(std::string_view data)
+        : data_(data)
+    {
+    }
+
+    template <typename T>
+    bool read(T& out)
+    {
+        if (data_.size() - offset_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&out, data_.data() + offset_, sizeof(T));
+        out = FromLittleEndian(out);
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    template <typename Length>
+    bool readString(std::string& out)
+    {
+        Length length {};
+        if (!read(length) || data_.size() - offset_ < length) {
+            return false;
+        }
+        out.assign(data_.data() + offset_, length);
+        offset_ += length;
+        return true;
+    }
+
+    bool readDoubles(std::vector<double>& out, std::size_t count)
+    {
+        if ((data_.size() - offset_) / sizeof(double) < count) {
+            return false;
+        }
+        out.resize(count);
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(out.data(), data_.data() + offset_, count * sizeof(double));
+            offset_ += count * sizeof(double);
+        } else {
+            for (auto& value : out) {
+                read(value);
+            }
+        }
+        return true;
+    }
+
+    // LSB-first bytes map onto little-endian words, so this is a byte-wise OR rather
+    // than a per-bit loop. Bits past `count` in the last byte are dropped.
+    bool readBits(std::vector<std::uint64_t>& words, std::size_t count)
+    {
+        const std::size_t bytes = (count + 7) / 8;
+        if (data_.size() - offset_ < bytes) {
+            return false;
+        }
+        words.assign(core::PackedBits::WordsFor(count), 0);
+        const auto* raw = reinterpret_cast<const unsigned char*>(data_.data() + offset_);
+        for (std::size_t i = 0; i < bytes; ++i) {
+            words[i / 8] |= static_cast<std::uint64_t>(raw[i]) << (8 * (i % 8));
+        }
+        if (count % 64 != 0) {
+            words.back() &= (std::uint64_t { 1 } << (count % 64)) - 1;
+        }
+        offset_ += bytes;
+        return true;
+    }
+
+    bool readWords(std::vector<std::uint64_t>& out, std::size_t count)
+    {
+        if ((data_.size() - offset_) / sizeof(std::uint64_t) < count) {
+            return false;
+        }
+        out.resize(count);
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(out.data(), data_.data() + offset_, count * sizeof(std::uint64_t));
+            offset_ += count * sizeof(std::uint64_t);
+        } else {
+            for (auto& word : out) {
+                read(word);
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool atEnd() const { return offset_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    std::size_t offset_ { 0 };
+};
+
+class Writer {
+public:
+    explicit Writer(std::string& out)
+        : out_(out)
+    {
+    }
+
+    template <typename T>
+    void write(T value)
+    {
+        value = ToLittleEndian(value);
+        const auto offset = out_.size();
+        out_.resize(offset + sizeof(T));
+        std::memcpy(out_.data() + offset, &value, sizeof(T));
+    }
+
+    template <typename Length>
+    void writeString(std::string_view text)
+    {
+        const auto length = static_cast<Length>(std::min<std::size_t>(text.size(), static_cast<std::size_t>(static_cast<Length>(~Length {}))));
+        write(length);
+        out_.append(text.data(), length);
+    }
+
+    void writeDoubles(const std::vector<double>& values)
+    {
+        if constexpr (std::endian::native == std::endian::little) {
+            const auto offset = out_.size();
+            out_.resize(offset + values.size() * sizeof(double));
+            std::memcpy(out_.data() + offset, values.data(), values.size() * sizeof(double));
+        } else {
+            for (double value : values) {
+                write(value);
+            }
+        }
+    }
+
+    void writeBits(const std::vector<std::uint64_t>& words, std::size_t count)
+    {
+        const std::size_t bytes = (count + 7) / 8;
+        const auto offset = out_.size();
+        out_.resize(offset + bytes);
+        for (std::size_t i = 0; i < bytes; ++i) {
+            out_[offset + i] = static_cast<char>(words[i / 8] >> (8 * (i % 8)));
+        }
+    }
+
+    void writeWords(const std::vector<std::uint64_t>& words)
+    {
+        if constexpr (std::endian::native == std::endian::little) {
+            const auto offset = out_.size();
+            out_.resize(offset + words.size() * sizeof(std::uint64_t));
+            std::memcpy(out_.data() + offset, words.data(), words.size() * sizeof(std::uint64_t));
+        } else {
+            for (auto word : words) {
+                write(word);
+            }
+        }
+    }
+
+private:
+    std::string& out_;
+};
+
+// Returns the payload alternative, reusing the existing one (and its buffers) when it matches.
+template <typename T>
+T& PayloadAs(core::DataPoint& point)
+{
+    if (auto* existing = std::get_if<T>(&point.payload)) {
+        return *existing;
+    }
+    return point.payload.emplace<T>();
+}
+
+std::chrono::system_clock::time_point TimestampFromSeconds(double seconds)
+{
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::duration<double>(seconds)));
+}
+
+double SecondsFromTimestamp(std::chrono::system_clock::time_point timestamp)
+{
+    return std::chrono::duration<double>(timestamp.time_since_epoch()).count();
+}
+
+bool DecodePoint(Reader& reader, core::DataPoint& point, std::chrono::system_clock::time_point timestamp)
+{
+    std::uint8_t tag = 0;
+    if (!reader.readString<std::uint16_t>(point.channelId) || !reader.read(tag)) {
+        return false;
+    }
+
+    switch (static_cast<PayloadTag>(tag)) {
+    case PayloadTag::None:
+        point.payload = std::monostate {};
+        return true;
+    case PayloadTag::Numeric: {
+        auto& sample = PayloadAs<core::NumericSample>(point);
+        sample.timestamp = timestamp;
+        return reader.read(sample.value) && reader.readString<std::uint8_t>(sample.unit);
+    }
+    case PayloadTag::Waveform: {
+        auto& sample = PayloadAs<core::WaveformSample>(point);
+        sample.timestamp = timestamp;
+        std::uint32_t count = 0;
+        return reader.read(sample.sampleRateHz) && reader.read(count) && reader.readDoubles(sample.samples, count);
+    }
+    case PayloadTag::Serial: {
+        auto& sample = PayloadAs<core::SerialSample>(point);
+        sample.timestamp = timestamp;
+        return reader.readString<std::uint32_t>(sample.text);
+    }
+    case PayloadTag::Logic: {
+        auto& sample = PayloadAs<core::LogicSample>(point);
+        sample.timestamp = timestamp;
+        std::int64_t periodNs = 0;
+        std::uint32_t count = 0;
+        if (!reader.read(periodNs) || !reader.read(count)) {
+            return false;
+        }
+        sample.samplePeriod = std::chrono::nanoseconds(periodNs);
+        sample.channelCount = count;
+        return reader.readBits(sample.words, count);
+    }
+    case PayloadTag::Gpio: {
+        auto& state = PayloadAs<core::GpioState>(point);
+        state.timestamp = timestamp;
+        return reader.read(state.pins.count) && reader.readBits(state.pins.words, state.pins.count);
+    }
+    case PayloadTag::LogicCapture: {
+        auto& sample = PayloadAs<core::LogicSample>(point);
+        sample.timestamp = timestamp;
+        std::int64_t periodNs = 0;
+        std::uint32_t sliceCount = 0;
+        if (!reader.read(periodNs) || !reader.read(sample.channelCount) || !reader.read(sliceCount)) {
+            return false;
+        }
+        sample.samplePeriod = std::chrono::nanoseconds(periodNs);
+        const std::uint64_t wordCount = static_cast<std::uint64_t>(sample.wordsPerSlice()) * sliceCount;
+        if (wordCount > kMaxPayloadSize / sizeof(std::uint64_t)) {
+            return false;
+        }
+        if (!reader.readWords(sample.words, static_cast<std::size_t>(wordCount))) {
+            return false;
+        }
+        core::NormalizeLogicSample(sample);
+        return true;
+    }
+    }
+    return false;
+}
+
+void EncodePoint(Writer& writer, const core::DataPoint& point)
+{
+    writer.writeString<std::uint16_t>(point.channelId);
+    std::visit(
+        [&writer](const auto& payload) {
+            using T = std::decay_t<decltype(payload)>;
+            if constexpr (std::is_same_v<T, core::NumericSample>) {
+                writer.write(static_cast<std::uint8_t>(PayloadTag::Numeric));
+                writer.write(payload.value);
+                writer.writeString<std::uint8_t>(payload.unit);
+            } else if constexpr (std::is_same_v<T, core::WaveformSample>) {
+                writer.write(static_cast<std::uint8_t>(PayloadTag::Waveform));
+                writer.write(payload.sampleRateHz);
+                writer.write(static_cast<std::uint32_t>(payload.samples.size()));
+                writer.writeDoubles(payload.samples);
+            } else if constexpr (std::is_same_v<T, core::SerialSample>) {
+                writer.write(static_cast<std::uint8_t>(PayloadTag::Serial));
+                writer.writeString<std::uint32_t>(payload.text);
+            } else if constexpr (std::is_same_v<T, core::LogicSample>) {
+                // Single slices keep the compact tag older relays and UIs understand.
+                const auto slices = payload.sliceCount();
+                writer.write(static_cast<std::uint8_t>(slices == 1 ? PayloadTag::Logic : PayloadTag::LogicCapture));
+                writer.write(static_cast<std::int64_t>(payload.samplePeriod.count()));
+                writer.write(payload.channelCount);
+                if (slices == 1) {
+                    writer.writeBits(payload.words, payload.channelCount);
+                } else {
+                    writer.write(static_cast<std::uint32_t>(slices));
+                    writer.writeWords(payload.words);
+                }
+            } else if constexpr (std::is_same_v<T, core::GpioState>) {
+                writer.write(static_cast<std::uint8_t>(PayloadTag::Gpio));
+                writer.write(payload.pins.count);
+                writer.writeBits(payload.pins.words, payload.pins.count);
+            } else {
+                writer.write(static_cast<std::uint8_t>(PayloadTag::None));
+            }
+        },
+        point.payload);
+}
+
+void BeginFrame(std::string& out, FrameType type, std::size_t& headerOffset)
+{
+    headerOffset = out.size();
+    out.resize(headerOffset + kHeaderSize);
+    out[headerOffset + 4] = static_cast<char>(type);
+}
+
+void FinishFrame(std::string& out, std::size_t headerOffset)
+{
+    const auto length = ToLittleEndian(static_cast<std::uint32_t>(out.size() - headerOffset - kHeaderSize));
+    std::memcpy(out.data() + headerOffset, &length, sizeof(length));
+}
+
+} // namespace
+
+bool ReadHeader(std::string_view buffer, FrameHeader& out)
+{
+    if (buffer.size() < kHeaderSize) {
+        return false;
+    }
+    std::uint32_t length = 0;
+    std::memcpy(&length, buffer.data(), sizeof(length));
+    out.payloadSize = FromLittleEndian(length);
+    out.type = static_cast<FrameType>(static_cast<std::uint8_t>(buffer[4]));
+    return true;
+}
+
+bool DecodeDataFrame(std::string_view payload, core::DataFrame& out)
+{
+    Reader reader(payload);
+    double seconds = 0.0;
+    std::uint16_t pointCount = 0;
+    if (!reader.readString<std::uint16_t>(out.sourceId) || !reader.readString<std::uint16_t>(out.sourceName)
+        || !reader.read(seconds) || !reader.read(pointCount)) {
+        return false;
+    }
+    if (out.sourceName.empty()) {
+        out.sourceName = out.sourceId;
+    }
+    out.timestamp = TimestampFromSeconds(seconds);
+
+    // Resizing keeps existing points (and their buffers) for reuse.
+    out.points.resize(pointCount);
+    for (auto& point : out.points) {
+        if (!DecodePoint(reader, point, out.timestamp)) {
+            return false;
+        }
+    }
+    return reader.atEnd();
+}
+
+void EncodeDataFrame(const core::DataFrame& frame, std::string& out)
+{
+    std::size_t headerOffset = 0;
+    BeginFrame(out, FrameType::DataFrame, headerOffset);
+    Writer writer(out);
+    writer.writeString<std::uint16_t>(frame.sourceId);
+    writer.writeString<std::uint16_t>(frame.sourceName == frame.sourceId ? std::string_view {} : std::string_view { frame.sourceName });
+    writer.write(SecondsFromTimestamp(frame.timestamp));
+    writer.write(static_cast<std::uint16_t>(std::min<std::size_t>(frame.points.size(), 0xFFFF)));
+    std::size_t written = 0;
+    for (const auto& point : frame.points) {
+        if (written++ == 0xFFFF) {
+            break;
+        }
+        EncodePoint(writer, point);
+    }
+    FinishFrame(out, headerOffset);
+}
+
+void EncodeJson(std::string_view json, std::string& out)
+{
+    std::size_t headerOffset = 0;
+    BeginFrame(out, FrameType::Json, headerOffset);
+    out.append(json.data(), json.size());
+    FinishFrame(out, headerOffset);
+}
+
+} // namespace hardware::binary
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hardware::binary {
+
+/**
+ * @brief Length-prefixed relay framing negotiated with `protocol: 2`.
+ *
+ * Once the relay acknowledges `workbench.registerClient` with protocol 2, every
+ * relay -> UI message is a frame: a little-endian `uint32` payload length, a
+ * one-byte `FrameType`, then the payload. JSON-RPC messages keep flowing inside
+ * `FrameType::Json` frames; data frames use the packed layout documented in
+ * `hardware/README.md` and decode straight into `core::DataFrame`.
+ */
+constexpr int kProtocolVersion = 2;
+constexpr std::size_t kHeaderSize = 5;
+constexpr std::uint32_t kMaxPayloadSize = 64u * 1024u * 1024u;
+
+enum class FrameType : std::uint8_t {
+    Json = 0x01,
+    DataFrame = 0x02,
+};
+
+enum class PayloadTag : std::uint8_t {
+    None = 0,
+    Numeric = 1,
+    Waveform = 2,
+    Serial = 3,
+    Logic = 4,
+    Gpio = 5,
+    LogicCapture = 6,
+};
+
+struct FrameHeader {
+    std::uint32_t payloadSize{0};
+    FrameType type{FrameType::Json};
+};
+
+// Returns false until `buffer` holds a complete header.
+bool ReadHeader(std::string_view buffer, FrameHeader& out);
+
+// Decodes a `FrameType::DataFrame` payload into `out`, reusing its storage.
+// Returns false (leaving `out` unspecified) on truncated or malformed input.
+bool DecodeDataFrame(std::string_view payload, core::DataFrame& out);
+
+// Append a complete frame (header + payload) to `out`.
+void EncodeDataFrame(const core::DataFrame& frame, std::string& out);
+void EncodeJson(std::string_view json, std::string& out);
+
+}  // namespace hardware::binary
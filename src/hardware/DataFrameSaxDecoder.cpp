@@ -0,0 +1,724 @@
+#include "hardware/DataFrameSaxDecoder.h"
+
+#include "core/LogicCapture.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace hardware {
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr std::string_view kDataFrameMethod = "workbench.dataFrame";
+constexpr std::int64_t kMaxLogicChannels = 1 << 16;
+
+// Where the parser currently is within the dataFrame schema.
+enum class Scope : std::uint8_t {
+    Root,
+    Params,
+    Source,
+    Frame,
+    Points,
+    Point,
+    Numeric,
+    Waveform,
+    Samples,
+    Serial,
+    Logic,
+    LogicBits,
+    LogicWords,
+    Gpio,
+    GpioBits,
+    Skip,
+};
+
+// The key whose value is about to arrive, resolved against the enclosing scope.
+enum class Field : std::uint8_t {
+    None,
+    Method,
+    Params,
+    Source,
+    Frame,
+    Id,
+    Name,
+    Kind,
+    Description,
+    Unit,
+    SourceId,
+    SourceName,
+    Timestamp,
+    Points,
+    ChannelId,
+    Numeric,
+    Waveform,
+    Serial,
+    Logic,
+    Gpio,
+    Value,
+    Samples,
+    SampleRate,
+    Text,
+    Channels,
+    ChannelCount,
+    Words,
+    PeriodNs,
+    Pins,
+};
+
+// Payload precedence when a point carries several payload objects, matching the DOM decoder.
+int PayloadRank(Field field)
+{
+    switch (field) {
+    case Field::Numeric:
+        return 1;
+    case Field::Waveform:
+        return 2;
+    case Field::Serial:
+        return 3;
+    case Field::Logic:
+        return 4;
+    case Field::Gpio:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+template <typename T>
+T& PayloadAs(core::DataPoint& point)
+{
+    if (auto* existing = std::get_if<T>(&point.payload)) {
+        return *existing;
+    }
+    return point.payload.emplace<T>();
+}
+
+std::chrono::system_clock::time_point TimestampFromSeconds(double seconds)
+{
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::duration<double>(seconds)));
+}
+
+class DataFrameSax {
+public:
+    explicit DataFrameSax(DataFrameNotification& out)
+        : out_(out)
+    {
+        out_.hasSource = false;
+        out_.hasFrame = false;
+    }
+
+    bool isDataFrame() const { return isDataFrame_; }
+
+    void finish()
+    {
+        auto& source = out_.source;
+        if (!out_.hasSource) {
+            source.id.clear();
+            source.name.clear();
+        } else if (!sourceNameSeen_) {
+            source.name = source.id;
+        }
+
+        auto& frame = out_.frame;
+        if (!frameSourceIdSeen_) {
+            frame.sourceId = source.id;
+        }
+        if (!frameSourceNameSeen_) {
+            frame.sourceName = source.name.empty() ? frame.sourceId : source.name;
+        }
+        frame.timestamp = timestampSeen_ ? TimestampFromSeconds(timestampSeconds_) : std::chrono::system_clock::now();
+
+        frame.points.resize(pointCount_);
+        for (auto& point : frame.points) {
+            std::visit(
+                [&frame](auto& payload) {
+                    using T = std::decay_t<decltype(payload)>;
+                    if constexpr (!std::is_same_v<T, std::monostate>) {
+                        payload.timestamp = frame.timestamp;
+                    }
+                    if constexpr (std::is_same_v<T, core::LogicSample>) {
+                        core::NormalizeLogicSample(payload);
+                    }
+                },
+                point.payload);
+        }
+    }
+
+    bool null()
+    {
+        if (top() == Scope::Source && field_ == Field::Unit) {
+            out_.source.unit.reset();
+        }
+        return true;
+    }
+
+    bool boolean(bool value)
+    {
+        if (bitWords_ && (top() == Scope::LogicBits || top() == Scope::GpioBits)) {
+            appendBit(value);
+        }
+        return true;
+    }
+
+    bool number_integer(json::number_integer_t value)
+    {
+        return number(static_cast<double>(value), value);
+    }
+
+    bool number_unsigned(json::number_unsigned_t value)
+    {
+        // Packed words need all 64 bits, which the double/int64 forms cannot carry.
+        if (top() == Scope::LogicWords) {
+            logicWords_->push_back(value);
+            return true;
+        }
+        return number(static_cast<double>(value), static_cast<std::int64_t>(value));
+    }
+
+    bool number_float(json::number_float_t value, const json::string_t& /*text*/)
+    {
+        // Only periodNs uses the integer form; out-of-range floats collapse to 0.
+        const bool representable = std::isfinite(value) && std::fabs(value) < 9.0e18;
+        return number(value, representable ? static_cast<std::int64_t>(value) : 0);
+    }
+
+    bool string(json::string_t& value)
+    {
+        // Values are assigned (not moved) so destination strings keep their capacity.
+        switch (top()) {
+        case Scope::Root:
+            if (field_ == Field::Method) {
+                isDataFrame_ = value == kDataFrameMethod;
+                // Abort early: anything else is handled by the generic JSON path.
+                return isDataFrame_;
+            }
+            break;
+        case Scope::Source:
+            switch (field_) {
+            case Field::Id:
+                out_.source.id = value;
+                break;
+            case Field::Name:
+                out_.source.name = value;
+                sourceNameSeen_ = true;
+                break;
+            case Field::Kind:
+                out_.source.kind = ParseKind(value);
+                break;
+            case Field::Description:
+                out_.source.description = value;
+                break;
+            case Field::Unit:
+                out_.source.unit = value;
+                break;
+            default:
+                break;
+            }
+            break;
+        case Scope::Frame:
+            if (field_ == Field::SourceId) {
+                out_.frame.sourceId = value;
+                frameSourceIdSeen_ = true;
+            } else if (field_ == Field::SourceName) {
+                out_.frame.sourceName = value;
+                frameSourceNameSeen_ = true;
+            } else if (field_ == Field::Timestamp) {
+                double seconds = 0.0;
+                const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+                if (ec == std::errc {} && ptr != value.data()) {
+                    timestampSeconds_ = seconds;
+                    timestampSeen_ = true;
+                }
+            }
+            break;
+        case Scope::Point:
+            if (field_ == Field::ChannelId) {
+                point_->channelId = value;
+            }
+            break;
+        case Scope::Numeric:
+            if (field_ == Field::Unit) {
+                std::get<core::NumericSample>(point_->payload).unit = value;
+            }
+            break;
+        case Scope::Serial:
+            if (field_ == Field::Text) {
+                std::get<core::SerialSample>(point_->payload).text = value;
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool binary(json::binary_t& /*value*/)
+    {
+        return true;
+    }
+
+    bool start_object(std::size_t /*elements*/)
+    {
+        if (depth_ == 0) {
+            push(Scope::Root);
+            return true;
+        }
+
+        Scope next = Scope::Skip;
+        switch (top()) {
+        case Scope::Root:
+            if (field_ == Field::Params) {
+                next = Scope::Params;
+            }
+            break;
+        case Scope::Params:
+            if (field_ == Field::Source) {
+                beginSource();
+                next = Scope::Source;
+            } else if (field_ == Field::Frame) {
+                beginFrame();
+                next = Scope::Frame;
+            }
+            break;
+        case Scope::Points:
+            beginPoint();
+            next = Scope::Point;
+            break;
+        case Scope::Point:
+            next = beginPayload(field_);
+            break;
+        default:
+            break;
+        }
+        push(next);
+        return true;
+    }
+
+    bool key(json::string_t& name)
+    {
+        field_ = ResolveField(top(), name);
+        return true;
+    }
+
+    bool end_object()
+    {
+        pop();
+        field_ = Field::None;
+        return true;
+    }
+
+    bool start_array(std::size_t /*elements*/)
+    {
+        Scope next = Scope::Skip;
+        if (depth_ > 0) {
+            switch (top()) {
+            case Scope::Frame:
+                if (field_ == Field::Points) {
+                    pointCount_ = 0;
+                    next = Scope::Points;
+                }
+                break;
+            case Scope::Waveform:
+                if (field_ == Field::Samples) {
+                    samples_ = &std::get<core::WaveformSample>(point_->payload).samples;
+                    samples_->clear();
+                    next = Scope::Samples;
+                }
+                break;
+            case Scope::Logic:
+                if (field_ == Field::Channels) {
+                    // A single slice of per-channel levels.
+                    auto& sample = std::get<core::LogicSample>(point_->payload);
+                    sample.words.clear();
+                    sample.channelCount = 0;
+                    bitWords_ = &sample.words;
+                    bitCount_ = &sample.channelCount;
+                    next = Scope::LogicBits;
+                } else if (field_ == Field::Words) {
+                    logicWords_ = &std::get<core::LogicSample>(point_->payload).words;
+                    logicWords_->clear();
+                    next = Scope::LogicWords;
+                }
+                break;
+            case Scope::Gpio:
+                if (field_ == Field::Pins) {
+                    auto& pins = std::get<core::GpioState>(point_->payload).pins;
+                    pins.clear();
+                    bitWords_ = &pins.words;
+                    bitCount_ = &pins.count;
+                    next = Scope::GpioBits;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        push(next);
+        return true;
+    }
+
+    bool end_array()
+    {
+        const Scope closed = top();
+        pop();
+        if (closed == Scope::Samples) {
+            samples_ = nullptr;
+        } else if (closed == Scope::LogicBits || closed == Scope::GpioBits) {
+            bitWords_ = nullptr;
+            bitCount_ = nullptr;
+        } else if (closed == Scope::LogicWords) {
+            logicWords_ = nullptr;
+        }
+        field_ = Field::None;
+        return true;
+    }
+
+    bool parse_error(std::size_t /*position*/, const std::string& /*token*/, const nlohmann::detail::exception& /*ex*/)
+    {
+        malformed_ = true;
+        return false;
+    }
+
+    bool malformed() const { return malformed_; }
+
+private:
+    // Fixed-size stack so decoding never allocates; anything nested deeper than the
+    // schema is skipped anyway, so only the depth is tracked past kMaxDepth.
+    Scope top() const { return depth_ == 0 || depth_ > kMaxDepth ? Scope::Skip : scopes_[depth_ - 1]; }
+
+    void push(Scope scope)
+    {
+        if (depth_ < kMaxDepth) {
+            scopes_[depth_] = scope;
+        }
+        ++depth_;
+    }
+
+    void pop()
+    {
+        if (depth_ > 0) {
+            --depth_;
+        }
+    }
+
+    static Field ResolveField(Scope scope, std::string_view name)
+    {
+        switch (scope) {
+        case Scope::Root:
+            if (name == "method") {
+                return Field::Method;
+            }
+            if (name == "params") {
+                return Field::Params;
+            }
+            break;
+        case Scope::Params:
+            if (name == "source") {
+                return Field::Source;
+            }
+            if (name == "frame") {
+                return Field::Frame;
+            }
+            break;
+        case Scope::Source:
+            if (name == "id") {
+                return Field::Id;
+            }
+            if (name == "name") {
+                return Field::Name;
+            }
+            if (name == "kind") {
+                return Field::Kind;
+            }
+            if (name == "description") {
+                return Field::Description;
+            }
+            if (name == "unit") {
+                return Field::Unit;
+            }
+            break;
+        case Scope::Frame:
+            if (name == "timestamp") {
+                return Field::Timestamp;
+            }
+            if (name == "sourceId") {
+                return Field::SourceId;
+            }
+            if (name == "sourceName") {
+                return Field::SourceName;
+            }
+            if (name == "points") {
+                return Field::Points;
+            }
+            break;
+        case Scope::Point:
+            if (name == "channelId") {
+                return Field::ChannelId;
+            }
+            if (name == "numeric") {
+                return Field::Numeric;
+            }
+            if (name == "waveform") {
+                return Field::Waveform;
+            }
+            if (name == "serial") {
+                return Field::Serial;
+            }
+            if (name == "logic") {
+                return Field::Logic;
+            }
+            if (name == "gpio") {
+                return Field::Gpio;
+            }
+            break;
+        case Scope::Numeric:
+            if (name == "value") {
+                return Field::Value;
+            }
+            if (name == "unit") {
+                return Field::Unit;
+            }
+            break;
+        case Scope::Waveform:
+            if (name == "samples") {
+                return Field::Samples;
+            }
+            if (name == "sampleRate") {
+                return Field::SampleRate;
+            }
+            break;
+        case Scope::Serial:
+            if (name == "text") {
+                return Field::Text;
+            }
+            break;
+        case Scope::Logic:
+            if (name == "channels") {
+                return Field::Channels;
+            }
+            if (name == "channelCount") {
+                return Field::ChannelCount;
+            }
+            if (name == "words") {
+                return Field::Words;
+            }
+            if (name == "periodNs") {
+                return Field::PeriodNs;
+            }
+            break;
+        case Scope::Gpio:
+            if (name == "pins") {
+                return Field::Pins;
+            }
+            break;
+        default:
+            break;
+        }
+        return Field::None;
+    }
+
+    bool number(double value, std::int64_t integer)
+    {
+        switch (top()) {
+        case Scope::Samples:
+            // Waveform samples land directly in the destination vector.
+            samples_->push_back(value);
+            break;
+        case Scope::LogicBits:
+        case Scope::GpioBits:
+            appendBit(value != 0.0);
+            break;
+        case Scope::LogicWords:
+            // Negative or fractional words are malformed input; keep the slot so
+            // slice alignment survives.
+            logicWords_->push_back(integer > 0 ? static_cast<std::uint64_t>(integer) : 0);
+            break;
+        case Scope::Frame:
+            if (field_ == Field::Timestamp) {
+                timestampSeconds_ = value;
+                timestampSeen_ = true;
+            }
+            break;
+        case Scope::Numeric:
+            if (field_ == Field::Value) {
+                std::get<core::NumericSample>(point_->payload).value = value;
+            }
+            break;
+        case Scope::Waveform:
+            if (field_ == Field::SampleRate) {
+                std::get<core::WaveformSample>(point_->payload).sampleRateHz = value;
+            }
+            break;
+        case Scope::Logic:
+            if (field_ == Field::PeriodNs) {
+                std::get<core::LogicSample>(point_->payload).samplePeriod = std::chrono::nanoseconds(integer);
+            } else if (field_ == Field::ChannelCount) {
+                std::get<core::LogicSample>(point_->payload).channelCount = static_cast<std::uint32_t>(std::clamp<std::int64_t>(integer, 0, kMaxLogicChannels));
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    void beginSource()
+    {
+        auto& source = out_.source;
+        out_.hasSource = true;
+        source.id.clear();
+        source.name.clear();
+        source.kind = core::DataKind::Custom;
+        source.description.clear();
+        source.unit.reset();
+        sourceNameSeen_ = false;
+    }
+
+    void beginFrame()
+    {
+        out_.hasFrame = true;
+        frameSourceIdSeen_ = false;
+        frameSourceNameSeen_ = false;
+        timestampSeen_ = false;
+        pointCount_ = 0;
+    }
+
+    void beginPoint()
+    {
+        // Reuse the point (and its payload buffers) left from the previous message.
+        auto& points = out_.frame.points;
+        if (pointCount_ == points.size()) {
+            points.emplace_back();
+        }
+        point_ = &points[pointCount_++];
+        point_->channelId.clear();
+        point_->payload = std::monostate {};
+        payloadRank_ = 0;
+    }
+
+    Scope beginPayload(Field field)
+    {
+        const int rank = PayloadRank(field);
+        if (rank == 0 || (payloadRank_ != 0 && rank > payloadRank_)) {
+            return Scope::Skip;
+        }
+        payloadRank_ = rank;
+        switch (field) {
+        case Field::Numeric: {
+            auto& sample = PayloadAs<core::NumericSample>(*point_);
+            sample.value = 0.0;
+            sample.unit.clear();
+            return Scope::Numeric;
+        }
+        case Field::Waveform: {
+            auto& sample = PayloadAs<core::WaveformSample>(*point_);
+            sample.samples.clear();
+            sample.sampleRateHz = 0.0;
+            return Scope::Waveform;
+        }
+        case Field::Serial:
+            PayloadAs<core::SerialSample>(*point_).text.clear();
+            return Scope::Serial;
+        case Field::Logic: {
+            auto& sample = PayloadAs<core::LogicSample>(*point_);
+            sample.channelCount = 0;
+            sample.words.clear();
+            sample.samplePeriod = std::chrono::nanoseconds { 0 };
+            return Scope::Logic;
+        }
+        case Field::Gpio:
+            PayloadAs<core::GpioState>(*point_).pins.clear();
+            return Scope::Gpio;
+        default:
+            return Scope::Skip;
+        }
+    }
+
+    void appendBit(bool value)
+    {
+        if (*bitCount_ % 64 == 0) {
+            bitWords_->push_back(0);
+        }
+        if (value) {
+            bitWords_->back() |= std::uint64_t { 1 } << (*bitCount_ % 64);
+        }
+        ++*bitCount_;
+    }
+
+    DataFrameNotification& out_;
+    static constexpr std::size_t kMaxDepth = 16;
+    std::array<Scope, kMaxDepth> scopes_ {};
+    std::size_t depth_ { 0 };
+    Field field_ { Field::None };
+
+    core::DataPoint* point_ { nullptr };
+    std::vector<double>* samples_ { nullptr };
+    std::vector<std::uint64_t>* bitWords_ { nullptr };
+    std::uint32_t* bitCount_ { nullptr };
+    std::vector<std::uint64_t>* logicWords_ { nullptr };
+    std::size_t pointCount_ { 0 };
+    int payloadRank_ { 0 };
+
+    double timestampSeconds_ { 0.0 };
+    bool timestampSeen_ { false };
+    bool sourceNameSeen_ { false };
+    bool frameSourceIdSeen_ { false };
+    bool frameSourceNameSeen_ { false };
+    bool isDataFrame_ { false };
+    bool malformed_ { false };
+};
+
+} // namespace
+
+DecodeStatus DecodeDataFrameNotification(std::string_view message, DataFrameNotification& out)
+{
+    DataFrameSax sax(out);
+    const bool completed = json::sax_parse(message.begin(), message.end(), &sax);
+    if (sax.malformed()) {
+        return DecodeStatus::Malformed;
+    }
+    if (!completed || !sax.isDataFrame()) {
+        return DecodeStatus::NotDataFrame;
+    }
+    sax.finish();
+    return DecodeStatus::Decoded;
+}
+
+core::DataKind ParseKind(std::string_view text)
+{
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (lower == "numeric") {
+        return core::DataKind::Numeric;
+    }
+    if (lower == "waveform") {
+        return core::DataKind::Waveform;
+    }
+    if (lower == "serial") {
+        return core::DataKind::Serial;
+    }
+    if (lower == "logic") {
+        return core::DataKind::Logic;
+    }
+    if (lower == "gpiostate" || lower == "gpio") {
+        return core::DataKind::GpioState;
+    }
+    return core::DataKind::Custom;
+}
+
+} // namespace hardware
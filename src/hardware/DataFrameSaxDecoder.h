@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/Types.h"
+
+#include <string_view>
+
+namespace hardware {
+
+/**
+ * @brief Output of the streaming `workbench.dataFrame` decoder.
+ *
+ * Kept alive across messages by the caller: points, strings and sample vectors
+ * are overwritten in place, so steady-state decoding does not allocate.
+ */
+struct DataFrameNotification {
+    core::DataFrame frame;
+    core::SourceMetadata source;
+    bool hasSource{false};
+    bool hasFrame{false};
+};
+
+enum class DecodeStatus {
+    Decoded,
+    // Valid JSON, but not a `workbench.dataFrame` notification.
+    NotDataFrame,
+    Malformed,
+};
+
+// Streams a newline-JSON message straight into `out` without building a DOM.
+// Missing fields get the same defaults as the schema in hardware/README.md.
+DecodeStatus DecodeDataFrameNotification(std::string_view message, DataFrameNotification& out);
+
+core::DataKind ParseKind(std::string_view text);
+
+}  // namespace hardware
@@ -0,0 +1,177 @@
+#include "hardware/DecodePipeline.h"
+
+#include "core/Metrics.h"
+#include "hardware/BinaryFrameCodec.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+namespace {
+
+// Decoding one relay data frame (JSON or binary) into its reused DataFrame.
+const core::metrics::Histogram kParseTime { "ingest.parse" };
+// Jobs queued for a decoder, and jobs taken from the pool but not yet committed.
+const core::metrics::Gauge kQueueDepth { "decode.queue" };
+const core::metrics::Gauge kInFlight { "decode.inflight" };
+// Times the reader found every job in flight and had to wait.
+const core::metrics::Counter kReaderStalls { "decode.stalls" };
+
+} // namespace
+
+namespace hardware {
+
+DecodeStatus DecodeRelayMessage(std::string_view message, bool binary, DataFrameNotification& out)
+{
+    const auto parseStart = std::chrono::steady_clock::now();
+    DecodeStatus status = DecodeStatus::Decoded;
+    if (binary) {
+        out.hasSource = false;
+        out.hasFrame = binary::DecodeDataFrame(message, out.frame);
+        status = out.hasFrame ? DecodeStatus::Decoded : DecodeStatus::Malformed;
+    } else {
+        status = DecodeDataFrameNotification(message, out);
+    }
+    if (status != DecodeStatus::NotDataFrame) {
+        kParseTime.record(std::chrono::steady_clock::now() - parseStart);
+    }
+    return status;
+}
+
+DecodePipeline::DecodePipeline(std::size_t workers, std::size_t depth)
+    : depth_(std::max<std::size_t>(depth, 1))
+    , mask_(std::bit_ceil(depth_) - 1)
+    , free_(depth_)
+    , work_(depth_)
+    , freeCount_(0)
+    , workCount_(0)
+{
+    jobs_.reserve(depth_);
+    for (std::size_t i = 0; i < depth_; ++i) {
+        jobs_.push_back(std::make_unique<Job>());
+        free_.tryPush(jobs_.back().get());
+    }
+    freeCount_.release(static_cast<std::ptrdiff_t>(depth_));
+    threads_.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back(&DecodePipeline::workerLoop, this);
+    }
+}
+
+DecodePipeline::~DecodePipeline()
+{
+    // Nothing may be left half way: commit callbacks refer to their owners.
+    for (std::int64_t pending = inFlight_.load(); pending != 0; pending = inFlight_.load()) {
+        inFlight_.wait(pending);
+    }
+    stopping_.store(true);
+    workCount_.release(static_cast<std::ptrdiff_t>(threads_.size()));
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void DecodePipeline::attach(Stream& stream)
+{
+    stream.slots = std::make_unique<std::atomic<Job*>[]>(mask_ + 1);
+    stream.submitted = 0;
+    stream.nextCommit.store(0);
+}
+
+DecodePipeline::Job& DecodePipeline::acquire(Stream& stream)
+{
+    if (!freeCount_.try_acquire()) {
+        kReaderStalls.add();
+        freeCount_.acquire();
+    }
+    Job* job = nullptr;
+    // The count guarantees a job is on its way, but with several workers releasing at
+    // once the one it stands for may sit behind a cell another worker has claimed and
+    // not yet published; wait for that instead of taking an empty pop for an answer.
+    while (!free_.tryPop(job)) {
+        std::this_thread::yield();
+    }
+    job->stream = &stream;
+    job->sequence = stream.submitted++;
+    kInFlight.set(inFlight_.fetch_add(1) + 1);
+    return *job;
+}
+
+void DecodePipeline::submit(Job& job)
+{
+    work_.tryPush(&job);
+    workCount_.release();
+    kQueueDepth.set(static_cast<std::int64_t>(work_.size()));
+}
+
+void DecodePipeline::drain(Stream& stream)
+{
+    if (!stream.slots) {
+        return;
+    }
+    for (auto committed = stream.nextCommit.load(); committed != stream.submitted; committed = stream.nextCommit.load()) {
+        stream.nextCommit.wait(committed);
+    }
+}
+
+void DecodePipeline::workerLoop()
+{
+    for (;;) {
+        workCount_.acquire();
+        Job* job = nullptr;
+        // Each count is one job (or, once stopping, one wakeup); a pop that finds the
+        // job not yet published retries rather than dropping the count.
+        while (!work_.tryPop(job)) {
+            if (stopping_.load()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        job->status = DecodeRelayMessage(job->bytes, job->binary, job->decoded);
+        complete(*job);
+    }
+}
+
+void DecodePipeline::complete(Job& job)
+{
+    Stream& stream = *job.stream;
+    // Sequentially consistent throughout: the hand-over below is a store-then-load on
+    // both sides (slot then flag here, flag then slot for the committer), which
+    // acquire/release alone would let both sides miss.
+    stream.slots[job.sequence & mask_].store(&job);
+    while (!stream.committing.exchange(true)) {
+        for (;;) {
+            const std::uint64_t next = stream.nextCommit.load(std::memory_order_relaxed);
+            auto& slot = stream.slots[next & mask_];
+            Job* ready = slot.load();
+            if (!ready) {
+                break;
+            }
+            slot.store(nullptr, std::memory_order_relaxed);
+            stream.commit(*ready);
+            release(*ready);
+            stream.nextCommit.store(next + 1);
+            stream.nextCommit.notify_all();
+        }
+        stream.committing.store(false);
+        // A job stored after the last look may have found the flag still set and left
+        // it to us; take the stream again if so.
+        if (!stream.slots[stream.nextCommit.load() & mask_].load()) {
+            break;
+        }
+    }
+}
+
+void DecodePipeline::release(Job& job)
+{
+    job.stream = nullptr;
+    free_.tryPush(&job);
+    freeCount_.release();
+    const auto remaining = inFlight_.fetch_sub(1) - 1;
+    kInFlight.set(remaining);
+    if (remaining == 0) {
+        inFlight_.notify_all();
+    }
+}
+
+}  // namespace hardware
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "core/MpmcQueue.h"
+#include "hardware/DataFrameSaxDecoder.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hardware {
+
+// Decodes one relay message into `out`: a binary protocol-2 data frame payload when
+// `binary` is set, otherwise newline JSON (which may turn out not to be a data frame).
+DecodeStatus DecodeRelayMessage(std::string_view message, bool binary, DataFrameNotification& out);
+
+/**
+ * @brief Decodes relay messages on worker threads and commits them in arrival order.
+ *
+ * The reader copies each framed message into a pooled job and queues it; any of
+ * the workers decodes it; then the job waits in its stream's reorder ring until
+ * every earlier job of that stream has been committed. Whichever worker finds the
+ * next job ready runs the stream's commit callback for it and for everything
+ * ready behind it, so commits of one stream are serialised and in order (and
+ * per-source frame order is kept) while decoding runs in parallel.
+ *
+ * The job pool bounds the messages in flight; when it runs dry the reader waits,
+ * which pushes back on the socket. Jobs keep their buffers, so the steady state
+ * does not allocate.
+ */
+class DecodePipeline {
+public:
+    struct Stream;
+
+    struct Job {
+        // Set by the reader.
+        Stream* stream{nullptr};
+        std::uint64_t sequence{0};
+        bool binary{false};
+        std::string bytes;
+        // Set by the decoder.
+        DecodeStatus status{DecodeStatus::NotDataFrame};
+        DataFrameNotification decoded;
+    };
+
+    // One ordered sequence of messages, usually a relay connection.
+    struct Stream {
+        // Runs on a worker, never concurrently with itself for the same stream.
+        std::function<void(Job&)> commit;
+
+    private:
+        friend class DecodePipeline;
+        // Reader only.
+        std::uint64_t submitted{0};
+        std::unique_ptr<std::atomic<Job*>[]> slots;
+        std::atomic<bool> committing{false};
+        std::atomic<std::uint64_t> nextCommit{0};
+    };
+
+    static constexpr std::size_t kDefaultDepth = 64;
+
+    DecodePipeline(std::size_t workers, std::size_t depth = kDefaultDepth);
+    ~DecodePipeline();
+
+    DecodePipeline(const DecodePipeline&) = delete;
+    DecodePipeline& operator=(const DecodePipeline&) = delete;
+
+    // Prepares `stream` for submissions; call once before its first acquire().
+    void attach(Stream& stream);
+    // A free job for `stream`, waiting for one if `depth` messages are in flight.
+    Job& acquire(Stream& stream);
+    void submit(Job& job);
+    // Waits until everything submitted on `stream` has been committed.
+    void drain(Stream& stream);
+
+    [[nodiscard]] std::size_t workers() const { return threads_.size(); }
+
+private:
+    void workerLoop();
+    void complete(Job& job);
+    void release(Job& job);
+
+    std::size_t depth_;
+    std::size_t mask_;
+    std::vector<std::unique_ptr<Job>> jobs_;
+    core::MpmcQueue<Job*> free_;
+    core::MpmcQueue<Job*> work_;
+    std::counting_semaphore<> freeCount_;
+    std::counting_semaphore<> workCount_;
+    std::atomic<std::int64_t> inFlight_{0};
+    std::atomic<bool> stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace hardware
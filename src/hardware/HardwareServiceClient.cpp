@@ -1,13 +1,18 @@
 #include "hardware/HardwareServiceClient.h"
 
+#include "core/ColumnarFrame.h"
 #include "core/DataRegistry.h"
+#include "core/Metrics.h"
 #include "core/Types.h"
+#include "hardware/BinaryFrameCodec.h"
+#include "hardware/DataFrameSaxDecoder.h"
 #include <spdlog/spdlog.h>
 
 #include "flags.h"
 #include <algorithm>
+#include <array>
 #include <atomic>
-#include <cctype>
+#include <climits>
 #include <cstring>
 #include <iomanip>
 #include <nlohmann/json.hpp>
@@ -37,57 +42,78 @@ public:
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 namespace {
 
-core::DataKind ParseKind(const std::string& text)
+const core::metrics::Counter kFramesIngested { "ingest.frames" };
+const core::metrics::Counter kMalformedFrames { "ingest.malformed" };
+const core::metrics::Counter kRelayConnects { "relay.connects" };
+const core::metrics::Counter kRelayDisconnects { "relay.disconnects" };
+
+// Bounds the recv() calls per readiness event, so one busy relay cannot starve the
+// others sharing the loop. The socket is level-triggered and reports again.
+constexpr int kReadsPerEvent = 8;
+// How often lingering subscriptions and request deadlines are checked while there
+// are any.
+constexpr int kSweepPollMs = 250;
+
+const char* DecimationName(hardware::Decimation decimation)
 {
-    std::string lower = text;
-    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    if (lower == "numeric") {
-        return core::DataKind::Numeric;
-    }
-    if (lower == "waveform") {
-        return core::DataKind::Waveform;
+    using hardware::Decimation;
+    switch (decimation) {
+    case Decimation::Last:
+        return "last";
+    case Decimation::Mean:
+        return "mean";
+    case Decimation::MinMax:
+        return "minmax";
+    case Decimation::None:
+        break;
     }
-    if (lower == "serial") {
-        return core::DataKind::Serial;
-    }
-    if (lower == "logic") {
-        return core::DataKind::Logic;
-    }
-    if (lower == "gpiostate" || lower == "gpio") {
-        return core::DataKind::GpioState;
-    }
-    return core::DataKind::Custom;
+    return "none";
+}
+
+std::string ToJsonRpcId(uint64_t counter)
+{
+    return "ui-" + std::to_string(counter);
 }
 
-std::chrono::system_clock::time_point ParseTimestamp(const nlohmann::json& value)
+std::string Describe(const hardware::RelayEndpoint& endpoint)
 {
-    if (value.is_number()) {
-        const double seconds = value.get<double>();
-        auto duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(
-            std::chrono::duration<double>(seconds));
-        return std::chrono::system_clock::time_point(duration);
+    if (endpoint.name.empty()) {
+        return "'" + endpoint.socketPath + "'";
     }
-    if (value.is_string()) {
-        const std::string text = value.get<std::string>();
-        try {
-            double seconds = std::stod(text);
-            auto duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(
-                std::chrono::duration<double>(seconds));
-            return std::chrono::system_clock::time_point(duration);
-        } catch (...) {
-            // fall through
-        }
+    return "'" + endpoint.name + "' (" + endpoint.socketPath + ")";
+}
+
+// The registry's view of a relay source: namespaced id, and the relay named in the title.
+core::SourceMetadata Published(const hardware::RelayEndpoint& endpoint, const std::string& prefix,
+    core::SourceMetadata metadata)
+{
+    if (!prefix.empty()) {
+        metadata.id.insert(0, prefix);
+        metadata.name += " (" + endpoint.name + ")";
     }
-    return std::chrono::system_clock::now();
+    return metadata;
 }
 
-std::string ToJsonRpcId(uint64_t counter)
+nlohmann::json ClientError(const std::string& message)
 {
-    return "ui-" + std::to_string(counter);
+    return { { "code", hardware::HardwareServiceClient::kClientErrorCode }, { "message", message } };
+}
+
+void CloseFd(int& fd)
+{
+#ifndef _WIN32
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+    fd = -1;
 }
 
 } // namespace
@@ -102,6 +128,8 @@ HardwareServiceClient::HardwareServiceClient(core::DataRegistry& registry)
 HardwareServiceClient::~HardwareServiceClient()
 {
     stop();
+    // Waits for frames still decoding from injectRelayBytes().
+    pipeline_.reset();
 }
 
 void HardwareServiceClient::configure(Options options)
@@ -123,7 +151,7 @@ void HardwareServiceClient::start()
     // during UI bootstrap, then start a mock publisher thread.
     if (options_.enableMock) {
         const std::string sourceId = "mock.12v";
-        // Register metadata for mock source synchronously so the UI can discover it.
+        // Register metadata for mock sources synchronously so the UI can discover them.
         core::SourceMetadata meta;
         meta.id = sourceId;
         meta.name = "12V Supply";
@@ -132,45 +160,130 @@ void HardwareServiceClient::start()
         registry_.registerSource(meta);
         spdlog::info("HardwareServiceClient: registered mock source '{}'", meta.id);
 
-        // Start a light-weight mock worker that publishes a 1Hz sine wave
+        core::SourceMetadata scopeMeta;
+        scopeMeta.id = "mock.scope";
+        scopeMeta.name = "Mock Scope";
+        scopeMeta.kind = core::DataKind::Waveform;
+        scopeMeta.unit = std::string("V");
+        registry_.registerSource(scopeMeta);
+
+        core::SourceMetadata logicMeta;
+        logicMeta.id = "mock.logic";
+        logicMeta.name = "Mock Logic";
+        logicMeta.kind = core::DataKind::Logic;
+        registry_.registerSource(logicMeta);
+
+        // Start a light-weight mock worker that publishes a 1Hz sine wave, a scope trace
+        // and an 8-line logic capture.
         worker_ = std::thread([this, sourceId]() {
             using namespace std::chrono_literals;
-            const std::string channelId = "12v";
+            // High-rate style publisher: interned ids and one reused columnar frame.
+            const core::Symbol channel = registry_.intern("12v");
+            const core::Symbol unit = registry_.intern("V");
+            core::ColumnarFrame frame;
+            frame.sourceId = sourceId;
+            frame.sourceName = "12V Supply";
+
+            const core::Symbol scopeChannel = registry_.intern("ch1");
+            core::ColumnarFrame scopeFrame;
+            scopeFrame.sourceId = "mock.scope";
+            scopeFrame.sourceName = "Mock Scope";
+            std::vector<double> trace(1000);
+            const double scopeRateHz = 100000.0;
+
+            // Counter on lines 0-6 plus a slow enable on line 7, 10 ns per slice.
+            core::DataFrame logicFrame;
+            std::uint64_t logicSlice = 0;
+            const std::size_t slicesPerFrame = 4096;
 
             const double amplitude = 0.5; // +/-0.5V
             const double offset = 12.0; // center 12V
             const double freqHz = 1.0; // 1 Hz
             const auto period = std::chrono::milliseconds(20); // 50 Hz update
             auto start = std::chrono::steady_clock::now();
+            std::uint64_t tick = 0;
             while (running_) {
                 auto now = std::chrono::steady_clock::now();
                 std::chrono::duration<double> t = now - start;
                 double angle = 2.0 * M_PI * freqHz * t.count();
                 double value = offset + amplitude * std::sin(angle);
 
-                core::NumericSample sample;
-                sample.value = value; // ensure double
-                sample.unit = "V";
-                sample.timestamp = std::chrono::system_clock::now();
+                frame.clear();
+                frame.timestamp = std::chrono::system_clock::now();
+                frame.addNumeric(channel, value, unit, frame.timestamp);
 
-                core::DataPoint point;
-                point.channelId = channelId;
-                point.payload = sample;
+                registry_.update(frame);
 
-                core::DataFrame frame;
-                frame.sourceId = sourceId;
-                frame.sourceName = "12V Supply";
-                frame.timestamp = sample.timestamp;
-                frame.points.push_back(std::move(point));
+                // 1 kHz sine with a slowly drifting phase and a little third harmonic.
+                for (std::size_t i = 0; i < trace.size(); ++i) {
+                    const double ts = static_cast<double>(i) / scopeRateHz;
+                    trace[i] = std::sin(2.0 * M_PI * 1000.0 * ts + angle) + 0.2 * std::sin(2.0 * M_PI * 3000.0 * ts);
+                }
+                scopeFrame.clear();
+                scopeFrame.timestamp = frame.timestamp;
+                scopeFrame.addWaveform(scopeChannel, trace, scopeRateHz, scopeFrame.timestamp);
+                registry_.update(scopeFrame);
 
-                registry_.update(frame);
-                spdlog::trace("HardwareServiceClient: published mock frame {} -> {}", frame.sourceId, value);
+                // The frame handed back by update(DataFrame&&) is a recycled one; refill it.
+                logicFrame.sourceId = "mock.logic";
+                logicFrame.sourceName = "Mock Logic";
+                logicFrame.timestamp = frame.timestamp;
+                logicFrame.points.resize(1);
+                logicFrame.points[0].channelId = "bus";
+                auto* logic = std::get_if<core::LogicSample>(&logicFrame.points[0].payload);
+                if (!logic) {
+                    logic = &logicFrame.points[0].payload.emplace<core::LogicSample>();
+                }
+                logic->channelCount = 8;
+                logic->samplePeriod = std::chrono::nanoseconds { 10 };
+                logic->timestamp = frame.timestamp;
+                logic->words.resize(slicesPerFrame);
+                const std::uint64_t enable = (tick / 25) % 2 == 0 ? 0x80 : 0;
+                for (auto& word : logic->words) {
+                    word = ((logicSlice++ >> 3) & 0x7F) | enable;
+                }
+                registry_.update(std::move(logicFrame));
+                ++tick;
 
                 std::this_thread::sleep_for(period);
             }
         });
     } else {
+#ifdef __linux__
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event wakeEvent {};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.ptr = nullptr;
+        if (epollFd_ < 0 || wakeFd_ < 0 || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &wakeEvent) != 0) {
+            spdlog::error("HardwareServiceClient: failed to set up the ingest loop: {}", std::strerror(errno));
+            CloseFd(wakeFd_);
+            CloseFd(epollFd_);
+            running_ = false;
+            return;
+        }
+        {
+            std::lock_guard lock(subscriptionsMutex_);
+            auto endpoints = options_.endpoints;
+            if (endpoints.empty()) {
+                endpoints.push_back({ "", options_.socketPath });
+            }
+            for (auto& endpoint : endpoints) {
+                auto connection = std::make_unique<Connection>();
+                connection->prefix = endpoint.name.empty() ? std::string() : endpoint.name + ":";
+                connection->endpoint = std::move(endpoint);
+                connection->backoff = options_.reconnectDelay;
+                connections_.push_back(std::move(connection));
+            }
+        }
+        createPipeline();
+        for (auto& connection : connections_) {
+            attachStream(*connection);
+        }
         worker_ = std::thread(&HardwareServiceClient::run, this);
+#else
+        spdlog::warn("HardwareServiceClient: relay ingest needs epoll (Linux); the client remains dormant");
+#endif
     }
 #endif
 }
@@ -184,184 +297,626 @@ void HardwareServiceClient::stop()
         return;
     }
     running_ = false;
-    closeSocket();
+    wake();
     if (worker_.joinable()) {
         worker_.join();
     }
+    // Commits still running refer to the connections.
+    pipeline_.reset();
+    {
+        std::lock_guard lock(subscriptionsMutex_);
+        connections_.clear();
+        CloseFd(wakeFd_);
+        CloseFd(epollFd_);
+    }
+    failPending(nullptr, "the hardware client stopped");
 #endif
 }
 
-void HardwareServiceClient::subscribeSource(const std::string& sourceId)
+int HardwareServiceClient::subscribeSource(const std::string& sourceId, SubscribeOptions options)
 {
     if (sourceId.empty()) {
+        return 0;
+    }
+    std::lock_guard lock(subscriptionsMutex_);
+    expireLingeringLocked(std::chrono::steady_clock::now());
+    const int token = nextSubscriptionToken_++;
+    auto [it, created] = subscriptions_.try_emplace(sourceId);
+    auto& subscription = it->second;
+    if (!created && subscription.requests.empty()) {
+        // Picked up again within the linger period; the relay is still streaming it.
+        lingering_.fetch_sub(1);
+    }
+    subscription.requests.emplace(token, options);
+    subscriptionSources_.emplace(token, sourceId);
+
+    const auto merged = MergeRequests(subscription);
+    if (created || merged != subscription.effective) {
+        subscription.effective = merged;
+        sendSubscriptionMessage(sourceId, merged);
+    }
+    return token;
+}
+
+void HardwareServiceClient::unsubscribeSource(int token)
+{
+    std::lock_guard lock(subscriptionsMutex_);
+    const auto now = std::chrono::steady_clock::now();
+    expireLingeringLocked(now);
+    const auto tokenIt = subscriptionSources_.find(token);
+    if (tokenIt == subscriptionSources_.end()) {
         return;
     }
-    bool shouldSend = false;
-    {
-        std::lock_guard lock(subscriptionsMutex_);
-        if (std::find(subscribedSources_.begin(), subscribedSources_.end(), sourceId) == subscribedSources_.end()) {
-            subscribedSources_.push_back(sourceId);
-            shouldSend = true;
+    const std::string sourceId = std::move(tokenIt->second);
+    subscriptionSources_.erase(tokenIt);
+
+    const auto it = subscriptions_.find(sourceId);
+    if (it == subscriptions_.end()) {
+        return;
+    }
+    auto& subscription = it->second;
+    subscription.requests.erase(token);
+    if (subscription.requests.empty()) {
+        if (options_.subscriptionLinger.count() > 0) {
+            // Keep the relay's stream (and its effective options) for a while.
+            subscription.lingerUntil = now + options_.subscriptionLinger;
+            lingering_.fetch_add(1);
+            return;
         }
+        subscriptions_.erase(it);
+        sendUnsubscribeMessage(sourceId);
+        return;
     }
-    if (shouldSend) {
-        sendSubscriptionMessage(sourceId);
+    // The departing consumer may have been the most demanding one.
+    const auto merged = MergeRequests(subscription);
+    if (merged != subscription.effective) {
+        subscription.effective = merged;
+        sendSubscriptionMessage(sourceId, merged);
     }
 }
 
-void HardwareServiceClient::unsubscribeSource(const std::string& sourceId)
+void HardwareServiceClient::expireLingeringLocked(std::chrono::steady_clock::time_point now)
 {
-    if (sourceId.empty()) {
+    if (lingering_.load() == 0) {
         return;
     }
-    bool shouldSend = false;
-    {
-        std::lock_guard lock(subscriptionsMutex_);
-        const auto it = std::remove(subscribedSources_.begin(), subscribedSources_.end(), sourceId);
-        if (it != subscribedSources_.end()) {
-            subscribedSources_.erase(it, subscribedSources_.end());
-            shouldSend = true;
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+        if (it->second.requests.empty() && it->second.lingerUntil <= now) {
+            sendUnsubscribeMessage(it->first);
+            it = subscriptions_.erase(it);
+            lingering_.fetch_sub(1);
+        } else {
+            ++it;
         }
     }
-    if (shouldSend) {
-        sendUnsubscribeMessage(sourceId);
+}
+
+SubscribeOptions HardwareServiceClient::MergeRequests(const SourceSubscription& subscription)
+{
+    // Unlimited (0) beats any limit, otherwise the highest limit wins. Decimation is only
+    // requested when every consumer agrees on it; mixed needs get unreduced data.
+    SubscribeOptions merged;
+    bool first = true;
+    for (const auto& [_, request] : subscription.requests) {
+        if (first) {
+            merged = request;
+            first = false;
+            continue;
+        }
+        merged.maxRateHz = (merged.maxRateHz <= 0.0 || request.maxRateHz <= 0.0)
+            ? 0.0
+            : std::max(merged.maxRateHz, request.maxRateHz);
+        merged.waveformPointBudget = (merged.waveformPointBudget == 0 || request.waveformPointBudget == 0)
+            ? 0
+            : std::max(merged.waveformPointBudget, request.waveformPointBudget);
+        if (merged.decimation != request.decimation) {
+            merged.decimation = Decimation::None;
+        }
     }
+    return merged;
 }
 
 void HardwareServiceClient::requestMetricReset(const std::string& sourceId,
     const std::string& channelId,
-    const std::string& metric)
+    const std::string& metric,
+    ResponseHandler onDone)
 {
+    std::string failure;
     if (sourceId.empty() || channelId.empty() || metric.empty()) {
+        failure = "sourceId, channelId and metric are required";
+    } else {
+        std::lock_guard lock(subscriptionsMutex_);
+        std::string relayId;
+        Connection* connection = route(sourceId, relayId);
+        if (!connection) {
+            failure = "no relay serves '" + sourceId + "'";
+        } else {
+            const auto request = makeRequest("workbench.resetMetric",
+                {
+                    { "sourceId", relayId },
+                    { "channelId", channelId },
+                    { "metric", metric },
+                });
+            if (!sendRequest(*connection, request, onDone)) {
+                failure = "relay " + Describe(connection->endpoint) + " is not connected";
+            }
+        }
+    }
+    if (!failure.empty() && onDone) {
+        onDone(false, ClientError(failure));
+    }
+}
+
+void HardwareServiceClient::injectRelayBytes(std::string_view bytes, bool binaryFraming)
+{
+    if (!pipeline_) {
+        createPipeline();
+    }
+    injected_.binaryFraming = binaryFraming;
+    while (!bytes.empty()) {
+        const auto space = injected_.readBuffer.prepareWrite();
+        const std::size_t count = std::min(space.size(), bytes.size());
+        std::memcpy(space.data(), bytes.data(), count);
+        injected_.readBuffer.commitWrite(count);
+        bytes.remove_prefix(count);
+        drainReadBuffer(injected_);
+    }
+}
+
+void HardwareServiceClient::createPipeline()
+{
+    std::size_t workers = 0;
+    if (options_.decodeWorkers < 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        workers = cores > 1 ? std::min<std::size_t>(cores - 1, 3) : 0;
+    } else {
+        workers = static_cast<std::size_t>(options_.decodeWorkers);
+    }
+    if (workers == 0) {
         return;
     }
-    nlohmann::json request {
-        { "jsonrpc", "2.0" },
-        { "id", nextRequestId() },
-        { "method", "workbench.resetMetric" },
-        { "params",
-            {
-                { "sourceId", sourceId },
-                { "channelId", channelId },
-                { "metric", metric },
-            } }
+    pipeline_ = std::make_unique<DecodePipeline>(workers);
+    attachStream(injected_);
+    spdlog::info("HardwareServiceClient: decoding on {} workers", workers);
+}
+
+void HardwareServiceClient::attachStream(Connection& connection)
+{
+    if (!pipeline_) {
+        return;
+    }
+    connection.stream.commit = [this, &connection](DecodePipeline::Job& job) {
+        commitMessage(connection, job.status, job.bytes, job.decoded);
     };
-    sendJson(request);
+    pipeline_->attach(connection.stream);
 }
 
 void HardwareServiceClient::run()
 {
-#ifndef _WIN32
+#ifdef __linux__
+    std::array<epoll_event, 16> events {};
+    const auto begin = std::chrono::steady_clock::now();
+    for (auto& connection : connections_) {
+        connection->retryAt = begin;
+    }
+
     while (running_) {
-        try {
-            connectSocket();
-            sendRegisterClient();
-            resendSubscriptions();
-            readLoop();
-        } catch (const std::exception& ex) {
-            // For now, swallow the exception. Detailed logging will be added later.
-            (void)ex;
+        const auto now = std::chrono::steady_clock::now();
+        if (lingering_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(subscriptionsMutex_);
+            expireLingeringLocked(now);
+        }
+        if (pendingCount_.load(std::memory_order_relaxed) > 0) {
+            expirePending(now);
+        }
+        for (auto& connection : connections_) {
+            if (connection->fd < 0 && connection->retryAt <= now) {
+                beginConnect(*connection);
+            }
+            if (connection->connected) {
+                flushOutbox(*connection);
+            }
         }
 
-        if (!running_) {
+        const int count = ::epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), nextTimeoutMs(now));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("HardwareServiceClient: epoll_wait failed: {}", std::strerror(errno));
             break;
         }
-        std::this_thread::sleep_for(options_.reconnectDelay);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                // Queued sends are flushed at the top of the loop.
+                std::uint64_t value = 0;
+                (void)!::read(wakeFd_, &value, sizeof(value));
+                continue;
+            }
+            handleEvents(*static_cast<Connection*>(events[i].data.ptr), events[i].events);
+        }
+    }
+
+    for (auto& connection : connections_) {
+        CloseFd(connection->fd);
+        connection->connected = false;
     }
 #endif
 }
 
-void HardwareServiceClient::connectSocket()
+int HardwareServiceClient::nextTimeoutMs(std::chrono::steady_clock::time_point now) const
 {
-#ifndef _WIN32
-    closeSocket();
-
-    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
-    if (fd == -1) {
-        throw std::runtime_error("HardwareServiceClient: failed to create socket");
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    for (const auto& connection : connections_) {
+        if (connection->fd < 0) {
+            deadline = std::min(deadline, connection->retryAt);
+        }
+    }
+    int timeout = -1;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        // Rounded up, so the loop does not spin through the last partial millisecond.
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+        timeout = static_cast<int>(std::clamp<std::int64_t>(wait, 0, INT_MAX));
+    }
+    if (lingering_.load(std::memory_order_relaxed) > 0 || pendingCount_.load(std::memory_order_relaxed) > 0) {
+        timeout = timeout < 0 ? kSweepPollMs : std::min(timeout, kSweepPollMs);
     }
+    return timeout;
+}
 
+void HardwareServiceClient::beginConnect(Connection& connection)
+{
+#ifdef __linux__
+    const auto& path = connection.endpoint.socketPath;
     sockaddr_un addr {};
-    std::memset(&addr, 0, sizeof(addr));
     addr.sun_family = AF_UNIX;
-    if (options_.socketPath.size() >= sizeof(addr.sun_path)) {
-        ::close(fd);
-        throw std::runtime_error("HardwareServiceClient: socket path is too long");
+    if (path.size() >= sizeof(addr.sun_path)) {
+        disconnect(connection, "socket path is too long");
+        return;
     }
-    std::strncpy(addr.sun_path, options_.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    std::memcpy(addr.sun_path, path.data(), path.size());
 
-    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(sockaddr_un)) == -1) {
-        const int err = errno;
-        ::close(fd);
-        throw std::runtime_error("HardwareServiceClient: connect() failed with errno " + std::to_string(err));
+    connection.fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (connection.fd < 0) {
+        disconnect(connection, std::string("socket() failed: ") + std::strerror(errno));
+        return;
+    }
+    if (::connect(connection.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        onConnected(connection);
+        return;
+    }
+    const int err = errno;
+    if (err == EINPROGRESS) {
+        // Completion is reported as writability; finishConnect() picks it up.
+        connection.connecting = true;
+        epoll_event event {};
+        event.events = EPOLLOUT;
+        event.data.ptr = &connection;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, connection.fd, &event) == 0) {
+            return;
+        }
     }
+    disconnect(connection, std::string("connect() failed: ") + std::strerror(err));
+#else
+    (void)connection;
+#endif
+}
 
-    socketFd_.store(fd);
-    readBuffer_.clear();
+void HardwareServiceClient::finishConnect(Connection& connection)
+{
+#ifdef __linux__
+    int err = 0;
+    socklen_t length = sizeof(err);
+    if (::getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &err, &length) != 0) {
+        err = errno;
+    }
+    if (err != 0) {
+        disconnect(connection, std::string("connect() failed: ") + std::strerror(err));
+        return;
+    }
+    onConnected(connection);
+#else
+    (void)connection;
 #endif
 }
 
-void HardwareServiceClient::closeSocket()
+void HardwareServiceClient::onConnected(Connection& connection)
 {
-#ifndef _WIN32
-    const int fd = socketFd_.exchange(-1);
-    if (fd >= 0) {
-        ::close(fd);
+#ifdef __linux__
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = &connection;
+    if (::epoll_ctl(epollFd_, connection.connecting ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, connection.fd, &event) != 0) {
+        disconnect(connection, std::string("epoll_ctl() failed: ") + std::strerror(errno));
+        return;
     }
+    connection.connecting = false;
+    connection.connected = true;
+    connection.reportedDown = false;
+    connection.wantWrite = false;
+    connection.readBuffer.reset(options_.receiveBufferSize);
+    connection.newlineScanOffset = 0;
+    connection.binaryFraming = false;
+    connection.sending.clear();
+    connection.sendOffset = 0;
+    kRelayConnects.add();
+    spdlog::info("HardwareServiceClient: connected to relay {}", Describe(connection.endpoint));
+
+    {
+        // registerClient has to be the first message the relay reads, ahead of anything
+        // another thread queues once the connection is online.
+        auto registration = registerClientMessage(connection);
+        std::lock_guard lock(connection.outboxMutex);
+        connection.outbox = std::move(registration);
+        connection.online = true;
+    }
+    resendSubscriptions(connection);
+#else
+    (void)connection;
 #endif
 }
 
-void HardwareServiceClient::readLoop()
+void HardwareServiceClient::disconnect(Connection& connection, const std::string& reason)
 {
-#ifndef _WIN32
-    const int fd = socketFd_.load();
-    if (fd < 0) {
+    // The next connection starts with an inline handshake, which must not race the
+    // commits of this one.
+    if (pipeline_) {
+        pipeline_->drain(connection.stream);
+    }
+#ifdef __linux__
+    if (connection.fd >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+    }
+#endif
+    CloseFd(connection.fd);
+    const bool wasConnected = connection.connected;
+    connection.connecting = false;
+    connection.connected = false;
+    {
+        std::lock_guard lock(connection.outboxMutex);
+        connection.online = false;
+        connection.outbox.clear();
+    }
+    connection.sending.clear();
+    connection.sendOffset = 0;
+    // The pipeline is drained, so nothing commits on this connection any more.
+    connection.rings.clear();
+    failPending(&connection, "connection to the relay was lost");
+
+    // Subscriptions stay in the table and are re-sent by the next onConnected().
+    if (wasConnected) {
+        kRelayDisconnects.add();
+        spdlog::warn("HardwareServiceClient: lost relay {}: {}; reconnecting in {} ms", Describe(connection.endpoint),
+            reason, connection.backoff.count());
+    } else if (!connection.reportedDown) {
+        spdlog::warn("HardwareServiceClient: relay {} unavailable: {}; retrying with backoff", Describe(connection.endpoint),
+            reason);
+    }
+    connection.reportedDown = true;
+    connection.retryAt = std::chrono::steady_clock::now() + connection.backoff;
+    connection.backoff = std::min(connection.backoff * 2, std::max(options_.maxReconnectDelay, options_.reconnectDelay));
+}
+
+void HardwareServiceClient::handleEvents(Connection& connection, std::uint32_t events)
+{
+#ifdef __linux__
+    if (connection.fd < 0) {
+        // Dropped by an earlier event in the same batch.
+        return;
+    }
+    if (connection.connecting) {
+        finishConnect(connection);
         return;
     }
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+        readAvailable(connection);
+        if (connection.fd < 0) {
+            return;
+        }
+    }
+    if ((events & EPOLLOUT) != 0) {
+        flushOutbox(connection);
+    }
+#else
+    (void)connection;
+    (void)events;
+#endif
+}
 
-    constexpr std::size_t kChunkSize = 4096;
-    std::vector<char> buffer(kChunkSize);
-    while (running_) {
-        const ssize_t bytesRead = ::recv(fd, buffer.data(), buffer.size(), 0);
+void HardwareServiceClient::readAvailable(Connection& connection)
+{
+#ifndef _WIN32
+    for (int i = 0; i < kReadsPerEvent; ++i) {
+        // Receive straight into the buffer's free tail; no intermediate chunk copy.
+        const auto space = connection.readBuffer.prepareWrite();
+        const ssize_t bytesRead = ::recv(connection.fd, space.data(), space.size(), 0);
         if (bytesRead > 0) {
-            readBuffer_.append(buffer.data(), static_cast<std::size_t>(bytesRead));
-
-            std::size_t newlinePos = std::string::npos;
-            while ((newlinePos = readBuffer_.find('\n')) != std::string::npos) {
-                std::string message = readBuffer_.substr(0, newlinePos);
-                readBuffer_.erase(0, newlinePos + 1);
-                if (!message.empty()) {
-                    handleIncomingMessage(message);
-                }
-            }
-        } else if (bytesRead == 0) {
-            break; // connection closed cleanly
-        } else {
-            if (errno == EINTR) {
-                continue;
+            connection.readBuffer.commitWrite(static_cast<std::size_t>(bytesRead));
+            // The relay is talking, so the next drop starts the backoff over.
+            connection.backoff = options_.reconnectDelay;
+            try {
+                drainReadBuffer(connection);
+            } catch (const std::exception& ex) {
+                disconnect(connection, ex.what());
+                return;
             }
+            continue;
+        }
+        if (bytesRead == 0) {
+            disconnect(connection, "connection closed by the relay");
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        }
+        disconnect(connection, std::string("recv() failed: ") + std::strerror(errno));
+        return;
+    }
+#else
+    (void)connection;
+#endif
+}
+
+void HardwareServiceClient::flushOutbox(Connection& connection)
+{
+#ifndef _WIN32
+    for (;;) {
+        if (connection.sendOffset == connection.sending.size()) {
+            connection.sending.clear();
+            connection.sendOffset = 0;
+            std::lock_guard lock(connection.outboxMutex);
+            // Swapping keeps both buffers' capacity for the next round.
+            connection.sending.swap(connection.outbox);
+        }
+        if (connection.sending.empty()) {
+            break;
+        }
+        const ssize_t sent = ::send(connection.fd, connection.sending.data() + connection.sendOffset,
+            connection.sending.size() - connection.sendOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.sendOffset += static_cast<std::size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
             break;
         }
+        disconnect(connection, std::string("send() failed: ") + std::strerror(errno));
+        return;
     }
+    const bool pending = connection.sendOffset < connection.sending.size();
+    if (pending != connection.wantWrite) {
+        connection.wantWrite = pending;
+        updateInterest(connection);
+    }
+#else
+    (void)connection;
+#endif
+}
 
-    closeSocket();
+void HardwareServiceClient::updateInterest(Connection& connection)
+{
+#ifdef __linux__
+    epoll_event event {};
+    event.events = EPOLLIN | (connection.wantWrite ? EPOLLOUT : 0u);
+    event.data.ptr = &connection;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
 #else
-    // No-op on Windows.
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    (void)connection;
 #endif
 }
 
-void HardwareServiceClient::handleIncomingMessage(const std::string& message)
+void HardwareServiceClient::wake()
 {
-    try {
-        auto json = nlohmann::json::parse(message);
+#ifdef __linux__
+    if (wakeFd_ >= 0) {
+        const std::uint64_t one = 1;
+        (void)!::write(wakeFd_, &one, sizeof(one));
+    }
+#endif
+}
+
+void HardwareServiceClient::drainReadBuffer(Connection& connection)
+{
+    // Messages are handled as views into the read buffer and consumed by moving the read
+    // cursor. The framing can switch from newline JSON to binary in the middle of a
+    // buffer (right after the registerClient response), so it is re-checked per message.
+    auto& buffer = connection.readBuffer;
+    while (!buffer.empty()) {
+        const std::string_view pending = buffer.readable();
+        if (connection.binaryFraming) {
+            binary::FrameHeader header;
+            if (!binary::ReadHeader(pending, header)) {
+                return;
+            }
+            if (header.payloadSize > binary::kMaxPayloadSize) {
+                throw std::runtime_error("HardwareServiceClient: oversized binary frame");
+            }
+            const std::size_t frameSize = binary::kHeaderSize + header.payloadSize;
+            if (pending.size() < frameSize) {
+                return;
+            }
+            const auto payload = pending.substr(binary::kHeaderSize, header.payloadSize);
+            switch (header.type) {
+            case binary::FrameType::Json:
+                dispatchMessage(connection, payload, false);
+                break;
+            case binary::FrameType::DataFrame:
+                dispatchMessage(connection, payload, true);
+                break;
+            default:
+                // Unknown frame types are skipped so the relay can add new ones compatibly.
+                break;
+            }
+            buffer.consume(frameSize);
+            continue;
+        }
+
+        const std::size_t newlinePos = pending.find('\n', connection.newlineScanOffset);
+        if (newlinePos == std::string_view::npos) {
+            // Remember how far we looked so a long partial message is not rescanned.
+            connection.newlineScanOffset = pending.size();
+            return;
+        }
+        connection.newlineScanOffset = 0;
+        const std::string_view message = pending.substr(0, newlinePos);
+        if (!message.empty()) {
+            dispatchMessage(connection, message, false);
+        }
+        buffer.consume(newlinePos + 1);
+    }
+}
+
+void HardwareServiceClient::dispatchMessage(Connection& connection, std::string_view message, bool binaryFrame)
+{
+    // The registerClient response decides how the reader frames whatever follows it,
+    // so nothing is handed off until the handshake is done.
+    if (!pipeline_ || !connection.registerRequestId.empty()) {
+        const DecodeStatus status = DecodeRelayMessage(message, binaryFrame, connection.decoded);
+        commitMessage(connection, status, message, connection.decoded);
+        return;
+    }
+    auto& job = pipeline_->acquire(connection.stream);
+    job.binary = binaryFrame;
+    job.bytes.assign(message);
+    pipeline_->submit(job);
+}
 
-        if (json.contains("method")) {
-            const std::string method = json.at("method").get<std::string>();
-            const auto& params = json.contains("params") ? json.at("params") : nlohmann::json::object();
-            handleRelayNotification(method, params);
-        } else if (json.contains("result") || json.contains("error")) {
-            handleResponse(json);
+void HardwareServiceClient::commitMessage(Connection& connection, DecodeStatus status, std::string_view message,
+    DataFrameNotification& decoded)
+{
+    // Data frames are the bulk of the traffic and were streamed without a DOM.
+    // Everything else (and any dataFrame the streaming decoder rejects) takes the DOM path.
+    switch (status) {
+    case DecodeStatus::Decoded:
+        kFramesIngested.add();
+        publishDecodedFrame(connection, decoded);
+        return;
+    case DecodeStatus::Malformed:
+        kMalformedFrames.add();
+        return;
+    case DecodeStatus::NotDataFrame:
+        break;
+    }
+    handleControlMessage(connection, message);
+}
+
+void HardwareServiceClient::handleControlMessage(Connection& connection, std::string_view message)
+{
+    try {
+        const auto json = nlohmann::json::parse(message.begin(), message.end());
+        if (json.is_array()) {
+            // A batch reply: one response per request of the batch that carried an id.
+            for (const auto& entry : json) {
+                handleControlObject(connection, entry);
+            }
+        } else {
+            handleControlObject(connection, json);
         }
     } catch (const nlohmann::json::exception& ex) {
         (void)ex;
@@ -370,122 +925,181 @@ void HardwareServiceClient::handleIncomingMessage(const std::string& message)
     }
 }
 
-void HardwareServiceClient::handleResponse(const nlohmann::json& response)
+void HardwareServiceClient::handleControlObject(Connection& connection, const nlohmann::json& message)
 {
-    // Currently, we have no stateful request tracking. This is a placeholder for
-    // future acknowledgement handling.
-    (void)response;
+    if (!message.is_object()) {
+        return;
+    }
+    if (message.contains("method")) {
+        const std::string method = message.at("method").get<std::string>();
+        const auto& params = message.contains("params") ? message.at("params") : nlohmann::json::object();
+        handleRelayNotification(connection, method, params);
+    } else if (message.contains("result") || message.contains("error")) {
+        handleResponse(connection, message);
+    }
 }
 
-void HardwareServiceClient::handleRelayNotification(const std::string& method,
-    const nlohmann::json& params)
+void HardwareServiceClient::handleResponse(Connection& connection, const nlohmann::json& response)
 {
-    if (method == "workbench.dataFrame") {
-        publishFrameFromJson(params);
+    const bool ok = !response.contains("error");
+    static const nlohmann::json kNoResult;
+    const auto& payload = ok ? (response.contains("result") ? response.at("result") : kNoResult) : response.at("error");
+    if (!response.contains("id") || !response.at("id").is_string()) {
+        // A null id answers a request the relay could not even parse.
+        if (!ok) {
+            spdlog::warn("HardwareServiceClient: relay {} reported {}", Describe(connection.endpoint), payload.dump());
+        }
         return;
     }
+    const auto& id = response.at("id").get_ref<const std::string&>();
+
+    // The registerClient handshake decides the framing used for everything the relay
+    // sends afterwards.
+    if (!connection.registerRequestId.empty() && id == connection.registerRequestId) {
+        connection.registerRequestId.clear();
+        int protocol = 1;
+        if (ok && payload.is_object()) {
+            protocol = payload.value("protocol", 1);
+        }
+        connection.binaryFraming = options_.preferBinaryProtocol && protocol == binary::kProtocolVersion;
+        spdlog::info("HardwareServiceClient: relay {} negotiated protocol {} ({} framing)", Describe(connection.endpoint),
+            protocol, connection.binaryFraming ? "binary" : "newline JSON");
+        return;
+    }
+
+    if (!completeRequest(id, ok, payload) && !ok) {
+        // Nobody is waiting on it (e.g. a subscribe), so the log is the only place it shows.
+        spdlog::warn("HardwareServiceClient: relay {} rejected request {}: {}", Describe(connection.endpoint), id,
+            payload.dump());
+    }
+}
 
+void HardwareServiceClient::handleRelayNotification(Connection& connection, const std::string& method,
+    const nlohmann::json& params)
+{
+    // workbench.dataFrame never gets here: DecodeDataFrameNotification() handles
+    // (or rejects as malformed) every message carrying that method.
     if (method == "workbench.metadata") {
         if (params.is_array()) {
             for (const auto& entry : params) {
-                registerMetadataFromJson(entry);
+                registerMetadataFromJson(connection, entry);
             }
         } else if (params.contains("sources")) {
             for (const auto& entry : params.at("sources")) {
-                registerMetadataFromJson(entry);
+                registerMetadataFromJson(connection, entry);
             }
         } else {
-            registerMetadataFromJson(params);
+            registerMetadataFromJson(connection, params);
         }
         return;
     }
+    if (method == "workbench.ring" || method == "workbench.ringReady") {
+        handleRingNotification(connection, method, params);
+        return;
+    }
 
     // Additional notifications (GPIO updates, serial streams, etc.) will be
     // handled here once the relay exposes them.
 }
 
-void HardwareServiceClient::publishFrameFromJson(const nlohmann::json& params)
+void HardwareServiceClient::handleRingNotification(Connection& connection, const std::string& method,
+    const nlohmann::json& params)
 {
-    if (!params.contains("frame")) {
+    if (!params.is_object()) {
         return;
     }
-
-    core::SourceMetadata metadata;
-    if (params.contains("source")) {
-        const auto& sourceJson = params.at("source");
-        metadata.id = sourceJson.value("id", "");
-        metadata.name = sourceJson.value("name", metadata.id);
-        metadata.description = sourceJson.value("description", "");
-        metadata.kind = ParseKind(sourceJson.value("kind", "custom"));
-        if (sourceJson.contains("unit") && !sourceJson.at("unit").is_null()) {
-            metadata.unit = sourceJson.at("unit").get<std::string>();
-        }
-        if (!metadata.id.empty()) {
-            registry_.registerSource(metadata);
+    const auto sourceId = params.value("sourceId", "");
+    auto it = connection.rings.find(sourceId);
+    if (method == "workbench.ringReady") {
+        if (it != connection.rings.end() && !drainRing(connection, *it->second)) {
+            abandonRing(connection, sourceId);
         }
+        return;
     }
-
-    const auto& frameJson = params.at("frame");
-    const std::string sourceId = frameJson.value("sourceId", metadata.id);
-    if (sourceId.empty()) {
+    if (it != connection.rings.end()) {
+        // Closed or replaced: whatever the relay pushed before that still counts.
+        drainRing(connection, *it->second);
+        connection.rings.erase(it);
+    }
+    if (params.value("closed", false)) {
+        return;
+    }
+    auto ring = SharedRing::Open(params.value("name", ""));
+    if (!ring) {
+        // The relay keeps writing into a ring nobody reads; resubscribing without
+        // sharedMemory is the way out.
+        spdlog::warn("HardwareServiceClient: cannot map the ring of source {} from relay {}", sourceId,
+            Describe(connection.endpoint));
         return;
     }
+    spdlog::debug("HardwareServiceClient: source {} streams through shared memory ({} bytes)", sourceId,
+        ring->capacity());
+    // Whatever the relay pushed before this was seen rings no doorbell of its own.
+    const bool usable = drainRing(connection, *ring);
+    connection.rings.emplace(sourceId, std::move(ring));
+    if (!usable) {
+        abandonRing(connection, sourceId);
+    }
+}
 
-    core::DataFrame frame;
-    frame.sourceId = sourceId;
-    frame.sourceName = frameJson.value("sourceName", metadata.name.empty() ? sourceId : metadata.name);
-    frame.timestamp = ParseTimestamp(frameJson.value("timestamp", nlohmann::json {}));
-
-    const auto& pointsJson = frameJson.value("points", nlohmann::json::array());
-    for (const auto& pointJson : pointsJson) {
-        core::DataPoint point;
-        point.channelId = pointJson.value("channelId", "");
-
-        if (pointJson.contains("numeric")) {
-            const auto& numeric = pointJson.at("numeric");
-            core::NumericSample sample;
-            sample.value = numeric.value("value", 0.0);
-            sample.unit = numeric.value("unit", "");
-            sample.timestamp = frame.timestamp;
-            point.payload = sample;
-        } else if (pointJson.contains("waveform")) {
-            const auto& waveform = pointJson.at("waveform");
-            core::WaveformSample sample;
-            sample.samples = waveform.value("samples", std::vector<double> {});
-            sample.sampleRateHz = waveform.value("sampleRate", 0.0);
-            sample.timestamp = frame.timestamp;
-            point.payload = sample;
-        } else if (pointJson.contains("serial")) {
-            const auto& serial = pointJson.at("serial");
-            core::SerialSample sample;
-            sample.text = serial.value("text", "");
-            sample.timestamp = frame.timestamp;
-            point.payload = sample;
-        } else if (pointJson.contains("logic")) {
-            const auto& logic = pointJson.at("logic");
-            core::LogicSample sample;
-            sample.channels = logic.value("channels", std::vector<bool> {});
-            const auto periodNs = logic.value("periodNs", 0LL);
-            sample.samplePeriod = std::chrono::nanoseconds(periodNs);
-            sample.timestamp = frame.timestamp;
-            point.payload = sample;
-        } else if (pointJson.contains("gpio")) {
-            const auto& gpio = pointJson.at("gpio");
-            core::GpioState state;
-            state.pins = gpio.value("pins", std::vector<bool> {});
-            state.timestamp = frame.timestamp;
-            point.payload = state;
-        } else {
-            point.payload = std::monostate {};
+void HardwareServiceClient::abandonRing(Connection& connection, const std::string& relayId)
+{
+    connection.rings.erase(relayId);
+    spdlog::warn("HardwareServiceClient: source {} from relay {} goes back to the socket after a corrupt ring record",
+        relayId, Describe(connection.endpoint));
+    std::lock_guard lock(subscriptionsMutex_);
+    connection.brokenRings.insert(relayId);
+    // Resubscribing without shared memory makes the relay drop the ring and send the
+    // frames on the socket instead.
+    const auto it = subscriptions_.find(connection.prefix + relayId);
+    if (it != subscriptions_.end()) {
+        sendJson(connection, subscriptionRequest(connection, relayId, it->second.effective));
+    }
+}
+
+bool HardwareServiceClient::drainRing(Connection& connection, SharedRing& ring)
+{
+    ring.drain([&](std::string_view record) {
+        binary::FrameHeader header;
+        if (!binary::ReadHeader(record, header) || header.type != binary::FrameType::DataFrame
+            || binary::kHeaderSize + header.payloadSize > record.size()) {
+            kMalformedFrames.add();
+            return;
         }
+        const auto payload = record.substr(binary::kHeaderSize, header.payloadSize);
+        const DecodeStatus status = DecodeRelayMessage(payload, true, connection.ringDecoded);
+        commitMessage(connection, status, payload, connection.ringDecoded);
+    });
+    return !ring.broken();
+}
 
-        frame.points.push_back(std::move(point));
+void HardwareServiceClient::publishDecodedFrame(Connection& connection, DataFrameNotification& notification)
+{
+    if (notification.hasSource && !notification.source.id.empty()) {
+        refreshSourceMetadata(connection, notification.source);
     }
+    if (!notification.hasFrame || notification.frame.sourceId.empty()) {
+        return;
+    }
+    notification.frame.sourceId.insert(0, connection.prefix);
+    registry_.update(std::move(notification.frame));
+}
 
-    registry_.update(frame);
+void HardwareServiceClient::refreshSourceMetadata(Connection& connection, const core::SourceMetadata& metadata)
+{
+    // Most relays repeat the source block on every frame; only take the registry's
+    // exclusive lock when it actually changed (or the source was dropped meanwhile).
+    const auto it = connection.knownSources.find(metadata.id);
+    if (it != connection.knownSources.end() && it->second.relay == metadata
+        && registry_.isRegistered(it->second.publishedId)) {
+        return;
+    }
+    auto published = Published(connection.endpoint, connection.prefix, metadata);
+    connection.knownSources.insert_or_assign(metadata.id, KnownSource { metadata, published.id });
+    registry_.registerSource(std::move(published));
 }
 
-void HardwareServiceClient::registerMetadataFromJson(const nlohmann::json& meta)
+void HardwareServiceClient::registerMetadataFromJson(Connection& connection, const nlohmann::json& meta)
 {
     if (!meta.contains("id")) {
         return;
@@ -493,6 +1107,14 @@ void HardwareServiceClient::registerMetadataFromJson(const nlohmann::json& meta)
 
     core::SourceMetadata metadata;
     metadata.id = meta.value("id", "");
+    if (meta.value("removed", false)) {
+        // Only sources this relay announced are withdrawn.
+        if (const auto it = connection.knownSources.find(metadata.id); it != connection.knownSources.end()) {
+            registry_.unregisterSource(it->second.publishedId);
+            connection.knownSources.erase(it);
+        }
+        return;
+    }
     metadata.name = meta.value("name", metadata.id);
     metadata.description = meta.value("description", "");
     metadata.kind = ParseKind(meta.value("kind", "custom"));
@@ -500,57 +1122,204 @@ void HardwareServiceClient::registerMetadataFromJson(const nlohmann::json& meta)
         metadata.unit = meta.at("unit").get<std::string>();
     }
 
-    registry_.registerSource(std::move(metadata));
+    auto published = Published(connection.endpoint, connection.prefix, metadata);
+    // Keyed by a copy: the key and the moved-from value would otherwise be evaluated in either order.
+    auto relayId = metadata.id;
+    connection.knownSources.insert_or_assign(std::move(relayId), KnownSource { std::move(metadata), published.id });
+    registry_.registerSource(std::move(published));
 }
 
-void HardwareServiceClient::resendSubscriptions()
+void HardwareServiceClient::resendSubscriptions(Connection& connection)
 {
     std::lock_guard lock(subscriptionsMutex_);
-    for (const auto& sourceId : subscribedSources_) {
-        sendSubscriptionMessage(sourceId);
+    std::string relayId;
+    auto batch = nlohmann::json::array();
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+        if (route(it->first, relayId) != &connection) {
+            ++it;
+            continue;
+        }
+        // A new connection starts unsubscribed; nobody is waiting on lingering sources.
+        if (it->second.requests.empty()) {
+            it = subscriptions_.erase(it);
+            lingering_.fetch_sub(1);
+            continue;
+        }
+        batch.push_back(subscriptionRequest(connection, relayId, it->second.effective));
+        ++it;
+    }
+    // A JSON-RPC batch: however many sources were open, the relay gets one message.
+    if (batch.size() == 1) {
+        sendJson(connection, batch.front());
+    } else if (!batch.empty()) {
+        sendJson(connection, batch);
     }
 }
 
-void HardwareServiceClient::sendJson(const nlohmann::json& message)
+HardwareServiceClient::Connection* HardwareServiceClient::route(const std::string& sourceId, std::string& relayId) const
 {
-#ifndef _WIN32
-    const int fd = socketFd_.load();
-    if (fd < 0) {
-        return;
+    // Named relays claim their prefix; an unnamed relay takes everything else.
+    Connection* unnamed = nullptr;
+    for (const auto& connection : connections_) {
+        if (connection->prefix.empty()) {
+            if (!unnamed) {
+                unnamed = connection.get();
+            }
+        } else if (sourceId.starts_with(connection->prefix)) {
+            relayId.assign(sourceId, connection->prefix.size());
+            return connection.get();
+        }
     }
+    relayId = sourceId;
+    return unnamed;
+}
 
-    const std::string serialized = message.dump() + "\n";
-    std::lock_guard lock(sendMutex_);
-    ssize_t total = 0;
-    const char* data = serialized.data();
-    const ssize_t size = static_cast<ssize_t>(serialized.size());
-    while (total < size) {
-        const ssize_t sent = ::send(fd, data + total, static_cast<size_t>(size - total), 0);
-        if (sent <= 0) {
-            break;
+bool HardwareServiceClient::sendJson(Connection& connection, const nlohmann::json& message)
+{
+    const std::string serialized = message.dump();
+    {
+        // Dropped while the relay is down; the connection starts from a fresh state.
+        std::lock_guard lock(connection.outboxMutex);
+        if (!connection.online) {
+            return false;
         }
-        total += sent;
+        connection.outbox += serialized;
+        connection.outbox += '\n';
     }
-#else
-    (void)message;
-#endif
+    wake();
+    return true;
 }
 
-void HardwareServiceClient::sendSubscriptionMessage(const std::string& sourceId)
+bool HardwareServiceClient::sendRequest(Connection& connection, const nlohmann::json& request, ResponseHandler& handler)
 {
-    if (sourceId.empty()) {
-        return;
+    if (!handler) {
+        return sendJson(connection, request);
+    }
+    // Tracked before it is queued: the response can arrive before sendJson() returns.
+    const std::string id = request.at("id").get<std::string>();
+    {
+        std::lock_guard lock(pendingMutex_);
+        pending_.insert_or_assign(id,
+            PendingRequest { &connection, std::move(handler), std::chrono::steady_clock::now() + options_.requestTimeout });
+        pendingCount_.store(pending_.size());
+    }
+    if (sendJson(connection, request)) {
+        return true;
+    }
+    std::lock_guard lock(pendingMutex_);
+    const auto it = pending_.find(id);
+    if (it != pending_.end()) {
+        handler = std::move(it->second.handler);
+        pending_.erase(it);
+        pendingCount_.store(pending_.size());
     }
-    nlohmann::json request {
+    return false;
+}
+
+nlohmann::json HardwareServiceClient::makeRequest(const std::string& method, nlohmann::json params)
+{
+    return {
         { "jsonrpc", "2.0" },
         { "id", nextRequestId() },
-        { "method", "workbench.subscribe" },
-        { "params",
-            {
-                { "sourceId", sourceId },
-            } }
+        { "method", method },
+        { "params", std::move(params) },
     };
-    sendJson(request);
+}
+
+bool HardwareServiceClient::completeRequest(const std::string& id, bool ok, const nlohmann::json& payload)
+{
+    ResponseHandler handler;
+    {
+        std::lock_guard lock(pendingMutex_);
+        const auto it = pending_.find(id);
+        if (it == pending_.end()) {
+            return false;
+        }
+        handler = std::move(it->second.handler);
+        pending_.erase(it);
+        pendingCount_.store(pending_.size());
+    }
+    handler(ok, payload);
+    return true;
+}
+
+void HardwareServiceClient::failPending(const Connection* connection, const std::string& message)
+{
+    std::vector<ResponseHandler> failed;
+    {
+        std::lock_guard lock(pendingMutex_);
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (connection && it->second.connection != connection) {
+                ++it;
+                continue;
+            }
+            failed.push_back(std::move(it->second.handler));
+            it = pending_.erase(it);
+        }
+        pendingCount_.store(pending_.size());
+    }
+    if (failed.empty()) {
+        return;
+    }
+    const auto error = ClientError(message);
+    for (auto& handler : failed) {
+        handler(false, error);
+    }
+}
+
+void HardwareServiceClient::expirePending(std::chrono::steady_clock::time_point now)
+{
+    std::vector<std::pair<std::string, ResponseHandler>> expired;
+    {
+        std::lock_guard lock(pendingMutex_);
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->second.deadline > now) {
+                ++it;
+                continue;
+            }
+            expired.emplace_back(it->first, std::move(it->second.handler));
+            it = pending_.erase(it);
+        }
+        pendingCount_.store(pending_.size());
+    }
+    for (auto& [id, handler] : expired) {
+        spdlog::warn("HardwareServiceClient: request {} timed out", id);
+        handler(false, ClientError("no response within " + std::to_string(options_.requestTimeout.count()) + " ms"));
+    }
+}
+
+nlohmann::json HardwareServiceClient::subscriptionRequest(const Connection& connection, const std::string& relayId,
+    const SubscribeOptions& options)
+{
+    nlohmann::json params {
+        { "sourceId", relayId },
+    };
+    // Limits are only sent when set, so protocol-1 relays see the same request as before.
+    if (options.maxRateHz > 0.0) {
+        params["maxRateHz"] = options.maxRateHz;
+    }
+    if (options.decimation != Decimation::None) {
+        params["decimation"] = DecimationName(options.decimation);
+    }
+    if (options.waveformPointBudget > 0) {
+        params["waveformPoints"] = options.waveformPointBudget;
+    }
+    if (options_.sharedMemory && !connection.brokenRings.contains(relayId)) {
+        params["transport"] = "shm";
+    }
+    return makeRequest("workbench.subscribe", std::move(params));
+}
+
+void HardwareServiceClient::sendSubscriptionMessage(const std::string& sourceId, const SubscribeOptions& options)
+{
+    if (sourceId.empty()) {
+        return;
+    }
+    std::string relayId;
+    Connection* connection = route(sourceId, relayId);
+    if (connection) {
+        sendJson(*connection, subscriptionRequest(*connection, relayId, options));
+    }
 }
 
 void HardwareServiceClient::sendUnsubscribeMessage(const std::string& sourceId)
@@ -558,30 +1327,21 @@ void HardwareServiceClient::sendUnsubscribeMessage(const std::string& sourceId)
     if (sourceId.empty()) {
         return;
     }
-    nlohmann::json request {
-        { "jsonrpc", "2.0" },
-        { "id", nextRequestId() },
-        { "method", "workbench.unsubscribe" },
-        { "params",
-            {
-                { "sourceId", sourceId },
-            } }
-    };
-    sendJson(request);
+    std::string relayId;
+    Connection* connection = route(sourceId, relayId);
+    if (connection) {
+        sendJson(*connection, makeRequest("workbench.unsubscribe", { { "sourceId", relayId } }));
+    }
 }
 
-void HardwareServiceClient::sendRegisterClient()
+std::string HardwareServiceClient::registerClientMessage(Connection& connection)
 {
-    nlohmann::json request {
-        { "jsonrpc", "2.0" },
-        { "id", nextRequestId() },
-        { "method", "workbench.registerClient" },
-        { "params",
-            {
-                { "protocol", 1 },
-            } }
-    };
-    sendJson(request);
+    const auto request = makeRequest("workbench.registerClient",
+        {
+            { "protocol", options_.preferBinaryProtocol ? binary::kProtocolVersion : 1 },
+        });
+    connection.registerRequestId = request.at("id").get<std::string>();
+    return request.dump() + "\n";
 }
 
 std::string HardwareServiceClient::nextRequestId()
@@ -1,12 +1,23 @@
 #pragma once
 
+#include "core/Types.h"
+#include "hardware/DataFrameSaxDecoder.h"
+#include "hardware/DecodePipeline.h"
+#include "hardware/ReceiveBuffer.h"
+#include "hardware/SharedRing.h"
+
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json_fwd.hpp>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace core {
@@ -15,21 +26,79 @@ class DataRegistry;
 
 namespace hardware {
 
+// Reduction the relay applies when it has to drop readings to honour maxRateHz or
+// the waveform point budget.
+enum class Decimation {
+    None,
+    Last,
+    Mean,
+    MinMax,
+};
+
+// What one consumer needs from a source stream; 0 means "no limit".
+struct SubscribeOptions {
+    double maxRateHz { 0.0 };
+    Decimation decimation { Decimation::None };
+    std::uint32_t waveformPointBudget { 0 };
+
+    bool operator==(const SubscribeOptions&) const = default;
+};
+
+// One relay to ingest from. A named relay publishes its sources as "<name>:<id>",
+// so identical relays on different machines do not collide in the registry.
+struct RelayEndpoint {
+    std::string name;
+    std::string socketPath;
+};
+
 /**
- * @brief Client responsible for talking to the external hardware relay service.
+ * @brief Client responsible for talking to the external hardware relay services.
  *
- * The relay process exposes a JSON-RPC 2.0 endpoint over a Unix domain socket.
- * This client keeps a persistent connection, forwards control requests, and
- * converts inbound notifications into calls to `DataRegistry::update()`.
+ * Each relay exposes a JSON-RPC 2.0 endpoint over a Unix domain socket. One
+ * ingest thread serves every configured relay from a single epoll loop over
+ * non-blocking sockets: it reconnects each endpoint on its own backoff, frames
+ * inbound messages and forwards control requests. Decoding runs on a
+ * `DecodePipeline`, whose workers turn each connection's messages into calls to
+ * `DataRegistry::update()` in the order they arrived.
  */
 class HardwareServiceClient {
 public:
     struct Options {
+        // The relay used when `endpoints` is empty; its source ids are not namespaced.
         std::string socketPath { "/var/run/workbench/hardware-relay.sock" };
+        std::vector<RelayEndpoint> endpoints;
+        // Retry delay after a failed or dropped connection, doubled per consecutive
+        // failure up to maxReconnectDelay. Each endpoint backs off independently.
         std::chrono::milliseconds reconnectDelay { std::chrono::seconds(2) };
+        std::chrono::milliseconds maxReconnectDelay { std::chrono::seconds(30) };
         bool enableMock { false };
+        // Ask the relay for the length-prefixed binary framing (protocol 2). Relays that
+        // only speak protocol 1 answer accordingly and the client stays on newline JSON.
+        bool preferBinaryProtocol { true };
+        // Minimum free space offered to each recv(); bursts of frames drain in one call.
+        std::size_t receiveBufferSize { ReceiveBuffer::kDefaultReceiveSize };
+        // How long a source stays subscribed at the relay after its last token is
+        // released, so closing and reopening (or switching away and back) a window
+        // costs no relay traffic. Zero unsubscribes immediately.
+        std::chrono::milliseconds subscriptionLinger { std::chrono::seconds(3) };
+        // Decoder threads; -1 uses one per spare core (at most three), 0 decodes on
+        // the ingest thread.
+        int decodeWorkers { -1 };
+        // How long a control request waits for its response before failing.
+        std::chrono::milliseconds requestTimeout { std::chrono::seconds(5) };
+        // Ask relays on this host to carry waveform and logic frames through a
+        // shared-memory ring instead of the socket. Relays without rings ignore it.
+        bool sharedMemory { false };
     };
 
+    // Completion of a control request: `ok` with the relay's "result", otherwise an
+    // error object ({"code", "message"}) from the relay, or with code
+    // kClientErrorCode for a timeout, a lost connection or a request that could not
+    // be sent. Called exactly once, on the ingest or a decode thread (or on the
+    // caller's thread when sending failed); keep it short and post UI work.
+    using ResponseHandler = std::function<void(bool ok, const nlohmann::json& payload)>;
+    static constexpr int kClientErrorCode = -32000;
+
     explicit HardwareServiceClient(core::DataRegistry& registry);
     ~HardwareServiceClient();
 
@@ -37,29 +106,138 @@ public:
     void start();
     void stop();
 
-    void subscribeSource(const std::string& sourceId);
-    void unsubscribeSource(const std::string& sourceId);
+    // Subscriptions are refcounted per source. The relay is asked for the most
+    // demanding combination of all open requests (re-sent whenever that changes)
+    // and is only told to unsubscribe once the last token has been released for
+    // `subscriptionLinger`; a new request within that time reuses the stream.
+    int subscribeSource(const std::string& sourceId, SubscribeOptions options = {});
+    void unsubscribeSource(int token);
 
+    // Requests are routed to the relay owning `sourceId`, which sees its own id.
+    // Never blocks: the request is queued and `onDone` reports the outcome.
     void requestMetricReset(const std::string& sourceId,
         const std::string& channelId,
-        const std::string& metric);
+        const std::string& metric,
+        ResponseHandler onDone = {});
+
+    // Runs `bytes` through the same framing, decode and publish path as data read
+    // from the relay socket, framing on the caller's thread; `binaryFraming` selects
+    // the protocol 2 framing. Frames may still be decoding when it returns, but are
+    // published in order. For benchmarks and replays only: never call it while the
+    // client is started.
+    void injectRelayBytes(std::string_view bytes, bool binaryFraming = false);
 
 private:
+    struct KnownSource {
+        core::SourceMetadata relay;
+        std::string publishedId;
+    };
+
+    // Per-relay state. Everything but the outbox belongs to the ingest thread.
+    struct Connection {
+        RelayEndpoint endpoint;
+        // "<name>:" for named relays, otherwise empty.
+        std::string prefix;
+        int fd { -1 };
+        bool connecting { false };
+        bool connected { false };
+        // Whether the last failure was logged, so a relay that stays down logs once.
+        bool reportedDown { false };
+        std::chrono::milliseconds backoff { 0 };
+        std::chrono::steady_clock::time_point retryAt;
+
+        ReceiveBuffer readBuffer;
+        // Bytes of readBuffer already searched for a newline without finding one.
+        std::size_t newlineScanOffset { 0 };
+        std::string registerRequestId;
+        bool binaryFraming { false };
+        // Decode target for messages handled inline. Publishing moves the frame into the
+        // registry, which swaps back a retired frame of the same source, so ingest does
+        // not allocate once the frame shapes have been seen (pipeline jobs do the same).
+        DataFrameNotification decoded;
+        DecodePipeline::Stream stream;
+
+        // Commit side (whichever thread commits the stream): last metadata registered
+        // per relay source id, so repeated source blocks skip the registry.
+        std::unordered_map<std::string, KnownSource> knownSources;
+        // Commit side: shared-memory rings the relay announced, by relay source id, and
+        // the decode target for the frames read from them.
+        std::unordered_map<std::string, std::unique_ptr<SharedRing>> rings;
+        DataFrameNotification ringDecoded;
+        // Relay source ids whose ring held a corrupt record; they are subscribed over
+        // the socket from then on. Guarded by subscriptionsMutex_.
+        std::unordered_set<std::string> brokenRings;
+
+        // Bytes queued by any thread; only accepted while `online`.
+        std::mutex outboxMutex;
+        std::string outbox;
+        bool online { false };
+        // Ingest thread: bytes taken from the outbox and not yet written.
+        std::string sending;
+        std::size_t sendOffset { 0 };
+        bool wantWrite { false };
+    };
+
     void run();
-    void connectSocket();
-    void closeSocket();
-    void readLoop();
-    void handleIncomingMessage(const std::string& message);
-    void handleResponse(const nlohmann::json& response);
-    void handleRelayNotification(const std::string& method, const nlohmann::json& params);
-    void publishFrameFromJson(const nlohmann::json& jsonParams);
-    void registerMetadataFromJson(const nlohmann::json& meta);
-    void resendSubscriptions();
-
-    void sendJson(const nlohmann::json& message);
-    void sendSubscriptionMessage(const std::string& sourceId);
+    void beginConnect(Connection& connection);
+    void finishConnect(Connection& connection);
+    void onConnected(Connection& connection);
+    void disconnect(Connection& connection, const std::string& reason);
+    void handleEvents(Connection& connection, std::uint32_t events);
+    void readAvailable(Connection& connection);
+    void flushOutbox(Connection& connection);
+    void updateInterest(Connection& connection);
+    void wake();
+    // Milliseconds until the next reconnect or linger deadline, -1 for none.
+    int nextTimeoutMs(std::chrono::steady_clock::time_point now) const;
+
+    // Consumes as many complete messages from the read buffer as the current framing allows.
+    void drainReadBuffer(Connection& connection);
+    // Hands one framed message to the pipeline, or decodes and commits it right away.
+    void dispatchMessage(Connection& connection, std::string_view message, bool binaryFrame);
+    void commitMessage(Connection& connection, DecodeStatus status, std::string_view message,
+        DataFrameNotification& decoded);
+    void handleControlMessage(Connection& connection, std::string_view message);
+    // One JSON-RPC message, or one entry of a batch.
+    void handleControlObject(Connection& connection, const nlohmann::json& message);
+    void handleResponse(Connection& connection, const nlohmann::json& response);
+    void handleRelayNotification(Connection& connection, const std::string& method, const nlohmann::json& params);
+    // Opens, drains or closes the ring a workbench.ring / workbench.ringReady names.
+    void handleRingNotification(Connection& connection, const std::string& method, const nlohmann::json& params);
+    // False once the ring turned out to be corrupt.
+    bool drainRing(Connection& connection, SharedRing& ring);
+    // Unmaps a corrupt ring and resubscribes its source over the socket.
+    void abandonRing(Connection& connection, const std::string& relayId);
+    void publishDecodedFrame(Connection& connection, DataFrameNotification& decoded);
+    // Starts the decode workers (if any) and attaches the injection stream.
+    void createPipeline();
+    void attachStream(Connection& connection);
+    void refreshSourceMetadata(Connection& connection, const core::SourceMetadata& metadata);
+    void registerMetadataFromJson(Connection& connection, const nlohmann::json& meta);
+    void resendSubscriptions(Connection& connection);
+    // Unsubscribes lingering sources whose grace period is over (subscriptionsMutex_ held).
+    void expireLingeringLocked(std::chrono::steady_clock::time_point now);
+
+    // The relay serving `sourceId`, with `relayId` set to the id that relay uses.
+    Connection* route(const std::string& sourceId, std::string& relayId) const;
+    // Queues one message (or a batch array); false while the relay is not connected.
+    bool sendJson(Connection& connection, const nlohmann::json& message);
+    // Sends a request carrying an "id" and tracks it until its response or timeout.
+    // On success `handler` has been moved into the pending table; on failure it is
+    // left for the caller to fail outside any locks.
+    bool sendRequest(Connection& connection, const nlohmann::json& request, ResponseHandler& handler);
+    nlohmann::json makeRequest(const std::string& method, nlohmann::json params);
+    nlohmann::json subscriptionRequest(const Connection& connection, const std::string& relayId,
+        const SubscribeOptions& options);
+    void sendSubscriptionMessage(const std::string& sourceId, const SubscribeOptions& options);
     void sendUnsubscribeMessage(const std::string& sourceId);
-    void sendRegisterClient();
+    std::string registerClientMessage(Connection& connection);
+
+    // Completes a tracked request; false if `id` was not pending.
+    bool completeRequest(const std::string& id, bool ok, const nlohmann::json& payload);
+    // Fails the requests tracked for `connection` (every request when null).
+    void failPending(const Connection* connection, const std::string& message);
+    void expirePending(std::chrono::steady_clock::time_point now);
 
     std::string nextRequestId();
 
@@ -69,12 +247,46 @@ private:
     std::thread worker_;
     std::atomic<bool> running_ { false };
 
-    std::atomic<int> socketFd_ { -1 };
-    std::mutex sendMutex_;
-    std::string readBuffer_;
+    // Built by start() and cleared by stop(), both under subscriptionsMutex_; the
+    // ingest thread reads it freely while running.
+    std::vector<std::unique_ptr<Connection>> connections_;
+    int epollFd_ { -1 };
+    // eventfd that wakes the loop for queued sends and stop().
+    int wakeFd_ { -1 };
+    // Target of injectRelayBytes(); never connected.
+    Connection injected_;
+    // Created by start() (or the first injectRelayBytes()) unless decodeWorkers is 0.
+    std::unique_ptr<DecodePipeline> pipeline_;
+
+    struct SourceSubscription {
+        std::unordered_map<int, SubscribeOptions> requests;
+        // What the relay was last asked for.
+        SubscribeOptions effective;
+        // With no requests left, when the relay is finally told to unsubscribe.
+        std::chrono::steady_clock::time_point lingerUntil;
+    };
+    static SubscribeOptions MergeRequests(const SourceSubscription& subscription);
 
+    // Guards the tables below; subscribe messages are sent while holding it so the
+    // relay always sees them in order.
     std::mutex subscriptionsMutex_;
-    std::vector<std::string> subscribedSources_;
+    std::unordered_map<std::string, SourceSubscription> subscriptions_;
+    std::unordered_map<int, std::string> subscriptionSources_;
+    int nextSubscriptionToken_ { 1 };
+    // Sources with no requests still subscribed at the relay; read without the lock
+    // by the ingest thread, which only polls for expiry while there are some.
+    std::atomic<int> lingering_ { 0 };
+
+    struct PendingRequest {
+        const Connection* connection { nullptr };
+        ResponseHandler handler;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    // Requests waiting for a response, by JSON-RPC id. Handlers run outside the lock.
+    std::mutex pendingMutex_;
+    std::unordered_map<std::string, PendingRequest> pending_;
+    // pending_.size(), for the ingest loop's timeout without taking the lock.
+    std::atomic<std::size_t> pendingCount_ { 0 };
 
     std::atomic<uint64_t> requestCounter_ { 0 };
 };
@@ -0,0 +1,64 @@
+#include "hardware/ReceiveBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hardware {
+
+ReceiveBuffer::ReceiveBuffer(std::size_t receiveSize)
+    : receiveSize_(std::max<std::size_t>(receiveSize, 1))
+{
+}
+
+void ReceiveBuffer::reset(std::size_t receiveSize)
+{
+    receiveSize_ = std::max<std::size_t>(receiveSize, 1);
+    clear();
+}
+
+void ReceiveBuffer::clear()
+{
+    readPos_ = 0;
+    writePos_ = 0;
+}
+
+std::span<char> ReceiveBuffer::prepareWrite()
+{
+    if (storage_.size() - writePos_ < receiveSize_) {
+        if (readPos_ > 0) {
+            // Compact: move the unread tail (usually a partial message) to the front.
+            const std::size_t unread = writePos_ - readPos_;
+            if (unread > 0) {
+                std::memmove(storage_.data(), storage_.data() + readPos_, unread);
+            }
+            readPos_ = 0;
+            writePos_ = unread;
+        }
+        if (storage_.size() - writePos_ < receiveSize_) {
+            storage_.resize(std::max(storage_.size() * 2, writePos_ + receiveSize_));
+        }
+    }
+    return { storage_.data() + writePos_, storage_.size() - writePos_ };
+}
+
+void ReceiveBuffer::commitWrite(std::size_t bytes)
+{
+    writePos_ = std::min(writePos_ + bytes, storage_.size());
+}
+
+std::string_view ReceiveBuffer::readable() const
+{
+    return { storage_.data() + readPos_, writePos_ - readPos_ };
+}
+
+void ReceiveBuffer::consume(std::size_t bytes)
+{
+    readPos_ = std::min(readPos_ + bytes, writePos_);
+    if (readPos_ == writePos_) {
+        // Fully drained: rewind for free instead of compacting later.
+        readPos_ = 0;
+        writePos_ = 0;
+    }
+}
+
+} // namespace hardware
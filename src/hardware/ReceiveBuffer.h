@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace hardware {
+
+/**
+ * @brief Reusable socket receive buffer with separate read and write cursors.
+ *
+ * `recv` writes straight into `prepareWrite()`, messages are parsed in place as
+ * views over `readable()`, and `consume()` just advances the read cursor. Unread
+ * bytes are only moved to the front when the free tail gets smaller than one
+ * receive, and the buffer only grows when a single message outgrows it.
+ */
+class ReceiveBuffer {
+public:
+    explicit ReceiveBuffer(std::size_t receiveSize = kDefaultReceiveSize);
+
+    static constexpr std::size_t kDefaultReceiveSize = 64 * 1024;
+
+    // Drops any buffered data and sets the minimum free space offered per receive.
+    void reset(std::size_t receiveSize);
+    void clear();
+
+    [[nodiscard]] std::span<char> prepareWrite();
+    void commitWrite(std::size_t bytes);
+
+    [[nodiscard]] std::string_view readable() const;
+    void consume(std::size_t bytes);
+
+    [[nodiscard]] bool empty() const { return readPos_ == writePos_; }
+    [[nodiscard]] std::size_t capacity() const { return storage_.size(); }
+
+private:
+    std::vector<char> storage_;
+    std::size_t readPos_{0};
+    std::size_t writePos_{0};
+    std::size_t receiveSize_;
+};
+
+}  // namespace hardware
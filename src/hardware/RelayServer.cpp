@@ -0,0 +1,904 @@
+#include "hardware/RelayServer.h"
+
+#include "core/DataRegistry.h"
+#include "core/Metrics.h"
+#include "hardware/BinaryFrameCodec.h"
+#include "hardware/HardwareServiceClient.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include <spdlog/spdlog.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace {
+
+const core::metrics::Counter kFramesServed { "server.frames" };
+// Data frames a client was too far behind to take.
+const core::metrics::Counter kFramesDropped { "server.dropped" };
+const core::metrics::Gauge kClients { "server.clients" };
+// Frames that did not fit in a client's shared-memory ring.
+const core::metrics::Counter kRingDropped { "server.ring.dropped" };
+// Frames skipped for a client by its maxRateHz.
+const core::metrics::Counter kFramesLimited { "server.limited" };
+
+constexpr int kReadsPerEvent = 8;
+// Frames waiting to be encoded per subscribed source.
+constexpr std::size_t kFeedQueueCapacity = 256;
+// Clients only send small requests; anything longer without a newline is garbage.
+constexpr std::size_t kMaxRequestBytes = 1024 * 1024;
+
+constexpr int kMethodNotFound = -32601;
+constexpr int kInvalidParams = -32602;
+constexpr int kParseError = -32700;
+
+const char* KindName(core::DataKind kind)
+{
+    switch (kind) {
+    case core::DataKind::Numeric:
+        return "numeric";
+    case core::DataKind::Waveform:
+        return "waveform";
+    case core::DataKind::Serial:
+        return "serial";
+    case core::DataKind::Logic:
+        return "logic";
+    case core::DataKind::GpioState:
+        return "gpio";
+    case core::DataKind::Custom:
+        break;
+    }
+    return "custom";
+}
+
+nlohmann::json MetadataJson(const core::SourceMetadata& metadata)
+{
+    nlohmann::json json {
+        { "id", metadata.id },
+        { "name", metadata.name },
+        { "kind", KindName(metadata.kind) },
+        { "description", metadata.description },
+    };
+    if (metadata.unit) {
+        json["unit"] = *metadata.unit;
+    }
+    return json;
+}
+
+nlohmann::json Notification(const char* method, nlohmann::json params)
+{
+    return { { "jsonrpc", "2.0" }, { "method", method }, { "params", std::move(params) } };
+}
+
+nlohmann::json Result(const nlohmann::json& id, nlohmann::json result)
+{
+    return { { "jsonrpc", "2.0" }, { "id", id }, { "result", std::move(result) } };
+}
+
+nlohmann::json Error(const nlohmann::json& id, int code, const std::string& message)
+{
+    return { { "jsonrpc", "2.0" }, { "id", id }, { "error", { { "code", code }, { "message", message } } } };
+}
+
+// Bulk sources, the ones worth a ring of their own.
+bool UsesRing(core::DataKind kind)
+{
+    return kind == core::DataKind::Waveform || kind == core::DataKind::Logic;
+}
+
+std::string RingName()
+{
+    static std::atomic<unsigned> counter { 0 };
+#ifndef _WIN32
+    const long pid = static_cast<long>(::getpid());
+#else
+    const long pid = 0;
+#endif
+    return "/workbench-" + std::to_string(pid) + "-" + std::to_string(++counter);
+}
+
+hardware::Decimation ParseDecimation(const std::string& name)
+{
+    using hardware::Decimation;
+    if (name == "last") {
+        return Decimation::Last;
+    }
+    if (name == "mean") {
+        return Decimation::Mean;
+    }
+    if (name == "minmax") {
+        return Decimation::MinMax;
+    }
+    return Decimation::None;
+}
+
+// Reduces `in` to at most `points` samples: the newest of each interval, its mean, or
+// its minimum and maximum in the order they came.
+void ReduceSamples(const std::vector<double>& in, std::size_t points, hardware::Decimation decimation, std::vector<double>& out)
+{
+    using hardware::Decimation;
+    out.clear();
+    const std::size_t buckets = decimation == Decimation::MinMax ? std::max<std::size_t>(points / 2, 1) : points;
+    for (std::size_t i = 0; i < buckets; ++i) {
+        const auto begin = in.begin() + static_cast<std::ptrdiff_t>(i * in.size() / buckets);
+        const auto end = in.begin() + static_cast<std::ptrdiff_t>((i + 1) * in.size() / buckets);
+        if (begin == end) {
+            continue;
+        }
+        if (decimation == Decimation::Mean) {
+            double sum = 0.0;
+            for (auto it = begin; it != end; ++it) {
+                sum += *it;
+            }
+            out.push_back(sum / static_cast<double>(end - begin));
+        } else if (decimation == Decimation::MinMax) {
+            const auto [low, high] = std::minmax_element(begin, end);
+            out.push_back(low < high ? *low : *high);
+            if (end - begin > 1) {
+                out.push_back(low < high ? *high : *low);
+            }
+        } else {
+            out.push_back(*(end - 1));
+        }
+    }
+}
+
+// One frame's encodings, one per distinct point budget, each built on first use.
+// Kept per dispatch worker so the buffers are reused from frame to frame.
+class FrameEncodings {
+public:
+    void reset(const core::DataFrame& frame)
+    {
+        frame_ = &frame;
+        used_ = 0;
+    }
+
+    const std::string& get(const hardware::SubscribeOptions& limits)
+    {
+        using hardware::Decimation;
+        const std::size_t points = limits.waveformPointBudget;
+        auto decimation = points > 0 ? limits.decimation : Decimation::None;
+        for (std::size_t i = 0; i < used_; ++i) {
+            if (entries_[i].points == points && entries_[i].decimation == decimation) {
+                return entries_[i].bytes;
+            }
+        }
+        if (used_ == entries_.size()) {
+            entries_.emplace_back();
+        }
+        auto& entry = entries_[used_++];
+        entry.points = points;
+        entry.decimation = decimation;
+        entry.bytes.clear();
+        if (points == 0 || !exceeds(points)) {
+            hardware::binary::EncodeDataFrame(*frame_, entry.bytes);
+            return entry.bytes;
+        }
+        if (decimation == Decimation::None || (decimation == Decimation::MinMax && points < 2)) {
+            decimation = Decimation::Last;
+        }
+        reduced_ = *frame_;
+        for (auto& point : reduced_.points) {
+            auto* waveform = std::get_if<core::WaveformSample>(&point.payload);
+            if (!waveform || waveform->samples.size() <= points) {
+                continue;
+            }
+            const auto count = waveform->samples.size();
+            ReduceSamples(waveform->samples, points, decimation, scratch_);
+            waveform->sampleRateHz *= static_cast<double>(scratch_.size()) / static_cast<double>(count);
+            waveform->samples.swap(scratch_);
+        }
+        hardware::binary::EncodeDataFrame(reduced_, entry.bytes);
+        return entry.bytes;
+    }
+
+private:
+    struct Entry {
+        std::size_t points { 0 };
+        hardware::Decimation decimation { hardware::Decimation::None };
+        std::string bytes;
+    };
+
+    bool exceeds(std::size_t points) const
+    {
+        return std::any_of(frame_->points.begin(), frame_->points.end(), [points](const core::DataPoint& point) {
+            const auto* waveform = std::get_if<core::WaveformSample>(&point.payload);
+            return waveform && waveform->samples.size() > points;
+        });
+    }
+
+    const core::DataFrame* frame_ { nullptr };
+    // Almost always one entry: clients rarely ask for different budgets.
+    std::vector<Entry> entries_;
+    std::size_t used_ { 0 };
+    core::DataFrame reduced_;
+    std::vector<double> scratch_;
+};
+
+void CloseFd(int& fd)
+{
+#ifndef _WIN32
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+    fd = -1;
+}
+
+} // namespace
+
+namespace hardware {
+
+RelayServer::Wakeup::~Wakeup()
+{
+    CloseFd(fd);
+}
+
+void RelayServer::Wakeup::signal() const
+{
+#ifdef __linux__
+    if (fd >= 0) {
+        const std::uint64_t one = 1;
+        (void)!::write(fd, &one, sizeof(one));
+    }
+#endif
+}
+
+RelayServer::RelayServer(core::DataRegistry& registry, HardwareServiceClient& hardwareService)
+    : registry_(registry)
+    , hardwareService_(hardwareService)
+{
+}
+
+RelayServer::~RelayServer()
+{
+    stop();
+}
+
+bool RelayServer::start(Options options)
+{
+#ifdef __linux__
+    if (running_) {
+        return true;
+    }
+    options_ = std::move(options);
+    const auto& path = options_.socketPath;
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        spdlog::error("RelayServer: invalid socket path '{}'", path);
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    // A socket left behind by a previous run would make bind() fail; other files are kept.
+    struct stat existing {};
+    if (::lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        ::unlink(path.c_str());
+    }
+
+    auto wakeup = std::make_shared<Wakeup>();
+    wakeup->fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const char* failed = nullptr;
+    if (wakeup->fd < 0 || epollFd_ < 0 || listenFd_ < 0) {
+        failed = "socket setup";
+    } else if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        failed = "bind()";
+    } else if (::listen(listenFd_, SOMAXCONN) != 0) {
+        failed = "listen()";
+    } else {
+        epoll_event wakeEvent {};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.ptr = nullptr;
+        epoll_event listenEvent {};
+        listenEvent.events = EPOLLIN;
+        listenEvent.data.ptr = &listenFd_;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeup->fd, &wakeEvent) != 0
+            || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &listenEvent) != 0) {
+            failed = "epoll_ctl()";
+        }
+    }
+    if (failed) {
+        spdlog::error("RelayServer: cannot serve on '{}': {} failed: {}", path, failed, std::strerror(errno));
+        CloseFd(listenFd_);
+        CloseFd(epollFd_);
+        return false;
+    }
+    wakeup_ = std::move(wakeup);
+
+    // Catalog changes reach every registered client. Runs on whichever thread changed
+    // the catalog, so it only queues.
+    catalogToken_ = registry_.catalog().addObserver([this, wakeup = wakeup_](const core::SourceEvent& event) {
+        auto metadata = MetadataJson(*event.source);
+        if (event.type == core::SourceEventType::Removed) {
+            metadata["removed"] = true;
+        }
+        const auto message = Notification("workbench.metadata", std::move(metadata)).dump();
+        std::lock_guard lock(clientsMutex_);
+        for (const auto& client : clients_) {
+            Queue(*client, message, Outgoing::Notification, options_.maxClientBacklog);
+        }
+        wakeup->signal();
+    });
+
+    running_ = true;
+    worker_ = std::thread(&RelayServer::run, this);
+    spdlog::info("RelayServer: serving the registry on '{}'", path);
+    return true;
+#else
+    (void)options;
+    spdlog::error("RelayServer: serving needs epoll (Linux)");
+    return false;
+#endif
+}
+
+void RelayServer::stop()
+{
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    wakeup_->signal();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    registry_.catalog().removeObserver(catalogToken_);
+    catalogToken_ = 0;
+    for (auto& [sourceId, feed] : feeds_) {
+        registry_.removeObserver(sourceId, feed->token);
+    }
+    feeds_.clear();
+    {
+        std::lock_guard lock(clientsMutex_);
+        for (auto& client : clients_) {
+            std::lock_guard clientLock(client->outboxMutex);
+            client->closed = true;
+            CloseFd(client->fd);
+        }
+        clients_.clear();
+    }
+    kClients.set(0);
+    CloseFd(listenFd_);
+    CloseFd(epollFd_);
+#ifndef _WIN32
+    ::unlink(options_.socketPath.c_str());
+#endif
+    wakeup_.reset();
+}
+
+std::size_t RelayServer::clientCount() const
+{
+    std::lock_guard lock(clientsMutex_);
+    return clients_.size();
+}
+
+void RelayServer::Queue(Client& client, std::string_view bytes, Outgoing kind, std::size_t maxBacklog)
+{
+    std::lock_guard lock(client.outboxMutex);
+    if (client.closed || (kind != Outgoing::Reply && !client.registered)) {
+        return;
+    }
+    if (kind == Outgoing::Data) {
+        if (client.outbox.size() >= maxBacklog) {
+            kFramesDropped.add();
+            return;
+        }
+        client.outbox.append(bytes);
+        return;
+    }
+    // Everything after the registerClient response is length-prefixed.
+    if (client.registered) {
+        binary::EncodeJson(bytes, client.outbox);
+    } else {
+        client.outbox.append(bytes);
+        client.outbox.push_back('\n');
+    }
+}
+
+void RelayServer::Deliver(Client& client, const std::string& sourceId, std::string_view encoded, std::size_t maxBacklog)
+{
+    {
+        std::lock_guard lock(client.outboxMutex);
+        const auto it = client.rings.find(sourceId);
+        // A frame too big for the ring would be dropped every time; the socket takes it.
+        if (it != client.rings.end() && it->second->accepts(encoded.size())) {
+            bool wake = false;
+            if (!it->second->push(encoded, wake)) {
+                kRingDropped.add();
+            } else if (wake && !client.closed) {
+                binary::EncodeJson(Notification("workbench.ringReady", { { "sourceId", sourceId } }).dump(), client.outbox);
+            }
+            return;
+        }
+    }
+    Queue(client, encoded, Outgoing::Data, maxBacklog);
+}
+
+void RelayServer::run()
+{
+#ifdef __linux__
+    std::array<epoll_event, 16> events {};
+    while (running_) {
+        std::vector<ClientPtr> clients;
+        {
+            std::lock_guard lock(clientsMutex_);
+            clients = clients_;
+        }
+        for (const auto& client : clients) {
+            flush(*client);
+        }
+
+        const int count = ::epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("RelayServer: epoll_wait failed: {}", std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            void* tag = events[i].data.ptr;
+            if (tag == nullptr) {
+                // Queued output is flushed at the top of the loop.
+                std::uint64_t value = 0;
+                (void)!::read(wakeup_->fd, &value, sizeof(value));
+                continue;
+            }
+            if (tag == &listenFd_) {
+                accept();
+                continue;
+            }
+            // Find the owning pointer; a client dropped earlier in this batch is gone.
+            ClientPtr client;
+            {
+                std::lock_guard lock(clientsMutex_);
+                const auto it = std::find_if(clients_.begin(), clients_.end(), [tag](const ClientPtr& candidate) {
+                    return candidate.get() == tag;
+                });
+                if (it != clients_.end()) {
+                    client = *it;
+                }
+            }
+            if (!client) {
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                readAvailable(client);
+                if (client->fd < 0) {
+                    continue;
+                }
+            }
+            if ((events[i].events & EPOLLOUT) != 0) {
+                flush(*client);
+            }
+        }
+    }
+#endif
+}
+
+void RelayServer::accept()
+{
+#ifdef __linux__
+    for (;;) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                spdlog::warn("RelayServer: accept() failed: {}", std::strerror(errno));
+            }
+            return;
+        }
+        auto client = std::make_shared<Client>();
+        client->fd = fd;
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.ptr = client.get();
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            spdlog::warn("RelayServer: epoll_ctl() failed for a new client: {}", std::strerror(errno));
+            CloseFd(client->fd);
+            continue;
+        }
+        std::size_t count = 0;
+        {
+            std::lock_guard lock(clientsMutex_);
+            clients_.push_back(std::move(client));
+            count = clients_.size();
+        }
+        kClients.set(static_cast<std::int64_t>(count));
+        spdlog::info("RelayServer: client connected ({} connected)", count);
+    }
+#endif
+}
+
+void RelayServer::drop(const ClientPtr& client, const std::string& reason)
+{
+#ifdef __linux__
+    if (client->fd >= 0) {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, client->fd, nullptr);
+    }
+#endif
+    const std::vector<std::string> subscriptions(client->subscriptions.begin(), client->subscriptions.end());
+    for (const auto& sourceId : subscriptions) {
+        unsubscribe(client, sourceId);
+    }
+    {
+        std::lock_guard lock(client->outboxMutex);
+        client->closed = true;
+        client->outbox.clear();
+    }
+    CloseFd(client->fd);
+    std::size_t count = 0;
+    {
+        std::lock_guard lock(clientsMutex_);
+        std::erase(clients_, client);
+        count = clients_.size();
+    }
+    kClients.set(static_cast<std::int64_t>(count));
+    spdlog::info("RelayServer: client disconnected: {} ({} connected)", reason, count);
+}
+
+void RelayServer::readAvailable(const ClientPtr& client)
+{
+#ifndef _WIN32
+    for (int i = 0; i < kReadsPerEvent; ++i) {
+        const auto space = client->readBuffer.prepareWrite();
+        const ssize_t bytesRead = ::recv(client->fd, space.data(), space.size(), 0);
+        if (bytesRead > 0) {
+            client->readBuffer.commitWrite(static_cast<std::size_t>(bytesRead));
+            auto& buffer = client->readBuffer;
+            while (!buffer.empty()) {
+                const std::string_view pending = buffer.readable();
+                const std::size_t newlinePos = pending.find('\n', client->newlineScanOffset);
+                if (newlinePos == std::string_view::npos) {
+                    client->newlineScanOffset = pending.size();
+                    if (pending.size() > kMaxRequestBytes) {
+                        drop(client, "oversized request");
+                        return;
+                    }
+                    break;
+                }
+                client->newlineScanOffset = 0;
+                if (newlinePos > 0) {
+                    handleLine(client, pending.substr(0, newlinePos));
+                }
+                buffer.consume(newlinePos + 1);
+            }
+            continue;
+        }
+        if (bytesRead == 0) {
+            drop(client, "connection closed by the client");
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        }
+        drop(client, std::string("recv() failed: ") + std::strerror(errno));
+        return;
+    }
+#else
+    (void)client;
+#endif
+}
+
+void RelayServer::flush(Client& client)
+{
+#ifndef _WIN32
+    if (client.fd < 0) {
+        return;
+    }
+    for (;;) {
+        if (client.sendOffset == client.sending.size()) {
+            client.sending.clear();
+            client.sendOffset = 0;
+            std::lock_guard lock(client.outboxMutex);
+            client.sending.swap(client.outbox);
+        }
+        if (client.sending.empty()) {
+            break;
+        }
+        const ssize_t sent = ::send(client.fd, client.sending.data() + client.sendOffset,
+            client.sending.size() - client.sendOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            client.sendOffset += static_cast<std::size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // The read side reports the hang-up and drops the client.
+        client.sending.clear();
+        client.sendOffset = 0;
+        break;
+    }
+    const bool pending = client.sendOffset < client.sending.size();
+    if (pending != client.wantWrite) {
+        client.wantWrite = pending;
+        updateInterest(client);
+    }
+#else
+    (void)client;
+#endif
+}
+
+void RelayServer::updateInterest(Client& client)
+{
+#ifdef __linux__
+    epoll_event event {};
+    event.events = EPOLLIN | (client.wantWrite ? EPOLLOUT : 0u);
+    event.data.ptr = &client;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, client.fd, &event);
+#else
+    (void)client;
+#endif
+}
+
+void RelayServer::handleLine(const ClientPtr& client, std::string_view line)
+{
+    const auto message = nlohmann::json::parse(line, nullptr, false);
+    bool negotiated = false;
+    nlohmann::json reply;
+    if (message.is_discarded()) {
+        reply = Error(nullptr, kParseError, "malformed JSON");
+    } else if (message.is_array()) {
+        reply = nlohmann::json::array();
+        for (const auto& request : message) {
+            auto response = handleRequest(client, request, negotiated);
+            if (!response.is_null()) {
+                reply.push_back(std::move(response));
+            }
+        }
+    } else {
+        reply = handleRequest(client, message, negotiated);
+    }
+    if (!reply.is_null() && !(reply.is_array() && reply.empty())) {
+        Queue(*client, reply.dump(), Outgoing::Reply, options_.maxClientBacklog);
+    }
+    if (!negotiated) {
+        return;
+    }
+    // Everything behind the registerClient response is framed, starting with the catalog.
+    {
+        std::lock_guard lock(client->outboxMutex);
+        client->registered = true;
+    }
+    announceCatalog(*client);
+}
+
+nlohmann::json RelayServer::handleRequest(const ClientPtr& client, const nlohmann::json& request, bool& negotiated)
+{
+    try {
+        return dispatchRequest(client, request, negotiated);
+    } catch (const nlohmann::json::exception& ex) {
+        // A field of the wrong type ("sourceId": 5, say) is the client's mistake, not
+        // a reason to take the server down.
+        if (!request.is_object() || !request.contains("id")) {
+            return nullptr;
+        }
+        return Error(request.at("id"), kInvalidParams, std::string("invalid params: ") + ex.what());
+    }
+}
+
+nlohmann::json RelayServer::dispatchRequest(const ClientPtr& client, const nlohmann::json& request, bool& negotiated)
+{
+    if (!request.is_object() || !request.contains("method") || !request.at("method").is_string()) {
+        return Error(request.is_object() ? request.value("id", nlohmann::json()) : nlohmann::json(), kInvalidParams,
+            "expected a JSON-RPC request");
+    }
+    const auto method = request.at("method").get<std::string>();
+    const bool notification = !request.contains("id");
+    const auto id = request.value("id", nlohmann::json());
+    const auto params = request.value("params", nlohmann::json::object());
+    const auto reply = [&](nlohmann::json response) {
+        return notification ? nlohmann::json() : std::move(response);
+    };
+    const auto sourceId = params.is_object() ? params.value("sourceId", "") : std::string();
+
+    bool registered = false;
+    {
+        std::lock_guard lock(client->outboxMutex);
+        registered = client->registered;
+    }
+    if (method == "workbench.registerClient") {
+        const int protocol = params.is_object() ? params.value("protocol", 1) : 1;
+        if (protocol < binary::kProtocolVersion) {
+            return reply(Error(id, kInvalidParams, "this relay serves protocol 2 only"));
+        }
+        negotiated = !registered;
+        return reply(Result(id, { { "relayVersion", "workbench-server" }, { "protocol", binary::kProtocolVersion } }));
+    }
+    if (!registered) {
+        return reply(Error(id, kInvalidParams, "send workbench.registerClient with protocol 2 first"));
+    }
+    if (method == "workbench.subscribe" || method == "workbench.unsubscribe") {
+        if (sourceId.empty()) {
+            return reply(Error(id, kInvalidParams, "sourceId is required"));
+        }
+        if (method == "workbench.subscribe") {
+            SubscribeOptions limits;
+            limits.maxRateHz = std::max(params.value("maxRateHz", 0.0), 0.0);
+            limits.decimation = ParseDecimation(params.value("decimation", ""));
+            limits.waveformPointBudget = params.value("waveformPoints", std::uint32_t { 0 });
+            subscribe(client, sourceId, params.value("transport", "") == "shm", limits);
+        } else {
+            unsubscribe(client, sourceId);
+        }
+        return reply(Result(id, nlohmann::json::object()));
+    }
+    if (method == "workbench.resetMetric") {
+        const auto channelId = params.value("channelId", "");
+        const auto metric = params.value("metric", "");
+        // Answered whenever the upstream relay does; the client matches replies by id.
+        hardwareService_.requestMetricReset(sourceId, channelId, metric,
+            [weak = std::weak_ptr(client), wakeup = wakeup_, id, notification,
+                maxBacklog = options_.maxClientBacklog](bool ok, const nlohmann::json& payload) {
+                auto target = weak.lock();
+                if (!target || notification) {
+                    return;
+                }
+                const auto response = ok ? Result(id, payload)
+                                         : Error(id, payload.value("code", HardwareServiceClient::kClientErrorCode),
+                                               payload.value("message", "reset failed"));
+                Queue(*target, response.dump(), Outgoing::Reply, maxBacklog);
+                wakeup->signal();
+            });
+        return nullptr;
+    }
+    return reply(Error(id, kMethodNotFound, "unknown method '" + method + "'"));
+}
+
+void RelayServer::subscribe(const ClientPtr& client, const std::string& sourceId, bool sharedMemory,
+    const SubscribeOptions& limits)
+{
+    if (!client->subscriptions.insert(sourceId).second) {
+        const auto& feed = feeds_.at(sourceId);
+        std::lock_guard lock(feed->mutex);
+        for (auto& subscriber : feed->subscribers) {
+            if (subscriber.client == client) {
+                subscriber.limits = limits;
+            }
+        }
+        // Asking again without shared memory is how a client gives up on its ring.
+        bool hadRing = false;
+        if (!sharedMemory) {
+            std::lock_guard clientLock(client->outboxMutex);
+            hadRing = client->rings.erase(sourceId) > 0;
+        }
+        if (hadRing) {
+            Queue(*client, Notification("workbench.ring", { { "sourceId", sourceId }, { "closed", true } }).dump(),
+                Outgoing::Notification, options_.maxClientBacklog);
+        }
+        return;
+    }
+    auto& feed = feeds_[sourceId];
+    if (!feed) {
+        feed = std::make_shared<Feed>();
+        core::ObserverOptions options;
+        options.delivery = core::ObserverDelivery::Queued;
+        options.policy = core::BackpressurePolicy::DropOldest;
+        options.queueCapacity = kFeedQueueCapacity;
+        feed->token = registry_.addObserver(sourceId,
+            [feed = std::weak_ptr(feed), sourceId, wakeup = wakeup_, maxBacklog = options_.maxClientBacklog](
+                const core::DataFrame& frame) {
+                auto target = feed.lock();
+                if (!target) {
+                    return;
+                }
+                // Encoded on the dispatch worker, once per point budget among the clients.
+                thread_local FrameEncodings encodings;
+                encodings.reset(frame);
+                kFramesServed.add();
+                const auto now = std::chrono::steady_clock::now();
+                std::lock_guard lock(target->mutex);
+                for (auto& subscriber : target->subscribers) {
+                    if (subscriber.limits.maxRateHz > 0.0
+                        && now - subscriber.lastSent < std::chrono::duration<double>(1.0 / subscriber.limits.maxRateHz)) {
+                        kFramesLimited.add();
+                        continue;
+                    }
+                    subscriber.lastSent = now;
+                    Deliver(*subscriber.client, sourceId, encodings.get(subscriber.limits), maxBacklog);
+                }
+                wakeup->signal();
+            },
+            options);
+    }
+    // The snapshot is queued under the feed lock, so frames published after it are
+    // queued behind it.
+    std::lock_guard lock(feed->mutex);
+    const auto metadata = sharedMemory ? registry_.metadata(sourceId) : std::nullopt;
+    if (metadata && UsesRing(metadata->kind)) {
+        // Announced ahead of the snapshot, so the client has mapped the ring before the
+        // first doorbell. Without a ring the frames simply stay on the socket.
+        if (auto ring = SharedRing::Create(RingName())) {
+            const auto announcement = Notification("workbench.ring",
+                { { "sourceId", sourceId }, { "name", ring->name() }, { "bytes", ring->capacity() } })
+                                          .dump();
+            Queue(*client, announcement, Outgoing::Notification, options_.maxClientBacklog);
+            std::lock_guard clientLock(client->outboxMutex);
+            client->rings.insert_or_assign(sourceId, std::move(ring));
+        }
+    }
+    Subscriber subscriber { client, limits, {} };
+    if (auto latest = registry_.latestShared(sourceId)) {
+        FrameEncodings encodings;
+        encodings.reset(*latest);
+        Deliver(*client, sourceId, encodings.get(limits), options_.maxClientBacklog);
+        subscriber.lastSent = std::chrono::steady_clock::now();
+    }
+    feed->subscribers.push_back(std::move(subscriber));
+}
+
+void RelayServer::unsubscribe(const ClientPtr& client, const std::string& sourceId)
+{
+    if (client->subscriptions.erase(sourceId) == 0) {
+        return;
+    }
+    const auto it = feeds_.find(sourceId);
+    if (it == feeds_.end()) {
+        return;
+    }
+    bool empty = false;
+    {
+        std::lock_guard lock(it->second->mutex);
+        std::erase_if(it->second->subscribers, [&](const Subscriber& subscriber) { return subscriber.client == client; });
+        empty = it->second->subscribers.empty();
+    }
+    // Out of the feed now, so nothing pushes into the ring any more. The client reads
+    // what is left in it before letting go of its mapping.
+    bool hadRing = false;
+    {
+        std::lock_guard lock(client->outboxMutex);
+        hadRing = client->rings.erase(sourceId) > 0;
+    }
+    if (hadRing) {
+        Queue(*client, Notification("workbench.ring", { { "sourceId", sourceId }, { "closed", true } }).dump(),
+            Outgoing::Notification, options_.maxClientBacklog);
+    }
+    if (empty) {
+        registry_.removeObserver(sourceId, it->second->token);
+        feeds_.erase(it);
+    }
+}
+
+void RelayServer::announceCatalog(Client& client)
+{
+    auto sources = nlohmann::json::array();
+    for (const auto& entry : registry_.catalog().query()) {
+        sources.push_back(MetadataJson(*entry));
+    }
+    if (sources.empty()) {
+        return;
+    }
+    Queue(client, Notification("workbench.metadata", std::move(sources)).dump(), Outgoing::Notification,
+        options_.maxClientBacklog);
+}
+
+} // namespace hardware
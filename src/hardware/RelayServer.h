@@ -0,0 +1,157 @@
+#pragma once
+
+#include "hardware/HardwareServiceClient.h"
+#include "hardware/ReceiveBuffer.h"
+#include "hardware/SharedRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace core {
+class DataRegistry;
+} // namespace core
+
+namespace hardware {
+
+/**
+ * @brief Serves a registry to other workbench processes as a hardware relay.
+ *
+ * Speaks the relay protocol of `hardware/README.md` (protocol 2 only), so a thin
+ * dashboard is just another instance pointed at the socket with `--relay`. Each
+ * client gets the source catalog on registerClient and catalog changes as they
+ * happen; subscribing sends the source's latest frame, then every frame published
+ * after it. One queued registry observer per subscribed source encodes each frame
+ * once for all its clients, off the ingest thread. A single epoll thread accepts
+ * clients, answers their requests and writes their outboxes; a client whose
+ * backlog outgrows `maxClientBacklog` loses data frames rather than stalling the
+ * others. Metric resets are forwarded to the server's own relays.
+ *
+ * Subscription limits apply per client: frames closer together than `maxRateHz`
+ * allows are skipped for that client, and waveform points longer than its
+ * `waveformPoints` budget are reduced with its decimation mode. Each distinct
+ * budget is encoded once per frame.
+ *
+ * A client on the same host may ask for a waveform or logic source's frames to
+ * go through a `SharedRing` instead of its socket; the socket then only carries
+ * a doorbell whenever the client has drained the ring and gone back to waiting.
+ */
+class RelayServer {
+public:
+    struct Options {
+        std::string socketPath;
+        // Bytes queued per client beyond which new data frames are dropped for it.
+        std::size_t maxClientBacklog { 16 * 1024 * 1024 };
+    };
+
+    RelayServer(core::DataRegistry& registry, HardwareServiceClient& hardwareService);
+    ~RelayServer();
+
+    RelayServer(const RelayServer&) = delete;
+    RelayServer& operator=(const RelayServer&) = delete;
+
+    // Binds the socket (replacing a stale one) and starts serving; false (logged)
+    // when the socket cannot be set up.
+    bool start(Options options);
+    void stop();
+
+    [[nodiscard]] std::size_t clientCount() const;
+
+private:
+    // Shared with observers and response handlers, which may outlive a stop().
+    struct Wakeup {
+        int fd { -1 };
+        ~Wakeup();
+        void signal() const;
+    };
+
+    struct Client {
+        int fd { -1 };
+        // Loop thread only.
+        ReceiveBuffer readBuffer;
+        std::size_t newlineScanOffset { 0 };
+        std::unordered_set<std::string> subscriptions;
+        std::string sending;
+        std::size_t sendOffset { 0 };
+        bool wantWrite { false };
+
+        std::mutex outboxMutex;
+        std::string outbox;
+        // Shared-memory rings by source id, written under outboxMutex like the outbox.
+        std::unordered_map<std::string, std::unique_ptr<SharedRing>> rings;
+        // Protocol 2 negotiated: replies are framed and notifications may be sent.
+        bool registered { false };
+        bool closed { false };
+    };
+    using ClientPtr = std::shared_ptr<Client>;
+
+    struct Subscriber {
+        ClientPtr client;
+        SubscribeOptions limits;
+        std::chrono::steady_clock::time_point lastSent;
+    };
+
+    // Clients subscribed to one source, fed by one registry observer.
+    struct Feed {
+        std::mutex mutex;
+        std::vector<Subscriber> subscribers;
+        int token { 0 };
+    };
+
+    enum class Outgoing {
+        // Replies go out even before registration, as newline JSON.
+        Reply,
+        Notification,
+        // Dropped once the client's backlog is full.
+        Data
+    };
+    static void Queue(Client& client, std::string_view bytes, Outgoing kind, std::size_t maxBacklog);
+    // Queues an encoded data frame of `sourceId`, through the client's ring if it has one.
+    static void Deliver(Client& client, const std::string& sourceId, std::string_view encoded, std::size_t maxBacklog);
+
+    void run();
+    void accept();
+    void drop(const ClientPtr& client, const std::string& reason);
+    void readAvailable(const ClientPtr& client);
+    void flush(Client& client);
+    void updateInterest(Client& client);
+    void handleLine(const ClientPtr& client, std::string_view line);
+    // The response for one request, or null for notifications and forwarded requests.
+    // Sets `negotiated` when the request registered the client.
+    nlohmann::json handleRequest(const ClientPtr& client, const nlohmann::json& request, bool& negotiated);
+    // handleRequest() without the guard against malformed fields, which throw.
+    nlohmann::json dispatchRequest(const ClientPtr& client, const nlohmann::json& request, bool& negotiated);
+    // `sharedMemory` asks for the frames to go through a ring, for the kinds that use one.
+    // Subscribing again only replaces the limits.
+    void subscribe(const ClientPtr& client, const std::string& sourceId, bool sharedMemory, const SubscribeOptions& limits);
+    void unsubscribe(const ClientPtr& client, const std::string& sourceId);
+    void announceCatalog(Client& client);
+
+    core::DataRegistry& registry_;
+    HardwareServiceClient& hardwareService_;
+    Options options_;
+
+    std::atomic<bool> running_ { false };
+    std::thread worker_;
+    int epollFd_ { -1 };
+    int listenFd_ { -1 };
+    std::shared_ptr<Wakeup> wakeup_;
+    int catalogToken_ { 0 };
+
+    // Written by the loop thread; the catalog observer reads it under the lock.
+    mutable std::mutex clientsMutex_;
+    std::vector<ClientPtr> clients_;
+    // Loop thread only (and stop() once it has joined).
+    std::unordered_map<std::string, std::shared_ptr<Feed>> feeds_;
+};
+
+} // namespace hardware
@@ -0,0 +1,160 @@
+#include "hardware/SharedRing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hardware {
+
+namespace {
+
+constexpr char kMagic[8] = { 'W', 'B', 'R', 'I', 'N', 'G', '0', '1' };
+constexpr std::uint32_t kVersion = 1;
+
+} // namespace
+
+SharedRing::SharedRing(std::string name, void* mapping, std::size_t mappedBytes)
+    : name_(std::move(name))
+    , mapping_(mapping)
+    , mappedBytes_(mappedBytes)
+    , header_(static_cast<Header*>(mapping))
+    , data_(static_cast<char*>(mapping) + sizeof(Header))
+    , capacity_(mappedBytes - sizeof(Header))
+{
+}
+
+SharedRing::~SharedRing()
+{
+#ifndef _WIN32
+    if (mapping_) {
+        ::munmap(mapping_, mappedBytes_);
+    }
+    if (owner_) {
+        // Usually gone already: the consumer unlinks the name once it has mapped it.
+        ::shm_unlink(name_.c_str());
+    }
+#endif
+}
+
+std::unique_ptr<SharedRing> SharedRing::Create(const std::string& name, std::size_t capacity)
+{
+#ifndef _WIN32
+    capacity = std::bit_ceil(std::max<std::size_t>(capacity, 4096));
+    const std::size_t bytes = sizeof(Header) + capacity;
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        spdlog::error("SharedRing: cannot create '{}': {}", name, std::strerror(errno));
+        return nullptr;
+    }
+    void* mapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int err = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        spdlog::error("SharedRing: cannot map '{}': {}", name, std::strerror(err));
+        ::shm_unlink(name.c_str());
+        return nullptr;
+    }
+    std::unique_ptr<SharedRing> ring(new SharedRing(name, mapping, bytes));
+    ring->owner_ = true;
+    auto* header = ring->header_;
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->capacityLog2 = static_cast<std::uint32_t>(std::countr_zero(capacity));
+    header->head = 0;
+    header->tail = 0;
+    // The consumer has not drained yet, so the first push rings.
+    header->waiting = 1;
+    return ring;
+#else
+    (void)name;
+    (void)capacity;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<SharedRing> SharedRing::Open(const std::string& name)
+{
+#ifndef _WIN32
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        spdlog::error("SharedRing: cannot open '{}': {}", name, std::strerror(errno));
+        return nullptr;
+    }
+    struct stat info {};
+    void* mapping = MAP_FAILED;
+    std::size_t bytes = 0;
+    if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) > sizeof(Header)) {
+        bytes = static_cast<std::size_t>(info.st_size);
+        mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    if (mapping == MAP_FAILED) {
+        spdlog::error("SharedRing: cannot map '{}'", name);
+        return nullptr;
+    }
+    std::unique_ptr<SharedRing> ring(new SharedRing(name, mapping, bytes));
+    const auto* header = ring->header_;
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion
+        || header->capacityLog2 >= 64 || (std::size_t { 1 } << header->capacityLog2) != ring->capacity_) {
+        spdlog::error("SharedRing: '{}' is not a version {} ring", name, kVersion);
+        return nullptr;
+    }
+    return ring;
+#else
+    (void)name;
+    return nullptr;
+#endif
+}
+
+void SharedRing::markBroken(std::uint64_t tail, std::uint64_t head)
+{
+    broken_ = true;
+    spdlog::error("SharedRing: '{}' holds a corrupt record (tail {}, head {}); no longer reading it", name_, tail, head);
+}
+
+bool SharedRing::push(std::string_view record, bool& wake)
+{
+    wake = false;
+    std::uint32_t length = static_cast<std::uint32_t>(record.size());
+    const std::size_t need = RecordBytes(record.size());
+    // Larger records could never be placed once the ring wraps.
+    if (!accepts(record.size())) {
+        return false;
+    }
+    const std::uint64_t mask = capacity_ - 1;
+    auto headRef = Cursor(header_->head);
+    std::uint64_t head = headRef.load(std::memory_order_relaxed);
+    const std::uint64_t tail = Cursor(header_->tail).load(std::memory_order_acquire);
+    const std::size_t toEnd = capacity_ - (head & mask);
+    const std::size_t padding = need > toEnd ? toEnd : 0;
+    if (head + padding + need - tail > capacity_) {
+        return false;
+    }
+    if (padding > 0) {
+        std::memcpy(data_ + (head & mask), &kWrapMarker, sizeof(kWrapMarker));
+        head += padding;
+    }
+    char* out = data_ + (head & mask);
+    std::memcpy(out, &length, sizeof(length));
+    std::memcpy(out + sizeof(length), record.data(), record.size());
+    // Sequentially consistent, pairing with the consumer's arm-then-recheck.
+    headRef.store(head + need, std::memory_order_seq_cst);
+    wake = waiting().exchange(0, std::memory_order_seq_cst) != 0;
+    return true;
+}
+
+} // namespace hardware
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace hardware {
+
+/**
+ * @brief Single-producer/single-consumer byte ring in POSIX shared memory.
+ *
+ * Carries one source's packed data frames from a relay to a UI on the same host
+ * without socket copies. Records are the protocol 2 binary frames (header and
+ * payload) padded to 8 bytes, written in place and published by advancing `head`;
+ * the reader consumes them in place and advances `tail`. A record that does not
+ * fit before the end of the buffer is preceded by a wrap marker.
+ *
+ * Wakeups are the caller's business: the consumer sets `waiting` once it has found
+ * the ring empty, and `push` reports when it cleared that flag, in which case the
+ * producer sends a doorbell over the control socket. A busy stream therefore costs
+ * one doorbell per drain, not one per frame.
+ */
+class SharedRing {
+public:
+    static constexpr std::size_t kDefaultCapacity = 4 * 1024 * 1024;
+
+    ~SharedRing();
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    // Producer side: creates and maps `name` (e.g. "/workbench-123-1"), rounding
+    // `capacity` up to a power of two. Null (logged) on failure. The producer's
+    // destructor removes the name too, in case the consumer never opened it.
+    static std::unique_ptr<SharedRing> Create(const std::string& name, std::size_t capacity = kDefaultCapacity);
+    // Consumer side: maps an existing ring and removes its name, so nothing is left
+    // behind once both sides unmap it. Null (logged) if it is missing or malformed.
+    static std::unique_ptr<SharedRing> Open(const std::string& name);
+
+    // Producer. Appends one record; false if it does not fit (the frame is dropped).
+    // `wake` is set when the consumer was waiting and needs a doorbell.
+    bool push(std::string_view record, bool& wake);
+    // Whether a record of `bytes` can ever be pushed, however empty the ring is.
+    [[nodiscard]] bool accepts(std::size_t bytes) const { return RecordBytes(bytes) <= capacity_ / 2; }
+
+    // Consumer. Hands each record to `visit` in order until the ring is empty, then
+    // arms the wakeup. Returns the number of records read. A record that does not lie
+    // between `tail` and `head` inside the buffer marks the ring broken; it is never
+    // visited and nothing more is read from the ring.
+    template <typename Visitor>
+    std::size_t drain(Visitor&& visit);
+    [[nodiscard]] bool broken() const { return broken_; }
+
+    [[nodiscard]] const std::string& name() const { return name_; }
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t capacityLog2;
+        alignas(64) std::uint64_t head;
+        alignas(64) std::uint64_t tail;
+        alignas(64) std::uint32_t waiting;
+    };
+    static constexpr std::uint32_t kWrapMarker = 0xFFFFFFFFu;
+    static constexpr std::size_t kAlignment = 8;
+
+    SharedRing(std::string name, void* mapping, std::size_t mappedBytes);
+    // Logs the corrupt record at `tail` and stops draining.
+    void markBroken(std::uint64_t tail, std::uint64_t head);
+
+    // Space a record takes: its length word and bytes, padded to kAlignment.
+    static constexpr std::size_t RecordBytes(std::size_t bytes)
+    {
+        return (sizeof(std::uint32_t) + bytes + kAlignment - 1) & ~(kAlignment - 1);
+    }
+    static std::atomic_ref<std::uint64_t> Cursor(std::uint64_t& value) { return std::atomic_ref<std::uint64_t>(value); }
+    [[nodiscard]] std::atomic_ref<std::uint32_t> waiting() const { return std::atomic_ref<std::uint32_t>(header_->waiting); }
+
+    std::string name_;
+    void* mapping_{nullptr};
+    std::size_t mappedBytes_{0};
+    Header* header_{nullptr};
+    char* data_{nullptr};
+    std::size_t capacity_{0};
+    bool owner_{false};
+    bool broken_{false};
+};
+
+template <typename Visitor>
+std::size_t SharedRing::drain(Visitor&& visit)
+{
+    if (broken_) {
+        return 0;
+    }
+    const std::uint64_t mask = capacity_ - 1;
+    auto tailRef = Cursor(header_->tail);
+    auto headRef = Cursor(header_->head);
+    std::uint64_t tail = tailRef.load(std::memory_order_relaxed);
+    std::size_t records = 0;
+    for (;;) {
+        const std::uint64_t head = headRef.load(std::memory_order_acquire);
+        // The producer is another process: every cursor and length it wrote is
+        // checked against the mapping before anything is read through it.
+        if (head - tail > capacity_) {
+            markBroken(tail, head);
+            return records;
+        }
+        while (tail != head) {
+            const std::size_t offset = tail & mask;
+            std::uint32_t length = 0;
+            if (capacity_ - offset < sizeof(length)) {
+                markBroken(tail, head);
+                return records;
+            }
+            std::memcpy(&length, data_ + offset, sizeof(length));
+            const std::uint64_t advance = length == kWrapMarker
+                ? capacity_ - offset
+                : (sizeof(length) + std::uint64_t { length } + kAlignment - 1) & ~std::uint64_t { kAlignment - 1 };
+            if ((length != kWrapMarker && length > capacity_ - offset - sizeof(length)) || advance > head - tail) {
+                markBroken(tail, head);
+                return records;
+            }
+            if (length != kWrapMarker) {
+                // The record carries its own binary frame header; `length` covers it.
+                visit(std::string_view(data_ + offset + sizeof(length), length));
+                ++records;
+            }
+            tail += advance;
+        }
+        tailRef.store(tail, std::memory_order_release);
+        // Arm, then look again: a push between the last check and the arm would
+        // otherwise go unannounced.
+        waiting().store(1, std::memory_order_seq_cst);
+        if (headRef.load(std::memory_order_seq_cst) == tail) {
+            return records;
+        }
+        waiting().store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace hardware
@@ -3,15 +3,18 @@
 #include "flags.h"
 #include "modules/DemoModule.h"
 #include "modules/GraphingDataModule.h"
+#include "modules/LogicAnalyzerModule.h"
 #include "modules/NumericDataModule.h"
+#include "modules/PerformanceModule.h"
+#include "modules/RecorderModule.h"
+#include "modules/ScopeModule.h"
 #include <memory>
 #include <print>
+#include <sstream>
+#include <vector>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/spdlog.h>
 
-bool flags::enableHardwareMock = false;
-int flags::logLevel = 2;
-
 int main(int argc, char* argv[])
 {
     /////////////////////////////////////////////////////////////////
@@ -69,6 +72,119 @@ int main(int argc, char* argv[])
             }
             return std::stoi(value);
         });
+    argumentParser.add_argument("--max-fps")
+        .help("Cap on UI rebuilds per second; data updates are coalesced to this rate (1-240)")
+        .default_value(30)
+        .action([&](const std::string& value) {
+            int valueInt = 30;
+            try {
+                valueInt = std::stoi(value);
+            } catch (...) {
+                throw std::invalid_argument("Max FPS must be an integer between 1 and 240");
+            }
+            if (valueInt < 1 || valueInt > 240) {
+                throw std::invalid_argument("Max FPS must be between 1 and 240");
+            }
+            return valueInt;
+        });
+    argumentParser.add_argument("--tick-rate")
+        .help("Base rate of module ticks per second, run off the UI thread (1-1000)")
+        .default_value(50)
+        .action([&](const std::string& value) {
+            int valueInt = 50;
+            try {
+                valueInt = std::stoi(value);
+            } catch (...) {
+                throw std::invalid_argument("Tick rate must be an integer between 1 and 1000");
+            }
+            if (valueInt < 1 || valueInt > 1000) {
+                throw std::invalid_argument("Tick rate must be between 1 and 1000");
+            }
+            return valueInt;
+        });
+    argumentParser.add_argument("--metrics-log-interval")
+        .help("Seconds between dumps of the performance counters to the log; 0 disables (0-3600)")
+        .default_value(0)
+        .action([&](const std::string& value) {
+            int valueInt = 0;
+            try {
+                valueInt = std::stoi(value);
+            } catch (...) {
+                throw std::invalid_argument("Metrics log interval must be an integer between 0 and 3600");
+            }
+            if (valueInt < 0 || valueInt > 3600) {
+                throw std::invalid_argument("Metrics log interval must be between 0 and 3600");
+            }
+            return valueInt;
+        });
+    argumentParser.add_argument("--relay")
+        .help("Comma-separated relays to ingest from, each [name=]socket-path; a named relay's sources appear as name:id")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--relay-shm")
+        .help("Take waveform and logic frames from relays on this host through shared memory instead of the socket")
+        .default_value(false)
+        .implicit_value(true);
+    argumentParser.add_argument("--capture-dir")
+        .help("Directory the recorder writes capture files to")
+        .default_value(std::string("captures"));
+    argumentParser.add_argument("--record")
+        .help("Comma-separated source ids to record from startup, e.g. demo.voltage")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--replay")
+        .help("Comma-separated capture files (.wbcap) to publish as live sources")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--replay-speed")
+        .help("Replay rate: 1 = real time, N or Nx = N times faster, max = as fast as possible")
+        .default_value(1.0)
+        .action([&](const std::string& value) {
+            if (value == "max") {
+                return 0.0;
+            }
+            double speed = 1.0;
+            try {
+                speed = std::stod(value.ends_with('x') ? value.substr(0, value.size() - 1) : value);
+            } catch (...) {
+                throw std::invalid_argument("Replay speed must be a number (e.g. 1, 4x, 0.5) or 'max'");
+            }
+            if (!(speed > 0.0 && speed <= 10000.0)) {
+                throw std::invalid_argument("Replay speed must be greater than 0 and at most 10000");
+            }
+            return speed;
+        });
+    argumentParser.add_argument("--replay-loop")
+        .help("Restart replays from the beginning when they reach the end")
+        .default_value(false)
+        .implicit_value(true);
+    argumentParser.add_argument("--replay-start")
+        .help("Seconds into the replay to start from")
+        .default_value(0.0)
+        .action([&](const std::string& value) {
+            double seconds = 0.0;
+            try {
+                seconds = std::stod(value);
+            } catch (...) {
+                throw std::invalid_argument("Replay start must be a number of seconds");
+            }
+            if (seconds < 0.0) {
+                throw std::invalid_argument("Replay start must not be negative");
+            }
+            return seconds;
+        });
+    argumentParser.add_argument("--derive")
+        .help("Semicolon-separated computed sources, each id[unit]=expression over {source/channel} references, "
+              "e.g. \"derived.power[W]={psu/voltage} * {psu/current}\"")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--layout")
+        .help("File the window layout is restored from at startup and saved to on exit; empty opens the default windows")
+        .default_value(std::string("workbench-layout.json"));
+    argumentParser.add_argument("--serve")
+        .help("Run headless: ingest once and serve the data to dashboards started with --relay SOCKET")
+        .default_value(std::string(""));
+    argumentParser.add_argument("--trigger")
+        .help("Semicolon-separated triggers, each \"name: {source/channel} rises|falls|above|below|rate LEVEL\" "
+              "or \"name: {source/channel} pattern BITS\", optionally followed by hysteresis H, holdoff MS, "
+              "freeze (hold graphs at the firing) and snapshot")
+        .default_value(std::string(""));
     try {
         argumentParser.parse_args(argc, argv);
     } catch (const std::exception& e) {
@@ -78,6 +194,21 @@ int main(int argc, char* argv[])
     
     flags::enableHardwareMock = argumentParser.get<bool>("--enable-hardware-mock");
     flags::logLevel = argumentParser.get<int>("--log-level");
+    flags::maxFps = argumentParser.get<int>("--max-fps");
+    flags::tickRate = argumentParser.get<int>("--tick-rate");
+    flags::metricsLogInterval = argumentParser.get<int>("--metrics-log-interval");
+    flags::relayEndpoints = argumentParser.get<std::string>("--relay");
+    flags::relaySharedMemory = argumentParser.get<bool>("--relay-shm");
+    flags::captureDir = argumentParser.get<std::string>("--capture-dir");
+    flags::recordSources = argumentParser.get<std::string>("--record");
+    flags::replayFiles = argumentParser.get<std::string>("--replay");
+    flags::replaySpeed = argumentParser.get<double>("--replay-speed");
+    flags::replayLoop = argumentParser.get<bool>("--replay-loop");
+    flags::replayStart = argumentParser.get<double>("--replay-start");
+    flags::derivedChannels = argumentParser.get<std::string>("--derive");
+    flags::triggers = argumentParser.get<std::string>("--trigger");
+    flags::layoutFile = argumentParser.get<std::string>("--layout");
+    flags::serveSocket = argumentParser.get<std::string>("--serve");
     
     // Initialize spdlog rotating file logger
     try {
@@ -115,8 +246,104 @@ int main(int argc, char* argv[])
 
     App app;
     app.setHardwareMockEnabled(flags::enableHardwareMock);
+    if (!flags::relayEndpoints.empty()) {
+        std::vector<hardware::RelayEndpoint> endpoints;
+        std::stringstream list(flags::relayEndpoints);
+        for (std::string entry; std::getline(list, entry, ',');) {
+            if (entry.empty()) {
+                continue;
+            }
+            hardware::RelayEndpoint endpoint;
+            const auto equals = entry.find('=');
+            if (equals == std::string::npos) {
+                endpoint.socketPath = entry;
+            } else {
+                endpoint.name = entry.substr(0, equals);
+                endpoint.socketPath = entry.substr(equals + 1);
+            }
+            if (endpoint.socketPath.empty() || endpoint.name.find(':') != std::string::npos) {
+                std::cerr << "Invalid relay '" << entry << "'; expected [name=]socket-path with no ':' in the name" << std::endl;
+                return 1;
+            }
+            endpoints.push_back(std::move(endpoint));
+        }
+        app.setRelayEndpoints(std::move(endpoints));
+    }
+    app.setRelaySharedMemory(flags::relaySharedMemory);
+    app.setLayoutFile(flags::layoutFile);
+    app.setMaxFps(flags::maxFps);
+    app.setTickRate(flags::tickRate);
+    if (!flags::replayFiles.empty()) {
+        std::vector<std::string> paths;
+        std::stringstream list(flags::replayFiles);
+        for (std::string path; std::getline(list, path, ',');) {
+            if (!path.empty()) {
+                paths.push_back(path);
+            }
+        }
+        core::ReplayOptions replayOptions;
+        replayOptions.speed = flags::replaySpeed;
+        replayOptions.loop = flags::replayLoop;
+        replayOptions.start = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(flags::replayStart));
+        if (!app.setReplayFiles(paths, replayOptions)) {
+            std::cerr << "Cannot replay '" << flags::replayFiles << "'; see the log for details" << std::endl;
+            return 1;
+        }
+    }
+    if (!flags::derivedChannels.empty()) {
+        std::vector<core::DerivedChannelSpec> specs;
+        std::stringstream list(flags::derivedChannels);
+        for (std::string entry; std::getline(list, entry, ';');) {
+            if (entry.find_first_not_of(" \t") == std::string::npos) {
+                continue;
+            }
+            core::DerivedChannelSpec spec;
+            std::string error;
+            if (!core::ParseDerivedChannelSpec(entry, spec, error)) {
+                std::cerr << "Invalid derived source '" << entry << "': " << error << std::endl;
+                return 1;
+            }
+            specs.push_back(std::move(spec));
+        }
+        if (!app.setDerivedChannels(std::move(specs))) {
+            std::cerr << "Cannot add derived sources '" << flags::derivedChannels << "'; see the log for details" << std::endl;
+            return 1;
+        }
+    }
+    if (!flags::triggers.empty()) {
+        std::vector<core::TriggerSpec> specs;
+        std::stringstream list(flags::triggers);
+        for (std::string entry; std::getline(list, entry, ';');) {
+            if (entry.find_first_not_of(" \t") == std::string::npos) {
+                continue;
+            }
+            core::TriggerSpec spec;
+            std::string error;
+            if (!core::ParseTriggerSpec(entry, spec, error)) {
+                std::cerr << "Invalid trigger '" << entry << "': " << error << std::endl;
+                return 1;
+            }
+            specs.push_back(std::move(spec));
+        }
+        if (!app.setTriggers(std::move(specs))) {
+            std::cerr << "Cannot arm triggers '" << flags::triggers << "'; see the log for details" << std::endl;
+            return 1;
+        }
+    }
     app.registerModule(std::make_unique<DemoModule>());
     app.registerModule(std::make_unique<NumericDataModule>());
     app.registerModule(std::make_unique<GraphingDataModule>());
+    app.registerModule(std::make_unique<ScopeModule>());
+    app.registerModule(std::make_unique<LogicAnalyzerModule>());
+    app.registerModule(std::make_unique<RecorderModule>());
+    app.registerModule(std::make_unique<PerformanceModule>());
+    if (!flags::serveSocket.empty()) {
+        std::cout << "Serving on '" << flags::serveSocket << "'; stop with Ctrl-C" << std::endl;
+        if (app.serve(flags::serveSocket) != 0) {
+            std::cerr << "Cannot serve on '" << flags::serveSocket << "'; see the log for details" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     return app.run();
 }
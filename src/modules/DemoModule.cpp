@@ -121,3 +121,8 @@ void DemoModule::tick(core::ModuleContext& context, std::chrono::milliseconds de
     }
     PublishVoltage(context, voltage_);
 }
+
+std::chrono::milliseconds DemoModule::tickInterval() const {
+    // The voltage only steps once a second; there is no point waking faster.
+    return std::chrono::milliseconds(100);
+}
@@ -18,6 +18,7 @@ public:
     std::vector<ui::WindowSpec> createDefaultWindows(core::ModuleContext& context) override;
 
     void tick(core::ModuleContext& context, std::chrono::milliseconds delta) override;
+    std::chrono::milliseconds tickInterval() const override;
 
 private:
     double voltage_{0.0};
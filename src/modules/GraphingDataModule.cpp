@@ -1,15 +1,26 @@
 #include "GraphingDataModule.h"
 
 #include "core/DataRegistry.h"
+#include "core/Downsample.h"
+#include "core/HistoryBuffer.h"
 #include "core/ModuleContext.h"
+#include "core/Statistics.h"
+#include "core/TriggerEngine.h"
 #include "hardware/HardwareServiceClient.h"
+#include "ui/RedrawScheduler.h"
+#include "ui/SourceList.h"
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -24,16 +35,42 @@
 
 namespace {
 
+// Sources the window can plot.
+core::SourceQuery PlottableSources()
+{
+    core::SourceQuery query;
+    query.kinds = { core::DataKind::Numeric, core::DataKind::Waveform };
+    return query;
+}
+
+// Undelivered frames kept per window before the oldest are dropped.
+constexpr std::size_t kObserverQueueCapacity = 64;
+// Two envelope points for each of up to 256 plot columns.
+constexpr std::uint32_t kWaveformPointBudget = 512;
+// How much of the shared history a newly opened or cloned window starts with.
+constexpr std::chrono::seconds kWarmStartSpan { 60 };
+
 struct ChannelHistory {
     std::string channelId;
     std::string unit;
-    std::vector<double> samples;
-    double current { 0.0 };
-    double min { 0.0 };
-    double max { 0.0 };
-    bool hasCurrent { false };
-    bool hasMin { false };
-    bool hasMax { false };
+    // Samples live in the registry's shared ring; this marks where a local clear happened.
+    std::uint64_t clearedAtSequence { 0 };
+    // The plot only labels current, min and max; no rolling window to keep up.
+    core::ChannelStatistics stats { 0 };
+};
+
+// Persistent UI for one channel. The row is built once when the channel first
+// appears and reads live state at render time, so streaming data only repaints.
+struct ChannelView {
+    std::string channelId;
+    std::string unit;
+    core::HistoryWindow window;
+    std::size_t firstVisible { 0 };
+    core::EnvelopeCache envelope;
+    // The trigger snapshot `window` was copied from, if any.
+    const core::TriggerSnapshot* shownSnapshot { nullptr };
+    std::function<std::vector<int>(int, int)> graphFn;
+    ftxui::Component row;
 };
 
 struct GraphingState : std::enable_shared_from_this<GraphingState> {
@@ -44,18 +81,42 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
 
     ~GraphingState()
     {
+        unwatchTriggers();
         unsubscribe();
+        detachRedraw();
+    }
+
+    void attachRedraw()
+    {
+        auto* scheduler = moduleContext.redrawScheduler;
+        if (!scheduler || redrawToken != 0)
+            return;
+        redrawToken = scheduler->addTarget([weak = weak_from_this()]() {
+            if (auto self = weak.lock()) {
+                self->refreshGraphPane();
+            }
+        });
+    }
+
+    void detachRedraw()
+    {
+        if (moduleContext.redrawScheduler && redrawToken != 0)
+            moduleContext.redrawScheduler->removeTarget(redrawToken);
+        redrawToken = 0;
     }
 
     void selectSource(int index, bool force)
     {
         std::lock_guard lock(mutex);
+        const auto& sources = sourceList.sources;
         if (sources.empty())
             return;
         if (index < 0 || index >= static_cast<int>(sources.size()))
             return;
-        selectedIndex = index;
+        sourceList.selected = index;
         const std::string newSource = sources[static_cast<std::size_t>(index)].id;
+        if (sourceList.preferred().empty())
+            *shownSource = newSource;
         if (!force && newSource == currentSourceId)
             return;
         // Debug: indicate selection in console
@@ -65,34 +126,185 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
         subscribe(newSource);
     }
 
+    // Catalog changes are queued by whichever thread registers the source and folded
+    // into the menu by syncSources() on the next render.
+    void watchSources()
+    {
+        auto& catalog = moduleContext.dataRegistry.catalog();
+        catalogToken = catalog.addObserver([weak = weak_from_this()](const core::SourceEvent& event) {
+            auto self = weak.lock();
+            if (!self || !self->sourceList.enqueue(event))
+                return;
+            self->renderCache.invalidate();
+            if (self->moduleContext.redrawScheduler)
+                self->moduleContext.redrawScheduler->requestRedraw();
+        });
+        sourceList.load(catalog);
+    }
+
+    void unwatchSources()
+    {
+        if (catalogToken != 0)
+            moduleContext.dataRegistry.catalog().removeObserver(catalogToken);
+        catalogToken = 0;
+    }
+
+    // Trigger firings arrive on the engine's worker. A freezing trigger on the plotted
+    // source holds the window on its snapshot unless it is already held; any snapshot
+    // is kept so 't' can bring it back.
+    void watchTriggers()
+    {
+        auto* triggers = moduleContext.triggers;
+        if (!triggers || triggerToken != 0)
+            return;
+        triggerToken = triggers->addListener([weak = weak_from_this()](const core::TriggerEvent& event) {
+            auto self = weak.lock();
+            if (!self || !event.snapshot)
+                return;
+            {
+                std::lock_guard lock(self->mutex);
+                if (event.snapshot->sourceId != self->currentSourceId)
+                    return;
+                self->lastTrigger = event;
+                if (event.trigger->freeze && !self->held) {
+                    self->held = true;
+                    self->frozen = event.snapshot;
+                }
+            }
+            self->notifyNewData();
+        });
+    }
+
+    void unwatchTriggers()
+    {
+        if (moduleContext.triggers && triggerToken != 0)
+            moduleContext.triggers->removeListener(triggerToken);
+        triggerToken = 0;
+    }
+
+    void toggleHold()
+    {
+        {
+            std::lock_guard lock(mutex);
+            held = !held;
+            frozen.reset();
+        }
+        notifyNewData();
+    }
+
+    void showLastTrigger()
+    {
+        {
+            std::lock_guard lock(mutex);
+            if (!lastTrigger.snapshot)
+                return;
+            held = true;
+            frozen = lastTrigger.snapshot;
+        }
+        notifyNewData();
+    }
+
+    ftxui::Element renderStatus()
+    {
+        using namespace ftxui;
+        std::lock_guard lock(mutex);
+        std::string status = held ? "[held]" : "[run]";
+        if (frozen && lastTrigger.trigger)
+            status = "[trigger '" + lastTrigger.trigger->name + "' at " + formatNumeric(lastTrigger.value) + "]";
+        const std::string keys = lastTrigger.snapshot ? "space hold  t last trigger" : "space hold";
+        return hbox({ text(keys) | dim, filler(), text(status) | bold });
+    }
+
+    // UI thread. Follows the selection to a neighbour when the plotted source goes away.
+    void syncSources()
+    {
+        if (!sourceList.sync())
+            return;
+        if (const auto* source = sourceList.selectedSource(); source && source->id != currentSourceId)
+            selectSource(sourceList.selected, false);
+    }
+
     void subscribe(const std::string& sourceId)
     {
         unsubscribe();
         histories.clear();
+        ++structureVersion;
         currentSourceId = sourceId;
-
-        moduleContext.hardwareService.subscribeSource(sourceId);
+        held = false;
+        frozen.reset();
+        lastTrigger = {};
+
+        // Ask the relay for roughly what the graph can show: one update per frame and
+        // waveforms reduced to a min/max pair per plot column.
+        hardware::SubscribeOptions subscribeOptions;
+        subscribeOptions.maxRateHz = moduleContext.redrawScheduler ? moduleContext.redrawScheduler->maxFps() : ui::RedrawScheduler::kDefaultMaxFps;
+        subscribeOptions.decimation = hardware::Decimation::MinMax;
+        subscribeOptions.waveformPointBudget = kWaveformPointBudget;
+        subscriptionToken = moduleContext.hardwareService.subscribeSource(sourceId, subscribeOptions);
 
         auto self = weak_from_this();
+        // Delivered off the ingest thread; frames still feed min/max, so keep a backlog
+        // rather than conflating.
+        core::ObserverOptions options;
+        options.delivery = core::ObserverDelivery::Queued;
+        options.policy = core::BackpressurePolicy::DropOldest;
+        options.queueCapacity = kObserverQueueCapacity;
         observerToken = moduleContext.dataRegistry.addObserver(sourceId, [self](const core::DataFrame& frame) {
             if (auto state = self.lock()) {
                 state->handleFrame(frame);
             }
-        });
+        }, options);
 
-        if (auto latest = moduleContext.dataRegistry.latest(sourceId)) {
-            handleFrame(*latest);
+        if (!warmStart(sourceId)) {
+            if (auto latest = moduleContext.dataRegistry.latest(sourceId)) {
+                handleFrame(*latest);
+            }
         }
     }
 
+    // Seeds every channel from the last kWarmStartSpan of the registry's shared
+    // history, one bulk copy per channel, so a new window shows the recent past
+    // straight away. The graph hides anything older, matching the statistics.
+    // Frames queued since the observer was added may repeat a few samples in the
+    // statistics, which leaves current/min/max unchanged.
+    bool warmStart(const std::string& sourceId)
+    {
+        auto& registry = moduleContext.dataRegistry;
+        core::HistoryWindow window;
+        bool seeded = false;
+        for (const auto& channelId : registry.historyChannels(sourceId)) {
+            if (!registry.readHistoryRecent(sourceId, channelId, kWarmStartSpan, registry.historyCapacity(), window) || window.empty())
+                continue;
+            auto& h = histories[channelId];
+            h.channelId = channelId;
+            h.clearedAtSequence = window.endSequence - window.size();
+            h.stats.addBlock(window.values);
+            seeded = true;
+        }
+        if (!seeded)
+            return false;
+
+        ++structureVersion;
+        // History holds values only; units come from the latest frame.
+        if (auto latest = registry.latestShared(sourceId)) {
+            for (const auto& point : latest->points) {
+                const auto* numeric = std::get_if<core::NumericSample>(&point.payload);
+                if (auto it = histories.find(point.channelId); numeric && it != histories.end())
+                    it->second.unit = numeric->unit;
+            }
+        }
+        return true;
+    }
+
     void unsubscribe()
     {
         if (observerToken != 0 && !currentSourceId.empty()) {
             moduleContext.dataRegistry.removeObserver(currentSourceId, observerToken);
         }
-        if (!currentSourceId.empty()) {
-            moduleContext.hardwareService.unsubscribeSource(currentSourceId);
+        if (subscriptionToken != 0) {
+            moduleContext.hardwareService.unsubscribeSource(subscriptionToken);
         }
+        subscriptionToken = 0;
         observerToken = 0;
         currentSourceId.clear();
     }
@@ -104,25 +316,25 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
         }
         {
             std::lock_guard lock(mutex);
+            // A queued frame from the previous source may arrive after a switch.
+            if (frame.sourceId != currentSourceId || held) {
+                return;
+            }
             for (const auto& point : frame.points) {
-                if (const auto* numeric = std::get_if<core::NumericSample>(&point.payload)) {
-                    auto& h = histories[point.channelId];
-                    h.channelId = point.channelId;
+                const auto* numeric = std::get_if<core::NumericSample>(&point.payload);
+                const auto* waveform = std::get_if<core::WaveformSample>(&point.payload);
+                if (!numeric && !waveform)
+                    continue;
+                auto [it, inserted] = histories.try_emplace(point.channelId);
+                if (inserted)
+                    ++structureVersion;
+                auto& h = it->second;
+                h.channelId = point.channelId;
+                if (numeric) {
                     h.unit = numeric->unit;
-                    h.current = numeric->value;
-                    h.hasCurrent = true;
-                    if (!h.hasMin || numeric->value < h.min) {
-                        h.min = numeric->value;
-                        h.hasMin = true;
-                    }
-                    if (!h.hasMax || numeric->value > h.max) {
-                        h.max = numeric->value;
-                        h.hasMax = true;
-                    }
-                    h.samples.push_back(numeric->value);
-                    if (static_cast<int>(h.samples.size()) > maxSamples) {
-                        h.samples.erase(h.samples.begin(), h.samples.begin() + (h.samples.size() - maxSamples));
-                    }
+                    h.stats.addSample(numeric->value);
+                } else {
+                    h.stats.addBlock(waveform->samples);
                 }
             }
         }
@@ -134,13 +346,8 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
         {
             std::lock_guard lock(mutex);
             if (auto it = histories.find(channelId); it != histories.end()) {
-                it->second.samples.clear();
-                it->second.hasMin = it->second.hasCurrent;
-                it->second.hasMax = it->second.hasCurrent;
-                if (it->second.hasCurrent) {
-                    it->second.min = it->second.current;
-                    it->second.max = it->second.current;
-                }
+                it->second.clearedAtSequence = moduleContext.dataRegistry.historySequence(currentSourceId, channelId);
+                it->second.stats.reset();
             }
         }
         notifyNewData();
@@ -151,9 +358,7 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
         auto self = shared_from_this();
         if (auto* screen = ftxui::ScreenInteractive::Active()) {
             screen->Post([self]() {
-                if (self->graphPane) {
-                    self->rebuildGraphPane();
-                }
+                self->refreshGraphPane();
             });
         }
     }
@@ -185,103 +390,177 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
         return out;
     }
 
+    // Maps the channel's cached M4 envelope onto the graph columns. The graph draws one
+    // height per column, so each column shows whichever extreme departs further from
+    // the previous column: spikes in either direction survive any amount of history.
+    static std::vector<int> plotEnvelope(ChannelView& view, int width, int height)
+    {
+        std::vector<int> out(std::max(0, width), 0);
+        if (width <= 0 || height <= 0)
+            return out;
+        if (view.firstVisible >= view.window.size())
+            return out;
+
+        const std::span<const double> visible(view.window.values.data() + view.firstVisible, view.window.size() - view.firstVisible);
+        view.envelope.update(visible, view.window.endSequence, static_cast<std::size_t>(width));
+        const auto& envelope = view.envelope.envelope();
+        if (envelope.low == envelope.high) {
+            // flat line in middle
+            std::fill(out.begin(), out.end(), height / 2);
+            return out;
+        }
+
+        const double scale = (height - 1) / (envelope.high - envelope.low);
+        double previous = envelope.firsts.front();
+        for (int x = 0; x < width; ++x) {
+            const auto column = static_cast<std::size_t>(x);
+            const double rise = envelope.maxs[column] - previous;
+            const double fall = previous - envelope.mins[column];
+            const double v = rise >= fall ? envelope.maxs[column] : envelope.mins[column];
+            int y = static_cast<int>(std::round((v - envelope.low) * scale));
+            out[x] = std::clamp(y, 0, height - 1);
+            previous = envelope.lasts[column];
+        }
+        return out;
+    }
+
+    // Runs on the UI thread once per frame in which data arrived. Only a change in the
+    // set of channels touches the component tree; otherwise the repaint is enough.
+    void refreshGraphPane()
+    {
+        if (!graphPane)
+            return;
+        std::uint64_t version = 0;
+        {
+            std::lock_guard lock(mutex);
+            version = structureVersion;
+        }
+        if (version != builtStructureVersion || graphPane->ChildCount() == 0)
+            rebuildGraphPane();
+    }
+
     void rebuildGraphPane()
     {
         if (!graphPane)
             return;
-        graphPane->DetachAllChildren();
+        renderCache.invalidate();
 
-        std::vector<ChannelHistory> items;
+        std::vector<std::string> channelIds;
         {
             std::lock_guard lock(mutex);
-            for (auto& [k, v] : histories)
-                items.push_back(v);
+            channelIds.reserve(histories.size());
+            for (const auto& [channelId, _] : histories)
+                channelIds.push_back(channelId);
+            builtStructureVersion = structureVersion;
         }
 
-        std::sort(items.begin(), items.end(), [](const ChannelHistory& a, const ChannelHistory& b) {
-            return a.channelId < b.channelId;
-        });
+        // Views are kept for channels that still exist so their rows and scratch
+        // buffers survive; histories is a std::map, so channelIds is already sorted.
+        for (auto it = channelViews.begin(); it != channelViews.end();) {
+            if (std::binary_search(channelIds.begin(), channelIds.end(), it->first))
+                ++it;
+            else
+                it = channelViews.erase(it);
+        }
 
-        auto weakSelf = weak_from_this();
-        for (const auto& h : items) {
-            ChannelHistory copy = h;
-
-            // Create a persistent function object for the graph callback and keep it alive
-            // by capturing a shared_ptr to it in the Renderer.
-            auto graphFunc = std::make_shared<std::function<std::vector<int>(int, int)>>(
-                [samples = copy.samples](int width, int height) -> std::vector<int> {
-                    std::vector<int> out(width, 0);
-                    if (width <= 0 || height <= 0)
-                        return out;
-                    if (samples.empty())
-                        return out;
-
-                    // find min/max
-                    double mn = samples.front();
-                    double mx = samples.front();
-                    for (double v : samples) {
-                        mn = std::min(mn, v);
-                        mx = std::max(mx, v);
-                    }
-                    if (mn == mx) {
-                        // flat line in middle
-                        int mid = height / 2;
-                        for (int x = 0; x < width; ++x)
-                            out[x] = mid;
-                        return out;
-                    }
-
-                    const double scale = (height - 1) / (mx - mn);
-                    const double srcSize = static_cast<double>(samples.size());
-                    for (int x = 0; x < width; ++x) {
-                        double srcPos = (srcSize - 1) * (static_cast<double>(x) / static_cast<double>(std::max(1, width - 1)));
-                        int i0 = static_cast<int>(std::floor(srcPos));
-                        int i1 = static_cast<int>(std::ceil(srcPos));
-                        double v = 0.0;
-                        if (i0 == i1)
-                            v = samples[std::clamp(i0, 0, static_cast<int>(samples.size()) - 1)];
-                        else {
-                            double t = srcPos - static_cast<double>(i0);
-                            double a = samples[std::clamp(i0, 0, static_cast<int>(samples.size()) - 1)];
-                            double b = samples[std::clamp(i1, 0, static_cast<int>(samples.size()) - 1)];
-                            v = a + (b - a) * t;
-                        }
-                        int y = static_cast<int>(std::round((v - mn) * scale));
-                        y = std::clamp(y, 0, height - 1);
-                        out[x] = y;
-                    }
-                    return out;
+        graphPane->DetachAllChildren();
+        for (const auto& channelId : channelIds) {
+            auto& view = channelViews[channelId];
+            if (!view)
+                view = makeChannelView(channelId);
+            graphPane->Add(view->row);
+        }
+
+        if (graphPane->ChildCount() == 0) {
+            if (!emptyRow) {
+                emptyRow = ftxui::Renderer([]() {
+                    using namespace ftxui;
+                    return text("No numeric data available.") | dim;
                 });
+            }
+            graphPane->Add(emptyRow);
+        }
+    }
 
-            auto row = ftxui::Renderer([copy, graphFunc]() {
-                using namespace ftxui;
-                Element e;
-                if (!copy.hasCurrent) {
-                    e = text(copy.channelId + ": no data") | dim;
-                } else {
-                    e = vbox({
-                            hbox({ text(copy.channelId), filler(), text(formatNumeric(copy.current) + (copy.unit.empty() ? "" : " " + copy.unit)) | bold }),
-                            separator(),
-                            // pass reference to the function object kept alive by graphFunc
-                            graph(std::ref(*graphFunc)) | color(Color::Green) | flex,
-                            hbox({ text("min: " + formatNumeric(copy.min)), filler(), text("max: " + formatNumeric(copy.max)) }),
-                        })
-                        | flex;
-                }
-                return e;
-            });
+    std::shared_ptr<ChannelView> makeChannelView(const std::string& channelId)
+    {
+        auto view = std::make_shared<ChannelView>();
+        view->channelId = channelId;
+        // The graph callback lives inside the view it reads, so a raw pointer is safe.
+        view->graphFn = [raw = view.get()](int width, int height) {
+            return plotEnvelope(*raw, width, height);
+        };
+        view->row = ftxui::Renderer([weakSelf = weak_from_this(), weakView = std::weak_ptr(view)]() -> ftxui::Element {
+            auto self = weakSelf.lock();
+            auto channelView = weakView.lock();
+            if (!self || !channelView)
+                return ftxui::text("");
+            return self->renderChannel(*channelView);
+        });
+        return view;
+    }
 
-            // Add the row directly (no manual clear button for streaming data)
-            graphPane->Add(row);
+    // Reads the channel's live stats and shared history at render time into the
+    // view's reusable buffers.
+    ftxui::Element renderChannel(ChannelView& view)
+    {
+        using namespace ftxui;
+        double current = 0.0;
+        double mn = 0.0;
+        double mx = 0.0;
+        std::uint64_t clearedAt = 0;
+        {
+            std::lock_guard lock(mutex);
+            auto it = histories.find(view.channelId);
+            if (it == histories.end() || !it->second.stats.hasCurrent())
+                return text(view.channelId + ": no data") | dim;
+            const auto& h = it->second;
+            current = h.stats.current();
+            mn = h.stats.min();
+            mx = h.stats.max();
+            clearedAt = h.clearedAtSequence;
+            if (view.unit != h.unit)
+                view.unit = h.unit;
+            if (frozen) {
+                // Show the history as of the firing, and its figures rather than the live ones.
+                if (view.shownSnapshot != frozen.get()) {
+                    const auto snapshotIt = frozen->channels.find(view.channelId);
+                    if (snapshotIt != frozen->channels.end())
+                        view.window = snapshotIt->second;
+                    else
+                        view.window.clear();
+                    view.shownSnapshot = frozen.get();
+                }
+                if (view.window.empty())
+                    return text(view.channelId + ": not in the trigger snapshot") | dim;
+                current = view.window.values.back();
+                const auto [low, high] = std::minmax_element(view.window.values.begin(), view.window.values.end());
+                mn = *low;
+                mx = *high;
+            } else if (!held) {
+                // The ring sequence only moves when samples arrive; skip the copy otherwise.
+                const auto sequence = moduleContext.dataRegistry.historySequence(currentSourceId, view.channelId);
+                // The envelope keeps rendering proportional to the width, so plot the whole
+                // ring, at whatever capacity it has now.
+                if (sequence != view.window.endSequence || view.window.empty() || view.shownSnapshot)
+                    moduleContext.dataRegistry.readHistory(currentSourceId, view.channelId,
+                        moduleContext.dataRegistry.historyCapacity(), view.window);
+                view.shownSnapshot = nullptr;
+            }
         }
 
-        if (graphPane->ChildCount() == 0) {
-            auto empty = ftxui::Renderer([]() {
-                using namespace ftxui;
-                return text("No numeric data available.") | dim;
-            });
-            graphPane->Add(empty);
-        }
+        // Hide samples that were pushed before this window last cleared the channel.
+        const std::uint64_t sinceClear = view.window.endSequence - std::min(view.window.endSequence, clearedAt);
+        const std::size_t keep = static_cast<std::size_t>(std::min<std::uint64_t>(view.window.size(), sinceClear));
+        view.firstVisible = view.window.size() - keep;
+
+        return vbox({
+                   hbox({ text(view.channelId), filler(), text(formatNumeric(current) + (view.unit.empty() ? "" : " " + view.unit)) | bold }),
+                   separator(),
+                   graph(std::ref(view.graphFn)) | color(Color::Green) | flex,
+                   hbox({ text("min: " + formatNumeric(mn)), filler(), text("max: " + formatNumeric(mx)) }),
+               })
+            | flex;
     }
 
     static std::string formatNumeric(double value)
@@ -292,30 +571,44 @@ struct GraphingState : std::enable_shared_from_this<GraphingState> {
     }
 
     core::ModuleContext& moduleContext;
-    std::vector<core::SourceMetadata> sources;
-    std::vector<std::string> sourceTitles;
-    int selectedIndex { 0 };
+    ui::SourceList sourceList { PlottableSources(), "No numeric sources available" };
+    int catalogToken { 0 };
     std::string currentSourceId;
     int observerToken { 0 };
+    int subscriptionToken { 0 };
     std::map<std::string, ChannelHistory> histories;
+    // Bumped whenever a channel appears or the channel set is reset.
+    std::uint64_t structureVersion { 0 };
+    // Held windows stop taking frames; `frozen` is the trigger snapshot shown instead
+    // of the live history, if any.
+    bool held { false };
+    std::shared_ptr<const core::TriggerSnapshot> frozen;
+    // The plotted source's latest firing that carried a snapshot.
+    core::TriggerEvent lastTrigger;
+    int triggerToken { 0 };
     mutable std::recursive_mutex mutex;
 
     ftxui::Component menuComponent;
     std::shared_ptr<ftxui::ComponentBase> graphPane;
-
-    const size_t maxSamples { 80 };
-    // No per-module refresher any more. Use the centralized postRedraw callback on moduleContext
-    // to request UI redraws from other threads.
+    // UI-thread only: persistent rows keyed by channel id.
+    std::map<std::string, std::shared_ptr<ChannelView>> channelViews;
+    ftxui::Component emptyRow;
+    std::uint64_t builtStructureVersion { ~std::uint64_t { 0 } };
+
+    int redrawToken { 0 };
+    ui::RenderInvalidator renderCache;
+    // WindowContext::selectedSource; saved with the layout.
+    std::shared_ptr<std::string> shownSource { std::make_shared<std::string>() };
+
+    // Called from the ingest thread for every frame. The redraw scheduler folds any
+    // number of these into at most one rebuild per display frame.
     void notifyNewData()
     {
-        if (moduleContext.postRedraw) {
-            auto self = shared_from_this();
-            moduleContext.postRedraw([self]() {
-                if (self->graphPane)
-                    self->rebuildGraphPane();
-            });
+        renderCache.invalidate();
+        if (redrawToken != 0 && moduleContext.redrawScheduler) {
+            moduleContext.redrawScheduler->markDirty(redrawToken);
+            return;
         }
-        // Always request a local rebuild as a secondary trigger.
         requestRebuild();
     }
 };
@@ -331,31 +624,40 @@ public:
         auto triggerSelect = [weak = std::weak_ptr(state_), this]() {
             if (auto state = weak.lock()) {
                 if (flags::logLevel >= 3) {
-                    spdlog::debug("Graphing menu on_change: index={} source_count={}", state->selectedIndex, state->sources.size());
+                    spdlog::debug("Graphing menu on_change: index={} source_count={}", state->sourceList.selected, state->sourceList.sources.size());
                 }
-                state->selectSource(state->selectedIndex, false);
+                // A pick from the menu wins over a restored source still awaited.
+                state->sourceList.prefer({});
+                state->selectSource(state->sourceList.selected, false);
             }
         };
         menuOption.on_change = triggerSelect;
         // menuOption.on_enter = triggerSelect;
 
-        menuComponent_ = ftxui::Menu(&state_->sourceTitles, &state_->selectedIndex, menuOption);
-        auto menuFrame = ftxui::Renderer(menuComponent_, [menuComponent = menuComponent_]() {
+        menuComponent_ = ftxui::Menu(&state_->sourceList.titles, &state_->sourceList.selected, menuOption);
+        auto menuFrame = ftxui::Renderer(menuComponent_, [state = state_, menuComponent = menuComponent_]() {
             using namespace ftxui;
+            state->syncSources();
             return menuComponent->Render() | vscroll_indicator;
         });
 
         state_->graphPane = ftxui::Container::Vertical({});
+        state_->attachRedraw();
+        state_->watchTriggers();
         auto graphFrame = ftxui::Renderer(state_->graphPane, [state = state_]() {
             using namespace ftxui;
-            return state->graphPane->Render() | vscroll_indicator | frame | flex;
+            return vbox({
+                       state->renderStatus(),
+                       state->graphPane->Render() | vscroll_indicator | frame | flex,
+                   })
+                | flex;
         });
 
         auto layout = ftxui::Container::Horizontal({ menuFrame, ftxui::Renderer([] { return ftxui::separator(); }), graphFrame });
         Add(layout);
 
-        if (!state_->sourceTitles.empty()) {
-            state_->selectSource(state_->selectedIndex, true);
+        if (!state_->sourceList.empty()) {
+            state_->selectSource(state_->sourceList.selected, true);
         } else {
             state_->rebuildGraphPane();
         }
@@ -364,51 +666,43 @@ public:
     ~GraphingComponent() override
     {
         if (state_) {
+            state_->unwatchTriggers();
+            state_->unwatchSources();
             state_->unsubscribe();
         }
     }
 
+    bool OnEvent(ftxui::Event event) override
+    {
+        if (event == ftxui::Event::Character(" ")) {
+            state_->toggleHold();
+            return true;
+        }
+        if (event == ftxui::Event::Character("t")) {
+            state_->showLastTrigger();
+            return true;
+        }
+        return ComponentBase::OnEvent(event);
+    }
+
 private:
     void buildSourceList()
     {
-        auto metadata = state_->moduleContext.dataRegistry.listSources();
+        state_->watchSources();
+        state_->sourceList.prefer(*state_->shownSource);
+        const auto& sources = state_->sourceList.sources;
         if (flags::logLevel >= 3) {
             std::vector<std::string> ids;
-            ids.reserve(metadata.size());
-            for (const auto& meta : metadata) {
+            ids.reserve(sources.size());
+            for (const auto& meta : sources) {
                 ids.push_back(meta.id);
             }
             spdlog::debug("Graphing: buildSourceList saw {} sources: {}", ids.size(), fmt::join(ids, ", "));
         }
-        for (const auto& meta : metadata) {
-            if (meta.kind == core::DataKind::Numeric) {
-                state_->sources.push_back(meta);
-                // Try to show a quick preview of the latest numeric value for this source, if available
-                auto latest = state_->moduleContext.dataRegistry.latest(meta.id);
-                if (latest && !latest->points.empty()) {
-                    const auto& p = latest->points.front();
-                    if (const auto* numeric = std::get_if<core::NumericSample>(&p.payload)) {
-                        state_->sourceTitles.push_back(meta.name + " (" + std::to_string(numeric->value) + " " + numeric->unit + ")");
-                        continue;
-                    }
-                }
-                state_->sourceTitles.push_back(meta.name);
-            }
-        }
-
-        if (state_->sources.empty()) {
-            state_->sourceTitles = { "No numeric sources available" };
-            return;
-        }
 
         // If hardware mock is enabled, prefer the mock source by default (if present).
         if (flags::enableHardwareMock) {
-            for (size_t i = 0; i < state_->sources.size(); ++i) {
-                if (state_->sources[i].id == "mock.12v") {
-                    state_->selectedIndex = static_cast<int>(i);
-                    break;
-                }
-            }
+            state_->sourceList.select("mock.12v");
         }
     }
 
@@ -441,8 +735,10 @@ std::vector<ui::WindowSpec> GraphingDataModule::createDefaultWindows(core::Modul
     spec.title = "Graphing";
     spec.cloneable = true;
     spec.openByDefault = true;
-    spec.componentFactory = [&context](ui::WindowContext&) -> ftxui::Component {
+    spec.componentFactory = [&context](ui::WindowContext& windowContext) -> ftxui::Component {
         auto state = std::make_shared<GraphingState>(context);
+        state->renderCache = windowContext.cacheRendering();
+        state->shownSource = windowContext.selectedSource;
         return std::make_shared<GraphingComponent>(std::move(state));
     };
 
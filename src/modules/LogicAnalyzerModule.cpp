@@ -0,0 +1,545 @@
+#include "modules/LogicAnalyzerModule.h"
+#include "hardware/HardwareServiceClient.h"
+
+#include "core/DataRegistry.h"
+#include "core/LogicCapture.h"
+#include "ui/RedrawScheduler.h"
+#include "ui/SourceList.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/event.hpp>
+#include <ftxui/component/screen_interactive.hpp>
+#include <ftxui/dom/canvas.hpp>
+#include <ftxui/dom/elements.hpp>
+
+#include "flags.h"
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// Sources the window can decode.
+core::SourceQuery LogicSources()
+{
+    core::SourceQuery query;
+    query.kinds = { core::DataKind::Logic, core::DataKind::GpioState };
+    return query;
+}
+
+// Undelivered frames kept per window before the oldest are dropped.
+constexpr std::size_t kObserverQueueCapacity = 64;
+// Lines drawn per capture; wider buses are cut off rather than squeezed.
+constexpr std::size_t kMaxVisibleLines = 32;
+constexpr std::uint64_t kMinViewSpan = 8;
+constexpr std::uint64_t kDefaultViewSpan = 1024;
+constexpr int kLabelWidth = 10;
+
+// Formats a slice offset as time when the sample period is known.
+std::string FormatSliceTime(std::uint64_t slices, std::chrono::nanoseconds period)
+{
+    char buffer[64];
+    if (period.count() <= 0) {
+        std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(slices));
+        return buffer;
+    }
+    const double ns = static_cast<double>(slices) * static_cast<double>(period.count());
+    if (ns >= 1e9) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f s", ns / 1e9);
+    } else if (ns >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f ms", ns / 1e6);
+    } else if (ns >= 1e3) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f us", ns / 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.0f ns", ns);
+    }
+    return buffer;
+}
+
+struct LogicAnalyzerState : std::enable_shared_from_this<LogicAnalyzerState> {
+    explicit LogicAnalyzerState(core::ModuleContext& moduleContext)
+        : moduleContext(moduleContext)
+    {
+    }
+
+    ~LogicAnalyzerState()
+    {
+        unsubscribe();
+    }
+
+    void selectSource(int index, bool force)
+    {
+        std::lock_guard lock(mutex);
+        const auto& sources = sourceList.sources;
+        if (sources.empty()) {
+            return;
+        }
+        if (index < 0 || index >= static_cast<int>(sources.size())) {
+            return;
+        }
+        sourceList.selected = index;
+        const std::string newSource = sources[static_cast<std::size_t>(index)].id;
+        if (sourceList.preferred().empty()) {
+            *shownSource = newSource;
+        }
+        if (!force && newSource == currentSourceId) {
+            return;
+        }
+        if (flags::logLevel >= 3) {
+            spdlog::debug("LogicAnalyzer: selecting source '{}' (index={})", newSource, index);
+        }
+        subscribe(newSource);
+    }
+
+    // Catalog changes are queued by whichever thread registers the source and folded
+    // into the menu by syncSources() on the next render.
+    void watchSources()
+    {
+        auto& catalog = moduleContext.dataRegistry.catalog();
+        catalogToken = catalog.addObserver([weak = weak_from_this()](const core::SourceEvent& event) {
+            auto self = weak.lock();
+            if (!self || !self->sourceList.enqueue(event)) {
+                return;
+            }
+            self->requestRedraw();
+        });
+        sourceList.load(catalog);
+    }
+
+    void unwatchSources()
+    {
+        if (catalogToken != 0) {
+            moduleContext.dataRegistry.catalog().removeObserver(catalogToken);
+        }
+        catalogToken = 0;
+    }
+
+    // UI thread. Follows the selection to a neighbour when the shown source goes away.
+    void syncSources()
+    {
+        if (!sourceList.sync()) {
+            return;
+        }
+        if (const auto* source = sourceList.selectedSource(); source && source->id != currentSourceId) {
+            selectSource(sourceList.selected, false);
+        }
+    }
+
+    void subscribe(const std::string& sourceId)
+    {
+        unsubscribe();
+        captures.clear();
+        follow = true;
+        viewSpan = kDefaultViewSpan;
+        currentSourceId = sourceId;
+
+        // No rate limit or decimation: every slice is part of the capture.
+        subscriptionToken = moduleContext.hardwareService.subscribeSource(sourceId);
+
+        auto self = weak_from_this();
+        // Queued so run compression never runs on the ingest thread; dropping the oldest
+        // frames under overload leaves a gap rather than stalling the relay.
+        core::ObserverOptions options;
+        options.delivery = core::ObserverDelivery::Queued;
+        options.policy = core::BackpressurePolicy::DropOldest;
+        options.queueCapacity = kObserverQueueCapacity;
+        observerToken = moduleContext.dataRegistry.addObserver(sourceId, [self](const core::DataFrame& frame) {
+            if (auto state = self.lock()) {
+                state->handleFrame(frame);
+            }
+        }, options);
+
+        if (auto latest = moduleContext.dataRegistry.latest(sourceId)) {
+            handleFrame(*latest);
+        }
+    }
+
+    void unsubscribe()
+    {
+        if (observerToken != 0 && !currentSourceId.empty()) {
+            moduleContext.dataRegistry.removeObserver(currentSourceId, observerToken);
+        }
+        if (subscriptionToken != 0) {
+            moduleContext.hardwareService.unsubscribeSource(subscriptionToken);
+        }
+        subscriptionToken = 0;
+        observerToken = 0;
+        currentSourceId.clear();
+    }
+
+    void handleFrame(const core::DataFrame& frame)
+    {
+        {
+            std::lock_guard lock(mutex);
+            // A queued frame from the previous source may arrive after a switch.
+            if (frame.sourceId != currentSourceId) {
+                return;
+            }
+            for (const auto& point : frame.points) {
+                if (const auto* logic = std::get_if<core::LogicSample>(&point.payload)) {
+                    captures[point.channelId].append(*logic);
+                } else if (const auto* gpio = std::get_if<core::GpioState>(&point.payload)) {
+                    // Each GPIO update becomes one slice of the capture.
+                    core::LogicSliceFromGpio(*gpio, gpioScratch);
+                    captures[point.channelId].append(gpioScratch);
+                }
+            }
+        }
+        requestRedraw();
+    }
+
+    void requestRedraw()
+    {
+        renderCache.invalidate();
+        if (moduleContext.redrawScheduler) {
+            moduleContext.redrawScheduler->requestRedraw();
+            return;
+        }
+        if (auto* screen = ftxui::ScreenInteractive::Active()) {
+            screen->PostEvent(ftxui::Event::Custom);
+        }
+    }
+
+    // The first capture drives navigation; captures of one source share slice indices.
+    const core::LogicCapture* primary() const
+    {
+        return captures.empty() ? nullptr : &captures.begin()->second;
+    }
+
+    // Visible [begin, end) for the primary capture, following the newest data unless
+    // the user has scrolled away.
+    std::pair<std::uint64_t, std::uint64_t> viewRange() const
+    {
+        const auto* capture = primary();
+        if (!capture || capture->empty()) {
+            return { 0, viewSpan };
+        }
+        const std::uint64_t last = capture->endSlice();
+        const std::uint64_t end = follow ? last : std::clamp(viewEnd, capture->firstSlice() + 1, last);
+        const std::uint64_t begin = end - std::min(viewSpan, end - capture->firstSlice());
+        return { begin, begin + viewSpan };
+    }
+
+    void pan(std::int64_t slices)
+    {
+        std::lock_guard lock(mutex);
+        const auto* capture = primary();
+        if (!capture || capture->empty()) {
+            return;
+        }
+        auto [begin, end] = viewRange();
+        const std::uint64_t visibleEnd = std::min(end, capture->endSlice());
+        if (slices < 0) {
+            const auto back = std::min<std::uint64_t>(static_cast<std::uint64_t>(-slices), begin - capture->firstSlice());
+            viewEnd = visibleEnd - back;
+            follow = false;
+        } else {
+            viewEnd = visibleEnd + static_cast<std::uint64_t>(slices);
+            follow = viewEnd >= capture->endSlice();
+        }
+    }
+
+    void zoom(bool in)
+    {
+        std::lock_guard lock(mutex);
+        auto [begin, end] = viewRange();
+        const std::uint64_t centre = cursorVisible(begin, end) ? cursor : begin + (end - begin) / 2;
+        viewSpan = in ? std::max(kMinViewSpan, viewSpan / 2) : std::min(viewSpan * 2, core::LogicCapture::kDefaultMaxSlices);
+        if (!follow) {
+            viewEnd = centre + viewSpan / 2;
+        }
+    }
+
+    // Moves the cursor to the next/previous edge on any line and scrolls it into view.
+    void jumpToEdge(bool forward)
+    {
+        std::lock_guard lock(mutex);
+        const auto* capture = primary();
+        if (!capture || capture->empty()) {
+            return;
+        }
+        auto [begin, end] = viewRange();
+        const std::uint64_t from = cursorVisible(begin, end) ? cursor : (forward ? begin : end - 1);
+        std::uint64_t target = forward ? capture->endSlice() : capture->firstSlice();
+        for (std::size_t word = 0; word < core::PackedBits::WordsFor(capture->channelCount()); ++word) {
+            if (forward) {
+                target = std::min(target, capture->nextEdge(from, word));
+            } else {
+                target = std::max(target, capture->previousEdge(from == 0 ? 0 : from - 1, word));
+            }
+        }
+        if (forward && target >= capture->endSlice()) {
+            return;
+        }
+        cursor = target;
+        if (!cursorVisible(begin, end)) {
+            viewEnd = std::min(capture->endSlice(), cursor + viewSpan / 2);
+            follow = false;
+        }
+    }
+
+    void setFollow(bool value)
+    {
+        std::lock_guard lock(mutex);
+        follow = value;
+        if (!value) {
+            if (const auto* capture = primary()) {
+                viewEnd = capture->firstSlice() + viewSpan;
+            }
+        }
+    }
+
+    bool cursorVisible(std::uint64_t begin, std::uint64_t end) const
+    {
+        return cursor >= begin && cursor < end;
+    }
+
+    ftxui::Element render()
+    {
+        using namespace ftxui;
+        std::lock_guard lock(mutex);
+        if (captures.empty()) {
+            return text("No logic data available.") | dim;
+        }
+
+        auto [begin, end] = viewRange();
+        const auto* first = primary();
+        Elements rows;
+        for (const auto& [channelId, capture] : captures) {
+            const std::size_t lines = std::min<std::size_t>(capture.channelCount(), kMaxVisibleLines);
+            Elements labels;
+            for (std::size_t line = 0; line < lines; ++line) {
+                labels.push_back(text(channelId + "[" + std::to_string(line) + "]"));
+            }
+            auto traces = canvas([self = shared_from_this(), id = channelId, begin, end](Canvas& c) {
+                self->drawCapture(c, id, begin, end);
+            });
+            rows.push_back(hbox({
+                vbox(std::move(labels)) | size(WIDTH, EQUAL, kLabelWidth),
+                traces | size(HEIGHT, EQUAL, static_cast<int>(lines)) | flex,
+            }));
+            rows.push_back(separator());
+        }
+
+        const auto period = first->samplePeriod();
+        std::string status = "span " + FormatSliceTime(end - begin, period) + "  edges " + std::to_string(first->countEdges(begin, end))
+            + "  runs " + std::to_string(first->runCount()) + "/" + std::to_string(first->sliceCount());
+        if (cursorVisible(begin, end)) {
+            std::string levels;
+            for (std::size_t line = std::min<std::size_t>(first->channelCount(), kMaxVisibleLines); line-- > 0;) {
+                levels += first->level(cursor, line) ? '1' : '0';
+            }
+            status += "  cursor +" + FormatSliceTime(cursor - first->firstSlice(), period) + " = " + levels;
+        }
+        rows.push_back(hbox({ text(status), filler(), text(follow ? "[live]" : "[held]") | bold }));
+        rows.push_back(text("</> pan  +/- zoom  n/p edge  f live") | dim);
+        return vbox(std::move(rows));
+    }
+
+    // Draws each line in one cell row (4 braille dots): high on the top dot, low on
+    // the bottom one, and a full-height stroke where the column holds an edge.
+    void drawCapture(ftxui::Canvas& c, const std::string& channelId, std::uint64_t begin, std::uint64_t end)
+    {
+        std::lock_guard lock(mutex);
+        auto it = captures.find(channelId);
+        if (it == captures.end() || c.width() <= 0) {
+            return;
+        }
+        const auto& capture = it->second;
+        const auto width = static_cast<std::size_t>(c.width());
+        const std::size_t lines = std::min<std::size_t>(capture.channelCount(), kMaxVisibleLines);
+        for (std::size_t word = 0; word * 64 < lines; ++word) {
+            capture.summarize(begin, end, width, word, columns);
+            for (std::size_t x = 0; x < width; ++x) {
+                const auto& column = columns[x];
+                const bool beyondEnd = begin + (end - begin) * x / width >= capture.endSlice();
+                if (beyondEnd) {
+                    break;
+                }
+                for (std::size_t line = word * 64; line < std::min(lines, word * 64 + 64); ++line) {
+                    const int top = static_cast<int>(line) * 4;
+                    const auto bit = std::uint64_t { 1 } << (line % 64);
+                    if (column.toggles & bit) {
+                        c.DrawPointLine(static_cast<int>(x), top, static_cast<int>(x), top + 3, ftxui::Color::Yellow);
+                    } else {
+                        c.DrawPoint(static_cast<int>(x), (column.levels & bit) ? top : top + 3, true, ftxui::Color::Green);
+                    }
+                }
+            }
+        }
+        if (cursorVisible(begin, end)) {
+            const int x = static_cast<int>((cursor - begin) * width / (end - begin));
+            c.DrawPointLine(x, 0, x, c.height() - 1, ftxui::Color::Red);
+        }
+    }
+
+    core::ModuleContext& moduleContext;
+    ui::SourceList sourceList { LogicSources(), "No logic sources available" };
+    int catalogToken { 0 };
+    std::string currentSourceId;
+    int observerToken { 0 };
+    int subscriptionToken { 0 };
+    std::map<std::string, core::LogicCapture> captures;
+    core::LogicSample gpioScratch;
+    mutable std::recursive_mutex mutex;
+    ui::RenderInvalidator renderCache;
+    // WindowContext::selectedSource; saved with the layout.
+    std::shared_ptr<std::string> shownSource { std::make_shared<std::string>() };
+
+    bool follow { true };
+    std::uint64_t viewEnd { 0 };
+    std::uint64_t viewSpan { kDefaultViewSpan };
+    std::uint64_t cursor { 0 };
+    // Reused by drawCapture().
+    std::vector<core::LogicCapture::Column> columns;
+};
+
+class LogicAnalyzerComponent : public ftxui::ComponentBase {
+public:
+    explicit LogicAnalyzerComponent(std::shared_ptr<LogicAnalyzerState> state)
+        : state_(std::move(state))
+    {
+        state_->watchSources();
+        state_->sourceList.prefer(*state_->shownSource);
+
+        ftxui::MenuOption menuOption;
+        auto triggerSelect = [weak = std::weak_ptr(state_)]() {
+            if (auto state = weak.lock()) {
+                state->sourceList.prefer({});
+                state->selectSource(state->sourceList.selected, false);
+            }
+        };
+        menuOption.on_change = triggerSelect;
+        menuOption.on_enter = triggerSelect;
+
+        menuComponent_ = ftxui::Menu(&state_->sourceList.titles, &state_->sourceList.selected, menuOption);
+        auto menuFrame = ftxui::Renderer(menuComponent_, [state = state_, menuComponent = menuComponent_]() {
+            using namespace ftxui;
+            state->syncSources();
+            return menuComponent->Render() | vscroll_indicator;
+        });
+
+        auto tracePane = ftxui::Renderer([state = state_]() {
+            using namespace ftxui;
+            return state->render() | vscroll_indicator | frame | flex;
+        });
+
+        Add(ftxui::Container::Horizontal({
+            menuFrame,
+            ftxui::Renderer([] { return ftxui::separator(); }),
+            tracePane,
+        }));
+
+        if (!state_->sourceList.empty()) {
+            state_->selectSource(state_->sourceList.selected, true);
+        }
+    }
+
+    ~LogicAnalyzerComponent() override
+    {
+        if (state_) {
+            state_->unwatchSources();
+            state_->unsubscribe();
+        }
+    }
+
+    bool OnEvent(ftxui::Event event) override
+    {
+        using ftxui::Event;
+        const auto span = static_cast<std::int64_t>(std::max<std::uint64_t>(state_->viewSpan / 4, 1));
+        if (event == Event::ArrowLeft || event == Event::Character("<")) {
+            state_->pan(-span);
+            return true;
+        }
+        if (event == Event::ArrowRight || event == Event::Character(">")) {
+            state_->pan(span);
+            return true;
+        }
+        if (event == Event::Character("+") || event == Event::Character("=")) {
+            state_->zoom(true);
+            return true;
+        }
+        if (event == Event::Character("-")) {
+            state_->zoom(false);
+            return true;
+        }
+        if (event == Event::Character("n")) {
+            state_->jumpToEdge(true);
+            return true;
+        }
+        if (event == Event::Character("p")) {
+            state_->jumpToEdge(false);
+            return true;
+        }
+        if (event == Event::Character("f") || event == Event::End) {
+            state_->setFollow(true);
+            return true;
+        }
+        if (event == Event::Home) {
+            state_->setFollow(false);
+            return true;
+        }
+        return ComponentBase::OnEvent(event);
+    }
+
+private:
+    std::shared_ptr<LogicAnalyzerState> state_;
+    ftxui::Component menuComponent_;
+};
+
+} // namespace
+
+LogicAnalyzerModule::LogicAnalyzerModule() = default;
+
+std::string LogicAnalyzerModule::id() const
+{
+    return "ui.logic_analyzer";
+}
+
+std::string LogicAnalyzerModule::displayName() const
+{
+    return "Logic Analyzer";
+}
+
+void LogicAnalyzerModule::initialize(core::ModuleContext& context)
+{
+    context_ = &context;
+}
+
+void LogicAnalyzerModule::shutdown(core::ModuleContext& context)
+{
+    (void)context;
+    context_ = nullptr;
+}
+
+std::vector<core::SourceMetadata> LogicAnalyzerModule::declareSources()
+{
+    return {};
+}
+
+std::vector<ui::WindowSpec> LogicAnalyzerModule::createDefaultWindows(core::ModuleContext& context)
+{
+    ui::WindowSpec spec;
+    spec.id = "ui.logic_analyzer.window";
+    spec.title = "Logic Analyzer";
+    spec.cloneable = true;
+    spec.defaultWidth = 72;
+    spec.defaultHeight = 16;
+    spec.componentFactory = [&context](ui::WindowContext& windowContext) -> ftxui::Component {
+        auto state = std::make_shared<LogicAnalyzerState>(context);
+        state->renderCache = windowContext.cacheRendering();
+        state->shownSource = windowContext.selectedSource;
+        return std::make_shared<LogicAnalyzerComponent>(std::move(state));
+    };
+
+    return { spec };
+}
@@ -2,8 +2,12 @@
 #include "hardware/HardwareServiceClient.h"
 
 #include "core/DataRegistry.h"
+#include "core/Statistics.h"
+#include "ui/RedrawScheduler.h"
+#include "ui/SourceList.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <map>
 #include <memory>
@@ -21,15 +25,33 @@
 
 namespace {
 
+// Sources the window can summarise.
+core::SourceQuery MeasurableSources()
+{
+    core::SourceQuery query;
+    query.kinds = { core::DataKind::Numeric, core::DataKind::Waveform };
+    return query;
+}
+
+// Undelivered frames kept per window before the oldest are dropped.
+constexpr std::size_t kObserverQueueCapacity = 64;
+// Waveform mean/RMS need every sample; the frame-rate limit still caps traffic.
+constexpr std::uint32_t kWaveformPointBudget = 0;
+
 struct MetricStats {
     std::string channelId;
     std::string unit;
-    double current { 0.0 };
-    double min { 0.0 };
-    double max { 0.0 };
-    bool hasCurrent { false };
-    bool hasMin { false };
-    bool hasMax { false };
+    bool hasWaveform { false };
+    core::ChannelStatistics stats;
+};
+
+// Persistent rows for one channel: current value, min/max with reset buttons and a
+// mean/RMS/spread summary.
+struct MetricRows {
+    ftxui::Component valueRow;
+    ftxui::Component minRow;
+    ftxui::Component maxRow;
+    ftxui::Component statsRow;
 };
 
 struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
@@ -41,19 +63,46 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
     ~NumericDataState()
     {
         unsubscribe();
+        detachRedraw();
+    }
+
+    void attachRedraw()
+    {
+        auto* scheduler = moduleContext.redrawScheduler;
+        if (!scheduler || redrawToken != 0) {
+            return;
+        }
+        redrawToken = scheduler->addTarget([weak = weak_from_this()]() {
+            if (auto self = weak.lock()) {
+                self->refreshMetricsPane();
+            }
+        });
+    }
+
+    void detachRedraw()
+    {
+        if (moduleContext.redrawScheduler && redrawToken != 0) {
+            moduleContext.redrawScheduler->removeTarget(redrawToken);
+        }
+        redrawToken = 0;
     }
 
     void selectSource(int index, bool force)
     {
         std::lock_guard lock(mutex);
+        const auto& sources = sourceList.sources;
         if (sources.empty()) {
             return;
         }
         if (index < 0 || index >= static_cast<int>(sources.size())) {
             return;
         }
-        selectedIndex = index;
+        sourceList.selected = index;
         const std::string newSource = sources[static_cast<std::size_t>(index)].id;
+        // While a restored source is still awaited, the layout keeps asking for it.
+        if (sourceList.preferred().empty()) {
+            *shownSource = newSource;
+        }
         if (!force && newSource == currentSourceId) {
             return;
         }
@@ -63,20 +112,69 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         subscribe(newSource);
     }
 
+    // Catalog changes are queued by whichever thread registers the source and folded
+    // into the menu by syncSources() on the next render.
+    void watchSources()
+    {
+        auto& catalog = moduleContext.dataRegistry.catalog();
+        catalogToken = catalog.addObserver([weak = weak_from_this()](const core::SourceEvent& event) {
+            auto self = weak.lock();
+            if (!self || !self->sourceList.enqueue(event)) {
+                return;
+            }
+            self->renderCache.invalidate();
+            if (self->moduleContext.redrawScheduler) {
+                self->moduleContext.redrawScheduler->requestRedraw();
+            }
+        });
+        sourceList.load(catalog);
+    }
+
+    void unwatchSources()
+    {
+        if (catalogToken != 0) {
+            moduleContext.dataRegistry.catalog().removeObserver(catalogToken);
+        }
+        catalogToken = 0;
+    }
+
+    // UI thread. Follows the selection to a neighbour when the shown source goes away.
+    void syncSources()
+    {
+        if (!sourceList.sync()) {
+            return;
+        }
+        if (const auto* source = sourceList.selectedSource(); source && source->id != currentSourceId) {
+            selectSource(sourceList.selected, false);
+        }
+    }
+
     void subscribe(const std::string& sourceId)
     {
         unsubscribe();
         metrics.clear();
+        ++structureVersion;
         currentSourceId = sourceId;
 
-        moduleContext.hardwareService.subscribeSource(sourceId);
+        // One update per frame; waveforms arrive whole so block statistics are exact.
+        hardware::SubscribeOptions subscribeOptions;
+        subscribeOptions.maxRateHz = moduleContext.redrawScheduler ? moduleContext.redrawScheduler->maxFps() : ui::RedrawScheduler::kDefaultMaxFps;
+        subscribeOptions.decimation = hardware::Decimation::None;
+        subscribeOptions.waveformPointBudget = kWaveformPointBudget;
+        subscriptionToken = moduleContext.hardwareService.subscribeSource(sourceId, subscribeOptions);
 
         auto self = weak_from_this();
+        // Delivered off the ingest thread; frames still feed min/max, so keep a backlog
+        // rather than conflating.
+        core::ObserverOptions options;
+        options.delivery = core::ObserverDelivery::Queued;
+        options.policy = core::BackpressurePolicy::DropOldest;
+        options.queueCapacity = kObserverQueueCapacity;
         observerToken = moduleContext.dataRegistry.addObserver(sourceId, [self](const core::DataFrame& frame) {
             if (auto state = self.lock()) {
                 state->handleFrame(frame);
             }
-        });
+        }, options);
 
         if (auto latest = moduleContext.dataRegistry.latest(sourceId)) {
             handleFrame(*latest);
@@ -88,9 +186,10 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         if (observerToken != 0 && !currentSourceId.empty()) {
             moduleContext.dataRegistry.removeObserver(currentSourceId, observerToken);
         }
-        if (!currentSourceId.empty()) {
-            moduleContext.hardwareService.unsubscribeSource(currentSourceId);
+        if (subscriptionToken != 0) {
+            moduleContext.hardwareService.unsubscribeSource(subscriptionToken);
         }
+        subscriptionToken = 0;
         observerToken = 0;
         currentSourceId.clear();
     }
@@ -99,21 +198,28 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
     {
         {
             std::lock_guard lock(mutex);
+            // A queued frame from the previous source may arrive after a switch.
+            if (frame.sourceId != currentSourceId) {
+                return;
+            }
             for (const auto& point : frame.points) {
-                if (const auto* numeric = std::get_if<core::NumericSample>(&point.payload)) {
-                    auto& entry = metrics[point.channelId];
-                    entry.channelId = point.channelId;
+                const auto* numeric = std::get_if<core::NumericSample>(&point.payload);
+                const auto* waveform = std::get_if<core::WaveformSample>(&point.payload);
+                if (!numeric && !waveform) {
+                    continue;
+                }
+                auto [it, inserted] = metrics.try_emplace(point.channelId);
+                if (inserted) {
+                    ++structureVersion;
+                }
+                auto& entry = it->second;
+                entry.channelId = point.channelId;
+                if (numeric) {
                     entry.unit = numeric->unit;
-                    entry.current = numeric->value;
-                    entry.hasCurrent = true;
-                    if (!entry.hasMin || numeric->value < entry.min) {
-                        entry.min = numeric->value;
-                        entry.hasMin = true;
-                    }
-                    if (!entry.hasMax || numeric->value > entry.max) {
-                        entry.max = numeric->value;
-                        entry.hasMax = true;
-                    }
+                    entry.stats.addSample(numeric->value);
+                } else {
+                    entry.hasWaveform = true;
+                    entry.stats.addBlock(waveform->samples);
                 }
             }
         }
@@ -125,10 +231,7 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         {
             std::lock_guard lock(mutex);
             if (auto it = metrics.find(channelId); it != metrics.end()) {
-                it->second.hasMin = it->second.hasCurrent;
-                if (it->second.hasCurrent) {
-                    it->second.min = it->second.current;
-                }
+                it->second.stats.resetMin();
             }
         }
         requestRebuild();
@@ -139,10 +242,7 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         {
             std::lock_guard lock(mutex);
             if (auto it = metrics.find(channelId); it != metrics.end()) {
-                it->second.hasMax = it->second.hasCurrent;
-                if (it->second.hasCurrent) {
-                    it->second.max = it->second.current;
-                }
+                it->second.stats.resetMax();
             }
         }
         requestRebuild();
@@ -152,18 +252,21 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
     {
         std::lock_guard lock(mutex);
         std::vector<std::string> lines;
-        lines.reserve(metrics.size() * 3);
+        lines.reserve(metrics.size() * 4);
         auto keys = collectSortedKeys();
         for (const auto& key : keys) {
             const auto& entry = metrics.at(key);
-            if (entry.hasCurrent) {
-                lines.push_back(formatValue(entry.channelId, entry.current, entry.unit, "Value"));
+            if (entry.stats.hasCurrent()) {
+                lines.push_back(formatValue(entry.channelId, entry.stats.current(), entry.unit, "Value"));
+            }
+            if (entry.stats.hasMin()) {
+                lines.push_back(formatValue(entry.channelId, entry.stats.min(), entry.unit, "Min"));
             }
-            if (entry.hasMin) {
-                lines.push_back(formatValue(entry.channelId, entry.min, entry.unit, "Min"));
+            if (entry.stats.hasMax()) {
+                lines.push_back(formatValue(entry.channelId, entry.stats.max(), entry.unit, "Max"));
             }
-            if (entry.hasMax) {
-                lines.push_back(formatValue(entry.channelId, entry.max, entry.unit, "Max"));
+            if (entry.stats.hasCurrent()) {
+                lines.push_back(formatSummary(entry));
             }
         }
         return lines;
@@ -189,6 +292,22 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         return label + ": " + formatNumeric(value) + (unit.empty() ? "" : " " + unit);
     }
 
+    // Waveform channels summarise their latest frame; numeric channels the rolling
+    // window of their last readings.
+    static std::string formatSummary(const MetricStats& entry)
+    {
+        const std::string unit = entry.unit.empty() ? "" : " " + entry.unit;
+        if (entry.hasWaveform || entry.stats.rolling().empty()) {
+            const auto& block = entry.stats.lastBlock();
+            return "  mean " + formatNumeric(block.mean) + unit + "  rms " + formatNumeric(block.rms()) + unit
+                + "  sd " + formatNumeric(block.stddev()) + "  p-p " + formatNumeric(block.peakToPeak());
+        }
+        const auto& rolling = entry.stats.rolling();
+        return "  last " + std::to_string(rolling.size()) + ": mean " + formatNumeric(rolling.mean()) + unit + "  rms "
+            + formatNumeric(rolling.rms()) + unit + "  min " + formatNumeric(rolling.min()) + "  max "
+            + formatNumeric(rolling.max());
+    }
+
     static std::string formatNumeric(double value)
     {
         char buffer[64];
@@ -196,98 +315,182 @@ struct NumericDataState : std::enable_shared_from_this<NumericDataState> {
         return std::string(buffer);
     }
 
+    // Coalesced through the redraw scheduler when one is available; the direct Post
+    // fallback only exists for contexts without a scheduler.
     void requestRebuild()
     {
+        renderCache.invalidate();
+        if (redrawToken != 0 && moduleContext.redrawScheduler) {
+            moduleContext.redrawScheduler->markDirty(redrawToken);
+            return;
+        }
         auto self = shared_from_this();
         if (auto* screen = ftxui::ScreenInteractive::Active()) {
             screen->Post([self]() {
-                if (self->metricsPane) {
-                    self->rebuildMetricsPane();
-                }
+                self->refreshMetricsPane();
             });
         }
     }
 
+    enum class MetricField {
+        Value,
+        Min,
+        Max,
+        Summary,
+    };
+
+    // Runs on the UI thread once per frame in which data arrived. Rows are only
+    // recreated when the set of channels changes; values are read at render time.
+    void refreshMetricsPane()
+    {
+        if (!metricsPane) {
+            return;
+        }
+        std::uint64_t version = 0;
+        {
+            std::lock_guard lock(mutex);
+            version = structureVersion;
+        }
+        if (version != builtStructureVersion || metricsPane->ChildCount() == 0) {
+            rebuildMetricsPane();
+        }
+    }
+
     void rebuildMetricsPane()
     {
         if (!metricsPane) {
             return;
         }
-        metricsPane->DetachAllChildren();
+        renderCache.invalidate();
 
-        auto keys = collectSortedKeys();
-        auto weakSelf = weak_from_this();
-        for (const auto& key : keys) {
-            MetricStats statsCopy;
-            {
-                std::lock_guard lock(mutex);
-                statsCopy = metrics.at(key);
-            }
+        std::vector<std::string> keys;
+        {
+            std::lock_guard lock(mutex);
+            keys = collectSortedKeys();
+            builtStructureVersion = structureVersion;
+        }
 
-            if (statsCopy.hasCurrent) {
-                const std::string line = formatValue(key, statsCopy.current, statsCopy.unit, "");
-                auto row = ftxui::Renderer([line]() {
-                    using namespace ftxui;
-                    return hbox({
-                        text(line),
-                    });
-                });
-                metricsPane->Add(row);
+        for (auto it = metricRows.begin(); it != metricRows.end();) {
+            if (std::binary_search(keys.begin(), keys.end(), it->first)) {
+                ++it;
+            } else {
+                it = metricRows.erase(it);
             }
-            if (statsCopy.hasMin) {
-                const std::string line = formatValue(key, statsCopy.min, statsCopy.unit, "Min");
-                auto resetButton = ftxui::Button("Reset", [weakSelf, key]() {
-                    if (auto self = weakSelf.lock()) {
-                        self->resetMin(key);
-                    } }, ftxui::ButtonOption::Ascii());
-                auto row = ftxui::Renderer(resetButton, [line, resetButton]() {
-                    using namespace ftxui;
-                    return hbox({
-                        text(line),
-                        filler(),
-                        resetButton->Render(),
-                    });
-                });
-                metricsPane->Add(row);
+        }
+
+        metricsPane->DetachAllChildren();
+        for (const auto& key : keys) {
+            auto& rows = metricRows[key];
+            if (!rows.valueRow) {
+                rows = makeMetricRows(key);
             }
-            if (statsCopy.hasMax) {
-                const std::string line = formatValue(key, statsCopy.max, statsCopy.unit, "Max");
-                auto resetButton = ftxui::Button("Reset", [weakSelf, key]() {
-                    if (auto self = weakSelf.lock()) {
-                        self->resetMax(key);
-                    } }, ftxui::ButtonOption::Ascii());
-                auto row = ftxui::Renderer(resetButton, [line, resetButton]() {
+            metricsPane->Add(rows.valueRow);
+            metricsPane->Add(rows.minRow);
+            metricsPane->Add(rows.maxRow);
+            metricsPane->Add(rows.statsRow);
+        }
+
+        if (metricsPane->ChildCount() == 0) {
+            if (!emptyRow) {
+                emptyRow = ftxui::Renderer([]() {
                     using namespace ftxui;
-                    return hbox({
-                        text(line),
-                        filler(),
-                        resetButton->Render(),
-                    });
+                    return text("No numeric data available.") | dim;
                 });
-                metricsPane->Add(row);
             }
+            metricsPane->Add(emptyRow);
         }
+    }
 
-        if (metricsPane->ChildCount() == 0) {
-            auto empty = ftxui::Renderer([]() {
-                using namespace ftxui;
-                return text("No numeric data available.") | dim;
+    MetricRows makeMetricRows(const std::string& key)
+    {
+        auto weakSelf = weak_from_this();
+        MetricRows rows;
+        rows.valueRow = ftxui::Renderer([weakSelf, key]() {
+            using namespace ftxui;
+            auto self = weakSelf.lock();
+            return hbox({
+                self ? self->renderMetric(key, MetricField::Value) : text(""),
+            });
+        });
+
+        auto resetMinButton = ftxui::Button("Reset", [weakSelf, key]() {
+            if (auto self = weakSelf.lock()) {
+                self->resetMin(key);
+            } }, ftxui::ButtonOption::Ascii());
+        rows.minRow = ftxui::Renderer(resetMinButton, [weakSelf, key, resetMinButton]() {
+            using namespace ftxui;
+            auto self = weakSelf.lock();
+            return hbox({
+                self ? self->renderMetric(key, MetricField::Min) : text(""),
+                filler(),
+                resetMinButton->Render(),
             });
-            metricsPane->Add(empty);
+        });
+
+        auto resetMaxButton = ftxui::Button("Reset", [weakSelf, key]() {
+            if (auto self = weakSelf.lock()) {
+                self->resetMax(key);
+            } }, ftxui::ButtonOption::Ascii());
+        rows.maxRow = ftxui::Renderer(resetMaxButton, [weakSelf, key, resetMaxButton]() {
+            using namespace ftxui;
+            auto self = weakSelf.lock();
+            return hbox({
+                self ? self->renderMetric(key, MetricField::Max) : text(""),
+                filler(),
+                resetMaxButton->Render(),
+            });
+        });
+        rows.statsRow = ftxui::Renderer([weakSelf, key]() {
+            using namespace ftxui;
+            auto self = weakSelf.lock();
+            return self ? self->renderMetric(key, MetricField::Summary) | dim : text("");
+        });
+        return rows;
+    }
+
+    ftxui::Element renderMetric(const std::string& key, MetricField field) const
+    {
+        using namespace ftxui;
+        std::lock_guard lock(mutex);
+        auto it = metrics.find(key);
+        if (it == metrics.end()) {
+            return text("");
+        }
+        const auto& entry = it->second;
+        switch (field) {
+        case MetricField::Value:
+            return entry.stats.hasCurrent() ? text(formatValue(key, entry.stats.current(), entry.unit, "")) : text("");
+        case MetricField::Min:
+            return entry.stats.hasMin() ? text(formatValue(key, entry.stats.min(), entry.unit, "Min")) : text("");
+        case MetricField::Max:
+            return entry.stats.hasMax() ? text(formatValue(key, entry.stats.max(), entry.unit, "Max")) : text("");
+        case MetricField::Summary:
+            return entry.stats.hasCurrent() ? text(formatSummary(entry)) : text("");
         }
+        return text("");
     }
 
     core::ModuleContext& moduleContext;
-    std::vector<core::SourceMetadata> sources;
-    std::vector<std::string> sourceTitles;
-    int selectedIndex { 0 };
+    ui::SourceList sourceList { MeasurableSources(), "No numeric sources available" };
+    int catalogToken { 0 };
     std::string currentSourceId;
     int observerToken { 0 };
+    int subscriptionToken { 0 };
+    int redrawToken { 0 };
+    ui::RenderInvalidator renderCache;
+    // The window's remembered source (WindowContext::selectedSource), saved with the layout.
+    std::shared_ptr<std::string> shownSource { std::make_shared<std::string>() };
     std::map<std::string, MetricStats> metrics;
+    // Bumped whenever a channel appears or the channel set is reset.
+    std::uint64_t structureVersion { 0 };
     mutable std::recursive_mutex mutex;
 
     ftxui::Component menuComponent;
     std::shared_ptr<ftxui::ComponentBase> metricsPane;
+    // UI-thread only: persistent rows keyed by channel id.
+    std::map<std::string, MetricRows> metricRows;
+    ftxui::Component emptyRow;
+    std::uint64_t builtStructureVersion { ~std::uint64_t { 0 } };
 };
 
 class NumericDataComponent : public ftxui::ComponentBase {
@@ -295,27 +498,31 @@ public:
     explicit NumericDataComponent(std::shared_ptr<NumericDataState> state)
         : state_(std::move(state))
     {
-        buildSourceList();
+        state_->watchSources();
+        state_->sourceList.prefer(*state_->shownSource);
 
         ftxui::MenuOption menuOption;
         auto triggerSelect = [weak = std::weak_ptr(state_), this]() {
             if (auto state = weak.lock()) {
                 if (flags::logLevel >= 3) {
-                    spdlog::debug("Numeric menu on_change: index={} source_count={}", state->selectedIndex, state->sources.size());
+                    spdlog::debug("Numeric menu on_change: index={} source_count={}", state->sourceList.selected, state->sourceList.sources.size());
                 }
-                state->selectSource(state->selectedIndex, false);
+                state->sourceList.prefer({});
+                state->selectSource(state->sourceList.selected, false);
             }
         };
         menuOption.on_change = triggerSelect;
         menuOption.on_enter = triggerSelect;
 
-        menuComponent_ = ftxui::Menu(&state_->sourceTitles, &state_->selectedIndex, menuOption);
-        auto menuFrame = ftxui::Renderer(menuComponent_, [menuComponent = menuComponent_]() {
+        menuComponent_ = ftxui::Menu(&state_->sourceList.titles, &state_->sourceList.selected, menuOption);
+        auto menuFrame = ftxui::Renderer(menuComponent_, [state = state_, menuComponent = menuComponent_]() {
             using namespace ftxui;
+            state->syncSources();
             return menuComponent->Render() | vscroll_indicator;
         });
 
         state_->metricsPane = ftxui::Container::Vertical({});
+        state_->attachRedraw();
         auto metricsFrame = ftxui::Renderer(state_->metricsPane, [state = state_]() {
             using namespace ftxui;
             return state->metricsPane->Render() | vscroll_indicator | frame | flex;
@@ -329,8 +536,8 @@ public:
 
         Add(layout);
 
-        if (!state_->sourceTitles.empty()) {
-            state_->selectSource(state_->selectedIndex, true);
+        if (!state_->sourceList.empty()) {
+            state_->selectSource(state_->sourceList.selected, true);
         } else {
             state_->rebuildMetricsPane();
         }
@@ -339,26 +546,12 @@ public:
     ~NumericDataComponent() override
     {
         if (state_) {
+            state_->unwatchSources();
             state_->unsubscribe();
         }
     }
 
 private:
-    void buildSourceList()
-    {
-        auto metadata = state_->moduleContext.dataRegistry.listSources();
-        for (const auto& meta : metadata) {
-            if (meta.kind == core::DataKind::Numeric) {
-                state_->sources.push_back(meta);
-                state_->sourceTitles.push_back(meta.name);
-            }
-        }
-
-        if (state_->sources.empty()) {
-            state_->sourceTitles = { "No numeric sources available" };
-        }
-    }
-
     std::shared_ptr<NumericDataState> state_;
     ftxui::Component menuComponent_;
 };
@@ -400,8 +593,10 @@ std::vector<ui::WindowSpec> NumericDataModule::createDefaultWindows(core::Module
     spec.title = "Numeric Data";
     spec.cloneable = true;
     spec.openByDefault = true;
-    spec.componentFactory = [&context](ui::WindowContext&) -> ftxui::Component {
+    spec.componentFactory = [&context](ui::WindowContext& windowContext) -> ftxui::Component {
         auto state = std::make_shared<NumericDataState>(context);
+        state->renderCache = windowContext.cacheRendering();
+        state->shownSource = windowContext.selectedSource;
         return std::make_shared<NumericDataComponent>(std::move(state));
     };
 
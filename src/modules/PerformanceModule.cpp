@@ -0,0 +1,222 @@
+#include "modules/PerformanceModule.h"
+
+#include "ui/RedrawScheduler.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/dom/elements.hpp>
+
+#include "flags.h"
+#include <spdlog/spdlog.h>
+
+namespace {
+
+constexpr auto kRefreshInterval = std::chrono::milliseconds(500);
+constexpr int kNameWidth = 24;
+constexpr int kValueWidth = 11;
+
+std::string FormatNs(double ns)
+{
+    char buffer[32];
+    if (ns >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+    } else if (ns >= 1e3) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f us", ns / 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.0f ns", ns);
+    }
+    return buffer;
+}
+
+std::string FormatRate(double perSecond)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.1f/s", perSecond);
+    return buffer;
+}
+
+ftxui::Element Cell(std::string value, int width)
+{
+    using namespace ftxui;
+    return text(std::move(value)) | size(WIDTH, EQUAL, width);
+}
+
+// Snapshots are taken on the UI thread at most once per refresh interval, so
+// rates and interval percentiles stay readable however often the screen repaints.
+struct PerformanceView {
+    explicit PerformanceView(std::shared_ptr<std::atomic<int>> openWindows)
+        : openWindows(std::move(openWindows))
+    {
+        this->openWindows->fetch_add(1);
+        current = core::metrics::Collect();
+        previous = current;
+    }
+
+    ~PerformanceView()
+    {
+        openWindows->fetch_sub(1);
+    }
+
+    void refresh()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - current.taken < kRefreshInterval) {
+            return;
+        }
+        previous = std::move(current);
+        current = core::metrics::Collect();
+    }
+
+    ftxui::Element render()
+    {
+        using namespace ftxui;
+        refresh();
+        const double seconds = std::chrono::duration<double>(current.taken - previous.taken).count();
+
+        Elements rows;
+        rows.push_back(hbox({ Cell("counter", kNameWidth), Cell("total", kValueWidth), Cell("rate", kValueWidth) }) | bold);
+        for (std::size_t i = 0; i < current.counters.size(); ++i) {
+            const auto& counter = current.counters[i];
+            const std::uint64_t before = i < previous.counters.size() ? previous.counters[i].total : 0;
+            const double rate = seconds > 0.0 ? static_cast<double>(counter.total - before) / seconds : 0.0;
+            rows.push_back(hbox({
+                Cell(counter.name, kNameWidth),
+                Cell(std::to_string(counter.total), kValueWidth),
+                Cell(FormatRate(rate), kValueWidth),
+            }));
+        }
+
+        rows.push_back(separator());
+        rows.push_back(hbox({
+            Cell("timing", kNameWidth),
+            Cell("rate", kValueWidth),
+            Cell("mean", kValueWidth),
+            Cell("p50", kValueWidth),
+            Cell("p99", kValueWidth),
+            Cell("max", kValueWidth),
+        }) | bold);
+        for (std::size_t i = 0; i < current.histograms.size(); ++i) {
+            const auto interval = i < previous.histograms.size()
+                ? core::metrics::Since(current.histograms[i], previous.histograms[i])
+                : current.histograms[i];
+            if (interval.count == 0) {
+                rows.push_back(hbox({ Cell(interval.name, kNameWidth), text("idle") }) | dim);
+                continue;
+            }
+            rows.push_back(hbox({
+                Cell(interval.name, kNameWidth),
+                Cell(FormatRate(seconds > 0.0 ? static_cast<double>(interval.count) / seconds : 0.0), kValueWidth),
+                Cell(FormatNs(interval.meanNs()), kValueWidth),
+                Cell(FormatNs(interval.percentileNs(0.50)), kValueWidth),
+                Cell(FormatNs(interval.percentileNs(0.99)), kValueWidth),
+                Cell(FormatNs(static_cast<double>(interval.maxNs)), kValueWidth),
+            }));
+        }
+        if (!current.gauges.empty()) {
+            rows.push_back(separator());
+            rows.push_back(hbox({ Cell("level", kNameWidth), Cell("now", kValueWidth), Cell("max", kValueWidth) }) | bold);
+            for (const auto& gauge : current.gauges) {
+                rows.push_back(hbox({
+                    Cell(gauge.name, kNameWidth),
+                    Cell(std::to_string(gauge.value), kValueWidth),
+                    Cell(std::to_string(gauge.max), kValueWidth),
+                }));
+            }
+        }
+        rows.push_back(separator());
+        rows.push_back(text("max is since start; other timings cover the last refresh") | dim);
+        return vbox(std::move(rows));
+    }
+
+    std::shared_ptr<std::atomic<int>> openWindows;
+    core::metrics::Snapshot previous;
+    core::metrics::Snapshot current;
+};
+
+} // namespace
+
+PerformanceModule::PerformanceModule()
+    : openWindows_(std::make_shared<std::atomic<int>>(0))
+{
+}
+
+std::string PerformanceModule::id() const
+{
+    return "ui.performance";
+}
+
+std::string PerformanceModule::displayName() const
+{
+    return "Performance";
+}
+
+void PerformanceModule::initialize(core::ModuleContext& context)
+{
+    (void)context;
+    sinceLog_ = std::chrono::milliseconds { 0 };
+    lastLogged_.reset();
+}
+
+void PerformanceModule::shutdown(core::ModuleContext& context)
+{
+    (void)context;
+    if (flags::metricsLogInterval > 0) {
+        // A final line covering everything since the last periodic dump.
+        const auto snapshot = core::metrics::Collect();
+        core::metrics::LogSnapshot(snapshot, lastLogged_ ? &*lastLogged_ : nullptr);
+    }
+}
+
+std::vector<core::SourceMetadata> PerformanceModule::declareSources()
+{
+    return {};
+}
+
+std::vector<ui::WindowSpec> PerformanceModule::createDefaultWindows(core::ModuleContext& context)
+{
+    (void)context;
+    ui::WindowSpec spec;
+    spec.id = "ui.performance.window";
+    spec.title = "Performance";
+    spec.cloneable = false;
+    spec.defaultWidth = 82;
+    spec.defaultHeight = 24;
+    spec.componentFactory = [openWindows = openWindows_](ui::WindowContext&) -> ftxui::Component {
+        auto view = std::make_shared<PerformanceView>(openWindows);
+        return ftxui::Renderer([view]() {
+            using namespace ftxui;
+            return view->render() | vscroll_indicator | frame | flex;
+        });
+    };
+
+    return { spec };
+}
+
+void PerformanceModule::tick(core::ModuleContext& context, std::chrono::milliseconds delta)
+{
+    if (openWindows_->load() > 0 && context.redrawScheduler) {
+        context.redrawScheduler->requestRedraw();
+    }
+
+    if (flags::metricsLogInterval <= 0) {
+        return;
+    }
+    sinceLog_ += delta;
+    if (sinceLog_ < std::chrono::seconds(flags::metricsLogInterval)) {
+        return;
+    }
+    sinceLog_ = std::chrono::milliseconds { 0 };
+    auto snapshot = core::metrics::Collect();
+    spdlog::info("Metrics: periodic dump ({} s interval)", flags::metricsLogInterval);
+    core::metrics::LogSnapshot(snapshot, lastLogged_ ? &*lastLogged_ : nullptr);
+    lastLogged_ = std::move(snapshot);
+}
+
+std::chrono::milliseconds PerformanceModule::tickInterval() const
+{
+    return kRefreshInterval;
+}
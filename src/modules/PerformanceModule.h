@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/Metrics.h"
+#include "core/Module.h"
+#include "ui/WindowSpec.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+/**
+ * @brief Built-in view of the process-wide hot-path metrics.
+ *
+ * The window lists every counter with its rate and every histogram over the last
+ * refresh interval. Ticking repaints open windows twice a second and, when
+ * `--metrics-log-interval` is set, writes the same figures to the log.
+ */
+class PerformanceModule : public core::Module {
+public:
+    PerformanceModule();
+    ~PerformanceModule() override = default;
+
+    std::string id() const override;
+    std::string displayName() const override;
+
+    void initialize(core::ModuleContext& context) override;
+    void shutdown(core::ModuleContext& context) override;
+
+    std::vector<core::SourceMetadata> declareSources() override;
+    std::vector<ui::WindowSpec> createDefaultWindows(core::ModuleContext& context) override;
+
+    void tick(core::ModuleContext& context, std::chrono::milliseconds delta) override;
+    std::chrono::milliseconds tickInterval() const override;
+
+private:
+    // Performance windows currently open; ticks only repaint while there are any.
+    std::shared_ptr<std::atomic<int>> openWindows_;
+    std::chrono::milliseconds sinceLog_{0};
+    std::optional<core::metrics::Snapshot> lastLogged_;
+};
@@ -0,0 +1,369 @@
+#include "modules/RecorderModule.h"
+#include "hardware/HardwareServiceClient.h"
+
+#include "core/CaptureFile.h"
+#include "core/DataRegistry.h"
+#include "ui/RedrawScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/dom/elements.hpp>
+
+#include "flags.h"
+#include <spdlog/spdlog.h>
+
+namespace {
+
+std::vector<std::string> SplitIds(const std::string& list)
+{
+    std::vector<std::string> ids;
+    std::size_t start = 0;
+    while (start <= list.size()) {
+        const auto comma = std::min(list.find(',', start), list.size());
+        if (comma > start) {
+            ids.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+    return ids;
+}
+
+std::string CapturePath(const std::string& sourceId)
+{
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm local {};
+    localtime_r(&now, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+    // Source ids are dotted names; anything that cannot go in a file name becomes '_'.
+    std::string name = sourceId;
+    for (auto& c : name) {
+        if (c == '/' || c == '\\' || c == ':') {
+            c = '_';
+        }
+    }
+    return (std::filesystem::path(flags::captureDir) / (name + "-" + stamp + ".wbcap")).string();
+}
+
+std::string FormatBytes(std::uint64_t bytes)
+{
+    char buffer[32];
+    if (bytes >= (std::uint64_t { 1 } << 30)) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f GiB", static_cast<double>(bytes) / (1 << 30));
+    } else if (bytes >= (std::uint64_t { 1 } << 20)) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f MiB", static_cast<double>(bytes) / (1 << 20));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.1f KiB", static_cast<double>(bytes) / (1 << 10));
+    }
+    return buffer;
+}
+
+struct Recording {
+    std::shared_ptr<core::CaptureWriter> writer;
+    int observerToken { 0 };
+    int subscriptionToken { 0 };
+};
+
+} // namespace
+
+// Shared by the module and its windows; recordings outlive any window.
+struct RecorderState {
+    bool isRecording(const std::string& sourceId) const
+    {
+        std::lock_guard lock(mutex);
+        return recordings.contains(sourceId);
+    }
+
+    void start(const std::string& sourceId)
+    {
+        std::lock_guard lock(mutex);
+        if (!context || recordings.contains(sourceId)) {
+            return;
+        }
+        auto metadata = context->dataRegistry.metadata(sourceId);
+        if (!metadata) {
+            spdlog::warn("Recorder: source '{}' is not registered", sourceId);
+            return;
+        }
+
+        Recording recording;
+        recording.writer = std::make_shared<core::CaptureWriter>();
+        if (!recording.writer->open(CapturePath(sourceId), *metadata)) {
+            return;
+        }
+        // Every reading, undecimated: the capture is the record of the session.
+        recording.subscriptionToken = context->hardwareService.subscribeSource(sourceId);
+        // Inline is fine here: append() only copies into the open chunk.
+        recording.observerToken = context->dataRegistry.addObserver(sourceId, [writer = recording.writer](const core::DataFrame& frame) {
+            writer->append(frame);
+        });
+        recordings.emplace(sourceId, std::move(recording));
+        ++version;
+    }
+
+    void stop(const std::string& sourceId)
+    {
+        Recording recording;
+        {
+            std::lock_guard lock(mutex);
+            auto it = recordings.find(sourceId);
+            if (it == recordings.end()) {
+                return;
+            }
+            recording = std::move(it->second);
+            recordings.erase(it);
+            ++version;
+            if (context) {
+                context->dataRegistry.removeObserver(sourceId, recording.observerToken);
+                context->hardwareService.unsubscribeSource(recording.subscriptionToken);
+            }
+        }
+        // Draining the writer can take a while; do it outside the lock.
+        recording.writer->close();
+    }
+
+    void toggle(const std::string& sourceId)
+    {
+        if (isRecording(sourceId)) {
+            stop(sourceId);
+        } else {
+            start(sourceId);
+        }
+    }
+
+    void stopAll()
+    {
+        std::vector<std::string> ids;
+        {
+            std::lock_guard lock(mutex);
+            for (const auto& [id, _] : recordings) {
+                ids.push_back(id);
+            }
+        }
+        for (const auto& id : ids) {
+            stop(id);
+        }
+    }
+
+    // Starts `--record` sources that have been registered since the last call.
+    void startPending()
+    {
+        std::vector<std::string> ready;
+        {
+            std::lock_guard lock(mutex);
+            if (!context) {
+                return;
+            }
+            for (auto it = pendingIds.begin(); it != pendingIds.end();) {
+                if (context->dataRegistry.isRegistered(*it)) {
+                    ready.push_back(*it);
+                    it = pendingIds.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (const auto& id : ready) {
+            start(id);
+        }
+    }
+
+    void sealStale()
+    {
+        std::lock_guard lock(mutex);
+        for (auto& [_, recording] : recordings) {
+            recording.writer->sealStale();
+        }
+    }
+
+    std::vector<std::pair<std::string, core::CaptureWriter::Stats>> stats() const
+    {
+        std::lock_guard lock(mutex);
+        std::vector<std::pair<std::string, core::CaptureWriter::Stats>> out;
+        for (const auto& [id, recording] : recordings) {
+            out.emplace_back(id, recording.writer->stats());
+        }
+        return out;
+    }
+
+    mutable std::mutex mutex;
+    core::ModuleContext* context { nullptr };
+    std::map<std::string, Recording> recordings;
+    std::vector<std::string> pendingIds;
+    // Bumped whenever a recording starts or stops.
+    std::uint64_t version { 0 };
+    std::atomic<int> openWindows { 0 };
+};
+
+namespace {
+
+class RecorderComponent : public ftxui::ComponentBase {
+public:
+    RecorderComponent(std::shared_ptr<RecorderState> state, core::DataRegistry& registry)
+        : state_(std::move(state))
+        , registry_(registry)
+    {
+        state_->openWindows.fetch_add(1);
+
+        ftxui::MenuOption menuOption;
+        menuOption.on_enter = [this]() {
+            if (selected_ >= 0 && selected_ < static_cast<int>(sourceIds_.size())) {
+                state_->toggle(sourceIds_[static_cast<std::size_t>(selected_)]);
+            }
+        };
+        menu_ = ftxui::Menu(&titles_, &selected_, menuOption);
+        Add(menu_);
+    }
+
+    ~RecorderComponent() override
+    {
+        state_->openWindows.fetch_sub(1);
+    }
+
+    ftxui::Element Render() override
+    {
+        using namespace ftxui;
+        refreshSources();
+
+        Elements rows;
+        for (const auto& [id, stats] : state_->stats()) {
+            rows.push_back(text(id) | bold);
+            rows.push_back(text("  " + std::to_string(stats.frames) + " frames, " + std::to_string(stats.chunks) + " chunks, "
+                + FormatBytes(stats.bytes)));
+            if (stats.droppedFrames > 0 || stats.failed) {
+                rows.push_back(text("  " + std::to_string(stats.droppedFrames) + " frames dropped"
+                    + (stats.failed ? " (write failed)" : "")) | color(Color::Red));
+            }
+        }
+        if (rows.empty()) {
+            rows.push_back(text("Not recording.") | dim);
+        }
+        rows.push_back(filler());
+        rows.push_back(text("Enter: start/stop | " + flags::captureDir) | dim);
+
+        return hbox({
+            menu_->Render() | vscroll_indicator | frame,
+            separator(),
+            vbox(std::move(rows)) | flex,
+        });
+    }
+
+private:
+    // Titles mark recording sources; rebuilt when sources or recordings change.
+    void refreshSources()
+    {
+        // Two version reads per frame; the catalog is only queried after a change.
+        const auto catalogVersion = registry_.catalog().version();
+        std::uint64_t version = 0;
+        {
+            std::lock_guard lock(state_->mutex);
+            version = state_->version;
+        }
+        if (version == builtVersion_ && catalogVersion == builtCatalogVersion_) {
+            return;
+        }
+        builtVersion_ = version;
+        builtCatalogVersion_ = catalogVersion;
+        const auto sources = registry_.catalog().query();
+        sourceIds_.clear();
+        titles_.clear();
+        for (const auto& meta : sources) {
+            sourceIds_.push_back(meta->id);
+            titles_.push_back((state_->isRecording(meta->id) ? "[REC] " : "      ") + meta->name);
+        }
+        if (titles_.empty()) {
+            titles_.push_back("No sources available");
+        }
+        selected_ = std::clamp(selected_, 0, static_cast<int>(titles_.size()) - 1);
+    }
+
+    std::shared_ptr<RecorderState> state_;
+    core::DataRegistry& registry_;
+    ftxui::Component menu_;
+    std::vector<std::string> sourceIds_;
+    std::vector<std::string> titles_;
+    int selected_ { 0 };
+    std::uint64_t builtVersion_ { ~std::uint64_t { 0 } };
+    std::uint64_t builtCatalogVersion_ { ~std::uint64_t { 0 } };
+};
+
+} // namespace
+
+RecorderModule::RecorderModule()
+    : state_(std::make_shared<RecorderState>())
+{
+}
+
+RecorderModule::~RecorderModule() = default;
+
+std::string RecorderModule::id() const
+{
+    return "ui.recorder";
+}
+
+std::string RecorderModule::displayName() const
+{
+    return "Recorder";
+}
+
+void RecorderModule::initialize(core::ModuleContext& context)
+{
+    std::lock_guard lock(state_->mutex);
+    state_->context = &context;
+    state_->pendingIds = SplitIds(flags::recordSources);
+}
+
+void RecorderModule::shutdown(core::ModuleContext& context)
+{
+    (void)context;
+    state_->stopAll();
+    std::lock_guard lock(state_->mutex);
+    state_->pendingIds.clear();
+    state_->context = nullptr;
+}
+
+std::vector<core::SourceMetadata> RecorderModule::declareSources()
+{
+    return {};
+}
+
+std::vector<ui::WindowSpec> RecorderModule::createDefaultWindows(core::ModuleContext& context)
+{
+    ui::WindowSpec spec;
+    spec.id = "ui.recorder.window";
+    spec.title = "Recorder";
+    spec.cloneable = false;
+    spec.defaultWidth = 72;
+    spec.defaultHeight = 16;
+    spec.componentFactory = [state = state_, &context](ui::WindowContext&) -> ftxui::Component {
+        return std::make_shared<RecorderComponent>(state, context.dataRegistry);
+    };
+
+    return { spec };
+}
+
+void RecorderModule::tick(core::ModuleContext& context, std::chrono::milliseconds delta)
+{
+    (void)delta;
+    state_->startPending();
+    state_->sealStale();
+    if (state_->openWindows.load() > 0 && context.redrawScheduler) {
+        context.redrawScheduler->requestRedraw();
+    }
+}
+
+std::chrono::milliseconds RecorderModule::tickInterval() const
+{
+    return std::chrono::seconds(1);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core/Module.h"
+#include "ui/WindowSpec.h"
+
+#include <chrono>
+#include <memory>
+
+struct RecorderState;
+
+/**
+ * @brief Records sources to capture files for long bench sessions.
+ *
+ * Each recording is an inline registry observer feeding a `core::CaptureWriter`,
+ * which copies frames into the open chunk and leaves encoding and disk writes to
+ * its own thread. The window toggles recording per source with Enter; sources
+ * named by `--record` start as soon as they are registered. Files are written to
+ * `--capture-dir` as `<source>-<YYYYmmdd-HHMMSS>.wbcap`.
+ */
+class RecorderModule : public core::Module {
+public:
+    RecorderModule();
+    ~RecorderModule() override;
+
+    std::string id() const override;
+    std::string displayName() const override;
+
+    void initialize(core::ModuleContext& context) override;
+    void shutdown(core::ModuleContext& context) override;
+
+    std::vector<core::SourceMetadata> declareSources() override;
+    std::vector<ui::WindowSpec> createDefaultWindows(core::ModuleContext& context) override;
+
+    void tick(core::ModuleContext& context, std::chrono::milliseconds delta) override;
+    std::chrono::milliseconds tickInterval() const override;
+
+private:
+    std::shared_ptr<RecorderState> state_;
+};
@@ -0,0 +1,419 @@
+#include "modules/ScopeModule.h"
+#include "hardware/HardwareServiceClient.h"
+
+#include "core/DataRegistry.h"
+#include "core/Downsample.h"
+#include "core/Statistics.h"
+#include "ui/RedrawScheduler.h"
+#include "ui/SourceList.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/event.hpp>
+#include <ftxui/component/screen_interactive.hpp>
+#include <ftxui/dom/canvas.hpp>
+#include <ftxui/dom/elements.hpp>
+
+#include "flags.h"
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// Sources the window can trace.
+core::SourceQuery WaveformSources()
+{
+    core::SourceQuery query;
+    query.kinds = { core::DataKind::Waveform };
+    return query;
+}
+
+// A min/max pair for each braille column of a wide window.
+constexpr std::uint32_t kWaveformPointBudget = 1024;
+constexpr int kTraceHeight = 8;
+
+// Latest waveform frame of one channel.
+struct Trace {
+    std::vector<double> samples;
+    double sampleRateHz { 0.0 };
+    std::string unit;
+    core::BlockStats block;
+    // Render-time scratch, reused across frames.
+    core::Envelope envelope;
+};
+
+std::string FormatValue(double value)
+{
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    return buffer;
+}
+
+std::string FormatRate(double hz)
+{
+    char buffer[64];
+    if (hz >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f MS/s", hz / 1e6);
+    } else if (hz >= 1e3) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f kS/s", hz / 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f S/s", hz);
+    }
+    return buffer;
+}
+
+struct ScopeState : std::enable_shared_from_this<ScopeState> {
+    explicit ScopeState(core::ModuleContext& moduleContext)
+        : moduleContext(moduleContext)
+    {
+    }
+
+    ~ScopeState()
+    {
+        unsubscribe();
+    }
+
+    void selectSource(int index, bool force)
+    {
+        std::lock_guard lock(mutex);
+        const auto& sources = sourceList.sources;
+        if (sources.empty()) {
+            return;
+        }
+        if (index < 0 || index >= static_cast<int>(sources.size())) {
+            return;
+        }
+        sourceList.selected = index;
+        const std::string newSource = sources[static_cast<std::size_t>(index)].id;
+        if (sourceList.preferred().empty()) {
+            *shownSource = newSource;
+        }
+        if (!force && newSource == currentSourceId) {
+            return;
+        }
+        if (flags::logLevel >= 3) {
+            spdlog::debug("Scope: selecting source '{}' (index={})", newSource, index);
+        }
+        subscribe(newSource);
+    }
+
+    // Catalog changes are queued by whichever thread registers the source and folded
+    // into the menu by syncSources() on the next render.
+    void watchSources()
+    {
+        auto& catalog = moduleContext.dataRegistry.catalog();
+        catalogToken = catalog.addObserver([weak = weak_from_this()](const core::SourceEvent& event) {
+            auto self = weak.lock();
+            if (!self || !self->sourceList.enqueue(event)) {
+                return;
+            }
+            self->requestRedraw();
+        });
+        sourceList.load(catalog);
+    }
+
+    void unwatchSources()
+    {
+        if (catalogToken != 0) {
+            moduleContext.dataRegistry.catalog().removeObserver(catalogToken);
+        }
+        catalogToken = 0;
+    }
+
+    // UI thread. Follows the selection to a neighbour when the shown source goes away.
+    void syncSources()
+    {
+        if (!sourceList.sync()) {
+            return;
+        }
+        if (const auto* source = sourceList.selectedSource(); source && source->id != currentSourceId) {
+            selectSource(sourceList.selected, false);
+        }
+    }
+
+    void subscribe(const std::string& sourceId)
+    {
+        unsubscribe();
+        traces.clear();
+        held = false;
+        currentSourceId = sourceId;
+        for (const auto& source : sourceList.sources) {
+            if (source.id == sourceId) {
+                unit = source.unit.value_or("");
+            }
+        }
+
+        // One trace per display frame, reduced to min/max pairs that keep glitches.
+        hardware::SubscribeOptions subscribeOptions;
+        subscribeOptions.maxRateHz = moduleContext.redrawScheduler ? moduleContext.redrawScheduler->maxFps() : ui::RedrawScheduler::kDefaultMaxFps;
+        subscribeOptions.decimation = hardware::Decimation::MinMax;
+        subscribeOptions.waveformPointBudget = kWaveformPointBudget;
+        subscriptionToken = moduleContext.hardwareService.subscribeSource(sourceId, subscribeOptions);
+
+        auto self = weak_from_this();
+        core::ObserverOptions options;
+        options.delivery = core::ObserverDelivery::Queued;
+        // Only the newest trace is drawn, so a pending one is simply replaced.
+        options.policy = core::BackpressurePolicy::ConflateLatest;
+        observerToken = moduleContext.dataRegistry.addObserver(sourceId, [self](const core::DataFrame& frame) {
+            if (auto state = self.lock()) {
+                state->handleFrame(frame);
+            }
+        }, options);
+
+        if (auto latest = moduleContext.dataRegistry.latest(sourceId)) {
+            handleFrame(*latest);
+        }
+    }
+
+    void unsubscribe()
+    {
+        if (observerToken != 0 && !currentSourceId.empty()) {
+            moduleContext.dataRegistry.removeObserver(currentSourceId, observerToken);
+        }
+        if (subscriptionToken != 0) {
+            moduleContext.hardwareService.unsubscribeSource(subscriptionToken);
+        }
+        subscriptionToken = 0;
+        observerToken = 0;
+        currentSourceId.clear();
+    }
+
+    void handleFrame(const core::DataFrame& frame)
+    {
+        {
+            std::lock_guard lock(mutex);
+            // A queued frame from the previous source may arrive after a switch.
+            if (frame.sourceId != currentSourceId || held) {
+                return;
+            }
+            for (const auto& point : frame.points) {
+                if (const auto* waveform = std::get_if<core::WaveformSample>(&point.payload)) {
+                    auto& trace = traces[point.channelId];
+                    trace.samples.assign(waveform->samples.begin(), waveform->samples.end());
+                    trace.sampleRateHz = waveform->sampleRateHz;
+                    trace.unit = unit;
+                    trace.block = core::ComputeBlockStats(waveform->samples);
+                }
+            }
+        }
+        requestRedraw();
+    }
+
+    void requestRedraw()
+    {
+        renderCache.invalidate();
+        if (moduleContext.redrawScheduler) {
+            moduleContext.redrawScheduler->requestRedraw();
+            return;
+        }
+        if (auto* screen = ftxui::ScreenInteractive::Active()) {
+            screen->PostEvent(ftxui::Event::Custom);
+        }
+    }
+
+    void toggleHold()
+    {
+        std::lock_guard lock(mutex);
+        held = !held;
+    }
+
+    ftxui::Element render()
+    {
+        using namespace ftxui;
+        std::lock_guard lock(mutex);
+        if (traces.empty()) {
+            return text("No waveform data available.") | dim;
+        }
+        Elements rows;
+        for (auto& [channelId, trace] : traces) {
+            const auto& block = trace.block;
+            std::string timebase = std::to_string(trace.samples.size()) + " pts";
+            if (trace.sampleRateHz > 0.0) {
+                timebase += " @ " + FormatRate(trace.sampleRateHz);
+            }
+            const std::string suffix = trace.unit.empty() ? "" : " " + trace.unit;
+            rows.push_back(hbox({ text(channelId) | bold, filler(), text(timebase) | dim }));
+            rows.push_back(canvas([self = shared_from_this(), id = channelId](Canvas& c) {
+                self->drawTrace(c, id);
+            }) | size(HEIGHT, EQUAL, kTraceHeight) | flex);
+            // Extremes survive min/max decimation exactly; mean/RMS would not, so the
+            // Numeric window (which asks for whole frames) is the place for those.
+            rows.push_back(hbox({
+                text("min " + FormatValue(block.min) + "  max " + FormatValue(block.max) + suffix),
+                filler(),
+                text("p-p " + FormatValue(block.peakToPeak()) + suffix),
+            }));
+            rows.push_back(separator());
+        }
+        rows.push_back(hbox({ text("space hold") | dim, filler(), text(held ? "[held]" : "[run]") | bold }));
+        return vbox(std::move(rows));
+    }
+
+    // Plots the latest frame as an M4 envelope: each braille column gets a stroke
+    // from its minimum to its maximum, joined to the next column's first sample.
+    void drawTrace(ftxui::Canvas& c, const std::string& channelId)
+    {
+        std::lock_guard lock(mutex);
+        auto it = traces.find(channelId);
+        if (it == traces.end() || c.width() <= 0 || c.height() <= 0) {
+            return;
+        }
+        auto& trace = it->second;
+        if (trace.samples.empty()) {
+            return;
+        }
+        const auto width = static_cast<std::size_t>(c.width());
+        core::BuildEnvelope(trace.samples, width, trace.envelope);
+        const auto& envelope = trace.envelope;
+        const int bottom = c.height() - 1;
+        const double range = envelope.high - envelope.low;
+        auto toY = [&](double value) {
+            if (range <= 0.0) {
+                return bottom / 2;
+            }
+            return std::clamp(bottom - static_cast<int>(std::lround((value - envelope.low) / range * bottom)), 0, bottom);
+        };
+        for (std::size_t x = 0; x < width; ++x) {
+            const int column = static_cast<int>(x);
+            c.DrawPointLine(column, toY(envelope.mins[x]), column, toY(envelope.maxs[x]), ftxui::Color::Green);
+            if (x + 1 < width) {
+                c.DrawPointLine(column, toY(envelope.lasts[x]), column + 1, toY(envelope.firsts[x + 1]), ftxui::Color::Green);
+            }
+        }
+    }
+
+    core::ModuleContext& moduleContext;
+    ui::SourceList sourceList { WaveformSources(), "No waveform sources available" };
+    int catalogToken { 0 };
+    std::string currentSourceId;
+    std::string unit;
+    int observerToken { 0 };
+    int subscriptionToken { 0 };
+    std::map<std::string, Trace> traces;
+    bool held { false };
+    ui::RenderInvalidator renderCache;
+    // WindowContext::selectedSource; saved with the layout.
+    std::shared_ptr<std::string> shownSource { std::make_shared<std::string>() };
+    mutable std::recursive_mutex mutex;
+};
+
+class ScopeComponent : public ftxui::ComponentBase {
+public:
+    explicit ScopeComponent(std::shared_ptr<ScopeState> state)
+        : state_(std::move(state))
+    {
+        state_->watchSources();
+        state_->sourceList.prefer(*state_->shownSource);
+
+        ftxui::MenuOption menuOption;
+        auto triggerSelect = [weak = std::weak_ptr(state_)]() {
+            if (auto state = weak.lock()) {
+                state->sourceList.prefer({});
+                state->selectSource(state->sourceList.selected, false);
+            }
+        };
+        menuOption.on_change = triggerSelect;
+        menuOption.on_enter = triggerSelect;
+
+        menuComponent_ = ftxui::Menu(&state_->sourceList.titles, &state_->sourceList.selected, menuOption);
+        auto menuFrame = ftxui::Renderer(menuComponent_, [state = state_, menuComponent = menuComponent_]() {
+            using namespace ftxui;
+            state->syncSources();
+            return menuComponent->Render() | vscroll_indicator;
+        });
+
+        auto tracePane = ftxui::Renderer([state = state_]() {
+            using namespace ftxui;
+            return state->render() | vscroll_indicator | frame | flex;
+        });
+
+        Add(ftxui::Container::Horizontal({
+            menuFrame,
+            ftxui::Renderer([] { return ftxui::separator(); }),
+            tracePane,
+        }));
+
+        if (!state_->sourceList.empty()) {
+            state_->selectSource(state_->sourceList.selected, true);
+        }
+    }
+
+    ~ScopeComponent() override
+    {
+        if (state_) {
+            state_->unwatchSources();
+            state_->unsubscribe();
+        }
+    }
+
+    bool OnEvent(ftxui::Event event) override
+    {
+        if (event == ftxui::Event::Character(" ")) {
+            state_->toggleHold();
+            return true;
+        }
+        return ComponentBase::OnEvent(event);
+    }
+
+private:
+    std::shared_ptr<ScopeState> state_;
+    ftxui::Component menuComponent_;
+};
+
+} // namespace
+
+ScopeModule::ScopeModule() = default;
+
+std::string ScopeModule::id() const
+{
+    return "ui.scope";
+}
+
+std::string ScopeModule::displayName() const
+{
+    return "Scope";
+}
+
+void ScopeModule::initialize(core::ModuleContext& context)
+{
+    context_ = &context;
+}
+
+void ScopeModule::shutdown(core::ModuleContext& context)
+{
+    (void)context;
+    context_ = nullptr;
+}
+
+std::vector<core::SourceMetadata> ScopeModule::declareSources()
+{
+    return {};
+}
+
+std::vector<ui::WindowSpec> ScopeModule::createDefaultWindows(core::ModuleContext& context)
+{
+    ui::WindowSpec spec;
+    spec.id = "ui.scope.window";
+    spec.title = "Scope";
+    spec.cloneable = true;
+    spec.defaultWidth = 60;
+    spec.defaultHeight = 16;
+    spec.componentFactory = [&context](ui::WindowContext& windowContext) -> ftxui::Component {
+        auto state = std::make_shared<ScopeState>(context);
+        state->renderCache = windowContext.cacheRendering();
+        state->shownSource = windowContext.selectedSource;
+        return std::make_shared<ScopeComponent>(std::move(state));
+    };
+
+    return { spec };
+}
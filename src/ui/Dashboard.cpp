@@ -1,10 +1,17 @@
 #include "Dashboard.h"
 
+#include "core/Metrics.h"
+
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/screen_interactive.hpp>
@@ -13,10 +20,203 @@
 #include <ftxui/util/ref.hpp>
 
 #include "flags.h"
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
 namespace ui {
 
+namespace {
+
+// Background windows drawn from their cached pixels, and windows whose content was
+// skipped because none of it was visible.
+const core::metrics::Counter kCachedWindows { "ui.window.cached" };
+const core::metrics::Counter kHiddenWindows { "ui.window.hidden" };
+// Window contents constructed, each on the first frame its window was visible.
+const core::metrics::Counter kBuiltWindows { "ui.window.built" };
+
+constexpr int kLayoutVersion = 1;
+
+// One window of a saved layout.
+struct SavedWindow {
+    std::string specId;
+    int left { 0 };
+    int top { 0 };
+    int width { 0 };
+    int height { 0 };
+    std::array<std::string, 3> label {};
+    std::string sourceId;
+};
+
+// Past this many uncovered fragments a window is simply treated as visible.
+constexpr std::size_t kMaxCoverageFragments = 64;
+
+// Window-area cells; right and bottom are exclusive.
+struct Rect {
+    int left { 0 };
+    int top { 0 };
+    int right { 0 };
+    int bottom { 0 };
+};
+
+bool Overlaps(const Rect& a, const Rect& b)
+{
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+// True when the windows in `above` leave no cell of `rect` visible.
+bool Covered(const Rect& rect, const std::vector<Rect>& above)
+{
+    std::vector<Rect> uncovered { rect };
+    std::vector<Rect> next;
+    for (const auto& cover : above) {
+        next.clear();
+        for (const auto& piece : uncovered) {
+            if (!Overlaps(piece, cover)) {
+                next.push_back(piece);
+                continue;
+            }
+            // What `cover` leaves of the piece: full-width bands above and below it,
+            // then whatever sticks out to either side.
+            if (piece.top < cover.top) {
+                next.push_back({ piece.left, piece.top, piece.right, cover.top });
+            }
+            if (cover.bottom < piece.bottom) {
+                next.push_back({ piece.left, cover.bottom, piece.right, piece.bottom });
+            }
+            const int top = std::max(piece.top, cover.top);
+            const int bottom = std::min(piece.bottom, cover.bottom);
+            if (piece.left < cover.left) {
+                next.push_back({ piece.left, top, cover.left, bottom });
+            }
+            if (cover.right < piece.right) {
+                next.push_back({ cover.right, top, piece.right, bottom });
+            }
+        }
+        if (next.empty()) {
+            return true;
+        }
+        if (next.size() > kMaxCoverageFragments) {
+            return false;
+        }
+        uncovered.swap(next);
+    }
+    return false;
+}
+
+// The part of `box` inside the screen's stencil, relative to the box's origin.
+ftxui::Box VisiblePart(const ftxui::Screen& screen, const ftxui::Box& box)
+{
+    auto visible = ftxui::Box::Intersection(box, screen.stencil);
+    visible.x_min -= box.x_min;
+    visible.x_max -= box.x_min;
+    visible.y_min -= box.y_min;
+    visible.y_max -= box.y_min;
+    return visible;
+}
+
+bool SameBox(const ftxui::Box& a, const ftxui::Box& b)
+{
+    return a.x_min == b.x_min && a.x_max == b.x_max && a.y_min == b.y_min && a.y_max == b.y_max;
+}
+
+bool SameSize(const ftxui::Box& a, const ftxui::Box& b)
+{
+    return a.x_max - a.x_min == b.x_max - b.x_min && a.y_max - a.y_min == b.y_max - b.y_min;
+}
+
+std::size_t CellCount(const ftxui::Box& box)
+{
+    const int width = std::max(0, box.x_max - box.x_min + 1);
+    const int height = std::max(0, box.y_max - box.y_min + 1);
+    return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+}
+
+// Lays out and draws a window's content as usual, then keeps the pixels it drew.
+class CapturedContent : public ftxui::Node {
+public:
+    CapturedContent(ftxui::Element content, WindowRenderCache& cache)
+        : ftxui::Node({ std::move(content) })
+        , cache_(cache)
+    {
+    }
+
+    void ComputeRequirement() override
+    {
+        children_.front()->ComputeRequirement();
+        requirement_ = children_.front()->requirement();
+    }
+
+    void SetBox(ftxui::Box box) override
+    {
+        ftxui::Node::SetBox(box);
+        children_.front()->SetBox(box);
+    }
+
+    void Render(ftxui::Screen& screen) override
+    {
+        children_.front()->Render(screen);
+        // The window clears its area before drawing the content, and the windows
+        // above are drawn later, so these cells hold exactly the content.
+        cache_.requirement = requirement_;
+        cache_.box = box_;
+        cache_.visible = VisiblePart(screen, box_);
+        cache_.pixels.resize(CellCount(cache_.visible));
+        std::size_t index = 0;
+        for (int y = cache_.visible.y_min; y <= cache_.visible.y_max; ++y) {
+            for (int x = cache_.visible.x_min; x <= cache_.visible.x_max; ++x) {
+                cache_.pixels[index++] = screen.PixelAt(box_.x_min + x, box_.y_min + y);
+            }
+        }
+        cache_.valid = true;
+    }
+
+private:
+    WindowRenderCache& cache_;
+};
+
+// Draws the pixels CapturedContent kept, in place of the content's element tree.
+class CachedContent : public ftxui::Node {
+public:
+    CachedContent(WindowRenderCache& cache, std::function<ftxui::Element()> live)
+        : cache_(cache)
+        , live_(std::move(live))
+    {
+    }
+
+    void ComputeRequirement() override
+    {
+        requirement_ = cache_.requirement;
+    }
+
+    void Render(ftxui::Screen& screen) override
+    {
+        // A window that only moved gets a box of the same size with the same part of
+        // it on screen.
+        const auto visible = VisiblePart(screen, box_);
+        if (!SameSize(box_, cache_.box) || !SameBox(visible, cache_.visible)) {
+            // Laid out differently after all: build the content now and capture it
+            // afresh in this box, rather than leave the window blank for a frame.
+            auto captured = std::make_shared<CapturedContent>(live_(), cache_);
+            captured->ComputeRequirement();
+            captured->SetBox(box_);
+            captured->Render(screen);
+            return;
+        }
+        std::size_t index = 0;
+        for (int y = visible.y_min; y <= visible.y_max; ++y) {
+            for (int x = visible.x_min; x <= visible.x_max; ++x) {
+                screen.PixelAt(box_.x_min + x, box_.y_min + y) = cache_.pixels[index++];
+            }
+        }
+    }
+
+private:
+    WindowRenderCache& cache_;
+    std::function<ftxui::Element()> live_;
+};
+
+} // namespace
+
 Dashboard::Dashboard(core::ModuleContext& moduleContext)
     : moduleContext_(moduleContext)
 {
@@ -27,29 +227,28 @@ void Dashboard::setAvailableWindows(std::vector<WindowSpec> specs)
     availableWindows_ = std::move(specs);
     updateAvailableWindowTitles();
     clampSelectedWindowIndex();
+    headerDirty_ = true;
     markLayoutDirty();
 }
 
 std::string Dashboard::addWindow(const WindowSpec& spec)
 {
     const std::string id = generateInstanceId(spec);
-    WindowInstance instance;
-    instance.instanceId = id;
-    instance.spec = spec;
-    instance.context.moduleContext = &moduleContext_;
-    instance.context.windowId = id;
-    instance.left = spec.defaultLeft + cascadeOffset_;
-    instance.top = spec.defaultTop + cascadeOffset_;
-    instance.width = std::max(10, spec.defaultWidth);
-    instance.height = std::max(6, spec.defaultHeight);
-    instance.resizeLeft = spec.resizeLeft;
-    instance.resizeRight = spec.resizeRight;
-    instance.resizeTop = spec.resizeTop;
-    instance.resizeBottom = spec.resizeBottom;
-    instance.renameLines = { spec.title, std::string {}, std::string {} };
+    auto instance = std::make_unique<WindowInstance>();
+    instance->instanceId = id;
+    instance->spec = spec;
+    instance->context.moduleContext = &moduleContext_;
+    instance->context.windowId = id;
+    instance->left = spec.defaultLeft + cascadeOffset_;
+    instance->top = spec.defaultTop + cascadeOffset_;
+    instance->width = std::max(10, spec.defaultWidth);
+    instance->height = std::max(6, spec.defaultHeight);
+    instance->resizeLeft = spec.resizeLeft;
+    instance->resizeRight = spec.resizeRight;
+    instance->resizeTop = spec.resizeTop;
+    instance->resizeBottom = spec.resizeBottom;
+    instance->renameLines = { spec.title, std::string {}, std::string {} };
     activeWindows_.insert(activeWindows_.begin(), std::move(instance));
-    auto& stored = activeWindows_.front();
-    ensureComponent(stored);
     cascadeOffset_ = (cascadeOffset_ + 2) % 20;
     markLayoutDirty();
     return id;
@@ -79,23 +278,23 @@ bool Dashboard::cloneWindow(const std::string& instanceId)
         }
         WindowSpec specCopy = instance->spec;
         const std::string id = generateInstanceId(specCopy);
-        WindowInstance clone;
-        clone.instanceId = id;
-        clone.spec = std::move(specCopy);
-        clone.context.moduleContext = &moduleContext_;
-        clone.context.windowId = id;
-        clone.left = instance->left + 4;
-        clone.top = instance->top + 2;
-        clone.width = instance->width;
-        clone.height = instance->height;
-        clone.resizeLeft = instance->resizeLeft;
-        clone.resizeRight = instance->resizeRight;
-        clone.resizeTop = instance->resizeTop;
-        clone.resizeBottom = instance->resizeBottom;
-        clone.renameLines = instance->renameLines;
+        auto clone = std::make_unique<WindowInstance>();
+        clone->instanceId = id;
+        clone->spec = std::move(specCopy);
+        clone->context.moduleContext = &moduleContext_;
+        clone->context.windowId = id;
+        clone->left = instance->left + 4;
+        clone->top = instance->top + 2;
+        clone->width = instance->width;
+        clone->height = instance->height;
+        clone->resizeLeft = instance->resizeLeft;
+        clone->resizeRight = instance->resizeRight;
+        clone->resizeTop = instance->resizeTop;
+        clone->resizeBottom = instance->resizeBottom;
+        clone->renameLines = instance->renameLines;
+        // The clone starts out on the same source.
+        *clone->context.selectedSource = *instance->context.selectedSource;
         activeWindows_.insert(activeWindows_.begin(), std::move(clone));
-        auto& stored = activeWindows_.front();
-        ensureComponent(stored);
         cascadeOffset_ = (cascadeOffset_ + 2) % 20;
         markLayoutDirty();
         return true;
@@ -105,11 +304,12 @@ bool Dashboard::cloneWindow(const std::string& instanceId)
 
 bool Dashboard::closeWindow(const std::string& instanceId)
 {
-    const auto it = std::remove_if(activeWindows_.begin(), activeWindows_.end(), [&](const WindowInstance& instance) {
-        return instance.instanceId == instanceId;
+    const auto it = std::find_if(activeWindows_.begin(), activeWindows_.end(), [&](const auto& instance) {
+        return instance->instanceId == instanceId;
     });
     if (it != activeWindows_.end()) {
-        activeWindows_.erase(it, activeWindows_.end());
+        closedWindows_.push_back(std::move(*it));
+        activeWindows_.erase(it);
         if (activeWindows_.empty()) {
             cascadeOffset_ = 0;
         }
@@ -139,11 +339,128 @@ std::vector<std::string> Dashboard::activeWindowIds() const
     std::vector<std::string> ids;
     ids.reserve(activeWindows_.size());
     for (const auto& window : activeWindows_) {
-        ids.push_back(window.instanceId);
+        ids.push_back(window->instanceId);
     }
     return ids;
 }
 
+std::vector<const Dashboard::WindowInstance*> Dashboard::stackingOrder() const
+{
+    std::vector<const WindowInstance*> order;
+    order.reserve(activeWindows_.size());
+    // The stacked container keeps its front window first.
+    if (windowStack_) {
+        for (std::size_t i = windowStack_->ChildCount(); i-- > 0;) {
+            const auto* component = windowStack_->ChildAt(i).get();
+            const auto it = std::find_if(activeWindows_.begin(), activeWindows_.end(), [&](const auto& instance) {
+                return instance->window.get() == component;
+            });
+            if (it != activeWindows_.end()) {
+                order.push_back(it->get());
+            }
+        }
+    }
+    // Windows not in the stack yet go on top, newest last, as the next refresh puts them.
+    for (auto it = activeWindows_.rbegin(); it != activeWindows_.rend(); ++it) {
+        if (!(*it)->window) {
+            order.push_back(it->get());
+        }
+    }
+    return order;
+}
+
+bool Dashboard::saveLayout(const std::string& path) const
+{
+    auto windows = nlohmann::json::array();
+    for (const auto* instance : stackingOrder()) {
+        windows.push_back({
+            { "spec", instance->spec.id },
+            { "left", instance->left },
+            { "top", instance->top },
+            { "width", instance->width },
+            { "height", instance->height },
+            { "label", instance->renameLines },
+            { "source", *instance->context.selectedSource },
+        });
+    }
+    const nlohmann::json layout { { "version", kLayoutVersion }, { "windows", std::move(windows) } };
+
+    // Written next to the old layout and renamed over it, so a crash mid-write leaves
+    // the previous one in place.
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << layout.dump(2) << '\n';
+        if (!out) {
+            spdlog::warn("Dashboard: cannot write the layout to '{}'", temporary);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        spdlog::warn("Dashboard: cannot save the layout as '{}': {}", path, error.message());
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    spdlog::debug("Dashboard: saved {} windows to '{}'", layout.at("windows").size(), path);
+    return true;
+}
+
+bool Dashboard::restoreLayout(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        spdlog::info("Dashboard: no saved layout at '{}'", path);
+        return false;
+    }
+    // Read in full before anything is opened, so a malformed file opens nothing.
+    std::vector<SavedWindow> saved;
+    try {
+        const auto layout = nlohmann::json::parse(in);
+        if (layout.value("version", 0) != kLayoutVersion) {
+            spdlog::warn("Dashboard: ignoring layout '{}': unsupported version", path);
+            return false;
+        }
+        for (const auto& entry : layout.at("windows")) {
+            SavedWindow window;
+            window.specId = entry.at("spec").get<std::string>();
+            window.left = entry.at("left").get<int>();
+            window.top = entry.at("top").get<int>();
+            window.width = entry.at("width").get<int>();
+            window.height = entry.at("height").get<int>();
+            if (entry.contains("label")) {
+                window.label = entry.at("label").get<std::array<std::string, 3>>();
+            }
+            window.sourceId = entry.value("source", "");
+            saved.push_back(std::move(window));
+        }
+    } catch (const nlohmann::json::exception& ex) {
+        spdlog::warn("Dashboard: ignoring malformed layout '{}': {}", path, ex.what());
+        return false;
+    }
+
+    // Back to front: each window opened goes on top of the ones before it.
+    for (const auto& window : saved) {
+        const auto* spec = findSpec(window.specId);
+        if (!spec) {
+            spdlog::info("Dashboard: saved window '{}' is no longer available", window.specId);
+            continue;
+        }
+        auto* instance = findInstance(addWindow(*spec));
+        instance->left = window.left;
+        instance->top = window.top;
+        instance->width = std::max(10, window.width);
+        instance->height = std::max(6, window.height);
+        instance->renameLines = window.label;
+        // Read when the content is first built, which may be before its relay is back.
+        *instance->context.selectedSource = window.sourceId;
+    }
+    cascadeOffset_ = 0;
+    spdlog::info("Dashboard: restored {} windows from '{}'", activeWindows_.size(), path);
+    return true;
+}
+
 ui::WindowSpec* Dashboard::findSpec(const std::string& specId)
 {
     auto it = std::find_if(availableWindows_.begin(), availableWindows_.end(), [&](const WindowSpec& spec) {
@@ -157,11 +474,11 @@ ui::WindowSpec* Dashboard::findSpec(const std::string& specId)
 
 Dashboard::WindowInstance* Dashboard::findInstance(const std::string& instanceId)
 {
-    auto it = std::find_if(activeWindows_.begin(), activeWindows_.end(), [&](const WindowInstance& instance) {
-        return instance.instanceId == instanceId;
+    auto it = std::find_if(activeWindows_.begin(), activeWindows_.end(), [&](const auto& instance) {
+        return instance->instanceId == instanceId;
     });
     if (it != activeWindows_.end()) {
-        return &*it;
+        return it->get();
     }
     return nullptr;
 }
@@ -173,9 +490,22 @@ std::string Dashboard::generateInstanceId(const WindowSpec& spec)
 
 void Dashboard::ensureComponent(WindowInstance& instance)
 {
-    if (!instance.component && instance.spec.componentFactory) {
+    if (instance.component) {
+        return;
+    }
+    if (instance.spec.componentFactory) {
         instance.component = instance.spec.componentFactory(instance.context);
     }
+    if (!instance.component) {
+        instance.component = ftxui::Renderer([]() {
+            using namespace ftxui;
+            return text("Component factory not provided.") | dim;
+        });
+    }
+    kBuiltWindows.add();
+    if (instance.content) {
+        instance.content->Add(instance.component);
+    }
 }
 
 void Dashboard::ensureRootInitialized()
@@ -184,6 +514,9 @@ void Dashboard::ensureRootInitialized()
         return;
     }
     root_ = ftxui::Container::Vertical({});
+    windowStack_ = ftxui::Container::Stacked({});
+    windowArea_ = buildWindowArea();
+    headerDirty_ = true;
     layoutDirty_ = true;
 }
 
@@ -193,20 +526,68 @@ void Dashboard::refreshWindowComponents()
         return;
     }
 
-    auto header = buildHeader();
-    auto windowArea = buildWindowArea();
-    auto separatorComponent = ftxui::Renderer([]() {
-        using namespace ftxui;
-        return separator();
-    });
+    if (headerDirty_) {
+        auto header = buildHeader();
+        auto separatorComponent = ftxui::Renderer([]() {
+            using namespace ftxui;
+            return separator();
+        });
+        root_->DetachAllChildren();
+        root_->Add(header);
+        root_->Add(separatorComponent);
+        root_->Add(windowArea_);
+        headerDirty_ = false;
+    }
 
-    root_->DetachAllChildren();
-    root_->Add(header);
-    root_->Add(separatorComponent);
-    root_->Add(windowArea);
+    // Only windows that came or went are touched; the rest keep their components,
+    // their place in the stack and their render caches.
+    for (auto& closed : closedWindows_) {
+        if (closed->window) {
+            closed->window->Detach();
+        }
+    }
+    closedWindows_.clear();
+    // activeWindows_ is newest first, so adding oldest first leaves the newest on top.
+    for (auto it = activeWindows_.rbegin(); it != activeWindows_.rend(); ++it) {
+        auto& instance = **it;
+        if (instance.window) {
+            continue;
+        }
+        instance.window = buildWindowComponent(instance);
+        windowStack_->Add(instance.window);
+        windowStack_->SetActiveChild(instance.window.get());
+    }
     layoutDirty_ = false;
 }
 
+void Dashboard::updateVisibility()
+{
+    const int areaWidth = areaBox_.x_max - areaBox_.x_min + 1;
+    const int areaHeight = areaBox_.y_max - areaBox_.y_min + 1;
+    // Unknown until the area has been laid out once.
+    const bool areaKnown = areaWidth > 1 && areaHeight > 1;
+
+    // The stacked container keeps its front window first.
+    std::vector<Rect> above;
+    above.reserve(windowStack_->ChildCount());
+    for (std::size_t i = 0; i < windowStack_->ChildCount(); ++i) {
+        const auto* component = windowStack_->ChildAt(i).get();
+        const auto it = std::find_if(activeWindows_.begin(), activeWindows_.end(), [&](const auto& instance) {
+            return instance->window.get() == component;
+        });
+        if (it == activeWindows_.end()) {
+            continue;
+        }
+        auto& instance = **it;
+        const Rect rect { instance.left, instance.top, instance.left + instance.width, instance.top + instance.height };
+        const bool offArea = areaKnown
+            && (rect.right <= 0 || rect.bottom <= 0 || rect.left >= areaWidth || rect.top >= areaHeight);
+        instance.front = i == 0;
+        instance.hidden = offArea || Covered(rect, above);
+        above.push_back(rect);
+    }
+}
+
 void Dashboard::markLayoutDirty()
 {
     layoutDirty_ = true;
@@ -305,26 +686,18 @@ ftxui::Component Dashboard::buildWindowArea()
 {
     using namespace ftxui;
 
-    if (activeWindows_.empty()) {
-        return Renderer([]() {
+    // Built once: refreshWindowComponents() adds and detaches the windows themselves.
+    return Renderer(windowStack_, [this]() {
+        using namespace ftxui;
+        if (windowStack_->ChildCount() == 0) {
             return vbox({
                        text("No windows open.") | dim,
                        text("Use the header above to add one.") | dim,
                    })
                 | border;
-        });
-    }
-
-    Components windowComponents;
-    windowComponents.reserve(activeWindows_.size());
-    for (auto& instance : activeWindows_) {
-        windowComponents.push_back(buildWindowComponent(instance));
-    }
-
-    auto stack = Container::Stacked(std::move(windowComponents));
-    return Renderer(stack, [stack]() {
-        using namespace ftxui;
-        return stack->Render() | flex;
+        }
+        updateVisibility();
+        return windowStack_->Render() | reflect(areaBox_) | flex;
     });
 }
 
@@ -332,8 +705,6 @@ ftxui::Component Dashboard::buildWindowComponent(WindowInstance& instance)
 {
     using namespace ftxui;
 
-    ensureComponent(instance);
-
     const std::string title = instance.spec.title.empty() ? instance.instanceId : instance.spec.title;
 
     Components controlComponents;
@@ -362,13 +733,9 @@ ftxui::Component Dashboard::buildWindowComponent(WindowInstance& instance)
         return text(title) | bold;
     });
 
-    Component contentComponent = instance.component;
-    if (!contentComponent) {
-        contentComponent = Renderer([]() {
-            using namespace ftxui;
-            return text("Component factory not provided.") | dim;
-        });
-    }
+    // Filled by ensureComponent() once the window is first drawn.
+    instance.content = Container::Vertical({});
+    Component contentComponent = instance.content;
 
     auto renameInputs = std::make_shared<std::array<Component, 3>>();
     const char* placeholders[3] = { "Window label", "...", "..." };
@@ -400,8 +767,16 @@ ftxui::Component Dashboard::buildWindowComponent(WindowInstance& instance)
         renameRenderer,
         contentComponent,
     });
-    auto innerRenderer = Renderer(windowContainer, [titleRenderer, controlsContainer, renameRenderer, contentComponent]() {
+    // Time spent building this window's element tree, per window kind: instance ids
+    // never repeat, and the registry keeps every name it is given.
+    const core::metrics::Histogram renderTime { "render." + instance.spec.id };
+    auto buildElement = [controlsContainer, renameRenderer, contentComponent, renderTime]() -> ftxui::Element {
         using namespace ftxui;
+        Element content;
+        {
+            core::metrics::ScopedTimer timer(renderTime);
+            content = contentComponent->Render();
+        }
         return vbox({
             hbox({
                 renameRenderer->Render(),
@@ -411,8 +786,38 @@ ftxui::Component Dashboard::buildWindowComponent(WindowInstance& instance)
             }),
             // renameRenderer->Render(),
             separator(),
-            contentComponent->Render() | flex,
+            std::move(content) | flex,
         });
+    };
+    auto innerRenderer = Renderer(windowContainer, [this, window = &instance, buildElement]() -> ftxui::Element {
+        using namespace ftxui;
+        if (window->hidden) {
+            kHiddenWindows.add();
+            return emptyElement();
+        }
+        // Before the cache check: the factory decides whether the window is cached.
+        ensureComponent(*window);
+        // Focus and keyboard input go to the front window, so it is always drawn live;
+        // its first frame in the background captures it afresh.
+        auto& cache = window->cache;
+        const bool cacheable = window->context.renderCached && !window->front;
+        // Read before the content is built, so a change made meanwhile is not lost.
+        const auto version = window->context.contentVersion->load(std::memory_order_acquire);
+        if (cacheable && cache.valid && cache.version == version && cache.width == window->width
+            && cache.height == window->height) {
+            kCachedWindows.add();
+            return std::make_shared<CachedContent>(cache, buildElement);
+        }
+        cache.valid = false;
+
+        auto element = buildElement();
+        if (!cacheable) {
+            return element;
+        }
+        cache.version = version;
+        cache.width = window->width;
+        cache.height = window->height;
+        return std::make_shared<CapturedContent>(std::move(element), cache);
     });
 
     auto tracedInner = innerRenderer;
@@ -445,12 +850,21 @@ ftxui::Component Dashboard::buildWindowComponent(WindowInstance& instance)
     options.resize_top = &instance.resizeTop;
     options.resize_down = &instance.resizeBottom;
     auto windowComponent = Window(std::move(options));
-    windowComponent |= ftxui::CatchEvent([id = instance.instanceId](ftxui::Event event) {
+    windowComponent |= ftxui::CatchEvent([this, window = &instance, id = instance.instanceId](ftxui::Event event) {
         if (!event.is_mouse()) {
             return false;
         }
+        const auto& mouse = event.mouse();
+        // Hovering and clicking change how buttons, menus and inputs draw, so the
+        // cache goes stale while the mouse is over the window and once as it leaves.
+        const int x = mouse.x - areaBox_.x_min - window->left;
+        const int y = mouse.y - areaBox_.y_min - window->top;
+        const bool over = x >= 0 && x < window->width && y >= 0 && y < window->height;
+        if (over || window->hovered) {
+            window->cache.valid = false;
+        }
+        window->hovered = over;
         if (flags::logLevel >= 4) {
-            const auto& mouse = event.mouse();
             spdlog::trace(
                 "Dashboard window '{}' mouse event button={} motion={} x={} y={}",
                 id,
@@ -3,10 +3,44 @@
 #include "ui/WindowSpec.h"
 
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <ftxui/dom/requirement.hpp>
+#include <ftxui/screen/box.hpp>
+#include <ftxui/screen/screen.hpp>
+
 namespace ui {
 
+// The pixels a cached window's content produced last time it was drawn.
+struct WindowRenderCache {
+    bool valid{false};
+    // Content version and window size the pixels were rendered for.
+    std::uint64_t version{0};
+    int width{0};
+    int height{0};
+    ftxui::Requirement requirement;
+    // Where the content was laid out, and the part of that box that was on screen
+    // (relative to the box), so a window that only moved can reuse it.
+    ftxui::Box box;
+    ftxui::Box visible;
+    std::vector<ftxui::Pixel> pixels;
+};
+
+/**
+ * @brief Header plus a stack of floating windows.
+ *
+ * Window components are built once and kept across layout changes; opening or
+ * closing a window only adds or detaches that window. Each frame, windows that are
+ * fully covered by the ones above them (or off the window area) skip rendering
+ * their content, and background windows that opted into caching
+ * (`WindowContext::cacheRendering()`) draw their last pixels instead of
+ * rebuilding their element tree. A window's content is only constructed (its
+ * spec's factory called) the first time any of it is visible, so windows opened
+ * behind others, or restored off screen, cost nothing until they are looked at.
+ */
 class Dashboard {
 public:
     explicit Dashboard(core::ModuleContext& moduleContext);
@@ -25,12 +59,22 @@ public:
     [[nodiscard]] const std::vector<WindowSpec>& availableWindows() const;
     [[nodiscard]] std::vector<std::string> activeWindowIds() const;
 
+    // The open windows (spec, position, size, label and selected source) in stacking
+    // order, as JSON written atomically to `path`. False (logged) if it cannot be written.
+    bool saveLayout(const std::string& path) const;
+    // Opens the windows saved by saveLayout(), skipping specs that are no longer
+    // available. False (and nothing opened) when there is no readable layout at `path`.
+    bool restoreLayout(const std::string& path);
+
 private:
     struct WindowInstance {
         std::string instanceId;
         WindowSpec spec;
         WindowContext context;
+        // Built by the factory on the first frame the window is visible, then added
+        // to `content`, which stands in for it until then.
         ftxui::Component component;
+        ftxui::Component content;
         int left{8};
         int top{4};
         int width{40};
@@ -40,15 +84,25 @@ private:
         bool resizeTop{true};
         bool resizeBottom{true};
         std::array<std::string, 3> renameLines{};
+        ftxui::Component window;
+        // As of the current frame, set by updateVisibility().
+        bool front{false};
+        bool hidden{false};
+        // Whether the last mouse event this window saw was over it.
+        bool hovered{false};
+        WindowRenderCache cache;
     };
 
     WindowSpec* findSpec(const std::string& specId);
     WindowInstance* findInstance(const std::string& instanceId);
     std::string generateInstanceId(const WindowSpec& spec);
+    // Open windows from the back of the stack to the front.
+    std::vector<const WindowInstance*> stackingOrder() const;
     void ensureComponent(WindowInstance& instance);
     void ensureRootInitialized();
     void refreshWindowComponents();
     void markLayoutDirty();
+    void updateVisibility();
     void updateAvailableWindowTitles();
     void clampSelectedWindowIndex();
     ftxui::Component buildHeader();
@@ -57,13 +111,22 @@ private:
 
     core::ModuleContext& moduleContext_;
     std::vector<WindowSpec> availableWindows_;
-    std::vector<WindowInstance> activeWindows_;
+    // Newest first. Heap allocated: components hold pointers into their instance.
+    std::vector<std::unique_ptr<WindowInstance>> activeWindows_;
+    // Closed since the last refresh; detached (and destroyed) there, outside of the
+    // event handler that closed them.
+    std::vector<std::unique_ptr<WindowInstance>> closedWindows_;
     std::vector<std::string> availableWindowTitles_;
     int selectedWindowIndex_{0};
     int nextWindowIndex_{1};
     int cascadeOffset_{0};
     bool layoutDirty_{true};
+    bool headerDirty_{true};
     ftxui::Component root_;
+    ftxui::Component windowStack_;
+    ftxui::Component windowArea_;
+    // The window area as laid out in the last frame.
+    ftxui::Box areaBox_;
 };
 
 }  // namespace ui
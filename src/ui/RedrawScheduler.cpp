@@ -0,0 +1,181 @@
+#include "RedrawScheduler.h"
+
+#include "core/Metrics.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace ui {
+
+namespace {
+
+const core::metrics::Counter kRebuilds { "ui.rebuilds" };
+// One flush on the UI thread: every dirty target's rebuild callback.
+const core::metrics::Histogram kRebuildTime { "ui.rebuild" };
+
+std::chrono::steady_clock::duration PeriodForFps(int fps)
+{
+    const int clamped = std::max(1, fps);
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / clamped));
+}
+
+} // namespace
+
+RedrawScheduler::RedrawScheduler(int maxFps)
+    : maxFps_(std::max(1, maxFps))
+    , framePeriod_(PeriodForFps(maxFps))
+{
+}
+
+RedrawScheduler::~RedrawScheduler()
+{
+    stop();
+}
+
+void RedrawScheduler::setMaxFps(int fps)
+{
+    std::lock_guard lock(mutex_);
+    maxFps_ = std::max(1, fps);
+    framePeriod_ = PeriodForFps(maxFps_);
+}
+
+int RedrawScheduler::maxFps() const
+{
+    std::lock_guard lock(mutex_);
+    return maxFps_;
+}
+
+void RedrawScheduler::start(Poster poster)
+{
+    std::lock_guard lock(mutex_);
+    if (running_) {
+        return;
+    }
+    poster_ = std::move(poster);
+    running_ = true;
+    flushPending_ = false;
+    thread_ = std::thread(&RedrawScheduler::run, this);
+    spdlog::debug("RedrawScheduler: started with a {} fps cap", maxFps_);
+}
+
+void RedrawScheduler::stop()
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    std::lock_guard lock(mutex_);
+    poster_ = nullptr;
+}
+
+int RedrawScheduler::addTarget(RebuildCallback callback)
+{
+    std::lock_guard lock(mutex_);
+    const int token = nextToken_++;
+    auto target = std::make_shared<Target>();
+    target->callback = std::move(callback);
+    targets_.emplace(token, std::move(target));
+    return token;
+}
+
+void RedrawScheduler::removeTarget(int token)
+{
+    std::lock_guard lock(mutex_);
+    // A flush already in progress keeps its own reference to the target, so the
+    // callback is never destroyed while it runs.
+    targets_.erase(token);
+}
+
+void RedrawScheduler::markDirty(int token)
+{
+    {
+        std::lock_guard lock(mutex_);
+        auto it = targets_.find(token);
+        if (it == targets_.end() || it->second->dirty) {
+            return;
+        }
+        it->second->dirty = true;
+        dirty_.push_back(it->second);
+    }
+    cv_.notify_one();
+}
+
+void RedrawScheduler::requestRedraw()
+{
+    {
+        std::lock_guard lock(mutex_);
+        redrawRequested_ = true;
+    }
+    cv_.notify_one();
+}
+
+bool RedrawScheduler::hasWorkLocked() const
+{
+    return !flushPending_ && (redrawRequested_ || !dirty_.empty());
+}
+
+void RedrawScheduler::run()
+{
+    std::unique_lock lock(mutex_);
+    while (running_) {
+        cv_.wait(lock, [this] { return !running_ || hasWorkLocked(); });
+        if (!running_) {
+            break;
+        }
+
+        // Hold the frame until the cap allows it; marks arriving meanwhile join it.
+        const auto due = lastFlush_ + framePeriod_;
+        if (Clock::now() < due) {
+            cv_.wait_until(lock, due, [this] { return !running_; });
+            if (!running_) {
+                break;
+            }
+        }
+
+        flushPending_ = true;
+        lastFlush_ = Clock::now();
+        auto poster = poster_;
+        lock.unlock();
+        if (poster) {
+            poster([this]() { flush(); });
+        }
+        lock.lock();
+    }
+}
+
+void RedrawScheduler::flush()
+{
+    {
+        std::lock_guard lock(mutex_);
+        batch_.swap(dirty_);
+        for (auto& target : batch_) {
+            target->dirty = false;
+        }
+        redrawRequested_ = false;
+        flushPending_ = false;
+    }
+
+    // Callbacks run unlocked on the UI thread; anything they mark lands in the next frame.
+    if (!batch_.empty()) {
+        core::metrics::ScopedTimer timer(kRebuildTime);
+        kRebuilds.add(batch_.size());
+        for (auto& target : batch_) {
+            if (target->callback) {
+                target->callback();
+            }
+        }
+    }
+    batch_.clear();
+    cv_.notify_one();
+}
+
+} // namespace ui
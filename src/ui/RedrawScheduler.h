@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ui {
+
+/**
+ * @brief Coalesces redraw requests into at most one rebuild per target per frame.
+ *
+ * Windows register a rebuild callback and get a token back. Data observers on any
+ * thread call `markDirty(token)` as often as they like; a pacing thread posts a
+ * single flush job to the UI thread at most `maxFps` times per second, and that job
+ * runs each dirty target's callback once before the screen repaints.
+ */
+class RedrawScheduler {
+public:
+    // Posts a job to the UI thread (e.g. ScreenInteractive::Post plus a repaint).
+    using Poster = std::function<void(std::function<void()>)>;
+    using RebuildCallback = std::function<void()>;
+
+    static constexpr int kDefaultMaxFps = 30;
+
+    explicit RedrawScheduler(int maxFps = kDefaultMaxFps);
+    ~RedrawScheduler();
+
+    RedrawScheduler(const RedrawScheduler&) = delete;
+    RedrawScheduler& operator=(const RedrawScheduler&) = delete;
+
+    void setMaxFps(int fps);
+    [[nodiscard]] int maxFps() const;
+
+    void start(Poster poster);
+    void stop();
+
+    // Callbacks should capture their owner weakly: a target removed while a flush is
+    // already running may still be invoked once.
+    int addTarget(RebuildCallback callback);
+    void removeTarget(int token);
+
+    // Thread-safe; repeated marks before the next frame collapse into one rebuild.
+    void markDirty(int token);
+    // Repaints on the next frame without rebuilding any target.
+    void requestRedraw();
+
+private:
+    struct Target {
+        RebuildCallback callback;
+        bool dirty{false};
+    };
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    void flush();
+    [[nodiscard]] bool hasWorkLocked() const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    Poster poster_;
+    bool running_{false};
+    bool flushPending_{false};
+    bool redrawRequested_{false};
+    int maxFps_;
+    Clock::duration framePeriod_;
+    Clock::time_point lastFlush_{};
+
+    std::unordered_map<int, std::shared_ptr<Target>> targets_;
+    std::vector<std::shared_ptr<Target>> dirty_;
+    // Reused by flush() so steady-state frames do not allocate.
+    std::vector<std::shared_ptr<Target>> batch_;
+    int nextToken_{1};
+};
+
+}  // namespace ui
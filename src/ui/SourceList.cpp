@@ -0,0 +1,148 @@
+#include "SourceList.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+namespace ui {
+
+SourceList::SourceList(core::SourceQuery query, std::string emptyTitle)
+    : query_(std::move(query))
+    , emptyTitle_(std::move(emptyTitle))
+{
+    // Menus show the whole match; paging is for other consumers.
+    query_.offset = 0;
+    query_.limit = 0;
+    titles = { emptyTitle_ };
+}
+
+void SourceList::load(const core::SourceCatalog& catalog)
+{
+    // Read first: changes racing the query are queued too and re-applied, which is
+    // harmless, whereas reading it afterwards could skip one.
+    version_ = catalog.version();
+    const auto entries = catalog.query(query_);
+    sources.clear();
+    titles.clear();
+    sources.reserve(entries.size());
+    titles.reserve(entries.size());
+    for (const auto& entry : entries) {
+        sources.push_back(*entry);
+        titles.push_back(entry->name);
+    }
+    if (sources.empty()) {
+        titles = { emptyTitle_ };
+    }
+    clampSelection();
+    if (!preferred_.empty() && select(preferred_)) {
+        preferred_.clear();
+    }
+}
+
+bool SourceList::enqueue(const core::SourceEvent& event)
+{
+    if (!event.source || !std::string_view(event.source->id).starts_with(query_.idPrefix)) {
+        return false;
+    }
+    // An update can move a listed source out of the query (a kind change), so all of
+    // them are taken; apply() drops the entry then.
+    if (event.type != core::SourceEventType::Updated && !query_.matches(*event.source)) {
+        return false;
+    }
+    std::lock_guard lock(pendingMutex_);
+    pending_.push_back(event);
+    return true;
+}
+
+bool SourceList::sync()
+{
+    {
+        std::lock_guard lock(pendingMutex_);
+        if (pending_.empty()) {
+            return false;
+        }
+        applying_.swap(pending_);
+    }
+    for (const auto& event : applying_) {
+        if (event.version > version_) {
+            apply(event);
+            version_ = event.version;
+        }
+    }
+    applying_.clear();
+    if (!preferred_.empty() && select(preferred_)) {
+        preferred_.clear();
+    }
+    return true;
+}
+
+void SourceList::apply(const core::SourceEvent& event)
+{
+    const auto& source = *event.source;
+    const auto it = std::lower_bound(sources.begin(), sources.end(), source.id, [](const core::SourceMetadata& entry, const std::string& id) {
+        return entry.id < id;
+    });
+    const bool listed = it != sources.end() && it->id == source.id;
+    const auto index = static_cast<int>(it - sources.begin());
+    const bool keep = event.type != core::SourceEventType::Removed && query_.matches(source);
+
+    if (listed && keep) {
+        *it = source;
+        titles[static_cast<std::size_t>(index)] = source.name;
+        return;
+    }
+    if (listed) {
+        sources.erase(it);
+        titles.erase(titles.begin() + index);
+        if (index < selected) {
+            --selected;
+        }
+    } else if (keep) {
+        if (sources.empty()) {
+            titles.clear();
+        } else if (index <= selected) {
+            ++selected;
+        }
+        sources.insert(it, source);
+        titles.insert(titles.begin() + index, source.name);
+    }
+    if (sources.empty()) {
+        titles = { emptyTitle_ };
+    }
+    clampSelection();
+}
+
+bool SourceList::select(const std::string& sourceId)
+{
+    const auto it = std::find_if(sources.begin(), sources.end(), [&](const core::SourceMetadata& entry) {
+        return entry.id == sourceId;
+    });
+    if (it == sources.end()) {
+        return false;
+    }
+    selected = static_cast<int>(it - sources.begin());
+    return true;
+}
+
+void SourceList::prefer(std::string sourceId)
+{
+    preferred_ = std::move(sourceId);
+    if (!preferred_.empty() && select(preferred_)) {
+        preferred_.clear();
+    }
+}
+
+const core::SourceMetadata* SourceList::selectedSource() const
+{
+    if (selected < 0 || selected >= static_cast<int>(sources.size())) {
+        return nullptr;
+    }
+    return &sources[static_cast<std::size_t>(selected)];
+}
+
+void SourceList::clampSelection()
+{
+    selected = std::clamp(selected, 0, std::max(0, static_cast<int>(sources.size()) - 1));
+}
+
+} // namespace ui
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/SourceCatalog.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ui {
+
+/**
+ * @brief A window's source menu, kept in step with the registry's SourceCatalog.
+ *
+ * `load()` fills it from one catalog query; after that the catalog observer
+ * `enqueue()`s each change from whatever thread made it, and `sync()` folds the
+ * queued changes into the menu on the UI thread instead of rescanning the catalog.
+ * Entries stay sorted by id, and the selection follows its source when entries are
+ * inserted or removed ahead of it.
+ */
+class SourceList {
+public:
+    SourceList(core::SourceQuery query, std::string emptyTitle);
+
+    SourceList(const SourceList&) = delete;
+    SourceList& operator=(const SourceList&) = delete;
+
+    // UI thread.
+    void load(const core::SourceCatalog& catalog);
+    // Thread-safe; false (and nothing queued) when the change is outside the query.
+    bool enqueue(const core::SourceEvent& event);
+    // UI thread; true when the menu changed.
+    bool sync();
+
+    // Selects the listed source `sourceId`; false when it is not listed.
+    bool select(const std::string& sourceId);
+    // Selects `sourceId` now or, if it is not listed yet, on the load() or sync() that
+    // lists it; for sources restored from a saved layout, which may belong to a relay
+    // still connecting. An empty id drops a pending preference.
+    void prefer(std::string sourceId);
+    // The preferred source still waiting to be listed, or empty.
+    [[nodiscard]] const std::string& preferred() const { return preferred_; }
+    // The selected source, or nullptr while the list is empty.
+    [[nodiscard]] const core::SourceMetadata* selectedSource() const;
+    [[nodiscard]] bool empty() const { return sources.empty(); }
+
+    // UI thread only. `titles` and `selected` back an ftxui::Menu; while the list is
+    // empty `titles` holds the placeholder.
+    std::vector<core::SourceMetadata> sources;
+    std::vector<std::string> titles;
+    int selected{0};
+
+private:
+    void apply(const core::SourceEvent& event);
+    void clampSelection();
+
+    core::SourceQuery query_;
+    std::string emptyTitle_;
+    std::string preferred_;
+    // Catalog version the list reflects; older queued events are skipped.
+    std::uint64_t version_{0};
+
+    std::mutex pendingMutex_;
+    std::vector<core::SourceEvent> pending_;
+    // Swapped with pending_ by sync() so steady-state updates do not allocate.
+    std::vector<core::SourceEvent> applying_;
+};
+
+}  // namespace ui
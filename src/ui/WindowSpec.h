@@ -2,7 +2,9 @@
 
 #include "core/ModuleContext.h"
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -11,14 +13,55 @@
 
 namespace ui {
 
+/**
+ * @brief Tells the dashboard that a cached window's content changed.
+ *
+ * Copyable and callable from any thread (typically a data observer). A default
+ * constructed handle does nothing.
+ */
+class RenderInvalidator {
+public:
+    RenderInvalidator() = default;
+    explicit RenderInvalidator(std::shared_ptr<std::atomic<std::uint64_t>> version)
+        : version_(std::move(version))
+    {
+    }
+
+    void invalidate() const {
+        if (version_) {
+            version_->fetch_add(1, std::memory_order_release);
+        }
+    }
+
+private:
+    std::shared_ptr<std::atomic<std::uint64_t>> version_;
+};
+
 struct WindowContext {
     core::ModuleContext* moduleContext{nullptr};
     std::string windowId;
+    // Bumped through RenderInvalidator; compared by the dashboard before each render.
+    std::shared_ptr<std::atomic<std::uint64_t>> contentVersion{std::make_shared<std::atomic<std::uint64_t>>(0)};
+    bool renderCached{false};
+    // The source the window shows, saved with the layout. Restored layouts set it before
+    // the factory runs; windows that pick a source keep it current (UI thread only).
+    std::shared_ptr<std::string> selectedSource{std::make_shared<std::string>()};
 
     [[nodiscard]] core::ModuleContext& module() const {
         assert(moduleContext != nullptr);
         return *moduleContext;
     }
+
+    // Opts the window into render caching; call from the component factory. While the
+    // window is in the background its last rendered pixels are reused until the
+    // returned handle is invalidated, the window is resized or the mouse acts on it,
+    // so call invalidate() whenever something the window draws changes outside of
+    // its own event handling (new data, a rebuilt row). Windows that never call this
+    // are rendered every frame.
+    [[nodiscard]] RenderInvalidator cacheRendering() {
+        renderCached = true;
+        return RenderInvalidator(contentVersion);
+    }
 };
 
 using ComponentFactory = std::function<ftxui::Component(WindowContext&)>;